@@ -1,10 +1,148 @@
 #include <stdio.h>
-#include "line.h"
-#include "error_handling.h"
-#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "core/error_handling.h"
+#include "core/thread_pool.h"
+#include "asm/batch.h"
 
-int main(){
 
+// mips_app: batch assembler. every input file is assembled on a worker pool, results come out in input order.
+//
+// usage: mips_app [-j jobs] [-m manifest]... [-c cache_dir] [-l log_file] [file.asm]...
 
-    
-}
\ No newline at end of file
+
+static void usage(void){
+
+    fprintf(stderr, "usage: mips_app [-j jobs] [-m manifest]... [-c cache_dir] [-l log_file] [file.asm]...\n"
+                    "  -j jobs       worker threads, 0 (default): one per online CPU\n"
+                    "  -m manifest   file with one source path per line ('#' comments, blank lines ignored)\n"
+                    "  -c cache_dir  reuse assembled programs from the on-disk cache\n"
+                    "  -l log_file   diagnostics go there instead of stderr\n");
+
+}
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+int main(int argc, char **argv){
+
+    unsigned jobs = 0;
+    const char *cache_dir = NULL;
+    const char *log_path = "/dev/stderr";
+    const char **manifests = calloc((size_t)argc, sizeof(*manifests));     // read once the context exists
+    size_t n_manifests = 0;
+    int i = 1;
+
+    if(!manifests) return 2;
+
+    for(; i < argc && argv[i][0] == '-'; i++){
+
+        if(strcmp(argv[i], "--") == 0){ i++; break; }
+
+        if(i + 1 >= argc || argv[i][1] == '\0' || argv[i][2] != '\0'){
+
+            usage();
+            free(manifests);
+            return 2;
+
+        }
+
+        switch(argv[i][1]){
+
+            case 'j': jobs = (unsigned)strtoul(argv[++i], NULL, 10); break;
+            case 'm': manifests[n_manifests++] = argv[++i]; break;
+            case 'c': cache_dir = argv[++i]; break;
+            case 'l': log_path = argv[++i]; break;
+            default: usage(); free(manifests); return 2;
+
+        }
+
+    }
+
+    app_context *app = create_app_context(log_path);
+
+    if(!app){
+
+        free(manifests);
+        return 2;
+
+    }
+
+    AsmBatchList list;
+    Err e = asm_batch_list_init(&list, app);
+
+    for(size_t k = 0; e == ERR_OK && k < n_manifests; k++) e = asm_batch_list_read_manifest(&list, manifests[k], app);
+    for(; e == ERR_OK && i < argc; i++) e = asm_batch_list_add(&list, argv[i], strlen(argv[i]), app);
+
+    free(manifests);
+
+    if(e != ERR_OK || list.n == 0){
+
+        if(e == ERR_OK) usage();
+        asm_batch_list_free(&list, app);
+        destroy_app_context(app);
+        return 2;
+
+    }
+
+    thread_pool *pool = create_thread_pool(app, jobs);
+    AsmBatchResult *results = calloc(list.n, sizeof(*results));
+
+    if(!pool || !results){
+
+        free(results);
+        if(pool) destroy_thread_pool(app, pool);
+        asm_batch_list_free(&list, app);
+        destroy_app_context(app);
+        return 2;
+
+    }
+
+    const AsmBatchConfig cfg = {.config = {.text_base = 0x00400000, .data_base = 0x10010000}, .pool = pool, .cache_dir = cache_dir};
+
+    double t0 = now_sec();
+    asm_batch_assemble(app, &cfg, &list, results);
+    double wall = now_sec() - t0;
+
+    app_context_flush(app);         // the diagnostics of the batch come before its results
+
+    size_t failed = 0;
+
+    for(size_t k = 0; k < list.n; k++){
+
+        const AsmBatchResult *r = &results[k];
+
+        if(r->result == ERR_OK){
+
+            printf("ok    %s  text=%zu data=%zu symbols=%zu%s  %.3f ms\n", list.paths[k], r->text_words, r->data_words, r->symbols,
+                   r->cache_hit ? " cached" : "", (double)r->ns * 1e-6);
+
+        }
+        else{
+
+            printf("FAIL  %s  %s  %.3f ms\n", list.paths[k], asm_batch_err_name(r->result), (double)r->ns * 1e-6);
+            failed++;
+
+        }
+
+    }
+
+    printf("files=%zu ok=%zu failed=%zu threads=%u  %.3f ms  (%.0f files/s)\n", list.n, list.n - failed, failed, thread_pool_size(pool),
+           wall * 1e3, wall > 0 ? (double)list.n / wall : 0.0);
+
+    free(results);
+    destroy_thread_pool(app, pool);
+    asm_batch_list_free(&list, app);
+    destroy_app_context(app);
+
+    return failed ? 1 : 0;
+
+}
@@ -0,0 +1,117 @@
+// bench_batch: throughput of asm_batch_assemble() over many small generated files, for 1, 2, 4, ... threads up
+// to the number of online CPUs. best of N per thread count.
+//
+// usage: bench_batch [number_of_files] [lines_per_file] [reps]
+
+#include "asm/batch.h"
+#include "core/thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static int write_file(const char *path, size_t lines, size_t seed){
+
+    FILE *f = fopen(path, "w");
+    if(!f) return 0;
+
+    fprintf(f, ".text\n");
+
+    for(size_t i = 0; i < lines; i++){
+
+        if(i % 8 == 0) fprintf(f, "loop_%zu: add $t0, $t1, $t2   # labeled\n", i);
+        else if(i % 8 == 3) fprintf(f, "    beq $t0, $zero, loop_%zu\n", i & ~(size_t)7);
+        else if(i % 8 == 5) fprintf(f, "    lw $s0, %zu($sp)\n", ((i + seed) * 4) & 0xFFF);
+        else fprintf(f, "    addi $t%zu, $t%zu, %zu\n", i % 8, (i + 1) % 8, (i + seed) & 0x7FFF);
+
+    }
+
+    fprintf(f, ".data\ntbl: .word %zu, -1, 0x7f\n", seed);
+    fclose(f);
+
+    return 1;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n_files = (argc > 1) ? strtoull(argv[1], NULL, 10) : 256;
+    size_t lines = (argc > 2) ? strtoull(argv[2], NULL, 10) : 2000;
+    int reps = (argc > 3) ? atoi(argv[3]) : 5;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    char dir[] = "/tmp/bench_batch_XXXXXX";
+    if(!mkdtemp(dir)) return 1;
+
+    AsmBatchList list;
+    if(asm_batch_list_init(&list, NULL) != ERR_OK) return 1;
+
+    for(size_t k = 0; k < n_files; k++){
+
+        char path[128];
+        int len = snprintf(path, sizeof(path), "%s/f%zu.s", dir, k);
+        if(!write_file(path, lines, k) || asm_batch_list_add(&list, path, (size_t)len, NULL) != ERR_OK) return 1;
+
+    }
+
+    AsmBatchResult *results = calloc(n_files, sizeof(*results));
+    if(!results) return 1;
+
+    printf("files=%zu lines/file=%zu cpus=%ld\n", n_files, lines, cpus);
+
+    double base = 0;
+
+    for(unsigned threads = 1; threads <= (unsigned)((cpus < 1) ? 1 : cpus); threads *= 2){
+
+        thread_pool *pool = create_thread_pool(NULL, threads);
+        if(!pool) return 1;
+
+        const AsmBatchConfig cfg = {.config = {.text_base = 0x00400000, .data_base = 0x10010000}, .pool = pool};
+        double best = 1e30;
+
+        for(int rep = 0; rep < reps; rep++){
+
+            double t0 = now_sec();
+            Err e = asm_batch_assemble(NULL, &cfg, &list, results);
+            double t = now_sec() - t0;
+
+            if(e != ERR_OK){
+
+                fprintf(stderr, "batch failed\n");
+                return 1;
+
+            }
+
+            if(t < best) best = t;
+
+        }
+
+        if(threads == 1) base = best;
+
+        printf("  threads=%-3u %9.3f ms  %9.0f files/s  speedup %.2fx\n", threads, best * 1e3, (double)n_files / best, base / best);
+
+        destroy_thread_pool(NULL, pool);
+
+    }
+
+    for(size_t k = 0; k < list.n; k++) unlink(list.paths[k]);
+    rmdir(dir);
+
+    free(results);
+    asm_batch_list_free(&list, NULL);
+
+    return 0;
+
+}
@@ -0,0 +1,91 @@
+// bench_cache: a generated program assembled through the on-disk cache, a cold run (miss: pass 1 + pass 2 + store)
+// against warm runs (hit: hash the source, map the entry).
+//
+// usage: bench_cache [number_of_lines]
+
+#include "asm/cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static int make_program(const char *path, size_t n){      // one forward branch and one forward jump every 8 lines
+
+    FILE *f = fopen(path, "w");
+    if(!f) return 0;
+
+    size_t data_from = n - n / 16;
+
+    for(size_t i = 0; i < n; i++){
+
+        if(i == 0) fprintf(f, ".text\n");
+        else if(i == data_from) fprintf(f, ".data\n");
+        else if(i > data_from) fprintf(f, "w%zu: .word %zu, -1\n", i, i);
+        else if(i % 8 == 1) fprintf(f, "loop_%zu: add $t0, $t1, $t2\n", i);
+        else if(i % 8 == 3 && i + 6 < data_from) fprintf(f, "    beq $t0, $zero, loop_%zu\n", i + 6);
+        else if(i % 8 == 7 && i + 2 < data_from) fprintf(f, "    j loop_%zu\n", i + 2);
+        else if(i % 8 == 5) fprintf(f, "    lw $s0, %zu($sp)\n", (i * 4) & 0xFFF);
+        else fprintf(f, "    addi $t%zu, $t%zu, %zu\n", i % 8, (i + 1) % 8, i & 0x7FFF);
+
+    }
+
+    return fclose(f) == 0;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+
+    char dir[] = "/tmp/bench_cache_XXXXXX";
+    if(!mkdtemp(dir)) return 1;
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s/prog.s", dir);
+    if(!make_program(path, n)) return 1;
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    asm_cached_program *p;
+    int hit;
+
+    double t0 = now_sec();
+    if(asm_cache_assemble_file(NULL, dir, &cfg, path, &p, &hit) != ERR_OK || hit) return 1;
+    double cold = now_sec() - t0;
+
+    size_t text_n = asm_cached_view(p)->text_n;
+    destroy_asm_cached_program(NULL, p);
+
+    double warm = 1e30;
+
+    for(int rep = 0; rep < 5; rep++){
+
+        t0 = now_sec();
+        if(asm_cache_assemble_file(NULL, dir, &cfg, path, &p, &hit) != ERR_OK || !hit) return 1;
+        double t = now_sec() - t0;
+        if(t < warm) warm = t;
+
+        if(asm_cached_view(p)->text_n != text_n) return 1;
+        destroy_asm_cached_program(NULL, p);
+
+    }
+
+    printf("lines=%zu\n  miss (assemble + store) : %8.3f ms\n  hit  (hash + map)       : %8.3f ms  %.1fx\n", n, cold * 1e3, warm * 1e3, cold / warm);
+
+    char cmd[96];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+
+    return system(cmd) == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,140 @@
+// bench_ir: memory and push rate of the compact IR for a 1M instruction program, against the
+// Statement array it replaced (label names and mnemonics inline, a heap array per .word line).
+//
+// usage: bench_ir [number_of_statements]
+
+#include "core/ir.h"
+#include "core/isa_mips.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+// the IR entry as it was before the compact records, kept here as the baseline
+
+typedef struct{
+
+    OpKind kind;
+    union{ int reg; int32_t imm; char *label; struct{ int32_t offset; int base_reg; }mem; }v;
+
+}LegacyOperand;
+
+typedef struct{
+
+    int line_no;
+    StatementKind kind;
+    union{
+
+        struct{ int32_t *values; size_t n; }dir_word;
+        struct{ char mnemonic[16]; LegacyOperand ops[3]; int op_count; }instr;
+        struct{ char name[64]; struct{ char mnemonic[16]; LegacyOperand ops[3]; int op_count; }instr; }label_plus_instr;
+        struct{ char name[64]; struct{ int32_t *values; size_t n; }dir_word; }label_plus_dir_word;
+
+    }as;
+
+}LegacyStatement;
+
+
+static void make_statement(size_t i, Statement *s, int32_t *words){     // 1 in 8 statements is labeled, 1 in 16 is a .word line of 4 values
+
+    memset(s, 0, sizeof(*s));
+    s->line_no = (int)i + 1;
+
+    if(i % 16 == 15){
+
+        s->kind = ST_DIR_WORD;
+        s->as.dir_word.values = words;
+        s->as.dir_word.n = 4;
+        return;
+
+    }
+
+    int op = (i % 3 == 0) ? ISA_ADD : (i % 3 == 1) ? ISA_LW : ISA_BEQ;
+    Operand ops[3] = {{0}};
+
+    ops[0] = (Operand){.kind = OP_REGISTER, .v.reg = (int)(i & 31)};
+
+    if(op == ISA_ADD){
+
+        ops[1] = (Operand){.kind = OP_REGISTER, .v.reg = 9};
+        ops[2] = (Operand){.kind = OP_REGISTER, .v.reg = 10};
+
+    }
+    else if(op == ISA_LW) ops[1] = (Operand){.kind = OP_MEMORY, .v.mem = {(int32_t)(i & 0xFF), 29}};
+    else{
+
+        ops[1] = (Operand){.kind = OP_REGISTER, .v.reg = 0};
+        ops[2] = (Operand){.kind = OP_LABEL, .v.label = (StrId)(i / 8 + 1)};
+
+    }
+
+    if(i % 8 == 0){
+
+        s->kind = ST_LABEL_PLUS_INSTR;
+        s->as.label_plus_instr.name = (StrId)(i / 8 + 1);
+        s->as.label_plus_instr.instr.op = op;
+        s->as.label_plus_instr.instr.op_count = isa_spec((IsaId)op)->op_count;
+        memcpy(s->as.label_plus_instr.instr.ops, ops, sizeof(ops));
+
+    }
+    else{
+
+        s->kind = ST_INSTR;
+        s->as.instr.op = op;
+        s->as.instr.op_count = isa_spec((IsaId)op)->op_count;
+        memcpy(s->as.instr.ops, ops, sizeof(ops));
+
+    }
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    int32_t words[4] = {1, 2, 3, 4};
+
+    IR ir;
+    if(ir_init(&ir, NULL) != ERR_OK) return 1;
+
+    size_t word_lines = 0;
+    double t0 = now_sec();
+
+    for(size_t i = 0; i < n; i++){
+
+        Statement s;
+        make_statement(i, &s, words);
+        word_lines += (s.kind == ST_DIR_WORD);
+
+        if(ir_push(&ir, &s, NULL) != ERR_OK) return 1;
+
+    }
+
+    double push_sec = now_sec() - t0;
+
+    // the old layout: one LegacyStatement per entry (array doubled like ir_grow) plus a malloc'd array per .word line
+
+    size_t legacy_cap = 64;
+    while(legacy_cap < n) legacy_cap *= 2;
+
+    size_t legacy_bytes = legacy_cap * sizeof(LegacyStatement) + word_lines * sizeof(words);
+    size_t new_bytes = ir.cap * sizeof(IrRec) + ir.words_cap * sizeof(int32_t);
+
+    printf("statements=%zu  .word lines=%zu  push %.3f s (%.1f M statements/s)\n", n, word_lines, push_sec, (double)n / push_sec / 1e6);
+    printf("  before (Statement, %zu bytes/entry): %8.1f MiB\n", sizeof(LegacyStatement), (double)legacy_bytes / (1024.0 * 1024.0));
+    printf("  after  (IrRec, %zu bytes/entry)    : %8.1f MiB  %.1fx smaller\n", sizeof(IrRec), (double)new_bytes / (1024.0 * 1024.0), (double)legacy_bytes / (double)new_bytes);
+
+    ir_free(&ir, NULL);
+    return 0;
+
+}
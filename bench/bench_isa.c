@@ -0,0 +1,90 @@
+// bench_isa: lookups/sec of the generated perfect hash isa_lookup() against the linear
+// strcmp scan it replaced, over every mnemonic of the table plus a few misses.
+//
+// usage: bench_isa [number_of_rounds]
+
+#include "core/isa_mips.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+// the lookup as it was before the hash, kept here as the baseline
+
+static const InstructionSpec *legacy_lookup(const char *mnemonic){
+
+    for(int id = 0; id < ISA_COUNT; id++){
+
+        const InstructionSpec *spec = isa_spec((IsaId)id);
+        if(strcmp(mnemonic, spec->mnemonic) == 0) return spec;
+
+    }
+
+    return NULL;
+
+}
+
+
+static const char *g_misses[] = { "mul", "addx", "ad", "ADD", "la", "li", "nop", "syscall" };
+
+
+int main(int argc, char **argv){
+
+    size_t rounds = (argc > 1) ? strtoull(argv[1], NULL, 10) : 2000000;
+    size_t nmisses = sizeof(g_misses) / sizeof(g_misses[0]);
+    size_t nkeys = (size_t)ISA_COUNT + nmisses;
+
+    const char **keys = malloc(nkeys * sizeof(*keys));
+    if(!keys) return 1;
+
+    for(int id = 0; id < ISA_COUNT; id++) keys[id] = isa_spec((IsaId)id)->mnemonic;
+    for(size_t i = 0; i < nmisses; i++) keys[ISA_COUNT + i] = g_misses[i];
+
+    // volatile sink so the compiler keeps every lookup
+
+    volatile uintptr_t sink = 0;
+    size_t lookups = rounds * nkeys;
+
+    double t0 = now_sec();
+
+    for(size_t r = 0; r < rounds; r++)
+        for(size_t k = 0; k < nkeys; k++) sink += (uintptr_t)legacy_lookup(keys[k]);
+
+    double old_sec = now_sec() - t0;
+
+    double t1 = now_sec();
+
+    for(size_t r = 0; r < rounds; r++)
+        for(size_t k = 0; k < nkeys; k++) sink += (uintptr_t)isa_lookup(keys[k]);
+
+    double new_sec = now_sec() - t1;
+
+    for(size_t k = 0; k < nkeys; k++){
+
+        if(legacy_lookup(keys[k]) != isa_lookup(keys[k])){
+
+            fprintf(stderr, "lookup mismatch on \"%s\"\n", keys[k]);
+            return 1;
+
+        }
+
+    }
+
+    printf("mnemonics=%d misses=%zu lookups=%zu\n", (int)ISA_COUNT, nmisses, lookups);
+    printf("  before (linear strcmp): %.3f s  %6.1f ns/lookup\n", old_sec, old_sec * 1e9 / (double)lookups);
+    printf("  after  (perfect hash) : %.3f s  %6.1f ns/lookup  speedup %.2fx\n", new_sec, new_sec * 1e9 / (double)lookups, old_sec / new_sec);
+
+    free(keys);
+    return 0;
+
+}
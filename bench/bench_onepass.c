@@ -0,0 +1,101 @@
+// bench_onepass: a generated program streamed from a file, assembled by the one-pass mode against
+// the two pass pipeline (streamed pass 1 into an IR, then pass 2). reports time and the memory held
+// besides the images: the IR for two passes, the fixup chains for one.
+//
+// usage: bench_onepass [number_of_lines]
+
+#include "asm/onepass.h"
+#include "asm/pass1.h"
+#include "asm/pass2.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static FILE *make_program(size_t n){      // one forward branch and one forward jump every 8 lines
+
+    FILE *f = tmpfile();
+    if(!f) return NULL;
+
+    size_t data_from = n - n / 16;
+
+    for(size_t i = 0; i < n; i++){
+
+        if(i == 0) fprintf(f, ".text\n");
+        else if(i == data_from) fprintf(f, ".data\n");
+        else if(i > data_from) fprintf(f, "w%zu: .word %zu, -1\n", i, i);
+        else if(i % 8 == 1) fprintf(f, "loop_%zu: add $t0, $t1, $t2\n", i);
+        else if(i % 8 == 3 && i + 6 < data_from) fprintf(f, "    beq $t0, $zero, loop_%zu\n", i + 6);
+        else if(i % 8 == 7 && i + 2 < data_from) fprintf(f, "    j loop_%zu\n", i + 2);
+        else if(i % 8 == 5) fprintf(f, "    lw $s0, %zu($sp)\n", (i * 4) & 0xFFF);
+        else fprintf(f, "    addi $t%zu, $t%zu, %zu\n", i % 8, (i + 1) % 8, i & 0x7FFF);
+
+    }
+
+    return f;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n = (argc > 1) ? strtoull(argv[1], NULL, 10) : 2000000;
+    FILE *f = make_program(n);
+    if(!f) return 1;
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    double two_best = 1e30, one_best = 1e30;
+    size_t ir_bytes = 0;
+    int same = 1;
+
+    for(int rep = 0; rep < 5; rep++){
+
+        IR ir;
+        Symtab st, st1;
+        AsmState state, state1;
+        AsmImage img, img1;
+
+        rewind(f);
+        double t0 = now_sec();
+        if(assemble_pass1_stream(NULL, &cfg, f, &ir, &st, &state) != ERR_OK) return 1;
+        if(assemble_pass2(NULL, &cfg, &ir, &st, &state, &img) != ERR_OK) return 1;
+        double t = now_sec() - t0;
+        if(t < two_best) two_best = t;
+
+        ir_bytes = ir.cap * sizeof(*ir.v) + ir.words_cap * sizeof(*ir.words);
+
+        rewind(f);
+        t0 = now_sec();
+        if(assemble_onepass_stream(NULL, &cfg, f, &img1, &st1, &state1) != ERR_OK) return 1;
+        t = now_sec() - t0;
+        if(t < one_best) one_best = t;
+
+        same &= img.text_n == img1.text_n && memcmp(img.text, img1.text, img.text_n * sizeof(*img.text)) == 0 &&
+                img.data_n == img1.data_n && memcmp(img.data, img1.data, img.data_n * sizeof(*img.data)) == 0;
+
+        asm_image_free(&img, NULL);
+        asm_image_free(&img1, NULL);
+        ir_free(&ir, NULL);
+        symtab_free(&st, NULL);
+        symtab_free(&st1, NULL);
+
+    }
+
+    printf("lines=%zu\n  pass1 + pass2 : %8.3f ms  %6.2f M lines/s  IR held %.1f MiB\n", n, two_best * 1e3, (double)n / two_best / 1e6, (double)ir_bytes / (1024.0 * 1024.0));
+    printf("  one pass      : %8.3f ms  %6.2f M lines/s  no IR  %s\n", one_best * 1e3, (double)n / one_best / 1e6, same ? "identical" : "MISMATCH");
+
+    fclose(f);
+
+    return same ? 0 : 1;
+
+}
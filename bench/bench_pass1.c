@@ -0,0 +1,125 @@
+// bench_pass1: assemble_pass1 throughput on a generated program, serial against the thread pool
+// with 1, 2, 4 and all online CPUs. the parallel results are checked against the serial ones.
+//
+// usage: bench_pass1 [number_of_lines]
+
+#include "asm/pass1.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static char **make_program(size_t n){      // mostly .text, a .data block every 4096 lines
+
+    char **lines = malloc(n * sizeof(*lines));
+    if(!lines) return NULL;
+
+    for(size_t i = 0; i < n; i++){
+
+        char buf[96];
+        size_t block = i % 4096;
+
+        if(block == 0) snprintf(buf, sizeof(buf), ".text");
+        else if(block == 3840) snprintf(buf, sizeof(buf), ".data");
+        else if(block > 3840) snprintf(buf, sizeof(buf), "w%zu: .word %zu, -1, 0x7f", i, i);
+        else if(i % 8 == 0) snprintf(buf, sizeof(buf), "loop_%zu: add $t0, $t1, $t2   # labeled", i);
+        else if(i % 8 == 3) snprintf(buf, sizeof(buf), "    beq $t0, $zero, loop_%zu", i & ~(size_t)7);
+        else if(i % 8 == 5) snprintf(buf, sizeof(buf), "    lw $s0, %zu($sp)", (i * 4) & 0xFFF);
+        else snprintf(buf, sizeof(buf), "    addi $t%zu, $t%zu, %zu", i % 8, (i + 1) % 8, i & 0x7FFF);
+
+        lines[i] = strdup(buf);
+        if(!lines[i]) return NULL;
+
+    }
+
+    return lines;
+
+}
+
+
+static double run(const AsmConfig *cfg, char **lines, size_t n, IR *ir, Symtab *st, AsmState *state){
+
+    double best = 1e30;
+
+    for(int rep = 0; rep < 5; rep++){
+
+        if(rep){
+
+            ir_free(ir, NULL);
+            symtab_free(st, NULL);
+
+        }
+
+        double t0 = now_sec();
+        if(assemble_pass1(NULL, cfg, lines, n, ir, st, state) != ERR_OK) exit(1);
+
+        double t = now_sec() - t0;
+        if(t < best) best = t;
+
+    }
+
+    return best;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n = (argc > 1) ? strtoull(argv[1], NULL, 10) : 2000000;
+    char **lines = make_program(n);
+    if(!lines) return 1;
+
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    IR serial_ir;
+    Symtab serial_st;
+    AsmState serial_state;
+
+    double serial_sec = run(&serial_cfg, lines, n, &serial_ir, &serial_st, &serial_state);
+    printf("lines=%zu\n  serial      : %.3f s  %6.2f M lines/s\n", n, serial_sec, (double)n / serial_sec / 1e6);
+
+    const unsigned threads[] = {1, 2, 4, 0};
+
+    for(size_t k = 0; k < sizeof(threads) / sizeof(threads[0]); k++){
+
+        thread_pool *pool = create_thread_pool(NULL, threads[k]);
+        if(!pool) return 1;
+
+        const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pool = pool};
+        IR ir;
+        Symtab st;
+        AsmState state;
+
+        double sec = run(&cfg, lines, n, &ir, &st, &state);
+        int same = ir.n == serial_ir.n && memcmp(ir.v, serial_ir.v, ir.n * sizeof(*ir.v)) == 0 && ir.words_n == serial_ir.words_n &&
+                   memcmp(ir.words, serial_ir.words, ir.words_n * sizeof(*ir.words)) == 0 && st.n == serial_st.n &&
+                   memcmp(st.v, serial_st.v, st.n * sizeof(*st.v)) == 0 && memcmp(&state, &serial_state, sizeof(state)) == 0;
+
+        printf("  %2u threads  : %.3f s  %6.2f M lines/s  %.2fx  %s\n", thread_pool_size(pool), sec, (double)n / sec / 1e6, serial_sec / sec, same ? "identical" : "MISMATCH");
+
+        ir_free(&ir, NULL);
+        symtab_free(&st, NULL);
+        destroy_thread_pool(NULL, pool);
+
+        if(!same) return 1;
+
+    }
+
+    ir_free(&serial_ir, NULL);
+    symtab_free(&serial_st, NULL);
+
+    for(size_t i = 0; i < n; i++) free(lines[i]);
+    free(lines);
+
+    return 0;
+
+}
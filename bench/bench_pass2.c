@@ -0,0 +1,97 @@
+// bench_pass2: encoding throughput of pass 2 in instructions per second, on a generated program
+// with registers, immediates, memory operands, branches and jumps.
+//
+// usage: bench_pass2 [number_of_lines]
+
+#include "asm/pass1.h"
+#include "asm/pass2.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static char **make_program(size_t n){      // .text first, the last 1/16 of the lines are .data
+
+    char **lines = malloc(n * sizeof(*lines));
+    if(!lines) return NULL;
+
+    size_t data_from = n - n / 16;
+
+    for(size_t i = 0; i < n; i++){
+
+        char buf[96];
+
+        if(i == 0) snprintf(buf, sizeof(buf), ".text");
+        else if(i == data_from) snprintf(buf, sizeof(buf), ".data");
+        else if(i > data_from) snprintf(buf, sizeof(buf), "w%zu: .word %zu, -1", i, i);
+        else if(i % 8 == 1) snprintf(buf, sizeof(buf), "loop_%zu: add $t0, $t1, $t2", i);
+        else if(i % 8 == 3) snprintf(buf, sizeof(buf), "    beq $t0, $zero, loop_%zu", (i & ~(size_t)7) | 1);
+        else if(i % 8 == 5) snprintf(buf, sizeof(buf), "    lw $s0, %zu($sp)", (i * 4) & 0xFFF);
+        else if(i % 8 == 7) snprintf(buf, sizeof(buf), "    j loop_%zu", (i & ~(size_t)7) | 1);
+        else snprintf(buf, sizeof(buf), "    addi $t%zu, $t%zu, %zu", i % 8, (i + 1) % 8, i & 0x7FFF);
+
+        lines[i] = strdup(buf);
+        if(!lines[i]) return NULL;
+
+    }
+
+    return lines;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n = (argc > 1) ? strtoull(argv[1], NULL, 10) : 2000000;
+    char **lines = make_program(n);
+    if(!lines) return 1;
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    IR ir;
+    Symtab st;
+    AsmState state;
+
+    if(assemble_pass1(NULL, &cfg, lines, n, &ir, &st, &state) != ERR_OK) return 1;
+
+    double best = 1e30;
+    uint32_t check = 0;
+
+    for(int rep = 0; rep < 10; rep++){
+
+        AsmImage img;
+        double t0 = now_sec();
+
+        if(assemble_pass2(NULL, &cfg, &ir, &st, &state, &img) != ERR_OK) return 1;
+
+        double t = now_sec() - t0;
+        if(t < best) best = t;
+
+        check = img.text[img.text_n / 2] ^ img.data[0];
+        asm_image_free(&img, NULL);
+
+    }
+
+    size_t instrs = state.text_pc / 4;
+
+    printf("instructions=%zu  data words=%u  pass2 %.3f ms  %.1f M instructions/s  (check %08x)\n",
+           instrs, state.data_pc / 4, best * 1e3, (double)instrs / best / 1e6, check);
+
+    ir_free(&ir, NULL);
+    symtab_free(&st, NULL);
+
+    for(size_t i = 0; i < n; i++) free(lines[i]);
+    free(lines);
+
+    return 0;
+
+}
@@ -0,0 +1,162 @@
+// bench_pipeline: the streaming entry points serial against AsmConfig.pipelined (reader, scanner and pass 1 on
+// three threads), for pass 1 alone and for the one-pass assembler. the input is a generated file read through
+// its descriptor, best of 5. the pipelined results are checked against the serial ones.
+//
+// usage: bench_pipeline [number_of_lines]
+
+#include "asm/onepass.h"
+#include "asm/pass1.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static FILE *make_program(size_t n){      // mostly .text, a .data block every 4096 lines, every branch target defined
+
+    FILE *f = tmpfile();
+    if(!f) return NULL;
+
+    for(size_t i = 0; i < n; i++){
+
+        size_t block = i % 4096;
+
+        if(block == 0) fprintf(f, ".text\n");
+        else if(block == 3840) fprintf(f, ".data\n");
+        else if(block > 3840) fprintf(f, "w%zu: .word %zu, -1, 0x7f\n", i, i);
+        else if(i % 8 == 1) fprintf(f, "loop_%zu: add $t0, $t1, $t2   # labeled\n", i);
+        else if(i % 8 == 3) fprintf(f, "    beq $t0, $zero, loop_%zu\n", (i & ~(size_t)7) + 1);
+        else if(i % 8 == 5) fprintf(f, "    lw $s0, %zu($sp)\n", (i * 4) & 0xFFF);
+        else fprintf(f, "    addi $t%zu, $t%zu, %zu\n", i % 8, (i + 1) % 8, i & 0x7FFF);
+
+    }
+
+    fflush(f);
+
+    return f;
+
+}
+
+
+static double run_pass1(const AsmConfig *cfg, FILE *f, IR *ir, Symtab *st, AsmState *state){
+
+    double best = 1e30;
+
+    for(int rep = 0; rep < 5; rep++){
+
+        if(rep){
+
+            ir_free(ir, NULL);
+            symtab_free(st, NULL);
+
+        }
+
+        lseek(fileno(f), 0, SEEK_SET);
+
+        double t0 = now_sec();
+        if(assemble_pass1_fd(NULL, cfg, fileno(f), ir, st, state) != ERR_OK) exit(1);
+
+        double t = now_sec() - t0;
+        if(t < best) best = t;
+
+    }
+
+    return best;
+
+}
+
+
+static double run_onepass(const AsmConfig *cfg, FILE *f, AsmImage *img, Symtab *st, AsmState *state){
+
+    double best = 1e30;
+
+    for(int rep = 0; rep < 5; rep++){
+
+        if(rep){
+
+            asm_image_free(img, NULL);
+            symtab_free(st, NULL);
+
+        }
+
+        lseek(fileno(f), 0, SEEK_SET);
+
+        double t0 = now_sec();
+        if(assemble_onepass_fd(NULL, cfg, fileno(f), img, st, state) != ERR_OK) exit(1);
+
+        double t = now_sec() - t0;
+        if(t < best) best = t;
+
+    }
+
+    return best;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n = (argc > 1) ? strtoull(argv[1], NULL, 10) : 2000000;
+    FILE *f = make_program(n);
+    if(!f) return 1;
+
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig pipe_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pipelined = 1};
+
+    printf("lines=%zu  cpus=%ld\n", n, sysconf(_SC_NPROCESSORS_ONLN));
+
+    // pass 1
+
+    IR serial_ir, ir;
+    Symtab serial_st, st;
+    AsmState serial_state, state;
+
+    double serial_sec = run_pass1(&serial_cfg, f, &serial_ir, &serial_st, &serial_state);
+    double pipe_sec = run_pass1(&pipe_cfg, f, &ir, &st, &state);
+
+    int same = ir.n == serial_ir.n && memcmp(ir.v, serial_ir.v, ir.n * sizeof(*ir.v)) == 0 && ir.words_n == serial_ir.words_n &&
+               memcmp(ir.words, serial_ir.words, ir.words_n * sizeof(*ir.words)) == 0 && st.n == serial_st.n &&
+               memcmp(st.v, serial_st.v, st.n * sizeof(*st.v)) == 0 && memcmp(&state, &serial_state, sizeof(state)) == 0;
+
+    printf("  pass 1   serial    : %.3f s  %6.2f M lines/s\n", serial_sec, (double)n / serial_sec / 1e6);
+    printf("  pass 1   pipelined : %.3f s  %6.2f M lines/s  %.2fx  %s\n", pipe_sec, (double)n / pipe_sec / 1e6, serial_sec / pipe_sec, same ? "identical" : "MISMATCH");
+
+    ir_free(&serial_ir, NULL);
+    symtab_free(&serial_st, NULL);
+    ir_free(&ir, NULL);
+    symtab_free(&st, NULL);
+
+    if(!same) return 1;
+
+    // one pass: encoding runs with address assignment
+
+    AsmImage serial_img, img;
+
+    serial_sec = run_onepass(&serial_cfg, f, &serial_img, &serial_st, &serial_state);
+    pipe_sec = run_onepass(&pipe_cfg, f, &img, &st, &state);
+
+    same = img.text_n == serial_img.text_n && memcmp(img.text, serial_img.text, img.text_n * sizeof(*img.text)) == 0 &&
+           img.data_n == serial_img.data_n && memcmp(img.data, serial_img.data, img.data_n * sizeof(*img.data)) == 0;
+
+    printf("  one pass serial    : %.3f s  %6.2f M lines/s\n", serial_sec, (double)n / serial_sec / 1e6);
+    printf("  one pass pipelined : %.3f s  %6.2f M lines/s  %.2fx  %s\n", pipe_sec, (double)n / pipe_sec / 1e6, serial_sec / pipe_sec, same ? "identical" : "MISMATCH");
+
+    asm_image_free(&serial_img, NULL);
+    symtab_free(&serial_st, NULL);
+    asm_image_free(&img, NULL);
+    symtab_free(&st, NULL);
+    fclose(f);
+
+    return same ? 0 : 1;
+
+}
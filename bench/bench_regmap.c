@@ -0,0 +1,113 @@
+// bench_regmap: register tokens/sec of regmap_decode() against the old path of
+// parse_reg_name (copy into a NUL terminated buffer + 32 strcmp) it replaced.
+//
+// usage: bench_regmap [number_of_rounds]
+
+#include "core/regmap.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+// the decoder as it was before regmap_decode(), kept here as the baseline
+
+static int legacy_decode(const char *lex, size_t n){
+
+    if(n < 2 || lex[0] != '$') return -1;
+
+    if(isdigit((unsigned char)lex[1])){
+
+        long v = 0;
+        for(size_t i = 1; i < n; i++){
+
+            if(!isdigit((unsigned char)lex[i]) || v > 31) return -1;
+            v = v * 10 + (lex[i] - '0');
+
+        }
+
+        return (v <= 31) ? (int)v : -1;
+
+    }
+
+    char name[8];
+    if(n >= sizeof(name)) return -1;
+    memcpy(name, lex, n);
+    name[n] = '\0';
+
+    for(int r = 0; r < REG_FILE_SIZE; r++){
+
+        if(strcmp(name, regmap_name(r)) == 0) return r;
+
+    }
+
+    return -1;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t rounds = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+
+    // every canonical name, every number, and a few misses
+
+    static const char *extra[] = { "$0", "$8", "$17", "$31", "$32", "$t10", "$x", "$zer" };
+    size_t nextra = sizeof(extra) / sizeof(extra[0]);
+    size_t nkeys = REG_FILE_SIZE + nextra;
+
+    const char **keys = malloc(nkeys * sizeof(*keys));
+    size_t *lens = malloc(nkeys * sizeof(*lens));
+    if(!keys || !lens) return 1;
+
+    for(int r = 0; r < REG_FILE_SIZE; r++) keys[r] = regmap_name(r);
+    for(size_t i = 0; i < nextra; i++) keys[REG_FILE_SIZE + i] = extra[i];
+    for(size_t k = 0; k < nkeys; k++) lens[k] = strlen(keys[k]);
+
+    for(size_t k = 0; k < nkeys; k++){
+
+        if(legacy_decode(keys[k], lens[k]) != regmap_decode(keys[k], lens[k])){
+
+            fprintf(stderr, "decode mismatch on \"%s\"\n", keys[k]);
+            return 1;
+
+        }
+
+    }
+
+    volatile int sink = 0;
+    size_t decodes = rounds * nkeys;
+
+    double t0 = now_sec();
+
+    for(size_t r = 0; r < rounds; r++)
+        for(size_t k = 0; k < nkeys; k++) sink += legacy_decode(keys[k], lens[k]);
+
+    double old_sec = now_sec() - t0;
+
+    double t1 = now_sec();
+
+    for(size_t r = 0; r < rounds; r++)
+        for(size_t k = 0; k < nkeys; k++) sink += regmap_decode(keys[k], lens[k]);
+
+    double new_sec = now_sec() - t1;
+
+    printf("tokens=%zu decodes=%zu\n", nkeys, decodes);
+    printf("  before (copy + strcmp scan): %.3f s  %7.1f M tokens/s\n", old_sec, (double)decodes / old_sec / 1e6);
+    printf("  after  (regmap_decode)     : %.3f s  %7.1f M tokens/s  speedup %.2fx\n", new_sec, (double)decodes / new_sec / 1e6, old_sec / new_sec);
+
+    free(keys);
+    free(lens);
+    return 0;
+
+}
@@ -0,0 +1,282 @@
+// bench_scanner: bytes/sec of the fused scan_line() against the old
+// strncpy + strip_comment + trim_inplace + lex_line sequence of pass 1.
+//
+// usage: bench_scanner [number_of_lines]
+
+#include "front/lexer.h"
+#include "front/scanner.h"
+#include "front/preprocess.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+// the lexer as it was before scan_line(), kept here as the baseline, with its 88 byte token
+
+typedef struct{
+
+    TokKind kind;
+    char lexeme[64];
+    size_t line_no;
+    size_t column_no;
+
+}LegacyToken;
+
+typedef struct{
+
+    LegacyToken *v;
+    size_t n;
+    size_t cap;
+
+}LegacyTokenVec;
+
+
+static Err legacy_push(LegacyTokenVec *tv, const LegacyToken *t){
+
+    if(tv->n == tv->cap){
+
+        size_t new_cap = (tv->cap == 0)? 64 : tv->cap * 2;
+        LegacyToken *p = realloc(tv->v, sizeof(*p) * new_cap);
+        if(!p) return ERR_OOM;
+
+        tv->v = p;
+        tv->cap = new_cap;
+
+    }
+
+    tv->v[tv->n++] = *t;
+    return ERR_OK;
+
+}
+
+static TokKind legacy_classify_word(const char *w){
+
+    if(w[0] == '.') return TOK_DOT;
+    if(w[0] == '$') return TOK_REG;
+
+    char *end = NULL;
+    errno = 0;
+    strtol(w, &end, 0);
+
+    if(end && *end == '\0' && errno == 0) return TOK_INT;
+
+    return TOK_IDENT;
+
+}
+
+
+static Err legacy_lex_line(const char *line, int line_no, LegacyTokenVec *out){
+
+    Err e;
+    out->v = NULL;
+    out->n = out->cap = 0;
+
+    size_t i = 0;
+
+    while(line[i]){
+
+        while(line[i] && isspace((unsigned char)line[i])) i++;
+        if(!line[i]) break;
+
+        char c = line[i];
+        LegacyToken t = {0};
+        t.line_no = line_no;
+        t.column_no = i + 1;
+
+        if(c == ':' || c == ',' || c == '(' || c == ')'){
+
+            t.kind = (c == ':') ? TOK_COLON : (c == ',') ? TOK_COMMA : (c == '(') ? TOK_LPAREN : TOK_RPAREN;
+            t.lexeme[0] = c;
+            i++;
+            if((e = legacy_push(out, &t)) != ERR_OK) return e;
+            continue;
+
+        }
+
+        char buf[64];
+        size_t b = 0;
+
+        while(line[i] && !isspace((unsigned char)line[i]) && line[i] != ':' && line[i] != ',' && line[i] != '(' && line[i] != ')'){
+
+            if(b + 1 < sizeof(buf)) buf[b++] = line[i];
+            i++;
+
+        }
+
+        buf[b] = '\0';
+        t.kind = legacy_classify_word(buf);
+        strcpy(t.lexeme, buf);
+
+        if((e = legacy_push(out, &t)) != ERR_OK) return e;
+
+    }
+
+    return ERR_OK;
+
+}
+
+
+static const char *g_line_templates[] = {
+
+    "main:                    # program entry",
+    "    add $t0, $t1, $t2    # t0 = t1 + t2",
+    "    lw $t3, 16($sp)",
+    "loop_%zu: addi $t1, $t1, -1",
+    "    beq $t1, $zero, loop_%zu   # back edge",
+    "    sw $t3, -4($sp)",
+    "table_%zu: .word 1, 2, 3, 0x10, -7, 077",
+    "",
+    "    j main"
+
+};
+
+
+static int run_workload(const char *name, char **lines, const size_t *lens, size_t nlines){
+
+    size_t total_bytes = 0;
+    for(size_t i = 0; i < nlines; i++) total_bytes += lens[i] + 1;
+
+    size_t tokens_old = 0;
+
+    double t0 = now_sec();
+
+    for(size_t i = 0; i < nlines; i++){
+
+        char buf[1024];
+        strncpy(buf, lines[i], sizeof(buf) - 1);
+        buf[sizeof(buf) - 1] = '\0';
+
+        strip_comment(buf);
+        trim_inplace(buf);
+        if(buf[0] == '\0') continue;
+
+        LegacyTokenVec tv = {0};
+        if(legacy_lex_line(buf, (int)i + 1, &tv) != ERR_OK) return 1;
+        tokens_old += tv.n;
+        free(tv.v);
+
+    }
+
+    double old_sec = now_sec() - t0;
+
+    printf("[%s] lines=%zu bytes=%zu tokens=%zu\n", name, nlines, total_bytes, tokens_old);
+    printf("  before (strncpy+strip_comment+trim_inplace+lex_line): %.3f s  %7.1f MB/s\n", old_sec, (double)total_bytes / old_sec / 1e6);
+
+    static const ScanImpl impls[] = { SCAN_IMPL_SCALAR, SCAN_IMPL_SSE2, SCAN_IMPL_AVX2 };
+
+    for(size_t k = 0; k < sizeof(impls) / sizeof(impls[0]); k++){
+
+        if(scanner_select_impl(impls[k]) != impls[k]) continue;      // not supported on this CPU
+
+        size_t tokens_new = 0;
+        TokenVec tv = {0};
+
+        double t1 = now_sec();
+
+        for(size_t i = 0; i < nlines; i++){
+
+            if(scan_line(lines[i], lens[i], (int)i + 1, &tv, NULL) != ERR_OK) return 1;
+            tokens_new += tv.n;
+
+        }
+
+        double new_sec = now_sec() - t1;
+        tokenvec_free(&tv, NULL);
+
+        if(tokens_old != tokens_new){
+
+            fprintf(stderr, "token count mismatch (%s): %zu vs %zu\n", scanner_impl_name(impls[k]), tokens_old, tokens_new);
+            return 1;
+
+        }
+
+        printf("  after  (scan_line, %-6s)                          : %.3f s  %7.1f MB/s  speedup %.2fx\n",
+               scanner_impl_name(impls[k]), new_sec, (double)total_bytes / new_sec / 1e6, old_sec / new_sec);
+
+    }
+
+    scanner_select_impl(SCAN_IMPL_AUTO);
+
+    return 0;
+
+}
+
+
+static char *dup_line(const char *s, size_t n){
+
+    char *p = malloc(n + 1);
+    if(p){
+
+        memcpy(p, s, n);
+        p[n] = '\0';
+
+    }
+
+    return p;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t nlines = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t ntemplates = sizeof(g_line_templates) / sizeof(g_line_templates[0]);
+
+    char **lines = calloc(nlines + 1, sizeof(*lines));      // +1: the long line workload below uses nlines / 32 + 1 slots
+    size_t *lens = calloc(nlines + 1, sizeof(*lens));
+    if(!lines || !lens) return 1;
+
+    // workload 1: typical hand written lines, 20-40 bytes
+
+    for(size_t i = 0; i < nlines; i++){
+
+        char tmp[128];
+        int n = snprintf(tmp, sizeof(tmp), g_line_templates[i % ntemplates], i);
+
+        lens[i] = (size_t)n;
+        if(!(lines[i] = dup_line(tmp, lens[i]))) return 1;
+
+    }
+
+    int rc = run_workload("short lines", lines, lens, nlines);
+    for(size_t i = 0; i < nlines; i++) free(lines[i]);
+
+    // workload 2: generated .word tables with a long trailing comment, ~1000 bytes per line
+
+    size_t nlong = nlines / 32 + 1;
+
+    for(size_t i = 0; rc == 0 && i < nlong; i++){
+
+        char tmp[1024];
+        size_t n = (size_t)snprintf(tmp, sizeof(tmp), "tbl_%zu: .word 0", i);
+
+        for(size_t v = 1; v < 110; v++) n += (size_t)snprintf(tmp + n, sizeof(tmp) - n, ", %zu", (i * 7 + v) & 0xFFF);
+
+        n += (size_t)snprintf(tmp + n, sizeof(tmp) - n, "    # generated table, checksum %zu, do not edit by hand ............................", i);
+
+        lens[i] = n;
+        if(!(lines[i] = dup_line(tmp, n))) return 1;
+
+    }
+
+    if(rc == 0) rc = run_workload("long .word lines", lines, lens, nlong);
+    for(size_t i = 0; i < nlong; i++) free(lines[i]);
+
+    free(lines);
+    free(lens);
+
+    return rc;
+
+}
@@ -0,0 +1,108 @@
+// bench_session: a one line edit to a large program, assembled again by an assembler session
+// against assemble_pass1() from scratch.
+//
+// usage: bench_session [number_of_lines]
+
+#include "asm/session.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static char **make_program(size_t n){      // mostly .text, a .data block every 4096 lines
+
+    char **lines = malloc(n * sizeof(*lines));
+    if(!lines) return NULL;
+
+    for(size_t i = 0; i < n; i++){
+
+        char buf[96];
+        size_t block = i % 4096;
+
+        if(block == 0) snprintf(buf, sizeof(buf), ".text");
+        else if(block == 3840) snprintf(buf, sizeof(buf), ".data");
+        else if(block > 3840) snprintf(buf, sizeof(buf), "w%zu: .word %zu, -1, 0x7f", i, i);
+        else if(i % 8 == 0) snprintf(buf, sizeof(buf), "loop_%zu: add $t0, $t1, $t2   # labeled", i);
+        else if(i % 8 == 3) snprintf(buf, sizeof(buf), "    beq $t0, $zero, loop_%zu", i & ~(size_t)7);
+        else snprintf(buf, sizeof(buf), "    addi $t%zu, $t%zu, %zu", i % 8, (i + 1) % 8, i & 0x7FFF);
+
+        lines[i] = strdup(buf);
+        if(!lines[i]) return NULL;
+
+    }
+
+    return lines;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    char **lines = make_program(n);
+    if(!lines) return 1;
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    IR ir;
+    Symtab st;
+    AsmState state;
+
+    double t0 = now_sec();
+    if(assemble_pass1(NULL, &cfg, lines, n, &ir, &st, &state) != ERR_OK) return 1;
+    double full_sec = now_sec() - t0;
+
+    ir_free(&ir, NULL);
+    symtab_free(&st, NULL);
+
+    asm_session *s = create_asm_session(NULL, &cfg);
+    if(!s) return 1;
+
+    t0 = now_sec();
+    if(asm_session_load(NULL, s, lines, n) != ERR_OK) return 1;
+    double load_sec = now_sec() - t0;
+
+    // the same line edited at the start, the middle and the end of the program
+
+    const double where[] = {0.0, 0.5, 0.999};
+    char *edit[] = {"    addi $t0, $t0, 1"};
+
+    printf("lines=%zu\n  assemble_pass1 from scratch : %8.3f ms\n  asm_session_load            : %8.3f ms\n", n, full_sec * 1e3, load_sec * 1e3);
+
+    for(size_t k = 0; k < sizeof(where) / sizeof(where[0]); k++){
+
+        size_t line = (size_t)((double)n * where[k]) | 1;         // odd: never the .text/.data directives
+        const int reps = 20;
+
+        t0 = now_sec();
+
+        for(int r = 0; r < reps; r++){
+
+            if(asm_session_edit(NULL, s, line, 1, edit, 1) != ERR_OK) return 1;
+            if(asm_session_edit(NULL, s, line, 1, &lines[line], 1) != ERR_OK) return 1;        // and back
+
+        }
+
+        double sec = (now_sec() - t0) / (2 * reps);
+
+        printf("  one line edit at line %7zu  : %8.3f ms  %.0fx faster\n", line, sec * 1e3, full_sec / sec);
+
+    }
+
+    destroy_asm_session(NULL, s);
+
+    for(size_t i = 0; i < n; i++) free(lines[i]);
+    free(lines);
+
+    return 0;
+
+}
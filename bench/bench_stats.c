@@ -0,0 +1,118 @@
+// bench_stats: cost of the per stage counters of pass 1. the same generated program is assembled with
+// AsmConfig.stats NULL and set, interleaved, best of N; then the collected table is printed.
+// configure with -DENABLE_ASM_STATS=OFF to compare against a build without the probes.
+//
+// usage: bench_stats [number_of_lines] [reps]
+
+#include "asm/pass1.h"
+#include "core/stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#if MIPS_ASM_STATS
+#define PROBES "compiled"
+#else
+#define PROBES "compiled out"
+#endif
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static char **make_program(size_t n){      // mostly .text, a .data block every 4096 lines
+
+    char **lines = malloc(n * sizeof(*lines));
+    if(!lines) return NULL;
+
+    for(size_t i = 0; i < n; i++){
+
+        char buf[96];
+        size_t block = i % 4096;
+
+        if(block == 0) snprintf(buf, sizeof(buf), ".text");
+        else if(block == 3840) snprintf(buf, sizeof(buf), ".data");
+        else if(block > 3840) snprintf(buf, sizeof(buf), "w%zu: .word %zu, -1, 0x7f", i, i);
+        else if(i % 8 == 0) snprintf(buf, sizeof(buf), "loop_%zu: add $t0, $t1, $t2   # labeled", i);
+        else if(i % 8 == 3) snprintf(buf, sizeof(buf), "    beq $t0, $zero, loop_%zu", i & ~(size_t)7);
+        else if(i % 8 == 5) snprintf(buf, sizeof(buf), "    lw $s0, %zu($sp)", (i * 4) & 0xFFF);
+        else snprintf(buf, sizeof(buf), "    addi $t%zu, $t%zu, %zu", i % 8, (i + 1) % 8, i & 0x7FFF);
+
+        lines[i] = strdup(buf);
+        if(!lines[i]) return NULL;
+
+    }
+
+    return lines;
+
+}
+
+
+static double run_once(const AsmConfig *cfg, char **lines, size_t n){
+
+    IR ir;
+    Symtab st;
+    AsmState state;
+
+    double t0 = now_sec();
+    Err e = assemble_pass1(NULL, cfg, lines, n, &ir, &st, &state);
+    double t = now_sec() - t0;
+
+    if(e != ERR_OK){
+
+        fprintf(stderr, "pass 1 failed\n");
+        exit(1);
+
+    }
+
+    ir_free(&ir, NULL);
+    symtab_free(&st, NULL);
+
+    return t;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t n = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    int reps = (argc > 2) ? atoi(argv[2]) : 7;
+
+    char **lines = make_program(n);
+    if(!lines) return 1;
+
+    AsmStats stats;
+    const AsmConfig off_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig on_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .stats = &stats};
+    double best_off = 1e30, best_on = 1e30;
+
+    for(int rep = 0; rep < reps; rep++){
+
+        double t = run_once(&off_cfg, lines, n);
+        if(t < best_off) best_off = t;
+
+        asm_stats_reset(&stats);
+        t = run_once(&on_cfg, lines, n);
+        if(t < best_on) best_on = t;
+
+    }
+
+    printf("lines=%zu  probes %s\n  stats NULL : %8.3f ms\n  stats set  : %8.3f ms  (%+.2f%%)\n\n", n, PROBES,
+           best_off * 1e3, best_on * 1e3, (best_on / best_off - 1.0) * 100.0);
+
+    asm_stats_print(&stats, stdout, NULL);
+
+    for(size_t i = 0; i < n; i++) free(lines[i]);
+    free(lines);
+
+    return 0;
+
+}
@@ -0,0 +1,122 @@
+// bench_symtab: per operation cost of symtab_add() and symtab_lookup() from 1K to 1M labels.
+// the hash index should keep both flat; the old linear scan (quadratic insert) is measured
+// up to LEGACY_MAX_LABELS for comparison.
+//
+// usage: bench_symtab [max_labels]
+
+#include "core/symtab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#define LEGACY_MAX_LABELS 32000
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+// the symbol table as it was before the index, kept here as the baseline
+
+typedef struct{
+
+    char name[64];
+    uint32_t addr;
+
+}LegacySymbol;
+
+static int legacy_find(const LegacySymbol *v, size_t n, const char *name){
+
+    for(size_t i = 0; i < n; i++){
+
+        if(strcmp(v[i].name, name) == 0) return (int)i;
+
+    }
+
+    return -1;
+
+}
+
+
+static double legacy_add_all(char (*names)[32], size_t n, LegacySymbol *v){
+
+    double t0 = now_sec();
+
+    for(size_t i = 0; i < n; i++){
+
+        if(legacy_find(v, i, names[i]) >= 0) return -1;
+        strcpy(v[i].name, names[i]);
+        v[i].addr = (uint32_t)i;
+
+    }
+
+    return now_sec() - t0;
+
+}
+
+
+int main(int argc, char **argv){
+
+    size_t max_labels = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+
+    char (*names)[32] = malloc(max_labels * sizeof(*names));
+    LegacySymbol *legacy = malloc((max_labels < LEGACY_MAX_LABELS ? max_labels : LEGACY_MAX_LABELS) * sizeof(*legacy));
+    if(!names || !legacy) return 1;
+
+    for(size_t i = 0; i < max_labels; i++) snprintf(names[i], sizeof(names[i]), "loop_%zu_end", i);
+
+    printf("%10s %14s %14s %14s\n", "labels", "add ns/op", "lookup ns/op", "legacy add ns/op");
+
+    for(size_t n = 1000; n <= max_labels; n *= 10){
+
+        Symtab st;
+        if(symtab_init(&st, NULL) != ERR_OK) return 1;
+
+        double t0 = now_sec();
+
+        for(size_t i = 0; i < n; i++){
+
+            if(symtab_add(&st, names[i], (uint32_t)i, NULL) != ERR_OK) return 1;
+
+        }
+
+        double add_sec = now_sec() - t0;
+
+        // lookups in a scrambled order so the probe does not walk memory sequentially
+
+        uint32_t addr = 0;
+        size_t stride = 7919;
+        double t1 = now_sec();
+
+        for(size_t i = 0, k = 0; i < n; i++, k = (k + stride) % n){
+
+            if(symtab_lookup(&st, names[k], &addr, NULL) != ERR_OK || addr != k) return 1;
+
+        }
+
+        double lookup_sec = now_sec() - t1;
+
+        symtab_free(&st, NULL);
+
+        if(n <= LEGACY_MAX_LABELS){
+
+            double legacy_sec = legacy_add_all(names, n, legacy);
+            printf("%10zu %14.1f %14.1f %14.1f\n", n, add_sec * 1e9 / (double)n, lookup_sec * 1e9 / (double)n, legacy_sec * 1e9 / (double)n);
+
+        }
+        else printf("%10zu %14.1f %14.1f %14s\n", n, add_sec * 1e9 / (double)n, lookup_sec * 1e9 / (double)n, "skipped");
+
+    }
+
+    free(names);
+    free(legacy);
+    return 0;
+
+}
@@ -0,0 +1,416 @@
+// mips_bench: stage by stage throughput of the assembler front end on a generated program.
+//
+// the program is written to a temporary file, then every stage runs over all of it in batches of BENCH_BATCH lines:
+// read_all_lines, preprocess (strip_comment + trim_inplace), lex_line, parse_line, symtab_add (label definitions)
+// and ir_push. each stage is timed on its own and counts the heap allocations it makes.
+// output is one JSON document on stdout; with --reps the fastest run of every stage is kept.
+//
+// usage: mips_bench [--lines N] [--label-density F] [--word-ratio F] [--words-per-line K] [--line-length L]
+//                   [--seed S] [--reps R]
+
+#include "core/error_handling.h"
+#include "core/ir.h"
+#include "core/line.h"
+#include "core/strpool.h"
+#include "core/symtab.h"
+#include "front/lexer.h"
+#include "front/parser.h"
+#include "front/preprocess.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+
+#define BENCH_BATCH 4096
+
+
+// allocation counting: the executable's malloc family wins over libc's, every call is counted and forwarded
+
+#ifdef __GLIBC__
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void __libc_free(void *p);
+
+static size_t g_allocs;
+
+void *malloc(size_t size){ g_allocs++; return __libc_malloc(size); }
+void *calloc(size_t n, size_t size){ g_allocs++; return __libc_calloc(n, size); }
+void *realloc(void *p, size_t size){ g_allocs++; return __libc_realloc(p, size); }
+void free(void *p){ __libc_free(p); }
+
+#define BENCH_ALLOCS_COUNTED 1
+
+#else
+
+static size_t g_allocs;
+#define BENCH_ALLOCS_COUNTED 0
+
+#endif
+
+
+typedef struct{
+
+    size_t lines;
+    double label_density;       // share of statements with a label definition
+    double word_ratio;          // share of lines that are .word directives, all in one .data section at the end
+    size_t words_per_line;
+    size_t line_length;         // lines shorter than this are padded with a comment, 0: no padding
+    unsigned seed;
+    int reps;
+
+}BenchConfig;
+
+typedef enum{
+
+    STAGE_READ,
+    STAGE_PREPROCESS,
+    STAGE_LEX,
+    STAGE_PARSE,
+    STAGE_SYMTAB,
+    STAGE_IR,
+    STAGE_COUNT
+
+}Stage;
+
+static const char *const stage_names[STAGE_COUNT] = {"read_all_lines", "preprocess", "lex_line", "parse_line", "symtab_add", "ir_push"};
+static const char *const stage_units[STAGE_COUNT] = {"lines", "lines", "lines", "lines", "labels", "statements"};
+
+typedef struct{
+
+    double seconds;
+    size_t items;
+    size_t bytes;
+    size_t allocs;
+
+}StageStats;
+
+
+static double now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+}
+
+
+static unsigned next_rand(unsigned *state){      // xorshift32, the same program for the same seed everywhere
+
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return *state = x;
+
+}
+
+
+static int chance(unsigned *state, double p){ return (double)(next_rand(state) % 1000000u) < p * 1000000.0; }
+
+
+static int generate(const BenchConfig *cfg, FILE *f, size_t *out_bytes){
+
+    unsigned rng = cfg->seed ? cfg->seed : 1;
+    size_t data_from = cfg->lines - (size_t)((double)cfg->lines * cfg->word_ratio);
+    size_t labels = 0;
+    char line[4096];
+    long start = ftell(f);
+
+    for(size_t i = 0; i < cfg->lines; i++){
+
+        int n;
+        int label = chance(&rng, cfg->label_density);
+
+        if(i == 0) n = snprintf(line, sizeof(line), ".text");
+        else if(i == data_from) n = snprintf(line, sizeof(line), ".data");
+        else if(i > data_from){
+
+            n = label ? snprintf(line, sizeof(line), "D%zu: .word", i) : snprintf(line, sizeof(line), "    .word");
+
+            for(size_t k = 0; k < cfg->words_per_line && n < (int)sizeof(line) - 24; k++){
+
+                n += snprintf(line + n, sizeof(line) - (size_t)n, "%s%d", k ? ", " : " ", (int)(next_rand(&rng) % 200001) - 100000);
+
+            }
+
+        }
+        else{
+
+            char prefix[32] = "    ";
+            if(label) snprintf(prefix, sizeof(prefix), "L%zu: ", labels);
+
+            switch(next_rand(&rng) % 6){
+
+                case 0: n = snprintf(line, sizeof(line), "%sadd $t%u, $t%u, $s%u", prefix, next_rand(&rng) % 8, next_rand(&rng) % 8, next_rand(&rng) % 8); break;
+                case 1: n = snprintf(line, sizeof(line), "%ssub $s%u, $t%u, $t%u", prefix, next_rand(&rng) % 8, next_rand(&rng) % 8, next_rand(&rng) % 8); break;
+                case 2: n = snprintf(line, sizeof(line), "%saddi $t%u, $t%u, %d", prefix, next_rand(&rng) % 8, next_rand(&rng) % 8, (int)(next_rand(&rng) % 65536) - 32768); break;
+                case 3: n = snprintf(line, sizeof(line), "%slw $t%u, %u($sp)", prefix, next_rand(&rng) % 8, (next_rand(&rng) % 1024) * 4); break;
+                case 4: n = snprintf(line, sizeof(line), "%ssw $t%u, %u($gp)", prefix, next_rand(&rng) % 8, (next_rand(&rng) % 1024) * 4); break;
+                default: n = labels ? snprintf(line, sizeof(line), "%sbeq $t0, $zero, L%u", prefix, next_rand(&rng) % (unsigned)labels)
+                                    : snprintf(line, sizeof(line), "%sadd $t0, $t0, $t0", prefix); break;
+
+            }
+
+            if(label) labels++;
+
+        }
+
+        if(cfg->line_length > (size_t)n + 2 && cfg->line_length < sizeof(line)){
+
+            line[n++] = ' ';
+            line[n++] = '#';
+            while((size_t)n < cfg->line_length) line[n++] = 'x';
+            line[n] = '\0';
+
+        }
+
+        fputs(line, f);
+        fputc('\n', f);
+
+    }
+
+    if(fflush(f) != 0) return 0;
+
+    *out_bytes = (size_t)(ftell(f) - start);
+
+    return 1;
+
+}
+
+
+static void stage_add(StageStats *s, double t0, size_t allocs0, size_t items, size_t bytes){
+
+    s->seconds += now_sec() - t0;
+    s->allocs += g_allocs - allocs0;
+    s->items += items;
+    s->bytes += bytes;
+
+}
+
+
+static int run_once(app_context *app, FILE *f, StageStats *stats){
+
+    memset(stats, 0, sizeof(*stats) * STAGE_COUNT);
+    rewind(f);
+
+    // read
+
+    LineList list;
+    size_t allocs0 = g_allocs;
+    double t0 = now_sec();
+
+    if(read_all_lines(app, f, &list) != ERR_OK) return 0;
+
+    size_t n = list.n;
+    stage_add(&stats[STAGE_READ], t0, allocs0, n, 0);
+
+    size_t read_bytes = 0;
+    for(size_t i = 0; i < n; i++) read_bytes += strlen(list.v[i].text);
+    stats[STAGE_READ].bytes = read_bytes;
+
+    // preprocess
+
+    allocs0 = g_allocs;
+    t0 = now_sec();
+
+    for(size_t i = 0; i < n; i++){
+
+        strip_comment(list.v[i].text);
+        trim_inplace(list.v[i].text);
+
+    }
+
+    stage_add(&stats[STAGE_PREPROCESS], t0, allocs0, n, read_bytes);
+
+    // lex, parse, symtab, ir: batch by batch, every stage timed over the whole batch
+
+    static TokenVec tvs[BENCH_BATCH];
+    static Statement statements[BENCH_BATCH];
+
+    StrPool pool;
+    Symtab symtab;
+    IR ir;
+    Arena arena;
+
+    if(strpool_init(&pool, app) != ERR_OK || symtab_init(&symtab, app) != ERR_OK || ir_init(&ir, app) != ERR_OK || arena_init(&arena, 0, app) != ERR_OK) return 0;
+
+    ArenaMark batch_start = arena_mark(&arena);
+    uint32_t addr = 0;
+    int ok = 1;
+
+    for(size_t first = 0; ok && first < n; first += BENCH_BATCH){
+
+        size_t count = (n - first < BENCH_BATCH) ? n - first : BENCH_BATCH;
+        size_t batch_bytes = 0;
+
+        allocs0 = g_allocs;
+        t0 = now_sec();
+
+        for(size_t k = 0; k < count; k++){
+
+            if(lex_line(list.v[first + k].text, (int)(first + k) + 1, &tvs[k], app) != ERR_OK) ok = 0;
+            batch_bytes += tvs[k].src_len;
+
+        }
+
+        stage_add(&stats[STAGE_LEX], t0, allocs0, count, batch_bytes);
+
+        size_t parsed = 0;
+        allocs0 = g_allocs;
+        t0 = now_sec();
+
+        for(size_t k = 0; ok && k < count; k++){
+
+            if(tvs[k].n == 0) continue;
+
+            int has_label = 0;
+            if(parse_line(app, &arena, &pool, &tvs[k], (int)(first + k) + 1, &has_label, &statements[parsed]) != ERR_OK) ok = 0;
+            else parsed++;
+
+        }
+
+        stage_add(&stats[STAGE_PARSE], t0, allocs0, count, batch_bytes);
+
+        size_t labels = 0, label_bytes = 0;
+        allocs0 = g_allocs;
+        t0 = now_sec();
+
+        for(size_t k = 0; ok && k < parsed; k++){
+
+            const Statement *s = &statements[k];
+            StrId name = (s->kind == ST_LABEL) ? s->as.label.name : (s->kind == ST_LABEL_PLUS_INSTR) ? s->as.label_plus_instr.name :
+                         (s->kind == ST_LABEL_PLUS_DIR_WORD) ? s->as.label_plus_dir_word.name : STRID_NONE;
+
+            addr += 4;
+            if(name == STRID_NONE) continue;
+
+            if(symtab_add(&symtab, strpool_str(&pool, name), addr, app) != ERR_OK) ok = 0;
+            labels++;
+            label_bytes += pool.v[name].len;
+
+        }
+
+        stage_add(&stats[STAGE_SYMTAB], t0, allocs0, labels, label_bytes);
+
+        allocs0 = g_allocs;
+        t0 = now_sec();
+
+        for(size_t k = 0; ok && k < parsed; k++){
+
+            if(ir_push(&ir, &statements[k], app) != ERR_OK) ok = 0;
+
+        }
+
+        stage_add(&stats[STAGE_IR], t0, allocs0, parsed, parsed * sizeof(IrRec));
+
+        for(size_t k = 0; k < count; k++) tokenvec_free(&tvs[k], app);
+        arena_rewind(&arena, batch_start);
+
+    }
+
+    arena_free(&arena, app);
+    ir_free(&ir, app);
+    symtab_free(&symtab, app);
+    strpool_free(&pool, app);
+
+    line_list_free(&list, app);
+
+    return ok;
+
+}
+
+
+static int parse_args(int argc, char **argv, BenchConfig *cfg){
+
+    for(int i = 1; i < argc; i++){
+
+        if(i + 1 >= argc) return 0;
+
+        const char *flag = argv[i];
+        const char *value = argv[++i];
+
+        if(strcmp(flag, "--lines") == 0) cfg->lines = strtoull(value, NULL, 10);
+        else if(strcmp(flag, "--label-density") == 0) cfg->label_density = strtod(value, NULL);
+        else if(strcmp(flag, "--word-ratio") == 0) cfg->word_ratio = strtod(value, NULL);
+        else if(strcmp(flag, "--words-per-line") == 0) cfg->words_per_line = strtoull(value, NULL, 10);
+        else if(strcmp(flag, "--line-length") == 0) cfg->line_length = strtoull(value, NULL, 10);
+        else if(strcmp(flag, "--seed") == 0) cfg->seed = (unsigned)strtoul(value, NULL, 10);
+        else if(strcmp(flag, "--reps") == 0) cfg->reps = atoi(value);
+        else return 0;
+
+    }
+
+    return cfg->lines >= 2 && cfg->label_density >= 0 && cfg->label_density <= 1 && cfg->word_ratio >= 0 && cfg->word_ratio < 1 &&
+           cfg->words_per_line >= 1 && cfg->reps >= 1;
+
+}
+
+
+int main(int argc, char **argv){
+
+    BenchConfig cfg = {.lines = 1000000, .label_density = 0.1, .word_ratio = 0.1, .words_per_line = 4, .line_length = 0, .seed = 1, .reps = 1};
+
+    if(!parse_args(argc, argv, &cfg)){
+
+        fprintf(stderr, "usage: %s [--lines N] [--label-density F] [--word-ratio F] [--words-per-line K] [--line-length L] [--seed S] [--reps R]\n", argv[0]);
+        return 2;
+
+    }
+
+    app_context *app = create_app_context("/dev/null");
+    FILE *f = tmpfile();
+    size_t file_bytes = 0;
+
+    if(!app || !f || !generate(&cfg, f, &file_bytes)) return 1;
+
+    StageStats best[STAGE_COUNT], run[STAGE_COUNT];
+
+    for(int rep = 0; rep < cfg.reps; rep++){
+
+        if(!run_once(app, f, run)){
+
+            fprintf(stderr, "mips_bench: the generated program did not assemble\n");
+            return 1;
+
+        }
+
+        for(int s = 0; s < STAGE_COUNT; s++){
+
+            if(rep == 0 || run[s].seconds < best[s].seconds) best[s] = run[s];
+
+        }
+
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("{\n  \"config\": {\"lines\": %zu, \"label_density\": %g, \"word_ratio\": %g, \"words_per_line\": %zu, \"line_length\": %zu, \"seed\": %u, \"reps\": %d, \"file_bytes\": %zu},\n",
+           cfg.lines, cfg.label_density, cfg.word_ratio, cfg.words_per_line, cfg.line_length, cfg.seed, cfg.reps, file_bytes);
+    printf("  \"allocations_counted\": %s,\n  \"peak_rss_kib\": %ld,\n  \"stages\": [\n", BENCH_ALLOCS_COUNTED ? "true" : "false", usage.ru_maxrss);
+
+    for(int s = 0; s < STAGE_COUNT; s++){
+
+        const StageStats *st = &best[s];
+        double secs = st->seconds > 0 ? st->seconds : 1e-9;
+
+        printf("    {\"stage\": \"%s\", \"unit\": \"%s\", \"items\": %zu, \"bytes\": %zu, \"seconds\": %.6f, \"items_per_sec\": %.0f, \"bytes_per_sec\": %.0f, \"allocations\": %zu}%s\n",
+               stage_names[s], stage_units[s], st->items, st->bytes, st->seconds, (double)st->items / secs, (double)st->bytes / secs, st->allocs,
+               (s + 1 < STAGE_COUNT) ? "," : "");
+
+    }
+
+    printf("  ]\n}\n");
+
+    fclose(f);
+    destroy_app_context(app);
+
+    return 0;
+
+}
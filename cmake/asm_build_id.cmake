@@ -0,0 +1,30 @@
+# Writes MIPS_ASM_BUILD_ID to OUTPUT: a hash of every source the assembler is built from.
+# The assembly cache keys its entries with it, so a changed assembler never reads old entries.
+#
+# cmake -DSOURCE_DIR=<repo> -DOUTPUT=<header> -P asm_build_id.cmake
+
+file(GLOB_RECURSE sources ${SOURCE_DIR}/src/*.c ${SOURCE_DIR}/include/*.h ${SOURCE_DIR}/include/*.def ${SOURCE_DIR}/tools/*.c)
+list(SORT sources)
+
+set(ids "")
+
+foreach(f IN LISTS sources)
+
+    file(SHA256 ${f} h)
+    file(RELATIVE_PATH rel ${SOURCE_DIR} ${f})
+    string(APPEND ids "${rel}:${h};")
+
+endforeach()
+
+string(SHA256 id "${ids}")
+string(SUBSTRING ${id} 0 32 id)
+
+set(content "// generated by cmake/asm_build_id.cmake, do not edit\n#define MIPS_ASM_BUILD_ID \"${id}\"\n")
+
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} old)
+endif()
+
+if(NOT "${old}" STREQUAL "${content}")         # untouched when nothing changed, no needless rebuild
+    file(WRITE ${OUTPUT} "${content}")
+endif()
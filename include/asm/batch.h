@@ -0,0 +1,61 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "asm/pass1.h"
+#include "core/arena.h"
+#include "core/thread_pool.h"
+
+// batch assembly: many independent source files, one task per file on a thread pool.
+//
+// every task assembles its file (pass 1 + pass 2, or the on-disk cache) on its own child context and its own arena,
+// so workers share nothing but the pool. the children are merged into the caller's context in file order once the
+// batch is done: results and log are the same for any number of threads.
+
+typedef struct{
+
+    const char **paths;     // NUL terminated, copied into arena
+    size_t n;
+    size_t cap;
+    Arena arena;
+
+}AsmBatchList;
+
+typedef struct{
+
+    AsmConfig config;           // only the bases are used: every file gets its own arena and no pool
+    thread_pool *pool;          // NULL: the files are assembled one after the other on the calling thread
+    const char *cache_dir;      // optional: asm_cache_assemble_file() on this directory
+
+}AsmBatchConfig;
+
+typedef struct{
+
+    Err result;
+    size_t text_words;
+    size_t data_words;
+    size_t symbols;
+    int cache_hit;
+    uint64_t ns;                // wall time of the task
+
+}AsmBatchResult;
+
+
+Err asm_batch_list_init(AsmBatchList *list, app_context *app_context_param);
+
+Err asm_batch_list_add(AsmBatchList *list, const char *path, size_t len, app_context *app_context_param);
+
+// one path per line, surrounding blanks are dropped, so are empty lines and lines starting with '#'
+
+Err asm_batch_list_read_manifest(AsmBatchList *list, const char *manifest_path, app_context *app_context_param);
+
+Err asm_batch_list_free(AsmBatchList *list, app_context *app_context_param);
+
+// out_results has list->n entries, in list order. returns the first error in list order, every file is tried anyway.
+
+Err asm_batch_assemble(app_context *app_context_param, const AsmBatchConfig *config, const AsmBatchList *list, AsmBatchResult *out_results);
+
+const char *asm_batch_err_name(Err e);
+
+#endif
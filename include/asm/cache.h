@@ -0,0 +1,70 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "asm/pass1.h"
+#include "asm/pass2.h"
+
+// content-addressed cache of assembled programs on disk.
+//
+// an entry is keyed by a 128-bit hash of the source bytes, the AsmConfig bases and the assembler build id
+// (a hash of the assembler sources, generated at build time), so editing the assembler invalidates every entry.
+// the entry file is the loaded layout itself: a hit is open + mmap + header check, the views below point into
+// the mapping. entries are written to a temporary file and renamed, readers never see a partial one.
+// a file that does not pass the header check is a miss, never an error.
+
+typedef struct asm_cached_program_t asm_cached_program;
+
+typedef struct{
+
+    uint64_t source[2];     // hash of the source bytes
+    uint32_t text_base;
+    uint32_t data_base;
+
+}AsmCacheKey;
+
+typedef struct{
+
+    uint32_t name;          // offset of the NUL terminated name in AsmCachedView.names
+    uint32_t addr;
+
+}AsmCachedSymbol;
+
+typedef struct{
+
+    const uint32_t *text;           // the images, as assemble_pass2() gives them
+    size_t text_n;
+    const uint32_t *data;
+    size_t data_n;
+    uint32_t text_base;
+    uint32_t data_base;
+
+    const uint32_t *text_lines;     // line map: source line (1 based) of every text word
+    const uint32_t *data_lines;     // and of the .word every data word comes from
+
+    const AsmCachedSymbol *symbols; // Symtab order
+    size_t n_symbols;
+    const char *names;
+
+    AsmState state;                 // final state of pass 1
+
+}AsmCachedView;
+
+
+void asm_cache_key(const char *source, size_t len, const AsmConfig *config, AsmCacheKey *out_key);
+
+Err asm_cache_lookup(app_context *app_context_param, const char *cache_dir, const AsmCacheKey *key, asm_cached_program **out_program);     // miss: ERR_OK and *out_program NULL
+
+Err asm_cache_store(app_context *app_context_param, const char *cache_dir, const AsmCacheKey *key,
+                    const IR *ir, const Symtab *symtab, const AsmState *final_state, const AsmImage *image);
+
+// the whole flow for one source file: a hit maps the entry, a miss runs pass 1 + pass 2, stores and maps the new entry.
+Err asm_cache_assemble_file(app_context *app_context_param, const char *cache_dir, const AsmConfig *config, const char *source_path,
+                            asm_cached_program **out_program, int *out_hit);
+
+const AsmCachedView *asm_cached_view(const asm_cached_program *program);
+
+Err destroy_asm_cached_program(app_context *app_context_param, asm_cached_program *program);
+
+#endif
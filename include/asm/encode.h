@@ -0,0 +1,128 @@
+#ifndef ENCODE_H
+#define ENCODE_H
+
+#include <stdint.h>
+#include "core/error_handling.h"
+#include "core/ir.h"
+#include "core/isa_mips.h"
+
+// instruction encoding shared by pass 2 and the one-pass mode.
+// asm_encode_instr() packs everything a record knows on its own, a branch offset or jump target is ORed in
+// by asm_encode_target() once the label address is known. errors are reported with the source line.
+
+typedef struct{
+
+    uint32_t base;              // opcode and funct in place
+    uint8_t reg_shift[3];       // bit position of register slot i of IrRec.regs
+    uint8_t imm_kind;           // ImmKind
+
+}EncodeRule;
+
+extern const EncodeRule asm_encode_rules[ISA_COUNT];       // built from isa_mips.def at compile time
+
+static inline ImmKind asm_label_kind(const IrRec *r){      // IMM_BRANCH16 / IMM_J26 for an instruction with a label operand, else IMM_NONE
+
+    ImmKind kind = (ImmKind)asm_encode_rules[r->op].imm_kind;
+    return (kind == IMM_BRANCH16 || kind == IMM_J26) ? kind : IMM_NONE;
+
+}
+
+void asm_report(app_context *app_context_param, uint32_t line_no, const char *message);
+
+
+static inline Err asm_encode_instr(app_context *app_context_param, const IrRec *r, uint32_t *out_word){
+
+    const EncodeRule *rule = &asm_encode_rules[r->op];
+    uint32_t w = rule->base;
+
+    // unused register fields of regs are zero, so the three slots need no look at the spec
+    w |= (uint32_t)ir_rec_reg(r, 0) << rule->reg_shift[0] | (uint32_t)ir_rec_reg(r, 1) << rule->reg_shift[1] | (uint32_t)ir_rec_reg(r, 2) << rule->reg_shift[2];
+
+    switch((ImmKind)rule->imm_kind){
+
+        case IMM_SIGNED16:{
+
+            int32_t v = (int32_t)r->val;
+
+            if(v < INT16_MIN || v > INT16_MAX){
+
+                asm_report(app_context_param, r->line_no, "IMMEDIATE DOES NOT FIT IN 16 BITS");
+                return ERR_SYNTAX;
+
+            }
+
+            w |= (uint32_t)v & 0xFFFFu;
+            break;
+
+        }
+
+        case IMM_UNSIGNED16:
+
+            if(r->val > 0xFFFFu){
+
+                asm_report(app_context_param, r->line_no, "IMMEDIATE DOES NOT FIT IN 16 BITS");
+                return ERR_SYNTAX;
+
+            }
+
+            w |= r->val;
+            break;
+
+        case IMM_SHAMT5:
+
+            if(r->val > 31u){
+
+                asm_report(app_context_param, r->line_no, "SHIFT AMOUNT OUT OF RANGE");
+                return ERR_SYNTAX;
+
+            }
+
+            w |= r->val << 6;
+            break;
+
+        default:        // labels: asm_encode_target()
+            break;
+
+    }
+
+    *out_word = w;
+
+    return ERR_OK;
+
+}
+
+
+static inline Err asm_encode_target(app_context *app_context_param, uint32_t line_no, ImmKind kind, uint32_t pc, uint32_t target, uint32_t *word){       // pc of the instruction itself
+
+    if(kind == IMM_BRANCH16){
+
+        int64_t offset = ((int64_t)target - ((int64_t)pc + 4)) / 4;      // in words, from the delay slot
+
+        if((target & 3u) || offset < INT16_MIN || offset > INT16_MAX){
+
+            asm_report(app_context_param, line_no, "BRANCH TARGET OUT OF RANGE");
+            return ERR_SYNTAX;
+
+        }
+
+        *word |= (uint32_t)offset & 0xFFFFu;
+
+    }
+    else if(kind == IMM_J26){
+
+        if((target & 3u) || ((pc + 4) & 0xF0000000u) != (target & 0xF0000000u)){      // same 256 MB region as the delay slot
+
+            asm_report(app_context_param, line_no, "JUMP TARGET OUT OF RANGE");
+            return ERR_SYNTAX;
+
+        }
+
+        *word |= (target >> 2) & 0x03FFFFFFu;
+
+    }
+
+    return ERR_OK;
+
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef ONEPASS_H
+#define ONEPASS_H
+
+#include <stdio.h>
+#include "asm/pass1.h"
+#include "asm/pass2.h"
+
+// one-pass mode for streamed input: every line is read, parsed, given its address and encoded once, no IR is kept.
+// a branch or jump to a label that is not defined yet is encoded without its target and chained on that label;
+// the chain is patched when the label shows up. a reference still chained at end of input is ERR_UNDEF_LABEL.
+//
+// the image and Symtab are the same as assemble_pass1() + assemble_pass2() give; the images grow while they are
+// written since their size is only known at the end. config->arena, when set, backs image and Symtab.
+
+Err assemble_onepass_stream(app_context *app_context_param, const AsmConfig *config, FILE *input, AsmImage *out_image, Symtab *out_symtab, AsmState *out_final_state);
+
+Err assemble_onepass_fd(app_context *app_context_param, const AsmConfig *config, int fd, AsmImage *out_image, Symtab *out_symtab, AsmState *out_final_state);
+
+#endif
@@ -4,6 +4,12 @@
 
 #include "core/ir.h"
 #include "core/symtab.h"
+#include "core/arena.h"
+#include "core/line.h"
+#include "core/thread_pool.h"
+#include "core/diag.h"
+#include "core/stats.h"
+#include <stdio.h>
 
 typedef struct{
 
@@ -17,11 +23,32 @@ typedef struct{
 
     uint32_t text_base;
     uint32_t data_base;
+    Arena *arena;           // optional: IR, Symtab, tokens and statement parts are carved from it.
+                            // the caller releases all of it with arena_free() instead of ir_free()/symtab_free().
+    thread_pool *pool;      // optional: assemble_pass1() and assemble_pass1_mapped() lex and parse in parallel on it,
+                            // with output identical to the serial pass. the streaming entry points ignore it.
+    DiagList *diagnostics;  // optional: error recovery. a line with an error is reported here and skipped, pass 1 goes on
+                            // with the next one and returns the first error code once the whole input is read.
+                            // nothing is printed, diag_emit() writes the list out.
+    AsmStats *stats;        // optional: per stage counters, added to what it already holds (see core/stats.h)
+    int pipelined;          // streaming entry points only: reading, scanning + parsing and the rest of pass 1 run on three
+                            // threads connected by bounded queues (see asm/pass1_pipeline.h), output identical to the serial stream
 
 }AsmConfig;
 
+// label names in out_ir are StrIds of out_symtab->names, the IR must not outlive the Symtab.
+
 Err assemble_pass1(app_context *app_context_param, const AsmConfig *config, char **lines, size_t nlines, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state);
 
+Err assemble_pass1_mapped(app_context *app_context_param, const AsmConfig *config, const mapped_program *program, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state);
+
+// streaming entry points: input is consumed through a window of fixed size, doubled only while a longer line does not fit.
+// out_ir may be NULL to keep only Symtab + final state.
+
+Err assemble_pass1_stream(app_context *app_context_param, const AsmConfig *config, FILE *input, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state);
+
+Err assemble_pass1_fd(app_context *app_context_param, const AsmConfig *config, int fd, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state);
+
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef PASS1_PARALLEL_H
+#define PASS1_PARALLEL_H
+
+#include <stddef.h>
+#include "asm/pass1.h"
+#include "core/line.h"
+
+// parallel engine behind assemble_pass1() and assemble_pass1_mapped() when AsmConfig.pool is set.
+//
+// the lines are cut into chunks that are scanned and parsed on the pool, each into its own IR and StrPool,
+// together with a summary of what the chunk does to the sections. the merge then walks the chunks in order:
+// the section and pcs at every chunk start follow from a prefix sum over those summaries, labels go to the
+// Symtab in source order and every record is copied with its StrIds remapped to the global pool.
+// the result is bit-identical to the serial pass.
+//
+// any error of the input (syntax, section, duplicate label) sets *out_rerun_serial instead of being reported:
+// the caller then runs the serial pass, which reports it exactly as it always does.
+
+typedef LineView (*pass1_line_at_fn)(const void *source, size_t index);
+
+#define PASS1_PARALLEL_MIN_CHUNK_LINES 1024         // smaller inputs are not worth a hand-off to the pool
+
+Err pass1_parallel(app_context *app_context_param, const AsmConfig *config, pass1_line_at_fn line_at, const void *source, size_t nlines,
+                   IR *out_ir, Symtab *out_symtab, AsmState *out_final_state, int *out_rerun_serial);
+
+#endif
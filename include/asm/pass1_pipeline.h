@@ -0,0 +1,71 @@
+#ifndef PASS1_PIPELINE_H
+#define PASS1_PIPELINE_H
+
+#include <stddef.h>
+#include "asm/pass1.h"
+#include "asm/pass1_stream.h"
+#include "core/ir.h"
+#include "core/strpool.h"
+
+// pipelined engine behind the streaming entry points when AsmConfig.pipelined is set.
+//
+// three stages, each on its own thread:
+//   reader   fills batches of whole source lines with read_fn, a window of PASS1_STREAM_WINDOW bytes or one long line each
+//   scanner  scans and parses every line of a batch into statements, names interned in a pool of its own
+//   caller   pass 1 proper (address assignment, Symtab, IR or sink), pass1_pipeline_next() .. pass1_pipeline_release()
+//
+// a fixed set of PASS1_PIPELINE_BATCHES batches circulates through three single-producer/single-consumer queues
+// (reader -> scanner -> caller -> reader), which bounds the memory in flight to PASS1_PIPELINE_BATCHES windows,
+// each grown to fit the longest line it held. every name new to the scanner pool travels with the batch it first appears in: interned in that order the caller's pool gives the same ids.
+// a line the scanner failed on is handed over as text, the caller assembles it again the serial way so the error
+// is reported exactly as the serial pass reports it. the scanner's own diagnostics are dropped.
+
+#define PASS1_PIPELINE_BATCHES 8
+
+typedef struct{
+
+    const char *text;           // the source line inside Pass1Batch.text, not NUL terminated
+    size_t len;
+    size_t line;                // 0 based
+    Err e;                      // ERR_OK: statement is valid. ERR_SYNTAX, ERR_UNDEF_LABEL: the caller reruns the line
+    Statement statement;        // .word values in Pass1Batch.words
+
+}Pass1PipeLine;
+
+typedef struct{
+
+    char *text;                 // whole lines
+    size_t len;
+    size_t text_cap;            // PASS1_STREAM_WINDOW, doubled for a longer line, kept when the batch goes round again
+    int last;                   // no batch follows this one
+    Err e;                      // after the lines: read error, or a scanner failure other than a bad line
+
+    Pass1PipeLine *lines;       // lines with tokens, in order
+    size_t n;
+    size_t cap;
+
+    StrEntry *names;            // new in the scanner pool, ids first_name, first_name + 1, ...
+    size_t n_names;
+    size_t cap_names;
+    StrId first_name;
+
+    Arena words;
+    ArenaMark words_mark;
+
+}Pass1Batch;
+
+typedef struct pass1_pipeline_t pass1_pipeline;
+
+
+pass1_pipeline *create_pass1_pipeline(app_context *app_context_param, const AsmConfig *config, pass1_read_fn read_fn, void *source);     // reader and scanner are running on return
+
+Pass1Batch *pass1_pipeline_next(pass1_pipeline *pipeline);         // waits for the next batch, in input order
+
+void pass1_pipeline_release(pass1_pipeline *pipeline, Pass1Batch *batch);      // the batch goes back to the reader
+
+// stops and joins the stages, adds their counters to config->stats. every batch taken with pass1_pipeline_next() must be
+// released first: ERR_UB when one of them is missing.
+
+Err destroy_pass1_pipeline(app_context *app_context_param, pass1_pipeline *pipeline);
+
+#endif
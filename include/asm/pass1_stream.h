@@ -0,0 +1,24 @@
+#ifndef PASS1_STREAM_H
+#define PASS1_STREAM_H
+
+#include <stddef.h>
+#include "asm/pass1.h"
+
+// streaming core behind assemble_pass1_stream() / assemble_pass1_fd(), shared with the one-pass mode.
+// a sink sees every statement right after pass 1 gave it an address: state is the one after the statement,
+// labels it defines are already in the Symtab. with a sink the IR is not filled (out_ir may be NULL).
+// with AsmConfig.pipelined the run goes through the pipeline of asm/pass1_pipeline.h instead, same results.
+
+#define PASS1_STREAM_WINDOW (64 * 1024)     // bytes kept in memory per window, independent of input size. a longer line doubles it until it fits
+
+typedef Err (*pass1_read_fn)(void *source, char *dst, size_t cap, size_t *out_n);        // *out_n == 0 means end of input
+
+typedef Err (*pass1_sink_fn)(void *sink_ctx, const Statement *statement, const AsmState *state, app_context *app_context_param);
+
+Err pass1_read_file(void *source, char *dst, size_t cap, size_t *out_n);      // source: FILE *
+Err pass1_read_fd(void *source, char *dst, size_t cap, size_t *out_n);        // source: int * holding the descriptor
+
+Err pass1_stream_run(app_context *app_context_param, const AsmConfig *config, pass1_read_fn read_fn, void *source, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state,
+                     pass1_sink_fn sink, void *sink_ctx);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef PASS2_H
+#define PASS2_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "asm/pass1.h"
+
+// pass 2: machine code. the IR is walked once and every instruction is packed from its InstructionSpec,
+// branch offsets and jump targets are resolved through the Symtab of pass 1.
+
+typedef struct{
+
+    uint32_t *text;         // text_n words at text_base, one per instruction
+    size_t text_n;
+    uint32_t *data;         // data_n words at data_base, the .word values
+    size_t data_n;
+    uint32_t text_base;
+    uint32_t data_base;
+    Arena *arena;           // NULL: heap owned, asm_image_free() releases it
+
+}AsmImage;
+
+// the images are sized from final_state (text_pc / data_pc of pass 1) and allocated once, before the walk.
+// config->arena, when set, backs them. errors: ERR_UNDEF_LABEL, ERR_SYNTAX for an immediate, branch or jump out of range.
+
+Err assemble_pass2(app_context *app_context_param, const AsmConfig *config, const IR *ir, const Symtab *symtab, const AsmState *final_state, AsmImage *out_image);
+
+Err asm_image_free(AsmImage *image, app_context *app_context_param);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stddef.h>
+#include "asm/pass1.h"
+
+// incremental pass 1: an assembler session keeps the program between edits and only redoes what an edit touches.
+//
+// every source line is kept as the 64-bit hash of its text plus its compact IR record (if it has a statement).
+// an edit lexes and parses only the inserted lines, splices their records into the IR, then assigns addresses and
+// rebuilds the Symtab from the checkpoint just before the first edited line. checkpoints (section, pcs, Symtab
+// size, IR position) are taken every ASM_SESSION_CHECKPOINT_LINES lines.
+//
+// an edit that makes the program invalid (syntax, section or duplicate label error) is reported like pass 1
+// reports it and is not applied: the session keeps the last valid program.
+//
+// IR, Symtab and final state are those of assemble_pass1() on the same lines, except for the StrIds: the session
+// keeps one name pool for its whole life, so names get ids in the order they were first seen across edits.
+// AsmConfig.arena is ignored, the session owns its memory. AsmConfig.pool speeds up asm_session_load().
+
+typedef struct asm_session_t asm_session;
+
+#define ASM_SESSION_CHECKPOINT_LINES 256
+
+asm_session *create_asm_session(app_context *app_context_param, const AsmConfig *config);
+
+Err destroy_asm_session(app_context *app_context_param, asm_session *session);
+
+Err asm_session_load(app_context *app_context_param, asm_session *session, char **lines, size_t nlines);       // replaces the whole program
+
+// replaces lines [first_line, first_line + n_removed) by n_inserted new_lines. pure inserts and deletes are n_removed 0 / n_inserted 0.
+Err asm_session_edit(app_context *app_context_param, asm_session *session, size_t first_line, size_t n_removed, char **new_lines, size_t n_inserted);
+
+// the new version of the whole program: lines whose hash did not change are kept, the changed range in between is re-parsed.
+Err asm_session_update(app_context *app_context_param, asm_session *session, char **lines, size_t nlines);
+
+size_t asm_session_line_count(const asm_session *session);
+const IR *asm_session_ir(const asm_session *session);             // label StrIds are ids of asm_session_symtab()->names
+const Symtab *asm_session_symtab(const asm_session *session);
+AsmState asm_session_state(const asm_session *session);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include "error_handling.h"
+
+// bump allocator owned by one assembly run. individual allocations are never freed,
+// arena_free() (or arena_rewind()) releases everything at once.
+
+typedef struct arena_block_t arena_block;
+
+typedef struct{
+
+    arena_block *head;          // block we are bumping in, linked to the older ones
+    size_t block_size;          // default size of a new block
+    size_t bytes_allocated;     // sum of all requested sizes, for statistics
+    AppMemTag tag;              // what the blocks are accounted as, APP_MEM_ARENA unless the owner sets another
+
+}Arena;
+
+typedef struct{
+
+    arena_block *block;
+    size_t used;
+    size_t bytes_allocated;
+
+}ArenaMark;
+
+
+Err arena_init(Arena *arena, size_t block_size, app_context *app_context_param);     // block_size 0 selects the default
+
+void *arena_alloc(Arena *arena, size_t size, app_context *app_context_param);
+
+void *arena_realloc(Arena *arena, void *old, size_t old_size, size_t new_size, app_context *app_context_param);   // grows in place when old is the last allocation
+
+char *arena_strndup(Arena *arena, const char *s, size_t n, app_context *app_context_param);
+
+ArenaMark arena_mark(const Arena *arena);
+
+void arena_rewind(Arena *arena, ArenaMark mark);        // drops everything allocated after mark
+
+Err arena_free(Arena *arena, app_context *app_context_param);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef DIAG_H
+#define DIAG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "error_handling.h"
+
+// structured diagnostics: collected while a pass runs, written out once at the end.
+// every message and a copy of its source line live in one text buffer, a diagnostic only keeps offsets into it.
+
+typedef struct{
+
+    uint32_t line_no;       // 1 based
+    uint32_t column;        // 1 based, 0: the whole line
+    Err code;               // ERR_SYNTAX, ERR_UNDEF_LABEL
+    uint32_t message;       // offset of the NUL terminated message in DiagList.text
+    uint32_t source;        // offset of the source line in DiagList.text, source_len bytes
+    uint32_t source_len;
+
+}Diagnostic;
+
+typedef struct{
+
+    Diagnostic *v;          // in the order they were added
+    size_t n;
+    size_t cap;
+
+    char *text;
+    size_t text_n;
+    size_t text_cap;
+
+}DiagList;
+
+
+Err diag_init(DiagList *list, app_context *app_context_param);      // allocates nothing, an error free run never does
+Err diag_free(DiagList *list, app_context *app_context_param);
+void diag_clear(DiagList *list);
+
+Err diag_add(DiagList *list, uint32_t line_no, uint32_t column, Err code, const char *message, const char *source, size_t source_len, app_context *app_context_param);
+
+static inline const char *diag_message(const DiagList *list, size_t i){ return list->text + list->v[i].message; }
+
+// the text of one diagnostic, snprintf style: returns its length, writes at most cap bytes (NUL included)
+
+size_t diag_format(char *dst, size_t cap, uint32_t line_no, uint32_t column, const char *message, const char *source, size_t source_len);
+
+Err diag_emit(const DiagList *list, FILE *out, app_context *app_context_param);      // every diagnostic, formatted into one buffer, one write
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef ERROR_HANDLING_H
 #define ERROR_HANDLING_H
 
+#include <stddef.h>
+
 
 typedef struct app_context_t app_context;   
 
@@ -29,6 +31,91 @@ void app_perror(app_context* app_context_param, const char* message, const char*
 
 app_context* create_app_context(const char* error_log_path_param);
 
+// asynchronous logging: app_error()/app_perror() format the record into a lock-free ring and return,
+// a background writer thread drains the ring into the log file. destroy_app_context() writes every accepted record.
+
+typedef enum{
+
+    APP_LOG_BLOCK,          // ring full: the caller waits for a free record
+    APP_LOG_DROP            // ring full: the record is dropped and counted, the caller never waits
+
+}AppLogPolicy;
+
+#define APP_LOG_RECORD_BYTES 256        // one preformatted record, longer messages are truncated
+
+typedef struct{
+
+    size_t ring_records;    // rounded up to a power of two, 0: 1024
+    AppLogPolicy policy;
+
+}AppLogConfig;
+
+app_context* create_app_context_async(const char* error_log_path_param, const AppLogConfig* config);
+
+Err app_context_flush(app_context* app_context_param);                 // returns once every record logged before the call is in the file
+
+size_t app_context_dropped(const app_context* app_context_param);      // records lost to APP_LOG_DROP so far
+
+// concurrency: a context may be logged to from several threads at once (each record is written in one piece).
+// for output that does not depend on scheduling, every thread logs to its own child instead: a child keeps its
+// records in memory, and merge_child_app_context() appends them to the parent in one piece. merging children
+// in a fixed order (task index, file order) gives the same log on every run. destroy_app_context() frees a child.
+
+app_context* create_child_app_context(app_context* parent);
+
+Err merge_child_app_context(app_context* parent, app_context* child);  // the child is emptied and can be reused
+
+int app_context_last_error(const app_context* app_context_param);      // errno of the last app_perror(), 0: none
+
+void app_log_text(app_context* app_context_param, const char* text, size_t len);     // preformatted text as is, NULL: stderr
+
+// memory accounting: the heap allocations of mips_core and mips_front go through app_alloc(), tagged with the
+// subsystem that makes them. a context counts live and peak bytes per tag, a child counts into its parent too.
+// a free names the same context and size as the allocation did. NULL context: plain realloc()/free(), nothing counted.
+
+typedef enum{
+
+    APP_MEM_ARENA,          // arena blocks, whatever is carved from them
+    APP_MEM_IR,
+    APP_MEM_SYMTAB,
+    APP_MEM_STRPOOL,
+    APP_MEM_TOKENS,
+    APP_MEM_LINES,          // read_all_lines() and the mapped line index
+    APP_MEM_WORDS,          // .word value arrays of heap parsed statements
+    APP_MEM_DIAG,
+    APP_MEM_OTHER,
+    APP_MEM_TAG_COUNT
+
+}AppMemTag;
+
+typedef struct{
+
+    size_t live;            // bytes
+    size_t peak;
+    size_t allocs;          // allocations and resizes
+
+}AppMemStats;
+
+// realloc contract: ptr NULL allocates, new_size 0 frees and returns NULL. called from any thread that uses the context.
+
+typedef void* (*app_alloc_fn)(void* ctx, AppMemTag tag, void* ptr, size_t old_size, size_t new_size);
+
+void app_context_set_allocator(app_context* app_context_param, app_alloc_fn alloc_fn, void* ctx);   // before anything is allocated through the context, NULL: libc. children take their parent's
+
+void app_context_set_mem_report(app_context* app_context_param, int enabled);    // destroy_app_context() logs the table of every tag
+
+void* app_alloc(app_context* app_context_param, AppMemTag tag, void* ptr, size_t old_size, size_t new_size);
+
+static inline void app_free(app_context* app_context_param, AppMemTag tag, void* ptr, size_t size){
+
+    app_alloc(app_context_param, tag, ptr, size, 0);
+
+}
+
+Err app_context_mem_stats(const app_context* app_context_param, AppMemTag tag, AppMemStats* out_stats);     // APP_MEM_TAG_COUNT: all tags together
+
+const char* app_mem_tag_name(AppMemTag tag);
+
 Err destroy_app_context(app_context* app_context_param);
 
 #endif
\ No newline at end of file
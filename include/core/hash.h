@@ -0,0 +1,49 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// string hash used by the hash indexed tables of mips_core (Symtab, ...). FNV-1a with a final avalanche
+// so the low bits, which pick the slot, depend on every byte.
+
+static inline uint32_t hash_bytes(const char *s, size_t n){
+
+    uint32_t h = 2166136261u;
+
+    for(size_t i = 0; i < n; i++){
+
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+
+    }
+
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+
+    return h;
+
+}
+
+
+// 64-bit FNV-1a, for keys that are compared by hash alone (source lines of an assembler session).
+
+static inline uint64_t hash_bytes64(const char *s, size_t n){
+
+    uint64_t h = 14695981039346656037ull;
+
+    for(size_t i = 0; i < n; i++){
+
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ull;
+
+    }
+
+    return h;
+
+}
+
+#endif
@@ -2,6 +2,8 @@
 #define IR_H
 
 #include "error_handling.h"
+#include "arena.h"
+#include "strpool.h"
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -31,7 +33,7 @@ typedef struct{
 
         int reg;
         int32_t imm;
-        char *label;
+        StrId label;        // label names are interned, see Symtab.names
         struct{
 
             int32_t offset;
@@ -76,7 +78,7 @@ typedef struct{
 
         struct{
 
-            char mnemonic[16];
+            int op;                 // IsaId, resolved by the parser
             Operand ops[3];
             int op_count;
 
@@ -84,16 +86,16 @@ typedef struct{
 
         struct{
 
-            char name[64];
+            StrId name;
 
         }label;
 
         struct{
 
-            char name[64];
+            StrId name;
             struct{
 
-                char mnemonic[16];
+                int op;             // IsaId
                 Operand ops[3];
                 int op_count;
 
@@ -104,7 +106,7 @@ typedef struct{
 
         struct{
 
-            char name[64];
+            StrId name;
             struct{
 
                 int32_t *values;
@@ -119,20 +121,55 @@ typedef struct{
 }Statement;
 
 
+// IR storage: one 16 byte record per statement instead of a Statement.
+// operands are packed by the operand classes of the instruction spec: every register (or base register)
+// takes 5 bits of regs and the single wide operand (immediate, memory offset or label StrId) lives in val.
+// .word payloads go to the words side table as [n, v0 .. vn-1], val is the index of n.
+// label definitions keep the StrId of their name in label, STRID_NONE otherwise.
+
 typedef struct{
 
-    Statement *v;
+    uint32_t line_no;
+    uint8_t kind;           // StatementKind
+    uint8_t op;             // IsaId of ST_INSTR / ST_LABEL_PLUS_INSTR
+    uint16_t regs;
+    uint32_t val;
+    StrId label;
+
+}IrRec;
+
+_Static_assert(sizeof(IrRec) == 16, "IrRec is meant to stay 16 bytes");
+
+#define IR_REG_BITS 5
+#define IR_REG_MASK ((1u << IR_REG_BITS) - 1)
+
+static inline int ir_rec_reg(const IrRec *r, int i){ return (int)((r->regs >> (IR_REG_BITS * i)) & IR_REG_MASK); }
+
+typedef struct{
+
+    IrRec *v;
     size_t n;
     size_t cap;
 
+    int32_t *words;     // .word payloads, see IrRec
+    size_t words_n;
+    size_t words_cap;
+
+    Arena *arena;       // NULL: heap owned, else records and payloads live in the arena
+
 }IR;
 
 
 Err ir_init(IR *ir, app_context *app_context_param);
-Err ir_push(IR *ir, const Statement *s, app_context *app_context_param);
+Err ir_init_arena(IR *ir, Arena *arena, app_context *app_context_param);
+Err ir_push(IR *ir, const Statement *s, app_context *app_context_param);       // encodes s, nothing of s is kept (its .word values are copied)
+Err ir_encode(const Statement *s, IrRec *out, app_context *app_context_param);   // the record alone, without a .word payload (val stays 0 for those)
+Err ir_get(const IR *ir, size_t i, Statement *out);                             // decodes record i, .word values point into ir->words
+Err ir_reserve(IR *ir, size_t records, size_t words, app_context *app_context_param);     // room for that many more records / words entries
 Err ir_free(IR *ir, app_context *app_context_param);
 
-void operand_free(Operand *op);
-void stmt_free_heap_parts(Statement *s);
+static inline const int32_t *ir_rec_words(const IR *ir, const IrRec *r, size_t *out_n){ *out_n = (size_t)(uint32_t)ir->words[r->val]; return &ir->words[r->val + 1]; }
+
+void stmt_free_heap_parts(Statement *s, app_context *app_context_param);
 
 #endif
\ No newline at end of file
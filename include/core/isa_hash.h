@@ -0,0 +1,29 @@
+#ifndef ISA_HASH_H
+#define ISA_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// mnemonic hash shared by tools/isa_hash_gen.c (which searches a collision free seed at build time)
+// and isa_lookup() (which uses that seed). both sides must hash exactly the same way.
+
+static inline uint32_t isa_mnemonic_hash(const char *s, size_t n, uint32_t seed){
+
+    uint32_t h = 2166136261u ^ seed;        // FNV-1a, seeded
+
+    for(size_t i = 0; i < n; i++){
+
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+
+    }
+
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+
+    return h;
+
+}
+
+#endif
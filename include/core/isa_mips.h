@@ -1,6 +1,7 @@
 #ifndef ISA_MIPS_H
 #define ISA_MIPS_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "ir.h"
 
@@ -45,8 +46,31 @@ typedef struct{
 
 }InstructionSpec;
 
+typedef enum{
+
+#define ISA_OPS(...)
+#define ISA_INSTR(id, mnemonic, format, opcode, funct, op_count, ops, imm_kind) ISA_##id,
+#include "isa_mips.def"
+#undef ISA_INSTR
+#undef ISA_OPS
+
+    ISA_COUNT
+
+}IsaId;
+
+_Static_assert(ISA_COUNT <= UINT8_MAX + 1, "IrRec.op is too narrow for IsaId");
+
+
+// O(1): one hash of the mnemonic and at most one string compare, the hash is generated from isa_mips.def at build time.
+
 const InstructionSpec *isa_lookup(const char *mnemonic);
+const InstructionSpec *isa_lookup_n(const char *mnemonic, size_t len);     // same, on a span that need not be NUL terminated
+
+const InstructionSpec *isa_spec(IsaId id);
+IsaId isa_spec_id(const InstructionSpec *instr_spec);
+
+int are_operands_valid(const InstructionSpec *instr_spec, const Operand *ops, size_t op_count);
 
-int are_operands_valid(const InstructionSpec *instr_spec, Operand *ops, size_t op_count);
+OpKind isa_operand_kind(OperandClass operand_class);
 
 #endif
\ No newline at end of file
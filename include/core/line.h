@@ -2,15 +2,54 @@
 #define LINE_H
 #include "error_handling.h"
 #include <stdio.h>
+#include <stddef.h>
 
 typedef struct input_program_t input_program;
 
-Err read_line_fgets(app_context* app_context_param, FILE *f, char **out_line);
+typedef struct mapped_program_t mapped_program;     // read-only mmap of a whole source file + line offset index
 
-Err read_all_lines(app_context* app_context_param, FILE *f, char ***out_lines, size_t *out_n);
+typedef struct{
+
+    const char *text;       // NOT NUL terminated, points into the mapping
+    size_t len;             // line length without '\n'
+
+}LineView;
+
+typedef struct{
+
+    char *text;             // NUL terminated, '\n' kept
+    size_t size;            // bytes allocated for text
+
+}LineBuf;
+
+typedef struct{
+
+    LineBuf *v;
+    size_t n;
+    size_t cap;
+
+}LineList;
+
+// a line is handed out with the size of its buffer, what app_free(app_context_param, APP_MEM_LINES, ...) needs back
+
+Err read_line_fgets(app_context* app_context_param, FILE *f, char **out_line, size_t *out_size);
+
+Err read_all_lines(app_context* app_context_param, FILE *f, LineList *out_lines);
+
+Err line_list_free(LineList *lines, app_context* app_context_param);
 
 input_program* create_input_program(app_context* app_context_param, const char* input_file_path);
 
 Err destroy_input_program(app_context* app_context_param, input_program* input_program_param);
 
+mapped_program* create_mapped_program(app_context* app_context_param, const char* input_file_path);
+
+Err destroy_mapped_program(app_context* app_context_param, mapped_program* mapped_program_param);
+
+size_t mapped_program_line_count(const mapped_program* mapped_program_param);
+
+LineView mapped_program_line(const mapped_program* mapped_program_param, size_t index);
+
+const char* mapped_program_text(const mapped_program* mapped_program_param, size_t *out_size);      // the whole mapping, "" for an empty file
+
 #endif
\ No newline at end of file
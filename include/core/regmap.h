@@ -1,9 +1,18 @@
 #ifndef REGMAP_H
 #define REGMAP_H
 
+#include <stddef.h>
+
 #define REG_NUM 32
 #define REG_FILE_SIZE REG_NUM
 
 int regmap_lookup(const char *s);
 
-#endif
\ No newline at end of file
+// constant time decoder for one register token: "$t0" style names (with the "$s8" and "$r0".."$r31" aliases)
+// and "$8" style numbers, on a span that need not be NUL terminated. returns 0..31 or -1.
+
+int regmap_decode(const char *s, size_t n);
+
+const char *regmap_name(int reg);       // canonical name ("$t0") of 0..31, NULL otherwise
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "error_handling.h"
+
+// bounded single producer / single consumer ring of pointers, lock free: one thread pushes, one other thread pops.
+// the producer owns tail, the consumer owns head, each keeps a cached copy of the other index so most operations
+// touch only their own cache line. the blocking variants spin a little, then yield, and give up once *stop is set.
+
+typedef struct{
+
+    void **slots;
+    size_t mask;                            // capacity - 1, capacity is a power of two
+
+    _Alignas(64) atomic_size_t head;        // next slot to pop, written by the consumer
+    size_t tail_cache;                      // consumer's last view of tail
+
+    _Alignas(64) atomic_size_t tail;        // next slot to push, written by the producer
+    size_t head_cache;                      // producer's last view of head
+
+}SpscQueue;
+
+
+Err spsc_init(SpscQueue *q, size_t capacity, app_context *app_context_param);     // capacity rounded up to a power of two, at least 2
+
+Err spsc_free(SpscQueue *q, app_context *app_context_param);
+
+int spsc_try_push(SpscQueue *q, void *item);        // 0: full
+
+void *spsc_try_pop(SpscQueue *q);                   // NULL: empty, so NULL items cannot be queued
+
+int spsc_push(SpscQueue *q, void *item, const atomic_int *stop);       // waits while full, 0: *stop was set first
+
+void *spsc_pop(SpscQueue *q, const atomic_int *stop);                  // waits while empty, NULL: *stop was set first
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "error_handling.h"
+
+// per stage counters of the assembler pipeline. pass 1 fills an AsmStats given through AsmConfig.stats,
+// the caller reads it after the run. calls, bytes and heap allocations are exact; time is taken on about one line
+// out of ASM_STATS_SAMPLE (clock reads would cost more than the stages) and asm_stage_ns() scales it up.
+// built without MIPS_ASM_STATS (cmake -DENABLE_ASM_STATS=OFF) every probe compiles to nothing.
+
+typedef enum{
+
+    ASM_STAGE_READ,         // input reads of the streaming entry points
+    ASM_STAGE_PREPROCESS,   // comment strip + trim, for callers that run it: scan_line does it while it lexes
+    ASM_STAGE_LEX,
+    ASM_STAGE_PARSE,
+    ASM_STAGE_SYMTAB,       // label definitions
+    ASM_STAGE_IR,           // ir_push, or the statement sink
+    ASM_STAGE_COUNT
+
+}AsmStage;
+
+typedef struct{
+
+    uint64_t calls;
+    uint64_t bytes;
+    uint64_t allocs;        // heap allocations made inside the stage
+    uint64_t sampled_calls; // calls that were timed
+    uint64_t sampled_ns;
+
+}AsmStageStats;
+
+typedef struct{
+
+    AsmStageStats stage[ASM_STAGE_COUNT];
+
+}AsmStats;
+
+#define ASM_STATS_SAMPLE 64
+
+void asm_stats_reset(AsmStats *stats);
+void asm_stats_merge(AsmStats *into, const AsmStats *from);
+void asm_stats_add(AsmStats *stats, AsmStage stage, uint64_t calls, uint64_t bytes, uint64_t ns);       // a stage timed by the caller, every call
+const char *asm_stage_name(AsmStage stage);
+Err asm_stats_print(const AsmStats *stats, FILE *out, app_context *app_context_param);                  // one line per stage
+
+static inline uint64_t asm_stage_ns(const AsmStats *stats, AsmStage stage){
+
+    const AsmStageStats *s = &stats->stage[stage];
+    return s->sampled_calls ? (uint64_t)((double)s->sampled_ns * (double)s->calls / (double)s->sampled_calls) : 0;
+
+}
+
+
+#if MIPS_ASM_STATS
+
+extern _Thread_local uint64_t asm_stats_alloc_count;        // heap allocations of mips_core / mips_front on this thread
+
+static inline uint64_t asm_stats_clock(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+}
+
+uint64_t asm_stats_clock_cost(void);        // ns of one asm_stats_clock(), measured once, taken out of every timed stage
+
+// a probe measures consecutive stages of one line: each ASM_STATS_END() closes a stage and opens the next one
+
+typedef struct{
+
+    AsmStats *stats;        // NULL: not collecting
+    int sampled;
+    uint64_t t;
+    uint64_t allocs;
+
+}AsmStatsProbe;
+
+static inline int asm_stats_sampled(uint64_t index){       // 1 in ASM_STATS_SAMPLE, scattered: a plain stride would alias with periodic input
+
+    return ((index * 0x9E3779B97F4A7C15u) >> 32) % ASM_STATS_SAMPLE == 0;
+
+}
+
+static inline void asm_probe_start(AsmStatsProbe *probe){
+
+    probe->allocs = asm_stats_alloc_count;
+    if(probe->sampled) probe->t = asm_stats_clock();
+
+}
+
+static inline void asm_probe_end(AsmStatsProbe *probe, AsmStage stage, uint64_t bytes){
+
+    AsmStageStats *s = &probe->stats->stage[stage];
+
+    s->calls++;
+    s->bytes += bytes;
+    s->allocs += asm_stats_alloc_count - probe->allocs;
+    probe->allocs = asm_stats_alloc_count;
+
+    if(probe->sampled){
+
+        uint64_t now = asm_stats_clock();
+        uint64_t cost = asm_stats_clock_cost();
+        s->sampled_ns += (now - probe->t > cost) ? now - probe->t - cost : 0;
+        s->sampled_calls++;
+        probe->t = now;
+
+    }
+
+}
+
+#define ASM_STATS_COUNT_ALLOC() ((void)asm_stats_alloc_count++)
+#define ASM_STATS_BEGIN(probe, stats_ptr, index) do{ (probe)->stats = (stats_ptr); \
+    if((probe)->stats){ (probe)->sampled = asm_stats_sampled(index); asm_probe_start(probe); } }while(0)
+#define ASM_STATS_RESTART(probe) do{ if((probe)->stats) asm_probe_start(probe); }while(0)
+#define ASM_STATS_END(probe, stage, bytes) do{ if((probe)->stats) asm_probe_end((probe), (stage), (bytes)); }while(0)
+
+// one call timed in full, no sampling: the read stage. BEGIN declares t
+#define ASM_STATS_TIME_BEGIN(t, stats_ptr) uint64_t t = (stats_ptr) ? asm_stats_clock() : 0
+#define ASM_STATS_TIME_END(t, stats_ptr, stage, bytes) do{ if(stats_ptr) asm_stats_add((stats_ptr), (stage), 1, (bytes), asm_stats_clock() - (t)); }while(0)
+
+#else
+
+typedef struct{ char unused; }AsmStatsProbe;
+
+#define ASM_STATS_COUNT_ALLOC() ((void)0)
+#define ASM_STATS_BEGIN(probe, stats_ptr, index) ((void)(probe))
+#define ASM_STATS_RESTART(probe) ((void)(probe))
+#define ASM_STATS_END(probe, stage, bytes) ((void)(probe))
+#define ASM_STATS_TIME_BEGIN(t, stats_ptr) ((void)0)
+#define ASM_STATS_TIME_END(t, stats_ptr, stage, bytes) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "error_handling.h"
+#include "arena.h"
+
+// interning table: every distinct identifier is stored once and named by a stable 32-bit id,
+// so comparing two names is comparing two integers. ids are dense, 1..n; 0 is never a valid id.
+
+typedef uint32_t StrId;
+
+#define STRID_NONE 0u
+
+typedef struct{
+
+    const char *s;      // NUL terminated, never moves
+    uint32_t len;
+    uint32_t hash;      // hash_bytes() of s
+
+}StrEntry;
+
+typedef struct{
+
+    uint32_t hash;
+    StrId id;           // STRID_NONE: empty slot
+
+}StrSlot;
+
+typedef struct{
+
+    StrEntry *v;        // indexed by id, v[0] unused
+    size_t n;           // ids in use + 1
+    size_t cap;
+
+    StrSlot *slots;     // Robin Hood open addressing index, power of two sized
+    size_t slot_cap;
+
+    Arena *arena;       // NULL: heap owned, string bytes then live in bytes
+    Arena bytes;
+
+}StrPool;
+
+
+Err strpool_init(StrPool *pool, app_context *app_context_param);
+Err strpool_init_arena(StrPool *pool, Arena *arena, app_context *app_context_param);
+Err strpool_free(StrPool *pool, app_context *app_context_param);
+
+Err strpool_intern(StrPool *pool, const char *s, size_t len, StrId *out_id, app_context *app_context_param);
+StrId strpool_find(const StrPool *pool, const char *s, size_t len);      // STRID_NONE when s was never interned
+
+static inline size_t strpool_count(const StrPool *pool){ return pool->n ? pool->n - 1 : 0; }
+
+static inline const char *strpool_str(const StrPool *pool, StrId id){ return (id && id < pool->n) ? pool->v[id].s : NULL; }
+
+static inline size_t strpool_len(const StrPool *pool, StrId id){ return (id && id < pool->n) ? pool->v[id].len : 0; }
+
+#endif
@@ -4,29 +4,47 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include "error_handling.h"
+#include "arena.h"
+#include "strpool.h"
 
 
 typedef struct{
 
-    char name[64];
+    StrId name;         // in Symtab.names
     uint32_t addr;
 
 }Symbol;
 
 typedef struct{
 
-    Symbol *v;
+    Symbol *v;          // insertion order
     size_t n;
     size_t cap;
+    Arena *arena;       // NULL: heap owned
+
+    StrPool names;      // every identifier of the program: label definitions and label operands of the IR
+    uint32_t *by_id;    // StrId -> index into v + 1, 0: name not defined here
+    size_t by_id_cap;
 
 
 }Symtab;
 
 
 Err symtab_init(Symtab *st, app_context *app_context_param);
+Err symtab_init_arena(Symtab *st, Arena *arena, app_context *app_context_param);
 Err symtab_free(Symtab *st, app_context *app_context_param);
 int symtab_find(Symtab *st, const char *name);
 Err symtab_add(Symtab *st, const char *name, uint32_t addr, app_context *app_context_param);
 Err symtab_lookup(Symtab *st, const char *name, uint32_t *out_addr, app_context *app_context_param);
 
-#endif
\ No newline at end of file
+// the same on names already interned in st->names, an integer compare per probe
+
+int symtab_find_id(const Symtab *st, StrId name);
+Err symtab_add_id(Symtab *st, StrId name, uint32_t addr, app_context *app_context_param);
+Err symtab_lookup_id(const Symtab *st, StrId name, uint32_t *out_addr, app_context *app_context_param);
+
+void symtab_truncate(Symtab *st, size_t n);        // drops every symbol added after the first n, names stay interned
+
+static inline const char *symtab_name(const Symtab *st, size_t i){ return strpool_str(&st->names, st->v[i].name); }
+
+#endif
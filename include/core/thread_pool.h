@@ -0,0 +1,22 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include "error_handling.h"
+
+// fixed set of worker threads reused across runs. thread_pool_run() hands out task indices
+// 0..n_tasks-1 to the workers (and the calling thread) and returns when every task has finished.
+
+typedef struct thread_pool_t thread_pool;
+
+typedef void (*thread_pool_fn)(void *arg, size_t task_index);
+
+thread_pool *create_thread_pool(app_context *app_context_param, unsigned n_threads);     // n_threads 0: one per online CPU
+
+Err destroy_thread_pool(app_context *app_context_param, thread_pool *pool);
+
+unsigned thread_pool_size(const thread_pool *pool);        // workers + the calling thread
+
+Err thread_pool_run(thread_pool *pool, size_t n_tasks, thread_pool_fn fn, void *arg);       // one run at a time, concurrent callers wait
+
+#endif
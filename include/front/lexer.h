@@ -3,7 +3,10 @@
 
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include "core/error_handling.h"
+#include "core/arena.h"
 
 
 typedef enum{
@@ -21,14 +24,15 @@ typedef enum{
 
 typedef struct{
 
-    TokKind kind;
-    char lexeme[64];      // lexeme is the content that a token has
-    size_t line_no;       
-    size_t column_no;
-
+    uint32_t off;         // lexeme starts at tv->src + off (the token points into the source line, nothing is copied)
+    uint32_t len;         // lexeme length in bytes, any length
+    uint32_t line_no;
+    TokKind kind;         // column is off + 1, see tok_column()
 
 }Token;
 
+_Static_assert(sizeof(Token) <= 16, "Token must stay 16 bytes, 4 per cache line");
+
 
 typedef struct{
 
@@ -36,12 +40,33 @@ typedef struct{
     size_t n;
     size_t cap;
 
+    const char *src;      // line the tokens were scanned from (not NUL terminated), used for diagnostics
+    size_t src_len;
+    Arena *arena;         // NULL: heap owned
+
 }TokenVec;
 
 
 Err tokenvec_init(TokenVec *tv, app_context *app_context_param);
+Err tokenvec_init_arena(TokenVec *tv, Arena *arena, app_context *app_context_param);
 void tokenvec_free(TokenVec *tv, app_context *app_context_param);
 
+Err tokenvec_push(TokenVec *tv, const Token *t, app_context *app_context_param);
+
+
+// span accessors, the lexeme is NOT NUL terminated
+
+static inline const char *tok_text(const TokenVec *tv, const Token *t){ return tv->src + t->off; }
+
+static inline int tok_column(const Token *t){ return (int)t->off + 1; }
+
+static inline int tok_eq(const TokenVec *tv, const Token *t, const char *s){
+
+    size_t n = strlen(s);
+    return t->len == n && memcmp(tv->src + t->off, s, n) == 0;
+
+}
+
 Err lex_line(const char *line, int line_no, TokenVec *out, app_context *app_context_param);
 
 #endif
\ No newline at end of file
@@ -2,8 +2,14 @@
 #define PARSER_H
 
 #include "core/ir.h"
+#include "core/diag.h"
 #include "lexer.h"
 
-Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *source_line, int line_no, int *out_has_label, Statement *out_statement);
+// arena: optional, .word values are allocated from it instead of the heap (stmt_free_heap_parts must not be called then)
+// pool: label definitions and label operands are interned here, the statement only keeps their StrId
+Err parse_line(app_context *app_context_param, Arena *arena, StrPool *pool, const TokenVec *tv, int line_no, int *out_has_label, Statement *out_statement);
+
+// per thread: syntax errors of parse_line go to diag instead of stderr, NULL restores stderr. returns the previous list.
+DiagList *parser_set_diagnostics(DiagList *diag);
 
 #endif
\ No newline at end of file
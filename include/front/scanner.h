@@ -0,0 +1,46 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <stddef.h>
+#include "core/error_handling.h"
+#include "front/lexer.h"
+
+
+// character classes used by the scanner, one table lookup instead of isspace() + four compares
+
+enum{
+
+    CC_SPACE = 1 << 0,      // ' ' \t \n \v \f \r
+    CC_DELIM = 1 << 1,      // : , ( )
+    CC_END   = 1 << 2       // '#' starts a comment, '\0' ends a C string
+
+};
+
+extern const unsigned char scanner_char_class[256];
+
+
+// block classifier behind scan_line(). AUTO picks the widest one the CPU supports (runtime dispatch),
+// the scalar table walk is always available and produces the same tokens.
+
+typedef enum{
+
+    SCAN_IMPL_AUTO = 0,
+    SCAN_IMPL_SCALAR,
+    SCAN_IMPL_SSE2,         // 16 byte compares
+    SCAN_IMPL_AVX2          // 32 byte compares
+
+}ScanImpl;
+
+ScanImpl scanner_select_impl(ScanImpl requested);        // returns the implementation actually in use (falls back when unsupported)
+
+const char *scanner_impl_name(ScanImpl impl);
+
+
+// single forward pass over the raw line: comment stripping, trimming and tokenizing at once, without copying the line.
+// out must be initialized (tokenvec_init or {0}), its previous tokens are dropped so one TokenVec can be reused line after line.
+
+Err scan_line(const char *line, size_t len, int line_no, TokenVec *out, app_context *app_context_param);
+
+int scan_int_literal(const char *p, size_t n, long *out_value);       // 1 if [p, p+n) is exactly what strtol(.., 0) accepts without ERANGE
+
+#endif
@@ -0,0 +1,290 @@
+#include "asm/batch.h"
+#include "asm/cache.h"
+#include "asm/pass2.h"
+#include "core/error_handling.h"
+#include "core/line.h"
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+
+
+typedef struct{
+
+    app_context *app;
+    const AsmBatchConfig *cfg;
+    const AsmBatchList *list;
+    app_context **children;
+    AsmBatchResult *results;
+
+}BatchJob;
+
+
+static uint64_t now_ns(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+}
+
+
+Err asm_batch_list_init(AsmBatchList *list, app_context *app_context_param){
+
+    if(!list){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    list->paths = NULL;
+    list->n = list->cap = 0;
+
+    return arena_init(&list->arena, 0, app_context_param);
+
+}
+
+
+Err asm_batch_list_add(AsmBatchList *list, const char *path, size_t len, app_context *app_context_param){
+
+    if(!list || !path){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    if(list->n == list->cap){
+
+        size_t new_cap = (list->cap == 0)? 64 : list->cap * 2;
+        const char **p = app_alloc(app_context_param, APP_MEM_OTHER, list->paths, sizeof(*p) * list->cap, sizeof(*p) * new_cap);
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "BATCH LIST REALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        list->paths = p;
+        list->cap = new_cap;
+
+    }
+
+    char *copy = arena_strndup(&list->arena, path, len, app_context_param);
+    if(!copy) return ERR_OOM;
+
+    list->paths[list->n++] = copy;
+
+    return ERR_OK;
+
+}
+
+
+Err asm_batch_list_read_manifest(AsmBatchList *list, const char *manifest_path, app_context *app_context_param){
+
+    if(!list || !manifest_path){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    mapped_program *manifest = create_mapped_program(app_context_param, manifest_path);
+    if(!manifest) return ERR_IO;
+
+    Err e = ERR_OK;
+    size_t n = mapped_program_line_count(manifest);
+
+    for(size_t i = 0; e == ERR_OK && i < n; i++){
+
+        LineView view = mapped_program_line(manifest, i);
+        const char *s = view.text;
+        size_t len = view.len;
+
+        while(len > 0 && isspace((unsigned char)*s)){ s++; len--; }
+        while(len > 0 && isspace((unsigned char)s[len - 1])) len--;
+
+        if(len == 0 || *s == '#') continue;
+
+        e = asm_batch_list_add(list, s, len, app_context_param);
+
+    }
+
+    destroy_mapped_program(app_context_param, manifest);
+
+    return e;
+
+}
+
+
+Err asm_batch_list_free(AsmBatchList *list, app_context *app_context_param){
+
+    if(!list) return ERR_INVALID_ARGUMENT;
+
+    app_free(app_context_param, APP_MEM_OTHER, list->paths, sizeof(*list->paths) * list->cap);
+    list->paths = NULL;
+    list->n = list->cap = 0;
+
+    return arena_free(&list->arena, app_context_param);
+
+}
+
+
+static Err assemble_cached(app_context *app_context_param, const char *cache_dir, const AsmConfig *config, const char *path, AsmBatchResult *r){
+
+    asm_cached_program *program = NULL;
+
+    Err e = asm_cache_assemble_file(app_context_param, cache_dir, config, path, &program, &r->cache_hit);
+    if(e != ERR_OK) return e;
+
+    const AsmCachedView *view = asm_cached_view(program);
+    r->text_words = view->text_n;
+    r->data_words = view->data_n;
+    r->symbols = view->n_symbols;
+
+    return destroy_asm_cached_program(app_context_param, program);
+
+}
+
+
+static Err assemble_file(app_context *app_context_param, AsmConfig config, const char *path, AsmBatchResult *r){      // everything of the file is carved from one arena, dropped at once
+
+    mapped_program *program = create_mapped_program(app_context_param, path);
+    if(!program) return ERR_IO;
+
+    Arena arena;
+    Err e = arena_init(&arena, 0, app_context_param);
+    config.arena = &arena;
+
+    IR ir;
+    Symtab symtab;
+    AsmState state;
+    AsmImage image;
+
+    if(e == ERR_OK) e = assemble_pass1_mapped(app_context_param, &config, program, &ir, &symtab, &state);
+    if(e == ERR_OK) e = assemble_pass2(app_context_param, &config, &ir, &symtab, &state, &image);
+
+    if(e == ERR_OK){
+
+        r->text_words = image.text_n;
+        r->data_words = image.data_n;
+        r->symbols = symtab.n;
+
+    }
+
+    arena_free(&arena, app_context_param);
+    destroy_mapped_program(app_context_param, program);
+
+    return e;
+
+}
+
+
+static void batch_task(void *arg, size_t index){
+
+    BatchJob *job = arg;
+    AsmBatchResult *r = &job->results[index];
+    app_context *app_context_param = job->children ? job->children[index] : NULL;
+    const char *path = job->list->paths[index];
+
+    AsmConfig config = {.text_base = job->cfg->config.text_base, .data_base = job->cfg->config.data_base};     // no pool: the batch keeps every worker busy, and the pool runs one job at a time
+
+    uint64_t t0 = now_ns();
+
+    r->result = job->cfg->cache_dir ? assemble_cached(app_context_param, job->cfg->cache_dir, &config, path, r) : assemble_file(app_context_param, config, path, r);
+    r->ns = now_ns() - t0;
+
+    if(r->result != ERR_OK){        // the diagnostics above carry line numbers only, this names their file
+
+        char line[512];
+        int n = snprintf(line, sizeof(line), "%s: %s\n", path, asm_batch_err_name(r->result));
+        if(n > 0) app_log_text(app_context_param, line, ((size_t)n < sizeof(line)) ? (size_t)n : sizeof(line) - 1);
+
+    }
+
+}
+
+
+Err asm_batch_assemble(app_context *app_context_param, const AsmBatchConfig *cfg, const AsmBatchList *list, AsmBatchResult *out_results){
+
+    if(!cfg || !list || (list->n && !out_results)){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    if(list->n == 0) return ERR_OK;
+
+    memset(out_results, 0, sizeof(*out_results) * list->n);
+
+    BatchJob job = {app_context_param, cfg, list, NULL, out_results};
+    Err e = ERR_OK;
+
+    // one child per file: its log waits for the merge, in file order
+
+    if(app_context_param){
+
+        job.children = app_alloc(app_context_param, APP_MEM_OTHER, NULL, 0, sizeof(*job.children) * list->n);
+
+        if(!job.children){
+
+            APP_PERROR(app_context_param, "BATCH CONTEXTS ALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        for(size_t i = 0; i < list->n; i++) job.children[i] = NULL;
+        for(size_t i = 0; e == ERR_OK && i < list->n; i++) if(!(job.children[i] = create_child_app_context(app_context_param))) e = ERR_OOM;
+
+    }
+
+    if(e == ERR_OK){
+
+        if(cfg->pool) e = thread_pool_run(cfg->pool, list->n, batch_task, &job);
+        else for(size_t i = 0; i < list->n; i++) batch_task(&job, i);
+
+    }
+
+    if(job.children){
+
+        for(size_t i = 0; i < list->n && job.children[i]; i++){
+
+            merge_child_app_context(app_context_param, job.children[i]);
+            destroy_app_context(job.children[i]);
+
+        }
+
+        app_free(app_context_param, APP_MEM_OTHER, job.children, sizeof(*job.children) * list->n);
+
+    }
+
+    for(size_t i = 0; e == ERR_OK && i < list->n; i++) e = out_results[i].result;
+
+    return e;
+
+}
+
+
+const char *asm_batch_err_name(Err e){
+
+    switch(e){
+
+        case ERR_OK: return "ok";
+        case ERR_IO: return "io error";
+        case ERR_READ_ERROR: return "read error";
+        case ERR_EOF: return "unexpected end of file";
+        case ERR_NO_CHAR_INPUT: return "empty input";
+        case ERR_OOM: return "out of memory";
+        case ERR_DEALLOC: return "deallocation failed";
+        case ERR_SYNTAX: return "syntax error";
+        case ERR_UNDEF_LABEL: return "undefined label";
+        case ERR_INVALID_ARGUMENT: return "invalid argument";
+        case ERR_UB: return "undefined behaviour";
+
+    }
+
+    return "unknown error";
+
+}
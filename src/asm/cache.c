@@ -0,0 +1,568 @@
+#include "asm/cache.h"
+#include "asm/asm_build_id.h"      // generated by cmake/asm_build_id.cmake
+#include "core/error_handling.h"
+#include "core/ir.h"
+#include "core/line.h"
+#include "core/symtab.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define ASM_CACHE_MAGIC "MIPSASMC"
+#define ASM_CACHE_FORMAT 1u
+#define ASM_CACHE_ENDIAN 0x01020304u        // a file written on a host of the other byte order fails the check
+
+// entry file: CacheHeader, then text, text_lines, data, data_lines, symbols and names, each 8 byte aligned
+
+typedef struct{
+
+    char magic[8];
+    uint32_t format;
+    uint32_t endian;
+    char build_id[32];
+    uint64_t source[2];
+    uint32_t text_base;
+    uint32_t data_base;
+
+    uint32_t section;
+    uint32_t text_pc;
+    uint32_t data_pc;
+    uint32_t text_n;
+    uint32_t data_n;
+    uint32_t n_symbols;
+    uint32_t names_bytes;
+    uint32_t reserved;
+
+    uint64_t text_off;
+    uint64_t text_lines_off;
+    uint64_t data_off;
+    uint64_t data_lines_off;
+    uint64_t symbols_off;
+    uint64_t names_off;
+    uint64_t total;
+
+}CacheHeader;
+
+_Static_assert(sizeof(CacheHeader) % 8 == 0, "sections after the header are 8 byte aligned");
+_Static_assert(sizeof(MIPS_ASM_BUILD_ID) - 1 == sizeof(((CacheHeader *)0)->build_id), "build id is 32 hex digits");
+
+struct asm_cached_program_t{
+
+    void *base;             // the entry: a mapping of its file, or a heap copy when it could not be stored
+    size_t size;
+    int mapped;
+    AsmCachedView view;
+
+};
+
+
+// 128-bit MurmurHash3 (x64 variant) of the source bytes, 8 bytes at a time
+
+static inline uint64_t rotl64(uint64_t x, int r){ return (x << r) | (x >> (64 - r)); }
+
+static inline uint64_t fmix64(uint64_t k){
+
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDull;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ull;
+    k ^= k >> 33;
+
+    return k;
+
+}
+
+static void hash128(const void *bytes, size_t len, uint64_t seed, uint64_t out[2]){
+
+    const unsigned char *p = bytes;
+    const uint64_t c1 = 0x87C37B91114253D5ull, c2 = 0x4CF5AD432745937Full;
+    uint64_t h1 = seed, h2 = seed;
+    size_t nblocks = len / 16;
+
+    for(size_t i = 0; i < nblocks; i++){
+
+        uint64_t k1, k2;
+        memcpy(&k1, p + i * 16, 8);
+        memcpy(&k2, p + i * 16 + 8, 8);
+
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52DCE729;
+
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495AB5;
+
+    }
+
+    unsigned char tail[16] = {0};
+    size_t rest = len & 15;
+    if(rest) memcpy(tail, p + nblocks * 16, rest);
+
+    uint64_t k1, k2;
+    memcpy(&k1, tail, 8);
+    memcpy(&k2, tail + 8, 8);
+
+    if(rest > 8){ k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2; }
+    if(rest){ k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1; }
+
+    h1 ^= (uint64_t)len;
+    h2 ^= (uint64_t)len;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    out[0] = h1;
+    out[1] = h2;
+
+}
+
+
+void asm_cache_key(const char *source, size_t len, const AsmConfig *cfg, AsmCacheKey *out_key){
+
+    hash128(source, len, 0, out_key->source);
+    out_key->text_base = cfg ? cfg->text_base : 0;
+    out_key->data_base = cfg ? cfg->data_base : 0;
+
+}
+
+
+static Err entry_path(app_context *app_context_param, const char *cache_dir, const AsmCacheKey *key, char *out, size_t cap){      // <cache_dir>/<32 hex>.masm
+
+    struct{ uint64_t source[2]; uint32_t text_base, data_base; char build_id[32]; }name_key;
+
+    memset(&name_key, 0, sizeof(name_key));
+    memcpy(name_key.source, key->source, sizeof(name_key.source));
+    name_key.text_base = key->text_base;
+    name_key.data_base = key->data_base;
+    memcpy(name_key.build_id, MIPS_ASM_BUILD_ID, sizeof(name_key.build_id));
+
+    uint64_t h[2];
+    hash128(&name_key, sizeof(name_key), 0x6D697073ull, h);
+
+    int n = snprintf(out, cap, "%s/%016llx%016llx.masm", cache_dir, (unsigned long long)h[0], (unsigned long long)h[1]);
+
+    if(n < 0 || (size_t)n >= cap){
+
+        APP_ERROR(app_context_param, "CACHE PATH TOO LONG");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    return ERR_OK;
+
+}
+
+
+static int section_fits(uint64_t off, uint64_t bytes, uint64_t total){ return off % 8 == 0 && off <= total && bytes <= total - off; }
+
+
+static int view_entry(const void *base, size_t size, const AsmCacheKey *key, AsmCachedView *out){      // 0: not a valid entry for key
+
+    if(size < sizeof(CacheHeader)) return 0;
+
+    const CacheHeader *h = base;
+
+    if(memcmp(h->magic, ASM_CACHE_MAGIC, sizeof(h->magic)) != 0 || h->format != ASM_CACHE_FORMAT || h->endian != ASM_CACHE_ENDIAN) return 0;
+    if(memcmp(h->build_id, MIPS_ASM_BUILD_ID, sizeof(h->build_id)) != 0) return 0;
+    if(h->source[0] != key->source[0] || h->source[1] != key->source[1] || h->text_base != key->text_base || h->data_base != key->data_base) return 0;
+    if(h->total != size || h->section > SEC_DATA) return 0;
+
+    if(!section_fits(h->text_off, (uint64_t)h->text_n * 4, size) || !section_fits(h->text_lines_off, (uint64_t)h->text_n * 4, size) ||
+       !section_fits(h->data_off, (uint64_t)h->data_n * 4, size) || !section_fits(h->data_lines_off, (uint64_t)h->data_n * 4, size) ||
+       !section_fits(h->symbols_off, (uint64_t)h->n_symbols * sizeof(AsmCachedSymbol), size) || !section_fits(h->names_off, h->names_bytes, size)) return 0;
+
+    const char *bytes = base;
+    const AsmCachedSymbol *symbols = (const AsmCachedSymbol *)(bytes + h->symbols_off);
+    const char *names = bytes + h->names_off;
+
+    if(h->names_bytes && names[h->names_bytes - 1] != '\0') return 0;
+
+    for(uint32_t i = 0; i < h->n_symbols; i++){
+
+        if(symbols[i].name >= h->names_bytes) return 0;
+
+    }
+
+    out->text = (const uint32_t *)(bytes + h->text_off);
+    out->text_n = h->text_n;
+    out->text_lines = (const uint32_t *)(bytes + h->text_lines_off);
+    out->data = (const uint32_t *)(bytes + h->data_off);
+    out->data_n = h->data_n;
+    out->data_lines = (const uint32_t *)(bytes + h->data_lines_off);
+    out->text_base = h->text_base;
+    out->data_base = h->data_base;
+    out->symbols = symbols;
+    out->n_symbols = h->n_symbols;
+    out->names = names;
+    out->state = (AsmState){(Section)h->section, h->text_pc, h->data_pc};
+
+    return 1;
+
+}
+
+
+Err asm_cache_lookup(app_context *app_context_param, const char *cache_dir, const AsmCacheKey *key, asm_cached_program **out_program){
+
+    if(!cache_dir || !key || !out_program){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    *out_program = NULL;
+
+    char path[4096];
+    Err e = entry_path(app_context_param, cache_dir, key, path, sizeof(path));
+    if(e != ERR_OK) return e;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return ERR_OK;          // not cached
+
+    struct stat st;
+    void *base = MAP_FAILED;
+
+    if(fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(CacheHeader)) base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);          // the mapping stays valid
+
+    if(base == MAP_FAILED) return ERR_OK;
+
+    asm_cached_program *p = calloc(1, sizeof(*p));
+
+    if(!p){
+
+        munmap(base, (size_t)st.st_size);
+        APP_PERROR(app_context_param, "CACHED PROGRAM ALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    p->base = base;
+    p->size = (size_t)st.st_size;
+    p->mapped = 1;
+
+    if(!view_entry(base, p->size, key, &p->view)){         // stale or foreign entry: a miss, the next store replaces it
+
+        destroy_asm_cached_program(app_context_param, p);
+        return ERR_OK;
+
+    }
+
+    *out_program = p;
+
+    return ERR_OK;
+
+}
+
+
+static uint64_t align8(uint64_t n){ return (n + 7) & ~(uint64_t)7; }
+
+
+static Err serialize_entry(app_context *app_context_param, const AsmCacheKey *key, const IR *ir, const Symtab *symtab, const AsmState *state, const AsmImage *image,
+                           void **out_base, size_t *out_size){
+
+    uint64_t names_bytes = 0;
+    for(size_t i = 0; i < symtab->n; i++) names_bytes += strpool_len(&symtab->names, symtab->v[i].name) + 1;
+
+    if(image->text_n > UINT32_MAX || image->data_n > UINT32_MAX || symtab->n > UINT32_MAX || names_bytes > UINT32_MAX){
+
+        APP_ERROR(app_context_param, "PROGRAM TOO LARGE FOR THE ASSEMBLY CACHE");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    CacheHeader h;
+    memset(&h, 0, sizeof(h));
+
+    memcpy(h.magic, ASM_CACHE_MAGIC, sizeof(h.magic));
+    h.format = ASM_CACHE_FORMAT;
+    h.endian = ASM_CACHE_ENDIAN;
+    memcpy(h.build_id, MIPS_ASM_BUILD_ID, sizeof(h.build_id));
+    h.source[0] = key->source[0];
+    h.source[1] = key->source[1];
+    h.text_base = key->text_base;
+    h.data_base = key->data_base;
+    h.section = (uint32_t)state->section;
+    h.text_pc = state->text_pc;
+    h.data_pc = state->data_pc;
+    h.text_n = (uint32_t)image->text_n;
+    h.data_n = (uint32_t)image->data_n;
+    h.n_symbols = (uint32_t)symtab->n;
+    h.names_bytes = (uint32_t)names_bytes;
+
+    h.text_off = sizeof(CacheHeader);
+    h.text_lines_off = align8(h.text_off + (uint64_t)h.text_n * 4);
+    h.data_off = align8(h.text_lines_off + (uint64_t)h.text_n * 4);
+    h.data_lines_off = align8(h.data_off + (uint64_t)h.data_n * 4);
+    h.symbols_off = align8(h.data_lines_off + (uint64_t)h.data_n * 4);
+    h.names_off = align8(h.symbols_off + (uint64_t)h.n_symbols * sizeof(AsmCachedSymbol));
+    h.total = align8(h.names_off + names_bytes);
+
+    char *base = calloc(1, (size_t)h.total);
+
+    if(!base){
+
+        APP_PERROR(app_context_param, "CACHE ENTRY ALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    memcpy(base, &h, sizeof(h));
+    if(h.text_n) memcpy(base + h.text_off, image->text, (size_t)h.text_n * 4);
+    if(h.data_n) memcpy(base + h.data_off, image->data, (size_t)h.data_n * 4);
+
+    // line map, from the IR walk pass 2 does
+
+    uint32_t *text_lines = (uint32_t *)(base + h.text_lines_off);
+    uint32_t *data_lines = (uint32_t *)(base + h.data_lines_off);
+    size_t text_i = 0, data_i = 0;
+
+    for(size_t i = 0; i < ir->n; i++){
+
+        const IrRec *r = &ir->v[i];
+
+        if((r->kind == ST_INSTR || r->kind == ST_LABEL_PLUS_INSTR) && text_i < h.text_n) text_lines[text_i++] = r->line_no;
+        else if(r->kind == ST_DIR_WORD || r->kind == ST_LABEL_PLUS_DIR_WORD){
+
+            size_t n;
+            ir_rec_words(ir, r, &n);
+            for(size_t k = 0; k < n && data_i < h.data_n; k++) data_lines[data_i++] = r->line_no;
+
+        }
+
+    }
+
+    AsmCachedSymbol *symbols = (AsmCachedSymbol *)(base + h.symbols_off);
+    char *names = base + h.names_off;
+    uint32_t at = 0;
+
+    for(size_t i = 0; i < symtab->n; i++){
+
+        size_t len = strpool_len(&symtab->names, symtab->v[i].name);
+
+        symbols[i] = (AsmCachedSymbol){at, symtab->v[i].addr};
+        memcpy(names + at, symtab_name(symtab, i), len + 1);
+        at += (uint32_t)len + 1;
+
+    }
+
+    *out_base = base;
+    *out_size = (size_t)h.total;
+
+    return ERR_OK;
+
+}
+
+
+static Err write_entry(app_context *app_context_param, const char *cache_dir, const AsmCacheKey *key, const void *base, size_t size){      // temporary file + rename
+
+    char path[4096], tmp[4200];
+    Err e = entry_path(app_context_param, cache_dir, key, path, sizeof(path));
+    if(e != ERR_OK) return e;
+
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);       // unique per call: workers storing the same key never share it
+
+    int fd = mkstemp(tmp);
+
+    if(fd < 0){
+
+        APP_PERROR(app_context_param, "CACHE ENTRY CAN NOT BE CREATED");
+        return ERR_IO;
+
+    }
+
+    if(fchmod(fd, 0644) != 0){
+
+        APP_PERROR(app_context_param, "CACHE ENTRY CAN NOT BE CREATED");
+        close(fd);
+        unlink(tmp);
+        return ERR_IO;
+
+    }
+
+    const char *p = base;
+    size_t left = size;
+
+    while(left > 0){
+
+        ssize_t w = write(fd, p, left);
+
+        if(w < 0 && errno == EINTR) continue;
+
+        if(w <= 0){
+
+            APP_PERROR(app_context_param, "CACHE ENTRY WRITE FAILED");
+            close(fd);
+            unlink(tmp);
+            return ERR_IO;
+
+        }
+
+        p += w;
+        left -= (size_t)w;
+
+    }
+
+    if(close(fd) != 0 || rename(tmp, path) != 0){
+
+        APP_PERROR(app_context_param, "CACHE ENTRY CAN NOT BE PUBLISHED");
+        unlink(tmp);
+        return ERR_IO;
+
+    }
+
+    return ERR_OK;
+
+}
+
+
+Err asm_cache_store(app_context *app_context_param, const char *cache_dir, const AsmCacheKey *key,
+                    const IR *ir, const Symtab *symtab, const AsmState *final_state, const AsmImage *image){
+
+    if(!cache_dir || !key || !ir || !symtab || !final_state || !image){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    void *base;
+    size_t size;
+
+    Err e = serialize_entry(app_context_param, key, ir, symtab, final_state, image, &base, &size);
+    if(e != ERR_OK) return e;
+
+    e = write_entry(app_context_param, cache_dir, key, base, size);
+    free(base);
+
+    return e;
+
+}
+
+
+static Err assemble_entry(app_context *app_context_param, const char *cache_dir, const AsmConfig *cfg, const mapped_program *program, const AsmCacheKey *key,
+                          asm_cached_program **out_program){      // the miss path: pass 1 + pass 2 over the hashed mapping, then the entry is both stored and returned
+
+    AsmConfig heap_cfg = *cfg;
+    heap_cfg.arena = NULL;
+
+    IR ir;
+    Symtab symtab;
+    AsmState state;
+    AsmImage image;
+
+    Err e = assemble_pass1_mapped(app_context_param, &heap_cfg, program, &ir, &symtab, &state);
+    if(e != ERR_OK) return e;
+
+    e = assemble_pass2(app_context_param, &heap_cfg, &ir, &symtab, &state, &image);
+
+    void *base = NULL;
+    size_t size = 0;
+
+    if(e == ERR_OK){
+
+        e = serialize_entry(app_context_param, key, &ir, &symtab, &state, &image, &base, &size);
+        asm_image_free(&image, app_context_param);
+
+    }
+
+    ir_free(&ir, app_context_param);
+    symtab_free(&symtab, app_context_param);
+
+    if(e != ERR_OK) return e;
+
+    write_entry(app_context_param, cache_dir, key, base, size);     // a cache that can not be written still assembles, the error is logged
+
+    asm_cached_program *p = calloc(1, sizeof(*p));
+
+    if(!p){
+
+        free(base);
+        APP_PERROR(app_context_param, "CACHED PROGRAM ALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    p->base = base;
+    p->size = size;
+    p->mapped = 0;
+    view_entry(base, size, key, &p->view);
+
+    *out_program = p;
+
+    return ERR_OK;
+
+}
+
+
+Err asm_cache_assemble_file(app_context *app_context_param, const char *cache_dir, const AsmConfig *cfg, const char *source_path,
+                            asm_cached_program **out_program, int *out_hit){
+
+    if(!cache_dir || !cfg || !source_path || !out_program){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    *out_program = NULL;
+    if(out_hit) *out_hit = 0;
+
+    // one mapping for the key and the assembly: a file changing meanwhile can not land under another content's key
+
+    mapped_program *program = create_mapped_program(app_context_param, source_path);
+    if(!program) return ERR_IO;
+
+    size_t len;
+    const char *bytes = mapped_program_text(program, &len);
+
+    AsmCacheKey key;
+    asm_cache_key(bytes, len, cfg, &key);
+
+    Err e = asm_cache_lookup(app_context_param, cache_dir, &key, out_program);
+
+    if(e == ERR_OK && *out_program){
+
+        if(out_hit) *out_hit = 1;
+
+    }
+    else if(e == ERR_OK) e = assemble_entry(app_context_param, cache_dir, cfg, program, &key, out_program);
+
+    destroy_mapped_program(app_context_param, program);
+
+    return e;
+
+}
+
+
+const AsmCachedView *asm_cached_view(const asm_cached_program *program){
+
+    return program ? &program->view : NULL;
+
+}
+
+
+Err destroy_asm_cached_program(app_context *app_context_param, asm_cached_program *program){
+
+    (void)app_context_param;
+
+    if(!program) return ERR_INVALID_ARGUMENT;
+
+    if(program->mapped) munmap(program->base, program->size);
+    else free(program->base);
+
+    free(program);
+
+    return ERR_OK;
+
+}
@@ -0,0 +1,40 @@
+#include "asm/encode.h"
+#include "core/error_handling.h"
+#include <stdint.h>
+#include <stdio.h>
+
+
+// register operand i (the base register for a memory operand) goes to:
+//   R: rd, rs, rt          (shift amount forms: rd, rt)
+//   I: rt, rs              (branches: rs, rt)
+//   J: no registers
+
+#define SHIFT_RS 21
+#define SHIFT_RT 16
+#define SHIFT_RD 11
+
+#define ISA_REG_SHIFT(format, imm_kind, i) \
+    ((format) == FMT_R ? ((imm_kind) == IMM_SHAMT5 ? ((i) == 0 ? SHIFT_RD : SHIFT_RT) : ((i) == 0 ? SHIFT_RD : (i) == 1 ? SHIFT_RS : SHIFT_RT)) \
+   : (format) == FMT_I ? ((imm_kind) == IMM_BRANCH16 ? ((i) == 0 ? SHIFT_RS : SHIFT_RT) : ((i) == 0 ? SHIFT_RT : SHIFT_RS)) \
+   : 0)
+
+const EncodeRule asm_encode_rules[ISA_COUNT] = {
+
+#define ISA_OPS(...)
+#define ISA_INSTR(id, mnemonic, format, opcode, funct, op_count, ops, imm_kind) \
+    [ISA_##id] = {((uint32_t)(opcode) << 26) | ((format) == FMT_R ? (uint32_t)(funct) : 0u), \
+                  {ISA_REG_SHIFT(format, imm_kind, 0), ISA_REG_SHIFT(format, imm_kind, 1), ISA_REG_SHIFT(format, imm_kind, 2)}, imm_kind},
+#include "core/isa_mips.def"
+#undef ISA_INSTR
+#undef ISA_OPS
+
+};
+
+
+void asm_report(app_context *app_context_param, uint32_t line_no, const char *message){
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "line %u: %s", line_no, message);
+    APP_ERROR(app_context_param, buf);
+
+}
@@ -0,0 +1,307 @@
+#include "asm/onepass.h"
+#include "asm/encode.h"
+#include "asm/pass1_stream.h"
+#include "core/error_handling.h"
+#include "core/ir.h"
+#include "core/symtab.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+
+typedef struct{
+
+    uint32_t at;            // text word to patch
+    uint32_t line_no;       // of the referencing instruction, for the diagnostic
+    uint32_t next;          // next fixup of the same label + 1, 0 ends the chain (and the free list)
+    uint8_t kind;           // ImmKind of the reference, IMM_NONE once patched
+
+}Fixup;
+
+typedef struct{
+
+    const AsmConfig *cfg;
+    Symtab *symtab;
+
+    AsmImage img;
+    size_t text_cap;
+    size_t data_cap;
+
+    Fixup *fix;             // every chain lives in here
+    size_t fix_n;
+    size_t fix_cap;
+    uint32_t free_head;     // patched fixups for reuse, index + 1
+
+    uint32_t *head;         // StrId -> first fixup of its chain + 1
+    size_t head_cap;
+
+}OnePass;
+
+
+static Err grow_words(app_context *app_context_param, Arena *arena, uint32_t **v, size_t *cap, size_t need){
+
+    size_t new_cap = *cap ? *cap : 1024;
+    while(new_cap < need) new_cap *= 2;
+
+    uint32_t *p = arena ? arena_realloc(arena, *v, sizeof(*p) * *cap, sizeof(*p) * new_cap, app_context_param)
+                        : realloc(*v, sizeof(*p) * new_cap);
+
+    if(!p){
+
+        APP_PERROR(app_context_param, "IMAGE REALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    *v = p;
+    *cap = new_cap;
+
+    return ERR_OK;
+
+}
+
+
+static Err chain_fixup(app_context *app_context_param, OnePass *op, StrId name, uint32_t at, uint32_t line_no, ImmKind kind){
+
+    if(name >= op->head_cap){
+
+        size_t new_cap = op->head_cap ? op->head_cap : 256;
+        while(new_cap <= name) new_cap *= 2;
+
+        uint32_t *p = realloc(op->head, sizeof(*p) * new_cap);
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "FIXUP HEADS REALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        memset(p + op->head_cap, 0, sizeof(*p) * (new_cap - op->head_cap));
+        op->head = p;
+        op->head_cap = new_cap;
+
+    }
+
+    uint32_t i;
+
+    if(op->free_head){
+
+        i = op->free_head - 1;
+        op->free_head = op->fix[i].next;
+
+    }
+    else{
+
+        if(op->fix_n == op->fix_cap){
+
+            size_t new_cap = op->fix_cap ? op->fix_cap * 2 : 256;
+            Fixup *p = realloc(op->fix, sizeof(*p) * new_cap);
+
+            if(!p){
+
+                APP_PERROR(app_context_param, "FIXUPS REALLOC FAILED.");
+                return ERR_OOM;
+
+            }
+
+            op->fix = p;
+            op->fix_cap = new_cap;
+
+        }
+
+        i = (uint32_t)op->fix_n++;
+
+    }
+
+    op->fix[i] = (Fixup){at, line_no, op->head[name], (uint8_t)kind};
+    op->head[name] = i + 1;
+
+    return ERR_OK;
+
+}
+
+
+static Err resolve_chain(app_context *app_context_param, OnePass *op, StrId name, uint32_t addr){      // name was just defined at addr
+
+    if(name >= op->head_cap || !op->head[name]) return ERR_OK;
+
+    uint32_t i = op->head[name];
+    op->head[name] = 0;
+
+    while(i){
+
+        Fixup *f = &op->fix[i - 1];
+        uint32_t next = f->next;
+
+        Err e = asm_encode_target(app_context_param, f->line_no, (ImmKind)f->kind, op->cfg->text_base + f->at * 4, addr, &op->img.text[f->at]);
+        if(e != ERR_OK) return e;
+
+        f->kind = IMM_NONE;
+        f->next = op->free_head;
+        op->free_head = i;
+        i = next;
+
+    }
+
+    return ERR_OK;
+
+}
+
+
+static Err onepass_sink(void *ctx, const Statement *statement, const AsmState *state, app_context *app_context_param){
+
+    OnePass *op = ctx;
+    IrRec r;
+
+    Err e = ir_encode(statement, &r, app_context_param);
+    if(e != ERR_OK) return e;
+
+    if(r.label != STRID_NONE){
+
+        uint32_t addr;
+        if((e = symtab_lookup_id(op->symtab, r.label, &addr, app_context_param)) != ERR_OK) return e;
+        if((e = resolve_chain(app_context_param, op, r.label, addr)) != ERR_OK) return e;
+
+    }
+
+    if(r.kind == ST_INSTR || r.kind == ST_LABEL_PLUS_INSTR){
+
+        size_t at = state->text_pc / 4 - 1;
+
+        if(at >= op->text_cap && (e = grow_words(app_context_param, op->img.arena, &op->img.text, &op->text_cap, at + 1)) != ERR_OK) return e;
+
+        uint32_t w;
+        if((e = asm_encode_instr(app_context_param, &r, &w)) != ERR_OK) return e;
+
+        ImmKind kind = asm_label_kind(&r);
+
+        if(kind != IMM_NONE){
+
+            uint32_t target;
+
+            if(symtab_lookup_id(op->symtab, r.val, &target, app_context_param) == ERR_OK) e = asm_encode_target(app_context_param, r.line_no, kind, op->cfg->text_base + (uint32_t)at * 4, target, &w);
+            else e = chain_fixup(app_context_param, op, r.val, (uint32_t)at, r.line_no, kind);        // forward reference
+
+            if(e != ERR_OK) return e;
+
+        }
+
+        op->img.text[at] = w;
+
+    }
+    else if(r.kind == ST_DIR_WORD || r.kind == ST_LABEL_PLUS_DIR_WORD){
+
+        const int32_t *values = (r.kind == ST_DIR_WORD) ? statement->as.dir_word.values : statement->as.label_plus_dir_word.dir_word.values;
+        size_t n = (r.kind == ST_DIR_WORD) ? statement->as.dir_word.n : statement->as.label_plus_dir_word.dir_word.n;
+        size_t at = state->data_pc / 4 - n;
+
+        if(at + n > op->data_cap && (e = grow_words(app_context_param, op->img.arena, &op->img.data, &op->data_cap, at + n)) != ERR_OK) return e;
+        if(n) memcpy(&op->img.data[at], values, sizeof(*values) * n);
+
+    }
+
+    return ERR_OK;
+
+}
+
+
+static Err onepass_run(app_context *app_context_param, const AsmConfig *cfg, pass1_read_fn read_fn, void *source, AsmImage *out_image, Symtab *out_symtab, AsmState *out_final_state){
+
+    OnePass op = {0};
+    op.cfg = cfg;
+    op.symtab = out_symtab;
+    op.img.text_base = cfg->text_base;
+    op.img.data_base = cfg->data_base;
+    op.img.arena = cfg->arena;
+
+    ArenaMark mark = {0};
+    if(cfg->arena) mark = arena_mark(cfg->arena);
+
+    AsmState state;
+    Err e = pass1_stream_run(app_context_param, cfg, read_fn, source, NULL, out_symtab, &state, onepass_sink, &op);
+    int symtab_ok = (e == ERR_OK);
+
+    if(e == ERR_OK){        // what is still chained was never defined, the first one in line order is reported
+
+        uint32_t first_line = 0;
+
+        for(size_t i = 0; i < op.fix_n; i++){
+
+            if(op.fix[i].kind != IMM_NONE && (!first_line || op.fix[i].line_no < first_line)) first_line = op.fix[i].line_no;
+
+        }
+
+        if(first_line){
+
+            asm_report(app_context_param, first_line, "UNDEFINED LABEL");
+            e = ERR_UNDEF_LABEL;
+
+        }
+
+    }
+
+    if(e == ERR_OK && (e = grow_words(app_context_param, op.img.arena, &op.img.text, &op.text_cap, 1)) == ERR_OK)      // an empty section still gets its buffer
+        e = grow_words(app_context_param, op.img.arena, &op.img.data, &op.data_cap, 1);
+
+    free(op.fix);
+    free(op.head);
+
+    if(e != ERR_OK){
+
+        if(symtab_ok) symtab_free(out_symtab, app_context_param);        // pass1_stream_run() cleans up after its own errors
+        asm_image_free(&op.img, app_context_param);
+        if(cfg->arena) arena_rewind(cfg->arena, mark);
+
+        return e;
+
+    }
+
+    op.img.text_n = state.text_pc / 4;
+    op.img.data_n = state.data_pc / 4;
+
+    *out_image = op.img;
+    *out_final_state = state;
+
+    return ERR_OK;
+
+}
+
+
+Err assemble_onepass_stream(app_context *app_context_param, const AsmConfig *cfg, FILE *input, AsmImage *out_image, Symtab *out_symtab, AsmState *out_final_state){
+
+    if(!cfg || !input || !out_image || !out_symtab || !out_final_state) {
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    Err e = onepass_run(app_context_param, cfg, pass1_read_file, input, out_image, out_symtab, out_final_state);
+    if(e == ERR_READ_ERROR) APP_ERROR(app_context_param, "READ ERROR WHILE STREAMING INPUT");
+
+    return e;
+
+}
+
+
+Err assemble_onepass_fd(app_context *app_context_param, const AsmConfig *cfg, int fd, AsmImage *out_image, Symtab *out_symtab, AsmState *out_final_state){
+
+    if(!cfg || fd < 0 || !out_image || !out_symtab || !out_final_state) {
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    Err e = onepass_run(app_context_param, cfg, pass1_read_fd, &fd, out_image, out_symtab, out_final_state);
+    if(e == ERR_READ_ERROR) APP_PERROR(app_context_param, "READ ERROR WHILE STREAMING INPUT");
+
+    return e;
+
+}
@@ -1,329 +1,641 @@
 #include "asm/pass1.h"
+#include "asm/pass1_parallel.h"
+#include "asm/pass1_pipeline.h"
+#include "asm/pass1_stream.h"
 #include "core/error_handling.h"
 #include "core/ir.h"
 #include "core/symtab.h"
-#include "front/preprocess.h"
+#include "core/line.h"
 #include "front/lexer.h"
+#include "front/scanner.h"
 #include "front/parser.h"
 #include <stdint.h>
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
-Err assemble_pass1(app_context *app_context_param, const AsmConfig *cfg, char **lines, size_t nlines, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state){
 
-    if(!cfg || !lines || !out_ir || !out_symtab || !out_final_state) {
+typedef struct{
 
-        APP_ERROR(app_context_param, "INVALID ARGUMENT");
-        return ERR_INVALID_ARGUMENT;
+    app_context *app;
+    const AsmConfig *cfg;
+    Arena *arena;           // cfg->arena, NULL when pass 1 allocates from the heap
+    ArenaMark mark;         // arena position at entry, a failed run rewinds to it
+    IR *ir;                 // NULL: statements are dropped after address assignment
+    pass1_sink_fn sink;     // optional: sees every statement after address assignment, instead of the IR
+    void *sink_ctx;
+    Symtab *symtab;
+    AsmState state;
+    TokenVec tv;            // one token vector reused by every line
+    Arena scratch;          // .word values of the line being parsed, rewound to scratch_mark after every line
+    ArenaMark scratch_mark;
+    DiagList *diag;         // cfg->diagnostics: recovery mode
+    DiagList *parser_diag;  // list of the parser before pass 1 installed diag, put back by pass1_end()
+    Err first_error;        // recovery mode: the result once the input is read
+    AsmStatsProbe probe;    // cfg->stats, the stages of the line being assembled
 
-    }
+}Pass1;
 
-    Err e;
-    if((e = ir_init(out_ir, app_context_param)) != ERR_OK) return e;
-    if ((e = symtab_init(out_symtab, app_context_param)) != ERR_OK) return e;
 
-    AsmState state = {0};
-    state.section = SEC_NONE;
-    state.text_pc = 0;
-    state.data_pc = 0;
+static Err pass1_error(Pass1 *p, int line_no, const char *message){
 
-    for(size_t ith_line = 0; ith_line < nlines; ith_line++){
+    if(p->diag) return diag_add(p->diag, (uint32_t)line_no, 0, ERR_SYNTAX, message, p->tv.src, p->tv.src_len, p->app) == ERR_OK ? ERR_SYNTAX : ERR_OOM;
 
-        char buf[1024];
-        strncpy(buf, lines[ith_line]? lines[ith_line] : "", sizeof(buf) - 1);
-        buf[sizeof(buf) - 1] = '\0';
+    APP_ERROR(p->app, message);
+    return ERR_SYNTAX;
 
+}
 
-        strip_comment(buf);
-        trim_inplace(buf);
 
-        if(buf[0] == '\0') continue;
+static Err pass1_define(Pass1 *p, int line_no, StrId name, uint32_t addr){
 
-        TokenVec tv = {0};
-        e = lex_line(buf, (int)ith_line + 1, &tv, app_context_param);
+    if(p->diag && symtab_find_id(p->symtab, name) >= 0) return pass1_error(p, line_no, "duplicate label");
 
-        if(e != ERR_OK){
+    return symtab_add_id(p->symtab, name, addr, p->app);
 
-            tokenvec_free(&tv, app_context_param);
-            ir_free(out_ir, app_context_param);
-            symtab_free(out_symtab, app_context_param);
-            
-            return e;
+}
 
-        }
 
-        
-        int has_label = 0;
-        Statement statement = {0};
+static Err pass1_statement(Pass1 *p, const Statement *statement){      // section tracking + address assignment for one parsed statement, then its compact record goes to the IR.
 
-        e = parse_line(app_context_param, &tv, buf, (int)ith_line + 1, &has_label, &statement);
-        tokenvec_free(&tv, app_context_param);
+    app_context *app_context_param = p->app;
+    const AsmConfig *cfg = p->cfg;
+    AsmState *state = &p->state;
+    Err e;
 
+    if(statement->kind == ST_LABEL){
 
-        if(e != ERR_OK){
+        if(state->section == SEC_NONE){
 
-            // statement that acquired from parse_line can be have some heap parts, so we have to check and free it for per line
+            return pass1_error(p, statement->line_no, "label before selecting .text/.data section");
 
-            stmt_free_heap_parts(&statement);
-            ir_free(out_ir, app_context_param);
-            symtab_free(out_symtab, app_context_param);
+        }
 
-            return e;
 
-        }
+        uint32_t base = (state->section == SEC_TEXT) ? cfg->text_base : cfg->data_base;
+        uint32_t pc = (state->section == SEC_TEXT) ? state->text_pc : state->data_pc;
+        uint32_t addr = base + pc;
 
-        if(statement.kind == ST_LABEL){
 
-            if(state.section == SEC_NONE){
+        ASM_STATS_RESTART(&p->probe);
+        e = pass1_define(p, statement->line_no, statement->as.label.name, addr);
+        ASM_STATS_END(&p->probe, ASM_STAGE_SYMTAB, 0);
 
-                APP_ERROR(app_context_param, "label before selecting .text/.data section");
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
-                return ERR_SYNTAX;
+        if(e != ERR_OK) return e;
 
-            }
+    }
 
+    else if(statement->kind == ST_EMPTY){
 
-            uint32_t base = (state.section == SEC_TEXT) ? cfg->text_base : cfg->data_base;
-            uint32_t pc = (state.section == SEC_TEXT) ? state.text_pc : state.data_pc;
-            uint32_t addr = base + pc;
+        return ERR_OK;
 
+    }
 
-            e = symtab_add(out_symtab, statement.as.label.name, addr, app_context_param);
+    else if(statement->kind == ST_DIR_TEXT){
 
-            if(e != ERR_OK){
+        state->section = SEC_TEXT;
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+    }
 
-                return e;
+    else if(statement->kind == ST_DIR_DATA){
 
-            }
+        state->section = SEC_DATA;
 
-        
-            e = ir_push(out_ir, &statement, app_context_param);
+    }
 
-            if(e != ERR_OK){
+    else if(statement->kind == ST_DIR_WORD){
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+        if(state->section != SEC_DATA){
 
-                return e;
+            return pass1_error(p, statement->line_no, ".word directives are out of .data section");
 
-            }
+        }
+
+        state->data_pc = state->data_pc + (statement->as.dir_word.n * 4);  // a word is 4 byte and we have statement.as.dir.word.n words
+
+    }
+
+    else if(statement->kind == ST_INSTR){
+
+        if(state->section != SEC_TEXT){
+
+            return pass1_error(p, statement->line_no, "Instruction outside of .text section");
 
-            continue;
         }
 
+        state->text_pc += 4;
+
+    }
+
+    else if(statement->kind == ST_LABEL_PLUS_DIR_WORD){
 
-        if(statement.kind == ST_EMPTY){
+        if(state->section != SEC_DATA){
 
-            continue;
+            return pass1_error(p, statement->line_no, ".word must be defined in .data section.");
 
         }
 
-        if(statement.kind == ST_DIR_TEXT){
+        uint32_t addr = cfg->data_base + state->data_pc;
 
-            state.section = SEC_TEXT;
-            e = ir_push(out_ir, &statement, app_context_param);
+        ASM_STATS_RESTART(&p->probe);
+        e = pass1_define(p, statement->line_no, statement->as.label_plus_dir_word.name, addr);
+        ASM_STATS_END(&p->probe, ASM_STAGE_SYMTAB, 0);
 
-            if(e != ERR_OK){
+        if(e != ERR_OK) return e;
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+        state->data_pc += statement->as.label_plus_dir_word.dir_word.n * 4;
 
-                return e;
+    }
 
-            }
+    else if(statement->kind == ST_LABEL_PLUS_INSTR){
+
+        if(state->section != SEC_TEXT){
+
+            return pass1_error(p, statement->line_no, "an instruction cannot be defined anywhere except .text section.");
 
-            continue;
         }
 
-        if(statement.kind == ST_DIR_DATA){
+        uint32_t addr = cfg->text_base + state->text_pc;
 
-            state.section = SEC_DATA;
-            e = ir_push(out_ir, &statement, app_context_param);
+        ASM_STATS_RESTART(&p->probe);
+        e = pass1_define(p, statement->line_no, statement->as.label_plus_instr.name, addr);
+        ASM_STATS_END(&p->probe, ASM_STAGE_SYMTAB, 0);
 
-            if(e != ERR_OK){
+        if(e != ERR_OK) return e;
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+        state->text_pc += 4;
 
-                return e;
+    }
 
-            }
+    else{
 
-            continue;
+        return ERR_OK;
 
-        }
+    }
 
+    if(!p->sink && !p->ir) return ERR_OK;       // streaming without IR: only addresses and symbols are kept.
 
-        if(statement.kind == ST_DIR_WORD){
+    ASM_STATS_RESTART(&p->probe);
+    e = p->sink ? p->sink(p->sink_ctx, statement, state, app_context_param) : ir_push(p->ir, statement, app_context_param);
+    ASM_STATS_END(&p->probe, ASM_STAGE_IR, sizeof(IrRec));
 
-            if(state.section != SEC_DATA){
+    return e;
 
-                APP_ERROR(app_context_param, ".word directives are out of .data section");
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+}
 
-                return ERR_SYNTAX;
 
-            }
+static Err pass1_recover(Pass1 *p, Err e, size_t reported, size_t ith_line){
 
-            state.data_pc = state.data_pc + (statement.as.dir_word.n * 4);  // a word is 4 byte and we have statement.as.dir.word.n words
-            e = ir_push(out_ir, &statement, app_context_param);
+    if(p->diag && (e == ERR_SYNTAX || e == ERR_UNDEF_LABEL)){
 
-            if(e != ERR_OK){
+        // recovery: the line is dropped, the next one starts from the state before it
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+        if(p->first_error == ERR_OK) p->first_error = e;
 
-                return e;
+        e = (p->diag->n == reported) ? diag_add(p->diag, (uint32_t)ith_line + 1, 0, e, "invalid statement", p->tv.src, p->tv.src_len, p->app) : ERR_OK;
 
-            }
+    }
 
-            continue;
+    return e;
 
-        }
+}
 
 
-        if(statement.kind == ST_INSTR){
+static Err pass1_line(Pass1 *p, const char *line, size_t len, size_t ith_line){
 
-            if(state.section != SEC_TEXT){
+    // scan_line strips the comment, skips the blanks and tokenizes straight from the source bytes, no per line copy.
 
-                APP_ERROR(app_context_param, "Instruction outside of .text section");
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+    ASM_STATS_BEGIN(&p->probe, p->cfg->stats, ith_line);
 
-                return ERR_SYNTAX;
+    Err e = scan_line(line, len, (int)ith_line + 1, &p->tv, p->app);
+    ASM_STATS_END(&p->probe, ASM_STAGE_LEX, len);
+    if(e != ERR_OK || p->tv.n == 0) return e;
 
-            }
 
-            state.text_pc += 4;
-            
-            e = ir_push(out_ir, &statement, app_context_param);
+    int has_label = 0;
+    Statement statement = {0};
 
-            if(e != ERR_OK){
+    size_t reported = p->diag ? p->diag->n : 0;
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+    e = parse_line(p->app, &p->scratch, &p->symtab->names, &p->tv, (int)ith_line + 1, &has_label, &statement);
+    ASM_STATS_END(&p->probe, ASM_STAGE_PARSE, len);
+    if(e == ERR_OK) e = pass1_statement(p, &statement);
 
-                return e;
+    arena_rewind(&p->scratch, p->scratch_mark);         // ir_push copied what it needs, the next line reuses the same bytes
 
-            }
+    return pass1_recover(p, e, reported, ith_line);
 
-            continue;
+}
 
-        }
 
-        if(statement.kind == ST_LABEL_PLUS_DIR_WORD){
+static Err pass1_parsed(Pass1 *p, const Statement *statement, const char *line, size_t len, size_t ith_line){      // a statement the pipeline's scanner parsed
 
-            if(state.section != SEC_DATA){
+    ASM_STATS_BEGIN(&p->probe, p->cfg->stats, ith_line);
 
-                APP_ERROR(app_context_param, ".word must be defined in .data section.");
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+    p->tv.src = line;           // what pass1_error() quotes, the tokens themselves are not needed any more
+    p->tv.src_len = len;
 
-                return ERR_SYNTAX;
+    size_t reported = p->diag ? p->diag->n : 0;
 
-            }
+    return pass1_recover(p, pass1_statement(p, statement), reported, ith_line);
 
-            uint32_t base = cfg->data_base;
-            uint32_t pc = state.data_pc;
-            uint32_t addr = base + pc;
+}
 
-            e = symtab_add(out_symtab, statement.as.label_plus_dir_word.name, addr, app_context_param);
 
-            if(e != ERR_OK){
+static Err pass1_begin(Pass1 *p, app_context *app_context_param, const AsmConfig *cfg, IR *out_ir, Symtab *out_symtab){
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+    memset(p, 0, sizeof(*p));
+    p->app = app_context_param;
+    p->cfg = cfg;
+    p->arena = cfg->arena;
+    p->state.section = SEC_NONE;
 
-                return e;
+    if(p->arena) p->mark = arena_mark(p->arena);
 
-            }
+    if(cfg->diagnostics){
 
-            state.data_pc += statement.as.label_plus_dir_word.dir_word.n * 4;
-            e = ir_push(out_ir, &statement, app_context_param);
-            
-            if(e != ERR_OK){
+        p->diag = cfg->diagnostics;
+        p->parser_diag = parser_set_diagnostics(p->diag);
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+    }
 
-                return e;
+    Err e;
+    if((e = arena_init(&p->scratch, 4096, app_context_param)) != ERR_OK) return e;
+    if(!arena_alloc(&p->scratch, 1, app_context_param)) return ERR_OOM;       // the first block then outlives every rewind
+    p->scratch_mark = arena_mark(&p->scratch);
 
-            }
+    // pass1_end() frees only what is set here, so an early failure never frees the caller's uninitialized outputs
+
+    if(out_ir && (e = ir_init_arena(out_ir, p->arena, app_context_param)) != ERR_OK) return e;
+    p->ir = out_ir;
+    if((e = symtab_init_arena(out_symtab, p->arena, app_context_param)) != ERR_OK) return e;
+    p->symtab = out_symtab;
+    if((e = tokenvec_init_arena(&p->tv, p->arena, app_context_param)) != ERR_OK) return e;
+
+    return ERR_OK;
+
+}
+
+
+static Err pass1_end(Pass1 *p, Err e, AsmState *out_final_state){      // the single cleanup site of every entry point
+
+    tokenvec_free(&p->tv, p->app);
+    arena_free(&p->scratch, p->app);
+
+    if(p->diag){
+
+        parser_set_diagnostics(p->parser_diag);
+        if(e == ERR_OK) e = p->first_error;
+
+    }
+
+    if(e != ERR_OK){
+
+        if(p->ir) ir_free(p->ir, p->app);
+        if(p->symtab) symtab_free(p->symtab, p->app);
+        if(p->arena) arena_rewind(p->arena, p->mark);       // O(1) in the number of statements
+
+        return e;
+
+    }
+
+    *out_final_state = p->state;
+    return ERR_OK;
+
+}
+
+
+static LineView line_of_array(const void *source, size_t index){
+
+    const char *line = ((char *const *)source)[index];
+    if(!line) line = "";
+
+    LineView view = {line, strlen(line)};
+    return view;
+
+}
+
+
+static LineView line_of_mapped(const void *source, size_t index){
+
+    return mapped_program_line(source, index);
+
+}
+
+
+Err assemble_pass1(app_context *app_context_param, const AsmConfig *cfg, char **lines, size_t nlines, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state){
+
+    if(!cfg || !lines || !out_ir || !out_symtab || !out_final_state) {
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    if(cfg->pool){
+
+        int rerun_serial = 0;
+        Err e = pass1_parallel(app_context_param, cfg, line_of_array, lines, nlines, out_ir, out_symtab, out_final_state, &rerun_serial);
+        if(e != ERR_OK || !rerun_serial) return e;
+
+    }
+
+    Pass1 p;
+    Err e = pass1_begin(&p, app_context_param, cfg, out_ir, out_symtab);
+
+    for(size_t ith_line = 0; e == ERR_OK && ith_line < nlines; ith_line++){
+
+        const char *line = lines[ith_line] ? lines[ith_line] : "";
+        e = pass1_line(&p, line, strlen(line), ith_line);
+
+    }
+
+    return pass1_end(&p, e, out_final_state);
+
+}
+
+
+Err assemble_pass1_mapped(app_context *app_context_param, const AsmConfig *cfg, const mapped_program *program, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state){
+
+    if(!cfg || !program || !out_ir || !out_symtab || !out_final_state) {
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    size_t nlines = mapped_program_line_count(program);
 
-            continue;
+    if(cfg->pool){
 
+        int rerun_serial = 0;
+        Err e = pass1_parallel(app_context_param, cfg, line_of_mapped, program, nlines, out_ir, out_symtab, out_final_state, &rerun_serial);
+        if(e != ERR_OK || !rerun_serial) return e;
+
+    }
+
+    Pass1 p;
+    Err e = pass1_begin(&p, app_context_param, cfg, out_ir, out_symtab);
+
+    for(size_t ith_line = 0; e == ERR_OK && ith_line < nlines; ith_line++){
+
+        LineView view = mapped_program_line(program, ith_line);     // non-owning, no per line allocation
+        e = pass1_line(&p, view.text, view.len, ith_line);
+
+    }
+
+    return pass1_end(&p, e, out_final_state);
+
+}
+
+
+
+static Err pass1_batch(Pass1 *p, const Pass1Batch *b){
+
+    // names first, in the scanner's id order: the ids of the statements then mean the same in p->symtab->names
+
+    for(size_t i = 0; i < b->n_names; i++){
+
+        StrId id;
+        Err e = strpool_intern(&p->symtab->names, b->names[i].s, b->names[i].len, &id, p->app);
+        if(e != ERR_OK) return e;
+
+        if(id != b->first_name + i){
+
+            APP_ERROR(p->app, "PIPELINE: NAME IDS OUT OF STEP");
+            return ERR_UB;
 
         }
 
-        if(statement.kind == ST_LABEL_PLUS_INSTR){
+    }
 
-            if(state.section != SEC_TEXT){
+    for(size_t i = 0; i < b->n; i++){
 
-                APP_ERROR(app_context_param, "an instruction cannot be defined anywhere except .text section.");
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+        const Pass1PipeLine *l = &b->lines[i];
+        Err e;
 
-                return ERR_SYNTAX;
+        if(l->e == ERR_OK) e = pass1_parsed(p, &l->statement, l->text, l->len, l->line);
+        else if(l->e == ERR_SYNTAX || l->e == ERR_UNDEF_LABEL) e = pass1_line(p, l->text, l->len, l->line);      // reported the serial way
+        else e = l->e;
 
-            }
+        if(e != ERR_OK) return e;
+
+    }
 
-            uint32_t base = cfg->text_base;
-            uint32_t pc = state.text_pc;
-            uint32_t addr = base + pc;
+    return b->e;
 
-            e = symtab_add(out_symtab, statement.as.label_plus_instr.name, addr, app_context_param);
+}
 
-            if(e != ERR_OK){
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+static Err pass1_pipeline_run(app_context *app_context_param, const AsmConfig *cfg, pass1_read_fn read_fn, void *source, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state,
+                              pass1_sink_fn sink, void *sink_ctx){
 
-                return e;
+    Pass1 p;
+    Err e = pass1_begin(&p, app_context_param, cfg, out_ir, out_symtab);
+    p.sink = sink;
+    p.sink_ctx = sink_ctx;
+
+    pass1_pipeline *pipeline = NULL;
+    if(e == ERR_OK && !(pipeline = create_pass1_pipeline(app_context_param, cfg, read_fn, source))) e = ERR_OOM;
+
+    for(int last = 0; e == ERR_OK && !last;){
+
+        Pass1Batch *b = pass1_pipeline_next(pipeline);
+
+        e = pass1_batch(&p, b);
+        last = b->last;
+
+        pass1_pipeline_release(pipeline, b);
+
+    }
+
+    if(pipeline){
+
+        Err destroy_e = destroy_pass1_pipeline(app_context_param, pipeline);
+        if(e == ERR_OK) e = destroy_e;
+
+    }
+
+    return pass1_end(&p, e, out_final_state);
+
+}
+
+
+Err pass1_stream_run(app_context *app_context_param, const AsmConfig *cfg, pass1_read_fn read_fn, void *source, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state,
+                     pass1_sink_fn sink, void *sink_ctx){
+
+    if(cfg->pipelined) return pass1_pipeline_run(app_context_param, cfg, read_fn, source, out_ir, out_symtab, out_final_state, sink, sink_ctx);
+
+    size_t cap = PASS1_STREAM_WINDOW;
+    char *window = app_alloc(app_context_param, APP_MEM_OTHER, NULL, 0, cap);       // the pipeline batches are counted the same way
+
+    if(!window){
+
+        APP_PERROR(app_context_param, "STREAM WINDOW MALLOC FAILED");
+        return ERR_OOM;
+
+    }
+
+    Pass1 p;
+    Err e = pass1_begin(&p, app_context_param, cfg, out_ir, out_symtab);
+    p.sink = sink;
+    p.sink_ctx = sink_ctx;
+
+    size_t head = 0;            // first byte not consumed yet
+    size_t scanned = 0;         // [head, scanned) holds no newline: a line spread over many refills is searched once
+    size_t tail = 0;            // end of valid bytes
+    size_t ith_line = 0;
+    int eof = 0;
+
+    while(e == ERR_OK){
+
+        // every complete line inside the window is assembled in place
+
+        while(head < tail){
+
+            char *nl = memchr(window + scanned, '\n', tail - scanned);
+
+            if(!nl){
+
+                scanned = tail;
+                break;
 
             }
 
-            state.text_pc += 4;
+            size_t len = (size_t)(nl - (window + head));
 
-            e = ir_push(out_ir, &statement, app_context_param);
+            e = pass1_line(&p, window + head, len, ith_line);
+            if(e != ERR_OK) break;
+
+            head += len + 1;
+            scanned = head;
+            ith_line++;
+
+        }
 
-            if(e != ERR_OK){
+        if(e != ERR_OK) break;
 
-                stmt_free_heap_parts(&statement);
-                ir_free(out_ir, app_context_param);
-                symtab_free(out_symtab, app_context_param);
+        if(eof){
 
-                return e;
+            if(head < tail) e = pass1_line(&p, window + head, tail - head, ith_line);
+            break;
+
+        }
+
+        // keep the partial line: slide it to the front of the window, or double the window when the line fills it alone
+
+        if(head > 0){
+
+            memmove(window, window + head, tail - head);
+            tail -= head;
+            scanned -= head;
+            head = 0;
+
+        }
+        else if(tail == cap){
+
+            char *grown = app_alloc(app_context_param, APP_MEM_OTHER, window, cap, cap * 2);
+
+            if(!grown){
+
+                APP_PERROR(app_context_param, "STREAM WINDOW REALLOC FAILED");
+                e = ERR_OOM;
+                break;
 
             }
 
-            continue;
+            window = grown;
+            cap *= 2;
 
         }
 
+        size_t n = 0;
+        ASM_STATS_TIME_BEGIN(t, cfg->stats);
+        e = read_fn(source, window + tail, cap - tail, &n);
+        ASM_STATS_TIME_END(t, cfg->stats, ASM_STAGE_READ, n);       // one call per window refill, all of them timed
+        if(e != ERR_OK) break;
 
-        stmt_free_heap_parts(&statement);
+        if(n == 0) eof = 1;
+        tail += n;
 
     }
 
-    *out_final_state = state;
+    app_free(app_context_param, APP_MEM_OTHER, window, cap);
+
+    return pass1_end(&p, e, out_final_state);
+
+}
+
+
+Err pass1_read_file(void *source, char *dst, size_t cap, size_t *out_n){
+
+    FILE *f = source;
+    *out_n = fread(dst, 1, cap, f);
+
+    if(*out_n == 0 && ferror(f)) return ERR_READ_ERROR;
     return ERR_OK;
 
-}
\ No newline at end of file
+}
+
+
+Err pass1_read_fd(void *source, char *dst, size_t cap, size_t *out_n){
+
+    int fd = *(const int *)source;
+
+    for(;;){
+
+        ssize_t r = read(fd, dst, cap);
+
+        if(r >= 0){
+
+            *out_n = (size_t)r;
+            return ERR_OK;
+
+        }
+
+        if(errno != EINTR) return ERR_READ_ERROR;
+
+    }
+
+}
+
+
+Err assemble_pass1_stream(app_context *app_context_param, const AsmConfig *cfg, FILE *input, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state){
+
+    if(!cfg || !input || !out_symtab || !out_final_state) {
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    Err e = pass1_stream_run(app_context_param, cfg, pass1_read_file, input, out_ir, out_symtab, out_final_state, NULL, NULL);
+    if(e == ERR_READ_ERROR) APP_ERROR(app_context_param, "READ ERROR WHILE STREAMING INPUT");
+
+    return e;
+
+}
+
+
+Err assemble_pass1_fd(app_context *app_context_param, const AsmConfig *cfg, int fd, IR *out_ir, Symtab *out_symtab, AsmState *out_final_state){
+
+    if(!cfg || fd < 0 || !out_symtab || !out_final_state) {
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);     // let the kernel read ahead while we parse.
+#endif
+
+    Err e = pass1_stream_run(app_context_param, cfg, pass1_read_fd, &fd, out_ir, out_symtab, out_final_state, NULL, NULL);
+    if(e == ERR_READ_ERROR) APP_PERROR(app_context_param, "READ ERROR WHILE STREAMING INPUT");
+
+    return e;
+
+}
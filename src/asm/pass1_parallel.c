@@ -0,0 +1,455 @@
+#include "asm/pass1_parallel.h"
+#include "core/error_handling.h"
+#include "core/ir.h"
+#include "core/isa_mips.h"
+#include "core/strpool.h"
+#include "core/symtab.h"
+#include "front/lexer.h"
+#include "front/parser.h"
+#include "front/scanner.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define PASS1_CHUNKS_PER_THREAD 4       // a few chunks per thread evens out lines of different cost
+
+
+typedef enum{
+
+    CHUNK_SEC_INHERITED = 0,            // before the first .text/.data of the chunk: the section the previous chunk ended in
+    CHUNK_SEC_TEXT,
+    CHUNK_SEC_DATA
+
+}ChunkSection;
+
+typedef struct{
+
+    StrId name;                         // in the chunk pool
+    uint8_t section;                    // ChunkSection
+    uint32_t offset;                    // bytes into that section from the chunk start (after the inherited prefix for TEXT/DATA)
+
+}ChunkLabel;
+
+typedef struct{
+
+    size_t first_line;
+    size_t end_line;
+
+    IR ir;                              // label StrIds of the records are chunk pool ids until the merge
+    StrPool pool;
+    ChunkLabel *labels;
+    size_t n_labels;
+    size_t cap_labels;
+
+    // what the chunk does to the sections
+
+    uint32_t prefix_bytes;              // instructions and .word bytes before the first directive
+    int prefix_has_instr;
+    int prefix_has_word;
+    int prefix_has_label;
+    int has_directive;
+    Section final_section;              // last directive, valid when has_directive
+    uint32_t text_bytes;                // after the first directive
+    uint32_t data_bytes;
+
+    Err e;                              // ERR_OK, or the first error: syntax and section errors ask for the serial rerun
+    AsmStats stats;                     // lex, parse and IR stages of the chunk, added to AsmConfig.stats after a merge
+
+}Pass1Chunk;
+
+typedef struct{
+
+    app_context *app;
+    pass1_line_at_fn line_at;
+    const void *source;
+    Pass1Chunk *chunks;
+    int collect_stats;
+
+}Pass1Job;
+
+
+static Err chunk_add_label(Pass1Chunk *c, StrId name, ChunkSection section, uint32_t offset, app_context *app_context_param){
+
+    if(c->n_labels == c->cap_labels){
+
+        size_t new_cap = c->cap_labels ? c->cap_labels * 2 : 64;
+        ChunkLabel *p = realloc(c->labels, sizeof(*p) * new_cap);
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "CHUNK LABELS REALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        c->labels = p;
+        c->cap_labels = new_cap;
+
+    }
+
+    c->labels[c->n_labels++] = (ChunkLabel){name, (uint8_t)section, offset};
+
+    return ERR_OK;
+
+}
+
+
+static Err chunk_account(Pass1Chunk *c, const Statement *s, app_context *app_context_param){      // the part of pass1_statement() that does not need the incoming section
+
+    StrId label = STRID_NONE;
+    uint32_t instr_bytes = 0, word_bytes = 0;
+
+    switch(s->kind){
+
+        case ST_DIR_TEXT: c->has_directive = 1; c->final_section = SEC_TEXT; return ERR_OK;
+        case ST_DIR_DATA: c->has_directive = 1; c->final_section = SEC_DATA; return ERR_OK;
+        case ST_LABEL: label = s->as.label.name; break;
+        case ST_INSTR: instr_bytes = 4; break;
+        case ST_LABEL_PLUS_INSTR: label = s->as.label_plus_instr.name; instr_bytes = 4; break;
+        case ST_DIR_WORD: word_bytes = (uint32_t)(s->as.dir_word.n * 4); break;
+        case ST_LABEL_PLUS_DIR_WORD: label = s->as.label_plus_dir_word.name; word_bytes = (uint32_t)(s->as.label_plus_dir_word.dir_word.n * 4); break;
+        default: return ERR_OK;
+
+    }
+
+    int is_instr = (s->kind == ST_INSTR || s->kind == ST_LABEL_PLUS_INSTR);
+    int is_word = (s->kind == ST_DIR_WORD || s->kind == ST_LABEL_PLUS_DIR_WORD);
+
+    if(!c->has_directive){
+
+        if(label != STRID_NONE){
+
+            c->prefix_has_label = 1;
+            Err e = chunk_add_label(c, label, CHUNK_SEC_INHERITED, c->prefix_bytes, app_context_param);
+            if(e != ERR_OK) return e;
+
+        }
+
+        c->prefix_has_instr |= is_instr;
+        c->prefix_has_word |= is_word;
+        c->prefix_bytes += instr_bytes + word_bytes;
+
+        return ERR_OK;
+
+    }
+
+    if((is_instr && c->final_section != SEC_TEXT) || (is_word && c->final_section != SEC_DATA)) return ERR_SYNTAX;
+
+    if(label != STRID_NONE){
+
+        Err e = (c->final_section == SEC_TEXT) ? chunk_add_label(c, label, CHUNK_SEC_TEXT, c->text_bytes, app_context_param)
+                                               : chunk_add_label(c, label, CHUNK_SEC_DATA, c->data_bytes, app_context_param);
+        if(e != ERR_OK) return e;
+
+    }
+
+    c->text_bytes += instr_bytes;
+    c->data_bytes += word_bytes;
+
+    return ERR_OK;
+
+}
+
+
+static Err chunk_run(Pass1Job *job, Pass1Chunk *c){
+
+    app_context *app_context_param = job->app;
+    TokenVec tv;
+    Arena scratch;
+    Err e;
+
+    if((e = tokenvec_init(&tv, app_context_param)) != ERR_OK) return e;
+    if((e = arena_init(&scratch, 4096, app_context_param)) != ERR_OK){
+
+        tokenvec_free(&tv, app_context_param);
+        return e;
+
+    }
+
+    ArenaMark line_start = arena_mark(&scratch);
+    AsmStatsProbe probe;
+
+    for(size_t i = c->first_line; e == ERR_OK && i < c->end_line; i++){
+
+        LineView view = job->line_at(job->source, i);
+
+        ASM_STATS_BEGIN(&probe, job->collect_stats ? &c->stats : NULL, i);
+
+        e = scan_line(view.text, view.len, (int)i + 1, &tv, app_context_param);
+        ASM_STATS_END(&probe, ASM_STAGE_LEX, view.len);
+        if(e != ERR_OK || tv.n == 0) continue;
+
+        int has_label = 0;
+        Statement statement = {0};
+
+        e = parse_line(app_context_param, &scratch, &c->pool, &tv, (int)i + 1, &has_label, &statement);
+        ASM_STATS_END(&probe, ASM_STAGE_PARSE, view.len);
+        if(e == ERR_OK) e = chunk_account(c, &statement, app_context_param);
+
+        if(e == ERR_OK){
+
+            ASM_STATS_RESTART(&probe);
+            e = ir_push(&c->ir, &statement, app_context_param);
+            ASM_STATS_END(&probe, ASM_STAGE_IR, sizeof(IrRec));
+
+        }
+
+        arena_rewind(&scratch, line_start);
+
+    }
+
+    arena_free(&scratch, app_context_param);
+    tokenvec_free(&tv, app_context_param);
+
+    return e;
+
+}
+
+
+static void chunk_task(void *arg, size_t index){
+
+    Pass1Job *job = arg;
+
+    // a failing chunk is assembled again serially, that run reports the diagnostics: these ones are dropped
+
+    DiagList dropped;
+    diag_init(&dropped, job->app);
+
+    DiagList *prev = parser_set_diagnostics(&dropped);
+    job->chunks[index].e = chunk_run(job, &job->chunks[index]);
+    parser_set_diagnostics(prev);
+
+    diag_free(&dropped, job->app);
+
+}
+
+
+static int rec_has_label_operand(const IrRec *r){
+
+    if(r->kind != ST_INSTR && r->kind != ST_LABEL_PLUS_INSTR) return 0;
+
+    const InstructionSpec *spec = isa_spec((IsaId)r->op);
+
+    for(int i = 0; i < spec->op_count; i++){
+
+        if(spec->ops[i] == OPK_LABEL) return 1;
+
+    }
+
+    return 0;
+
+}
+
+
+static Err merge_chunk(app_context *app_context_param, const AsmConfig *cfg, Pass1Chunk *c, StrId *remap,
+                       IR *ir, Symtab *symtab, AsmState *state, AsmStats *stats, int *out_rerun_serial){
+
+    // 1. the section this chunk starts in decides whether its prefix is valid, exactly like pass1_statement()
+
+    if(c->prefix_has_label || c->prefix_has_instr || c->prefix_has_word){
+
+        if(state->section == SEC_NONE || (state->section == SEC_TEXT && c->prefix_has_word) || (state->section == SEC_DATA && c->prefix_has_instr)){
+
+            *out_rerun_serial = 1;
+            return ERR_OK;
+
+        }
+
+    }
+
+    // 2. chunk pool ids -> global ids, interned in chunk id order so every id equals the one of the serial pass
+
+    for(size_t id = 1; id < c->pool.n; id++){
+
+        Err e = strpool_intern(&symtab->names, c->pool.v[id].s, c->pool.v[id].len, &remap[id], app_context_param);
+        if(e != ERR_OK) return e;
+
+    }
+
+    // 3. labels, in source order
+
+    uint32_t prefix_base = (state->section == SEC_TEXT) ? cfg->text_base + state->text_pc : cfg->data_base + state->data_pc;
+
+    if(state->section == SEC_TEXT) state->text_pc += c->prefix_bytes;
+    else if(state->section == SEC_DATA) state->data_pc += c->prefix_bytes;
+
+    for(size_t i = 0; i < c->n_labels; i++){
+
+        const ChunkLabel *l = &c->labels[i];
+        StrId name = remap[l->name];
+        uint32_t addr = (l->section == CHUNK_SEC_INHERITED) ? prefix_base + l->offset
+                      : (l->section == CHUNK_SEC_TEXT) ? cfg->text_base + state->text_pc + l->offset
+                      : cfg->data_base + state->data_pc + l->offset;
+
+        AsmStatsProbe probe;
+        ASM_STATS_BEGIN(&probe, stats, i);
+
+        if(symtab_find_id(symtab, name) >= 0){         // duplicate: the serial rerun reports the first one in line order
+
+            *out_rerun_serial = 1;
+            return ERR_OK;
+
+        }
+
+        Err e = symtab_add_id(symtab, name, addr, app_context_param);
+        ASM_STATS_END(&probe, ASM_STAGE_SYMTAB, 0);
+        if(e != ERR_OK) return e;
+
+    }
+
+    if(c->has_directive){
+
+        state->text_pc += c->text_bytes;
+        state->data_pc += c->data_bytes;
+        state->section = c->final_section;
+
+    }
+
+    // 4. records, with StrIds remapped and .word indices moved to the global side table
+
+    Err e = ir_reserve(ir, c->ir.n, c->ir.words_n, app_context_param);
+    if(e != ERR_OK) return e;
+
+    uint32_t words_base = (uint32_t)ir->words_n;
+
+    for(size_t i = 0; i < c->ir.n; i++){
+
+        IrRec r = c->ir.v[i];
+
+        if(r.label != STRID_NONE) r.label = remap[r.label];
+        if(r.kind == ST_DIR_WORD || r.kind == ST_LABEL_PLUS_DIR_WORD) r.val += words_base;
+        else if(rec_has_label_operand(&r)) r.val = remap[r.val];
+
+        ir->v[ir->n++] = r;
+
+    }
+
+    if(c->ir.words_n) memcpy(&ir->words[ir->words_n], c->ir.words, sizeof(*c->ir.words) * c->ir.words_n);
+    ir->words_n += c->ir.words_n;
+
+    return ERR_OK;
+
+}
+
+
+Err pass1_parallel(app_context *app_context_param, const AsmConfig *cfg, pass1_line_at_fn line_at, const void *source, size_t nlines,
+                   IR *out_ir, Symtab *out_symtab, AsmState *out_final_state, int *out_rerun_serial){
+
+    if(!cfg || !cfg->pool || !line_at || !out_ir || !out_symtab || !out_final_state || !out_rerun_serial){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    *out_rerun_serial = 0;
+
+    size_t n_chunks = (size_t)thread_pool_size(cfg->pool) * PASS1_CHUNKS_PER_THREAD;
+    if(n_chunks > nlines / PASS1_PARALLEL_MIN_CHUNK_LINES) n_chunks = nlines / PASS1_PARALLEL_MIN_CHUNK_LINES;
+
+    if(n_chunks < 2){           // not worth it, the serial pass does the job
+
+        *out_rerun_serial = 1;
+        return ERR_OK;
+
+    }
+
+    Pass1Chunk *chunks = calloc(n_chunks, sizeof(*chunks));
+
+    if(!chunks){
+
+        APP_PERROR(app_context_param, "PASS1 CHUNKS ALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    Err e = ERR_OK;
+
+    for(size_t i = 0; i < n_chunks; i++){
+
+        chunks[i].first_line = nlines * i / n_chunks;
+        chunks[i].end_line = nlines * (i + 1) / n_chunks;
+
+        ir_init(&chunks[i].ir, app_context_param);
+        if(e == ERR_OK) e = strpool_init(&chunks[i].pool, app_context_param);
+
+    }
+
+    Pass1Job job = {app_context_param, line_at, source, chunks, cfg->stats != NULL};
+
+    if(e == ERR_OK) e = thread_pool_run(cfg->pool, n_chunks, chunk_task, &job);
+
+    for(size_t i = 0; e == ERR_OK && i < n_chunks; i++){
+
+        if(chunks[i].e == ERR_SYNTAX) *out_rerun_serial = 1;
+        else if(chunks[i].e != ERR_OK) e = chunks[i].e;
+
+    }
+
+    // merge, in chunk order
+
+    ArenaMark mark = {0};
+    if(cfg->arena) mark = arena_mark(cfg->arena);
+
+    int merging = (e == ERR_OK && !*out_rerun_serial);
+
+    if(merging){
+
+        e = ir_init_arena(out_ir, cfg->arena, app_context_param);
+        if(e == ERR_OK) e = symtab_init_arena(out_symtab, cfg->arena, app_context_param);
+
+    }
+
+    AsmState state = {SEC_NONE, 0, 0};
+    StrId *remap = NULL;
+    AsmStats stats = {0};           // kept only if no serial rerun follows, that one counts every line again
+
+    for(size_t i = 0; merging && e == ERR_OK && !*out_rerun_serial && i < n_chunks; i++){
+
+        StrId *p = realloc(remap, sizeof(*remap) * (chunks[i].pool.n ? chunks[i].pool.n : 1));
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "PASS1 REMAP ALLOC FAILED.");
+            e = ERR_OOM;
+            break;
+
+        }
+
+        remap = p;
+        e = merge_chunk(app_context_param, cfg, &chunks[i], remap, out_ir, out_symtab, &state, cfg->stats ? &stats : NULL, out_rerun_serial);
+        asm_stats_merge(&stats, &chunks[i].stats);
+
+    }
+
+    free(remap);
+
+    for(size_t i = 0; i < n_chunks; i++){
+
+        ir_free(&chunks[i].ir, app_context_param);
+        strpool_free(&chunks[i].pool, app_context_param);
+        free(chunks[i].labels);
+
+    }
+
+    free(chunks);
+
+    if(merging && (e != ERR_OK || *out_rerun_serial)){
+
+        ir_free(out_ir, app_context_param);
+        symtab_free(out_symtab, app_context_param);
+        if(cfg->arena) arena_rewind(cfg->arena, mark);
+
+    }
+
+    if(e == ERR_OK && !*out_rerun_serial){
+
+        *out_final_state = state;
+        asm_stats_merge(cfg->stats, &stats);
+
+    }
+
+    return e;
+
+}
@@ -0,0 +1,475 @@
+#include "asm/pass1_pipeline.h"
+#include "core/error_handling.h"
+#include "core/spsc.h"
+#include "core/stats.h"
+#include "front/lexer.h"
+#include "front/parser.h"
+#include "front/scanner.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+struct pass1_pipeline_t{
+
+    app_context *app;
+    app_context *scan_app;          // child of app for the scanner thread, merged at destroy (failures only: bad lines go to a dropped list)
+    const AsmConfig *cfg;
+    pass1_read_fn read_fn;
+    void *source;
+
+    Pass1Batch batches[PASS1_PIPELINE_BATCHES];
+    SpscQueue free_q;               // caller -> reader
+    SpscQueue read_q;               // reader -> scanner
+    SpscQueue parsed_q;             // scanner -> caller
+    atomic_int stop;
+    Pass1Batch *spare;              // reader only: taken from free_q and not filled, the reader never pushes to free_q itself
+
+    pthread_t reader;
+    pthread_t scanner;
+    int reader_started;
+    int scanner_started;
+
+    AsmStats read_stats;            // per stage thread, added to cfg->stats at destroy
+    AsmStats scan_stats;
+
+    TokenVec tv;                    // scanner thread only
+    StrPool names;
+
+};
+
+
+static Pass1Batch *take_batch(pass1_pipeline *pl){
+
+    Pass1Batch *b = pl->spare ? pl->spare : spsc_pop(&pl->free_q, &pl->stop);
+    if(!b) return NULL;
+
+    pl->spare = NULL;
+    b->len = 0;
+    b->last = 0;
+    b->e = ERR_OK;
+
+    return b;
+
+}
+
+
+static Err read_window(pass1_pipeline *pl, char *dst, size_t cap, size_t *out_n){
+
+    ASM_STATS_TIME_BEGIN(t, pl->cfg->stats);
+    Err e = pl->read_fn(pl->source, dst, cap, out_n);
+    ASM_STATS_TIME_END(t, pl->cfg->stats ? &pl->read_stats : NULL, ASM_STAGE_READ, *out_n);
+
+    return e;
+
+}
+
+
+static Err grow_batch(pass1_pipeline *pl, Pass1Batch *b, size_t need){        // doubling: a long line costs linear time to gather
+
+    size_t new_cap = b->text_cap;
+    while(new_cap < need) new_cap *= 2;
+
+    char *p = app_alloc(pl->app, APP_MEM_OTHER, b->text, b->text_cap, new_cap);
+
+    if(!p){
+
+        APP_PERROR(pl->app, "PIPELINE BATCH REALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    b->text = p;
+    b->text_cap = new_cap;
+
+    return ERR_OK;
+
+}
+
+
+static void *reader_main(void *arg){      // the same lines as pass1_stream_run(): a batch is a full window without its partial last line
+
+    pass1_pipeline *pl = arg;
+    Pass1Batch *b = take_batch(pl);
+    size_t cut = 0;             // b->text[0, cut) is whole lines
+
+    while(b){
+
+        Err e = ERR_OK;
+
+        if(b->len == b->text_cap && cut == 0){
+
+            e = grow_batch(pl, b, b->text_cap * 2);          // one line fills the batch alone
+
+        }
+        else if(b->len == b->text_cap){
+
+            // full: every whole line goes to the scanner, the partial one starts the next batch
+
+            Pass1Batch *next = take_batch(pl);
+            if(!next) break;
+
+            size_t carry = b->len - cut;
+            if(carry >= next->text_cap) e = grow_batch(pl, next, carry * 2);
+
+            if(e == ERR_OK){
+
+                memcpy(next->text, b->text + cut, carry);
+                next->len = carry;
+                b->len = cut;
+
+                if(!spsc_push(&pl->read_q, b, &pl->stop)) break;
+
+                b = next;
+                cut = 0;
+
+            }
+            else pl->spare = next;         // back to free_q from destroy, once the reader is joined
+
+        }
+
+        size_t n = 0;
+        if(e == ERR_OK) e = read_window(pl, b->text + b->len, b->text_cap - b->len, &n);
+
+        if(e != ERR_OK || n == 0){
+
+            // end of input: the unterminated last line goes out too, after an error only whole lines do
+
+            if(e != ERR_OK) b->len = cut;
+
+            b->e = e;
+            b->last = 1;
+            spsc_push(&pl->read_q, b, &pl->stop);
+            break;
+
+        }
+
+        // the last newline can only be among the fresh bytes
+
+        for(size_t i = b->len + n; i > b->len; i--){
+
+            if(b->text[i - 1] == '\n'){
+
+                cut = i;
+                break;
+
+            }
+
+        }
+
+        b->len += n;
+
+    }
+
+    return NULL;
+
+}
+
+
+static Err scan_one(pass1_pipeline *pl, Pass1Batch *b, const char *line, size_t len, size_t ith_line){
+
+    app_context *app_context_param = pl->scan_app;
+    AsmStatsProbe probe;
+
+    ASM_STATS_BEGIN(&probe, pl->cfg->stats ? &pl->scan_stats : NULL, ith_line);
+
+    Err e = scan_line(line, len, (int)ith_line + 1, &pl->tv, app_context_param);
+    ASM_STATS_END(&probe, ASM_STAGE_LEX, len);
+    if(e == ERR_OK && pl->tv.n == 0) return ERR_OK;
+
+    if(b->n == b->cap){
+
+        size_t new_cap = b->cap ? b->cap * 2 : 256;
+        Pass1PipeLine *p = app_alloc(app_context_param, APP_MEM_OTHER, b->lines, sizeof(*p) * b->cap, sizeof(*p) * new_cap);
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "PIPELINE LINES REALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        b->lines = p;
+        b->cap = new_cap;
+
+    }
+
+    Pass1PipeLine *l = &b->lines[b->n++];
+    l->text = line;
+    l->len = len;
+    l->line = ith_line;
+    l->statement = (Statement){0};
+
+    if(e == ERR_OK){
+
+        int has_label = 0;
+        e = parse_line(app_context_param, &b->words, &pl->names, &pl->tv, (int)ith_line + 1, &has_label, &l->statement);
+        ASM_STATS_END(&probe, ASM_STAGE_PARSE, len);
+
+    }
+
+    l->e = e;
+
+    return (e == ERR_SYNTAX || e == ERR_UNDEF_LABEL) ? ERR_OK : e;       // a bad line is the caller's to report
+
+}
+
+
+static Err scan_batch(pass1_pipeline *pl, Pass1Batch *b, size_t *ith_line){
+
+    app_context *app_context_param = pl->scan_app;
+    StrId first = (StrId)(strpool_count(&pl->names) + 1);
+
+    b->n = 0;
+    b->n_names = 0;
+    b->first_name = first;
+    arena_rewind(&b->words, b->words_mark);
+
+    const char *s = b->text;
+    const char *end = b->text + b->len;
+    Err e = ERR_OK;
+
+    while(e == ERR_OK && s < end){
+
+        const char *nl = memchr(s, '\n', (size_t)(end - s));
+        size_t len = nl ? (size_t)(nl - s) : (size_t)(end - s);
+
+        e = scan_one(pl, b, s, len, *ith_line);
+        (*ith_line)++;
+        s = nl ? nl + 1 : end;
+
+    }
+
+    // names first seen in this batch, in id order
+
+    size_t n_new = strpool_count(&pl->names) + 1 - first;
+
+    if(n_new > b->cap_names){
+
+        StrEntry *p = app_alloc(app_context_param, APP_MEM_OTHER, b->names, sizeof(*p) * b->cap_names, sizeof(*p) * n_new);
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "PIPELINE NAMES REALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        b->names = p;
+        b->cap_names = n_new;
+
+    }
+
+    if(n_new) memcpy(b->names, &pl->names.v[first], sizeof(*b->names) * n_new);
+    b->n_names = n_new;
+
+    return e;
+
+}
+
+
+static void *scanner_main(void *arg){
+
+    pass1_pipeline *pl = arg;
+    size_t ith_line = 0;
+
+    DiagList dropped;
+    diag_init(&dropped, pl->scan_app);
+
+    DiagList *prev = parser_set_diagnostics(&dropped);
+
+    for(;;){
+
+        Pass1Batch *b = spsc_pop(&pl->read_q, &pl->stop);
+        if(!b) break;
+
+        Err e = scan_batch(pl, b, &ith_line);
+
+        if(e != ERR_OK){            // out of memory and the like: the caller stops at this batch
+
+            if(b->e == ERR_OK) b->e = e;
+            b->last = 1;
+
+        }
+
+        diag_clear(&dropped);
+
+        int last = b->last;
+        if(!spsc_push(&pl->parsed_q, b, &pl->stop) || last) break;
+
+    }
+
+    parser_set_diagnostics(prev);
+    diag_free(&dropped, pl->scan_app);
+
+    return NULL;
+
+}
+
+
+pass1_pipeline *create_pass1_pipeline(app_context *app_context_param, const AsmConfig *cfg, pass1_read_fn read_fn, void *source){
+
+    if(!cfg || !read_fn){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return NULL;
+
+    }
+
+    pass1_pipeline *pl = calloc(1, sizeof(*pl));
+
+    if(!pl){
+
+        APP_PERROR(app_context_param, "PIPELINE ALLOC FAILED.");
+        return NULL;
+
+    }
+
+    pl->app = app_context_param;
+    pl->cfg = cfg;
+    pl->read_fn = read_fn;
+    pl->source = source;
+    atomic_init(&pl->stop, 0);
+
+    Err e = ERR_OK;
+
+    if(app_context_param && !(pl->scan_app = create_child_app_context(app_context_param))) e = ERR_OOM;
+
+    if(e == ERR_OK) e = spsc_init(&pl->free_q, PASS1_PIPELINE_BATCHES, app_context_param);
+    if(e == ERR_OK) e = spsc_init(&pl->read_q, PASS1_PIPELINE_BATCHES, app_context_param);
+    if(e == ERR_OK) e = spsc_init(&pl->parsed_q, PASS1_PIPELINE_BATCHES, app_context_param);
+    if(e == ERR_OK) e = tokenvec_init(&pl->tv, pl->scan_app);
+    if(e == ERR_OK) e = strpool_init(&pl->names, pl->scan_app);
+
+    for(size_t i = 0; e == ERR_OK && i < PASS1_PIPELINE_BATCHES; i++){
+
+        Pass1Batch *b = &pl->batches[i];
+
+        if(!(b->text = app_alloc(app_context_param, APP_MEM_OTHER, NULL, 0, PASS1_STREAM_WINDOW))){
+
+            APP_PERROR(app_context_param, "PIPELINE BATCH ALLOC FAILED.");
+            e = ERR_OOM;
+            break;
+
+        }
+
+        b->text_cap = PASS1_STREAM_WINDOW;
+
+        if((e = arena_init(&b->words, 4096, pl->scan_app)) != ERR_OK) break;
+        if(!arena_alloc(&b->words, 1, pl->scan_app)) e = ERR_OOM;         // the first block then outlives every rewind
+        b->words_mark = arena_mark(&b->words);
+
+        if(e == ERR_OK) spsc_try_push(&pl->free_q, b);
+
+    }
+
+    if(e == ERR_OK){
+
+        pl->reader_started = (pthread_create(&pl->reader, NULL, reader_main, pl) == 0);
+        pl->scanner_started = pl->reader_started && (pthread_create(&pl->scanner, NULL, scanner_main, pl) == 0);
+
+        if(!pl->scanner_started){
+
+            APP_ERROR(app_context_param, "PIPELINE: PTHREAD_CREATE FAILED");
+            e = ERR_UB;
+
+        }
+
+    }
+
+    if(e != ERR_OK){
+
+        destroy_pass1_pipeline(app_context_param, pl);
+        return NULL;
+
+    }
+
+    return pl;
+
+}
+
+
+Pass1Batch *pass1_pipeline_next(pass1_pipeline *pl){
+
+    return spsc_pop(&pl->parsed_q, &pl->stop);
+
+}
+
+
+void pass1_pipeline_release(pass1_pipeline *pl, Pass1Batch *batch){
+
+    spsc_try_push(&pl->free_q, batch);      // never full: it has room for every batch
+
+}
+
+
+Err destroy_pass1_pipeline(app_context *app_context_param, pass1_pipeline *pl){
+
+    if(!pl){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    atomic_store_explicit(&pl->stop, 1, memory_order_release);
+
+    if(pl->reader_started) pthread_join(pl->reader, NULL);
+    if(pl->scanner_started) pthread_join(pl->scanner, NULL);
+
+    Err e = ERR_OK;
+
+    if(pl->scanner_started){        // only this thread is left: every batch the caller released is on a queue or spare
+
+        size_t found = pl->spare ? 1 : 0;
+        SpscQueue *queues[] = {&pl->free_q, &pl->read_q, &pl->parsed_q};
+
+        for(size_t k = 0; k < sizeof(queues) / sizeof(queues[0]); k++) while(spsc_try_pop(queues[k])) found++;
+
+        if(found != PASS1_PIPELINE_BATCHES){
+
+            APP_ERROR(app_context_param, "PIPELINE: BATCH LOST");
+            e = ERR_UB;
+
+        }
+
+    }
+
+    if(pl->cfg->stats){
+
+        asm_stats_merge(pl->cfg->stats, &pl->read_stats);
+        asm_stats_merge(pl->cfg->stats, &pl->scan_stats);
+
+    }
+
+    for(size_t i = 0; i < PASS1_PIPELINE_BATCHES; i++){
+
+        Pass1Batch *b = &pl->batches[i];
+
+        app_free(app_context_param, APP_MEM_OTHER, b->text, b->text_cap);
+        app_free(pl->scan_app, APP_MEM_OTHER, b->lines, sizeof(*b->lines) * b->cap);
+        app_free(pl->scan_app, APP_MEM_OTHER, b->names, sizeof(*b->names) * b->cap_names);
+        arena_free(&b->words, pl->scan_app);
+
+    }
+
+    tokenvec_free(&pl->tv, pl->scan_app);
+    strpool_free(&pl->names, pl->scan_app);
+
+    if(pl->free_q.slots) spsc_free(&pl->free_q, app_context_param);
+    if(pl->read_q.slots) spsc_free(&pl->read_q, app_context_param);
+    if(pl->parsed_q.slots) spsc_free(&pl->parsed_q, app_context_param);
+
+    if(pl->scan_app){
+
+        merge_child_app_context(app_context_param, pl->scan_app);
+        destroy_app_context(pl->scan_app);
+
+    }
+
+    free(pl);
+
+    return e;
+
+}
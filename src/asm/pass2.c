@@ -0,0 +1,178 @@
+#include "asm/pass2.h"
+#include "asm/encode.h"
+#include "core/error_handling.h"
+#include "core/ir.h"
+#include "core/isa_mips.h"
+#include "core/symtab.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static Err encode_instr(app_context *app_context_param, const Symtab *symtab, const IrRec *r, uint32_t pc, uint32_t *out_word){
+
+    Err e = asm_encode_instr(app_context_param, r, out_word);
+    ImmKind kind = asm_label_kind(r);
+
+    if(e != ERR_OK || kind == IMM_NONE) return e;
+
+    uint32_t target;
+
+    if(symtab_lookup_id(symtab, r->val, &target, app_context_param) != ERR_OK){
+
+        asm_report(app_context_param, r->line_no, "UNDEFINED LABEL");
+        return ERR_UNDEF_LABEL;
+
+    }
+
+    return asm_encode_target(app_context_param, r->line_no, kind, pc, target, out_word);
+
+}
+
+
+static uint32_t *image_alloc(app_context *app_context_param, Arena *arena, size_t n){
+
+    if(arena){
+
+        uint32_t *p = arena_alloc(arena, sizeof(*p) * (n ? n : 1), app_context_param);
+        if(p) memset(p, 0, sizeof(*p) * n);
+        return p;
+
+    }
+
+    uint32_t *p = calloc(n ? n : 1, sizeof(*p));
+    if(!p) APP_PERROR(app_context_param, "IMAGE ALLOC FAILED.");
+
+    return p;
+
+}
+
+
+Err assemble_pass2(app_context *app_context_param, const AsmConfig *cfg, const IR *ir, const Symtab *symtab, const AsmState *final_state, AsmImage *out_image){
+
+    if(!cfg || !ir || !symtab || !final_state || !out_image || (final_state->text_pc & 3u) || (final_state->data_pc & 3u)){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    AsmImage img = {0};
+    img.text_n = final_state->text_pc / 4;
+    img.data_n = final_state->data_pc / 4;
+    img.text_base = cfg->text_base;
+    img.data_base = cfg->data_base;
+    img.arena = cfg->arena;
+
+    ArenaMark mark = {0};
+    if(img.arena) mark = arena_mark(img.arena);
+
+    img.text = image_alloc(app_context_param, img.arena, img.text_n);
+    img.data = image_alloc(app_context_param, img.arena, img.data_n);
+
+    if(!img.text || !img.data){
+
+        asm_image_free(&img, app_context_param);
+        if(cfg->arena) arena_rewind(cfg->arena, mark);
+        return ERR_OOM;
+
+    }
+
+    // one walk: the section directives are in the IR, so are the pcs
+
+    Section section = SEC_NONE;
+    size_t text_i = 0, data_i = 0;
+    Err e = ERR_OK;
+
+    for(size_t i = 0; e == ERR_OK && i < ir->n; i++){
+
+        const IrRec *r = &ir->v[i];
+
+        switch((StatementKind)r->kind){
+
+            case ST_DIR_TEXT: section = SEC_TEXT; break;
+            case ST_DIR_DATA: section = SEC_DATA; break;
+
+            case ST_INSTR:
+            case ST_LABEL_PLUS_INSTR:
+
+                if(section != SEC_TEXT || text_i >= img.text_n){
+
+                    asm_report(app_context_param, r->line_no, "IR DOES NOT MATCH THE FINAL STATE OF PASS 1");
+                    e = ERR_INVALID_ARGUMENT;
+                    break;
+
+                }
+
+                e = encode_instr(app_context_param, symtab, r, cfg->text_base + (uint32_t)text_i * 4, &img.text[text_i]);
+                text_i++;
+                break;
+
+            case ST_DIR_WORD:
+            case ST_LABEL_PLUS_DIR_WORD:{
+
+                size_t n;
+                const int32_t *values = ir_rec_words(ir, r, &n);
+
+                if(section != SEC_DATA || n > img.data_n - data_i){
+
+                    asm_report(app_context_param, r->line_no, "IR DOES NOT MATCH THE FINAL STATE OF PASS 1");
+                    e = ERR_INVALID_ARGUMENT;
+                    break;
+
+                }
+
+                memcpy(&img.data[data_i], values, sizeof(*values) * n);
+                data_i += n;
+                break;
+
+            }
+
+            default:
+                break;
+
+        }
+
+    }
+
+    if(e == ERR_OK && (text_i != img.text_n || data_i != img.data_n)){
+
+        APP_ERROR(app_context_param, "IR DOES NOT MATCH THE FINAL STATE OF PASS 1");
+        e = ERR_INVALID_ARGUMENT;
+
+    }
+
+    if(e != ERR_OK){
+
+        asm_image_free(&img, app_context_param);
+        if(cfg->arena) arena_rewind(cfg->arena, mark);
+        return e;
+
+    }
+
+    *out_image = img;
+
+    return ERR_OK;
+
+}
+
+
+Err asm_image_free(AsmImage *image, app_context *app_context_param){
+
+    (void)app_context_param;
+
+    if(!image) return ERR_INVALID_ARGUMENT;
+
+    if(!image->arena){          // arena backed images go with their arena
+
+        free(image->text);
+        free(image->data);
+
+    }
+
+    image->text = image->data = NULL;
+    image->text_n = image->data_n = 0;
+
+    return ERR_OK;
+
+}
@@ -0,0 +1,608 @@
+#include "asm/session.h"
+#include "core/error_handling.h"
+#include "core/hash.h"
+#include "core/ir.h"
+#include "core/symtab.h"
+#include "front/lexer.h"
+#include "front/parser.h"
+#include "front/scanner.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct{
+
+    AsmState state;         // before the first line of the checkpoint
+    uint32_t symbols;       // Symtab size there
+    uint32_t rec;           // first IR record at or after that line
+    uint32_t words;         // and the words side table position of that record
+
+}SessionCheckpoint;
+
+typedef struct{             // a run of lines cut out of (or going into) the program, line numbers and .word indices relative to the run
+
+    IR ir;
+    uint64_t *hashes;
+    size_t nlines;
+
+}SessionPiece;
+
+struct asm_session_t{
+
+    AsmConfig cfg;
+    IR ir;
+    Symtab symtab;
+    AsmState state;
+
+    uint64_t *hashes;       // one per source line
+    size_t nlines;
+    size_t hashes_cap;
+
+    SessionCheckpoint *cps;         // cps[k]: line k * ASM_SESSION_CHECKPOINT_LINES
+    size_t cps_cap;
+
+};
+
+
+static uint64_t line_hash(const char *line){
+
+    if(!line) line = "";
+    return hash_bytes64(line, strlen(line));
+
+}
+
+
+static inline uint32_t rec_words_len(const IR *ir, const IrRec *r){      // side table entries of a record, [n, v0 .. vn-1]
+
+    if(r->kind != ST_DIR_WORD && r->kind != ST_LABEL_PLUS_DIR_WORD) return 0;
+    return 1 + (uint32_t)ir->words[r->val];
+
+}
+
+
+static inline int rec_is_word(const IrRec *r){ return r->kind == ST_DIR_WORD || r->kind == ST_LABEL_PLUS_DIR_WORD; }
+
+
+static void piece_free(SessionPiece *piece, app_context *app_context_param){
+
+    ir_free(&piece->ir, app_context_param);
+    free(piece->hashes);
+    piece->hashes = NULL;
+    piece->nlines = 0;
+
+}
+
+
+static Err session_reserve_lines(asm_session *s, size_t nlines, app_context *app_context_param){
+
+    if(nlines > UINT32_MAX){
+
+        APP_ERROR(app_context_param, "TOO MANY LINES FOR AN ASSEMBLER SESSION");
+        return ERR_OOM;
+
+    }
+
+    if(nlines > s->hashes_cap){
+
+        size_t new_cap = s->hashes_cap ? s->hashes_cap : 1024;
+        while(new_cap < nlines) new_cap *= 2;
+
+        uint64_t *p = realloc(s->hashes, sizeof(*p) * new_cap);
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "SESSION LINES REALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        s->hashes = p;
+        s->hashes_cap = new_cap;
+
+    }
+
+    size_t n_cps = nlines / ASM_SESSION_CHECKPOINT_LINES + 1;
+
+    if(n_cps > s->cps_cap){
+
+        size_t new_cap = s->cps_cap ? s->cps_cap : 64;
+        while(new_cap < n_cps) new_cap *= 2;
+
+        SessionCheckpoint *p = realloc(s->cps, sizeof(*p) * new_cap);
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "SESSION CHECKPOINTS REALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        s->cps = p;
+        s->cps_cap = new_cap;
+
+    }
+
+    return ERR_OK;
+
+}
+
+
+static Err session_parse(app_context *app_context_param, asm_session *s, size_t first, char **lines, size_t n, SessionPiece *out){      // lex + parse only, sections are checked by the walk
+
+    TokenVec tv;
+    Arena scratch;
+    Err e;
+
+    if((e = tokenvec_init(&tv, app_context_param)) != ERR_OK) return e;
+    if((e = arena_init(&scratch, 4096, app_context_param)) != ERR_OK){
+
+        tokenvec_free(&tv, app_context_param);
+        return e;
+
+    }
+
+    ArenaMark line_start = arena_mark(&scratch);
+
+    for(size_t i = 0; e == ERR_OK && i < n; i++){
+
+        const char *line = lines[i] ? lines[i] : "";
+        int line_no = (int)(first + i) + 1;         // diagnostics name the line of the program
+
+        e = scan_line(line, strlen(line), line_no, &tv, app_context_param);
+        if(e != ERR_OK || tv.n == 0) continue;
+
+        int has_label = 0;
+        Statement statement = {0};
+
+        e = parse_line(app_context_param, &scratch, &s->symtab.names, &tv, line_no, &has_label, &statement);
+        if(e == ERR_OK && statement.kind != ST_EMPTY) e = ir_push(&out->ir, &statement, app_context_param);
+
+        arena_rewind(&scratch, line_start);
+
+    }
+
+    arena_free(&scratch, app_context_param);
+    tokenvec_free(&tv, app_context_param);
+
+    for(size_t i = 0; i < out->ir.n; i++) out->ir.v[i].line_no -= (uint32_t)first;
+
+    return e;
+
+}
+
+
+static Err session_splice(app_context *app_context_param, asm_session *s, size_t first, size_t n_removed, const SessionPiece *in, SessionPiece *out_removed){
+
+    IR *ir = &s->ir;
+
+    // records and words of the removed lines: [r0, r1) and [w0, w1)
+
+    const SessionCheckpoint *cp = &s->cps[first / ASM_SESSION_CHECKPOINT_LINES];
+    size_t r0 = cp->rec, w0 = cp->words;
+
+    for(; r0 < ir->n && ir->v[r0].line_no <= first; r0++) w0 += rec_words_len(ir, &ir->v[r0]);
+
+    size_t r1 = r0, w1 = w0;
+
+    for(; r1 < ir->n && ir->v[r1].line_no <= first + n_removed; r1++) w1 += rec_words_len(ir, &ir->v[r1]);
+
+    size_t nlines = s->nlines - n_removed + in->nlines;
+    Err e;
+
+    if((e = session_reserve_lines(s, nlines, app_context_param)) != ERR_OK) return e;
+    if((e = ir_reserve(ir, in->ir.n > r1 - r0 ? in->ir.n - (r1 - r0) : 0, in->ir.words_n > w1 - w0 ? in->ir.words_n - (w1 - w0) : 0, app_context_param)) != ERR_OK) return e;
+
+    if(ir->words_n + in->ir.words_n - (w1 - w0) > UINT32_MAX){
+
+        APP_ERROR(app_context_param, "TOO MANY .word VALUES");
+        return ERR_OOM;
+
+    }
+
+    if(out_removed){
+
+        if((e = ir_reserve(&out_removed->ir, r1 - r0, w1 - w0, app_context_param)) != ERR_OK) return e;
+
+        out_removed->hashes = malloc(sizeof(*out_removed->hashes) * (n_removed ? n_removed : 1));
+
+        if(!out_removed->hashes){
+
+            APP_PERROR(app_context_param, "SESSION PIECE MALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        for(size_t i = r0; i < r1; i++){
+
+            IrRec r = ir->v[i];
+            r.line_no -= (uint32_t)first;
+            if(rec_is_word(&r)) r.val -= (uint32_t)w0;
+
+            out_removed->ir.v[out_removed->ir.n++] = r;
+
+        }
+
+        if(w1 > w0) memcpy(out_removed->ir.words, &ir->words[w0], sizeof(*ir->words) * (w1 - w0));
+        out_removed->ir.words_n = w1 - w0;
+
+        if(n_removed) memcpy(out_removed->hashes, &s->hashes[first], sizeof(*s->hashes) * n_removed);
+        out_removed->nlines = n_removed;
+
+    }
+
+    // nothing can fail from here on: move the tail, then drop the new piece in the gap
+
+    uint32_t line_delta = (uint32_t)(in->nlines - n_removed);            // modulo 2^32, the sums below wrap back
+    uint32_t word_delta = (uint32_t)(in->ir.words_n - (w1 - w0));
+    size_t tail_recs = ir->n - r1, tail_words = ir->words_n - w1;
+
+    if(tail_recs) memmove(&ir->v[r0 + in->ir.n], &ir->v[r1], sizeof(*ir->v) * tail_recs);
+    if(tail_words) memmove(&ir->words[w0 + in->ir.words_n], &ir->words[w1], sizeof(*ir->words) * tail_words);
+
+    for(size_t i = r0 + in->ir.n; i < r0 + in->ir.n + tail_recs; i++){
+
+        IrRec *r = &ir->v[i];
+        r->line_no += line_delta;
+        if(rec_is_word(r)) r->val += word_delta;
+
+    }
+
+    for(size_t i = 0; i < in->ir.n; i++){
+
+        IrRec r = in->ir.v[i];
+        r.line_no += (uint32_t)first;
+        if(rec_is_word(&r)) r.val += (uint32_t)w0;
+
+        ir->v[r0 + i] = r;
+
+    }
+
+    if(in->ir.words_n) memcpy(&ir->words[w0], in->ir.words, sizeof(*in->ir.words) * in->ir.words_n);
+
+    ir->n = r0 + in->ir.n + tail_recs;
+    ir->words_n = w0 + in->ir.words_n + tail_words;
+
+    memmove(&s->hashes[first + in->nlines], &s->hashes[first + n_removed], sizeof(*s->hashes) * (s->nlines - first - n_removed));
+    if(in->nlines) memcpy(&s->hashes[first], in->hashes, sizeof(*s->hashes) * in->nlines);
+    s->nlines = nlines;
+
+    return ERR_OK;
+
+}
+
+
+static Err session_account(app_context *app_context_param, asm_session *s, const IrRec *r, AsmState *state){      // pass1_statement() on a record
+
+    const AsmConfig *cfg = &s->cfg;
+
+    switch(r->kind){
+
+        case ST_DIR_TEXT: state->section = SEC_TEXT; return ERR_OK;
+        case ST_DIR_DATA: state->section = SEC_DATA; return ERR_OK;
+
+        case ST_LABEL:
+
+            if(state->section == SEC_NONE){
+
+                APP_ERROR(app_context_param, "label before selecting .text/.data section");
+                return ERR_SYNTAX;
+
+            }
+
+            return symtab_add_id(&s->symtab, r->label, (state->section == SEC_TEXT) ? cfg->text_base + state->text_pc : cfg->data_base + state->data_pc, app_context_param);
+
+        case ST_DIR_WORD:
+
+            if(state->section != SEC_DATA){
+
+                APP_ERROR(app_context_param, ".word directives are out of .data section");
+                return ERR_SYNTAX;
+
+            }
+
+            state->data_pc += (uint32_t)s->ir.words[r->val] * 4;
+            return ERR_OK;
+
+        case ST_INSTR:
+
+            if(state->section != SEC_TEXT){
+
+                APP_ERROR(app_context_param, "Instruction outside of .text section");
+                return ERR_SYNTAX;
+
+            }
+
+            state->text_pc += 4;
+            return ERR_OK;
+
+        case ST_LABEL_PLUS_DIR_WORD:{
+
+            if(state->section != SEC_DATA){
+
+                APP_ERROR(app_context_param, ".word must be defined in .data section.");
+                return ERR_SYNTAX;
+
+            }
+
+            Err e = symtab_add_id(&s->symtab, r->label, cfg->data_base + state->data_pc, app_context_param);
+            if(e != ERR_OK) return e;
+
+            state->data_pc += (uint32_t)s->ir.words[r->val] * 4;
+            return ERR_OK;
+
+        }
+
+        case ST_LABEL_PLUS_INSTR:{
+
+            if(state->section != SEC_TEXT){
+
+                APP_ERROR(app_context_param, "an instruction cannot be defined anywhere except .text section.");
+                return ERR_SYNTAX;
+
+            }
+
+            Err e = symtab_add_id(&s->symtab, r->label, cfg->text_base + state->text_pc, app_context_param);
+            if(e != ERR_OK) return e;
+
+            state->text_pc += 4;
+            return ERR_OK;
+
+        }
+
+        default: return ERR_OK;
+
+    }
+
+}
+
+
+static Err session_walk(app_context *app_context_param, asm_session *s, size_t from_cp){        // addresses, Symtab and checkpoints from checkpoint from_cp to the end
+
+    const SessionCheckpoint *start = &s->cps[from_cp];
+    AsmState state = start->state;
+    size_t words = start->words;
+    size_t n_cps = s->nlines / ASM_SESSION_CHECKPOINT_LINES + 1;
+    size_t next_cp = from_cp + 1;
+    size_t next_cp_line = next_cp * ASM_SESSION_CHECKPOINT_LINES;
+
+    symtab_truncate(&s->symtab, start->symbols);
+
+    for(size_t i = start->rec; i < s->ir.n; i++){
+
+        const IrRec *r = &s->ir.v[i];
+
+        while(r->line_no > next_cp_line){       // line_no is 1 based: record i is the first one at or after that line
+
+            s->cps[next_cp++] = (SessionCheckpoint){state, (uint32_t)s->symtab.n, (uint32_t)i, (uint32_t)words};
+            next_cp_line += ASM_SESSION_CHECKPOINT_LINES;
+
+        }
+
+        Err e = session_account(app_context_param, s, r, &state);
+        if(e != ERR_OK) return e;
+
+        words += rec_words_len(&s->ir, r);
+
+    }
+
+    while(next_cp < n_cps) s->cps[next_cp++] = (SessionCheckpoint){state, (uint32_t)s->symtab.n, (uint32_t)s->ir.n, (uint32_t)words};
+
+    s->state = state;
+
+    return ERR_OK;
+
+}
+
+
+static Err session_replace(app_context *app_context_param, asm_session *s, size_t first, size_t n_removed, char **new_lines, const uint64_t *hashes, size_t n_inserted){
+
+    SessionPiece fresh = {.hashes = (uint64_t *)hashes, .nlines = n_inserted};
+    SessionPiece removed = {0};
+
+    ir_init(&fresh.ir, app_context_param);
+    ir_init(&removed.ir, app_context_param);
+
+    Err e = session_parse(app_context_param, s, first, new_lines, n_inserted, &fresh);
+    if(e == ERR_OK) e = session_splice(app_context_param, s, first, n_removed, &fresh, &removed);
+
+    if(e == ERR_OK){
+
+        size_t from_cp = first / ASM_SESSION_CHECKPOINT_LINES;
+        e = session_walk(app_context_param, s, from_cp);
+
+        if(e != ERR_OK){        // back to the previous program, it was valid so the walk succeeds again
+
+            session_splice(app_context_param, s, first, n_inserted, &removed, NULL);
+            session_walk(app_context_param, s, from_cp);
+
+        }
+
+    }
+
+    fresh.hashes = NULL;
+    piece_free(&fresh, app_context_param);
+    piece_free(&removed, app_context_param);
+
+    return e;
+
+}
+
+
+asm_session *create_asm_session(app_context *app_context_param, const AsmConfig *cfg){
+
+    if(!cfg){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return NULL;
+
+    }
+
+    asm_session *s = calloc(1, sizeof(*s));
+
+    if(!s){
+
+        APP_PERROR(app_context_param, "ASM SESSION ALLOC FAILED.");
+        return NULL;
+
+    }
+
+    s->cfg = *cfg;
+    s->cfg.arena = NULL;
+    s->state.section = SEC_NONE;
+
+    if(ir_init(&s->ir, app_context_param) != ERR_OK || symtab_init(&s->symtab, app_context_param) != ERR_OK ||
+       session_reserve_lines(s, 0, app_context_param) != ERR_OK){
+
+        destroy_asm_session(app_context_param, s);
+        return NULL;
+
+    }
+
+    s->cps[0] = (SessionCheckpoint){s->state, 0, 0, 0};
+
+    return s;
+
+}
+
+
+Err destroy_asm_session(app_context *app_context_param, asm_session *s){
+
+    if(!s) return ERR_INVALID_ARGUMENT;
+
+    ir_free(&s->ir, app_context_param);
+    symtab_free(&s->symtab, app_context_param);
+    free(s->hashes);
+    free(s->cps);
+    free(s);
+
+    return ERR_OK;
+
+}
+
+
+Err asm_session_load(app_context *app_context_param, asm_session *s, char **lines, size_t nlines){
+
+    if(!s || (!lines && nlines)){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    IR ir;
+    Symtab symtab;
+    AsmState state;
+
+    Err e = assemble_pass1(app_context_param, &s->cfg, lines, nlines, &ir, &symtab, &state);
+    if(e != ERR_OK) return e;
+
+    size_t old_nlines = s->nlines;
+    s->nlines = 0;
+
+    if((e = session_reserve_lines(s, nlines, app_context_param)) != ERR_OK){
+
+        s->nlines = old_nlines;
+        ir_free(&ir, app_context_param);
+        symtab_free(&symtab, app_context_param);
+
+        return e;
+
+    }
+
+    ir_free(&s->ir, app_context_param);
+    symtab_free(&s->symtab, app_context_param);
+
+    s->ir = ir;
+    s->symtab = symtab;
+    s->nlines = nlines;
+
+    for(size_t i = 0; i < nlines; i++) s->hashes[i] = line_hash(lines[i]);
+
+    s->cps[0] = (SessionCheckpoint){{SEC_NONE, 0, 0}, 0, 0, 0};
+
+    return session_walk(app_context_param, s, 0);          // same symbols in the same order, this only lays the checkpoints
+
+}
+
+
+Err asm_session_edit(app_context *app_context_param, asm_session *s, size_t first_line, size_t n_removed, char **new_lines, size_t n_inserted){
+
+    if(!s || first_line > s->nlines || n_removed > s->nlines - first_line || (!new_lines && n_inserted)){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    uint64_t *hashes = malloc(sizeof(*hashes) * (n_inserted ? n_inserted : 1));
+
+    if(!hashes){
+
+        APP_PERROR(app_context_param, "SESSION HASHES MALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    for(size_t i = 0; i < n_inserted; i++) hashes[i] = line_hash(new_lines[i]);
+
+    Err e = session_replace(app_context_param, s, first_line, n_removed, new_lines, hashes, n_inserted);
+
+    free(hashes);
+
+    return e;
+
+}
+
+
+Err asm_session_update(app_context *app_context_param, asm_session *s, char **lines, size_t nlines){
+
+    if(!s || (!lines && nlines)){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    uint64_t *hashes = malloc(sizeof(*hashes) * (nlines ? nlines : 1));
+
+    if(!hashes){
+
+        APP_PERROR(app_context_param, "SESSION HASHES MALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    for(size_t i = 0; i < nlines; i++) hashes[i] = line_hash(lines[i]);
+
+    // unchanged head and tail, the lines in between are the edit
+
+    size_t common = (nlines < s->nlines) ? nlines : s->nlines;
+    size_t head = 0, tail = 0;
+
+    while(head < common && hashes[head] == s->hashes[head]) head++;
+    while(tail < common - head && hashes[nlines - 1 - tail] == s->hashes[s->nlines - 1 - tail]) tail++;
+
+    Err e = ERR_OK;
+
+    if(head != nlines || head != s->nlines) e = session_replace(app_context_param, s, head, s->nlines - head - tail, lines + head, hashes + head, nlines - head - tail);
+
+    free(hashes);
+
+    return e;
+
+}
+
+
+size_t asm_session_line_count(const asm_session *s){ return s ? s->nlines : 0; }
+
+const IR *asm_session_ir(const asm_session *s){ return s ? &s->ir : NULL; }
+
+const Symtab *asm_session_symtab(const asm_session *s){ return s ? &s->symtab : NULL; }
+
+AsmState asm_session_state(const asm_session *s){
+
+    AsmState none = {SEC_NONE, 0, 0};
+    return s ? s->state : none;
+
+}
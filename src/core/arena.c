@@ -0,0 +1,178 @@
+#include "core/arena.h"
+#include "core/error_handling.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+#define ARENA_ALIGN 16
+
+
+struct arena_block_t{
+
+    arena_block *prev;
+    app_context *app;       // the block goes back to the context that paid for it
+    size_t cap;
+    size_t used;
+    _Alignas(ARENA_ALIGN) unsigned char data[];
+
+};
+
+
+static size_t align_up(size_t n){
+
+    return (n + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+
+}
+
+
+Err arena_init(Arena *arena, size_t block_size, app_context *app_context_param){
+
+    if(!arena){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    arena->head = NULL;
+    arena->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK;
+    arena->bytes_allocated = 0;
+    arena->tag = APP_MEM_ARENA;
+
+    return ERR_OK;
+
+}
+
+
+static Err arena_new_block(Arena *arena, size_t min_size, app_context *app_context_param){
+
+    size_t cap = arena->block_size;
+    while(cap < min_size) cap *= 2;     // oversized requests get a block of their own size class
+
+    arena_block *b = app_alloc(app_context_param, arena->tag, NULL, 0, sizeof(*b) + cap);
+
+    if(!b){
+
+        APP_PERROR(app_context_param, "ARENA BLOCK MALLOC FAILED");
+        return ERR_OOM;
+
+    }
+
+    b->prev = arena->head;
+    b->app = app_context_param;
+    b->cap = cap;
+    b->used = 0;
+    arena->head = b;
+
+    return ERR_OK;
+
+}
+
+
+void *arena_alloc(Arena *arena, size_t size, app_context *app_context_param){
+
+    if(!arena){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return NULL;
+
+    }
+
+    size_t n = align_up(size ? size : 1);
+
+    if(!arena->head || arena->head->cap - arena->head->used < n){
+
+        if(arena_new_block(arena, n, app_context_param) != ERR_OK) return NULL;
+
+    }
+
+    void *p = arena->head->data + arena->head->used;
+    arena->head->used += n;
+    arena->bytes_allocated += size;
+
+    return p;
+
+}
+
+
+void *arena_realloc(Arena *arena, void *old, size_t old_size, size_t new_size, app_context *app_context_param){
+
+    if(!old) return arena_alloc(arena, new_size, app_context_param);
+
+    arena_block *b = arena->head;
+    size_t old_n = align_up(old_size ? old_size : 1);
+    size_t new_n = align_up(new_size ? new_size : 1);
+
+    // last allocation of the current block: just move the bump pointer
+
+    if(b && (unsigned char *)old + old_n == b->data + b->used && (size_t)((unsigned char *)old - b->data) + new_n <= b->cap){
+
+        b->used = (size_t)((unsigned char *)old - b->data) + new_n;
+        if(new_size > old_size) arena->bytes_allocated += new_size - old_size;
+        return old;
+
+    }
+
+    if(new_size <= old_size) return old;
+
+    void *p = arena_alloc(arena, new_size, app_context_param);
+    if(p) memcpy(p, old, old_size);
+
+    return p;
+
+}
+
+
+char *arena_strndup(Arena *arena, const char *s, size_t n, app_context *app_context_param){
+
+    char *p = arena_alloc(arena, n + 1, app_context_param);
+    if(!p) return NULL;
+
+    memcpy(p, s, n);
+    p[n] = '\0';
+
+    return p;
+
+}
+
+
+ArenaMark arena_mark(const Arena *arena){
+
+    ArenaMark m = {arena->head, arena->head ? arena->head->used : 0, arena->bytes_allocated};
+    return m;
+
+}
+
+
+void arena_rewind(Arena *arena, ArenaMark mark){
+
+    while(arena->head && arena->head != mark.block){
+
+        arena_block *prev = arena->head->prev;
+        app_free(arena->head->app, arena->tag, arena->head, sizeof(*arena->head) + arena->head->cap);
+        arena->head = prev;
+
+    }
+
+    if(arena->head) arena->head->used = mark.used;
+    arena->bytes_allocated = mark.bytes_allocated;
+
+}
+
+
+Err arena_free(Arena *arena, app_context *app_context_param){
+
+    if(!arena){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    ArenaMark empty = {NULL, 0, 0};
+    arena_rewind(arena, empty);
+
+    return ERR_OK;
+
+}
@@ -0,0 +1,228 @@
+#include "core/diag.h"
+#include "core/error_handling.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+Err diag_init(DiagList *list, app_context *app_context_param){
+
+    if(!list){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    memset(list, 0, sizeof(*list));
+
+    return ERR_OK;
+
+}
+
+
+Err diag_free(DiagList *list, app_context *app_context_param){
+
+    if(!list) return ERR_INVALID_ARGUMENT;
+
+    app_free(app_context_param, APP_MEM_DIAG, list->v, sizeof(*list->v) * list->cap);
+    app_free(app_context_param, APP_MEM_DIAG, list->text, list->text_cap);
+    memset(list, 0, sizeof(*list));
+
+    return ERR_OK;
+
+}
+
+
+void diag_clear(DiagList *list){
+
+    if(!list) return;
+
+    list->n = 0;
+    list->text_n = 0;
+
+}
+
+
+static Err text_reserve(DiagList *list, size_t extra, app_context *app_context_param){
+
+    if(extra <= list->text_cap - list->text_n) return ERR_OK;
+
+    size_t new_cap = list->text_cap ? list->text_cap * 2 : 1024;
+    while(new_cap - list->text_n < extra) new_cap *= 2;
+
+    if(new_cap > UINT32_MAX){
+
+        APP_ERROR(app_context_param, "DIAGNOSTIC TEXT TOO LARGE.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    char *p = app_alloc(app_context_param, APP_MEM_DIAG, list->text, list->text_cap, new_cap);
+
+    if(!p){
+
+        APP_PERROR(app_context_param, "DIAGNOSTIC TEXT REALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    list->text = p;
+    list->text_cap = new_cap;
+
+    return ERR_OK;
+
+}
+
+
+Err diag_add(DiagList *list, uint32_t line_no, uint32_t column, Err code, const char *message, const char *source, size_t source_len, app_context *app_context_param){
+
+    if(!list || !message || (!source && source_len)){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    if(list->n == list->cap){
+
+        size_t new_cap = list->cap ? list->cap * 2 : 16;
+        Diagnostic *p = app_alloc(app_context_param, APP_MEM_DIAG, list->v, sizeof(*p) * list->cap, sizeof(*p) * new_cap);
+
+        if(!p){
+
+            APP_PERROR(app_context_param, "DIAGNOSTIC LIST REALLOC FAILED.");
+            return ERR_OOM;
+
+        }
+
+        list->v = p;
+        list->cap = new_cap;
+
+    }
+
+    size_t message_len = strlen(message);
+    Err e = text_reserve(list, message_len + 1 + source_len, app_context_param);
+    if(e != ERR_OK) return e;
+
+    Diagnostic *d = &list->v[list->n++];
+    d->line_no = line_no;
+    d->column = column;
+    d->code = code;
+
+    d->message = (uint32_t)list->text_n;
+    memcpy(list->text + list->text_n, message, message_len + 1);
+    list->text_n += message_len + 1;
+
+    d->source = (uint32_t)list->text_n;
+    d->source_len = (uint32_t)source_len;
+    if(source_len) memcpy(list->text + list->text_n, source, source_len);
+    list->text_n += source_len;
+
+    return ERR_OK;
+
+}
+
+
+static size_t put(char *dst, size_t cap, size_t at, const char *s, size_t n){      // bytes past cap are only counted
+
+    if(at < cap) memcpy(dst + at, s, (n < cap - at) ? n : cap - at);
+    return at + n;
+
+}
+
+
+static size_t put_fill(char *dst, size_t cap, size_t at, char c, size_t n){
+
+    if(at < cap) memset(dst + at, c, (n < cap - at) ? n : cap - at);
+    return at + n;
+
+}
+
+
+size_t diag_format(char *dst, size_t cap, uint32_t line_no, uint32_t column, const char *message, const char *source, size_t source_len){
+
+    // Syntax error at line L, col C: message
+    //  source line
+    //      ^
+
+    char head[64];
+    int head_n = column ? snprintf(head, sizeof(head), "Syntax error at line %u, col %u: ", line_no, column)
+                        : snprintf(head, sizeof(head), "Syntax error at line %u: ", line_no);
+
+    size_t at = put(dst, cap, 0, head, (size_t)head_n);
+    at = put(dst, cap, at, message, strlen(message));
+    at = put(dst, cap, at, "\n", 1);
+
+    if(source){
+
+        at = put(dst, cap, at, " ", 1);
+        at = put(dst, cap, at, source, source_len);
+        at = put(dst, cap, at, "\n", 1);
+
+        if(column){
+
+            at = put_fill(dst, cap, at, ' ', column);
+            at = put(dst, cap, at, "^\n", 2);
+
+        }
+
+    }
+
+    if(cap) dst[(at < cap) ? at : cap - 1] = '\0';
+
+    return at;
+
+}
+
+
+Err diag_emit(const DiagList *list, FILE *out, app_context *app_context_param){
+
+    if(!list || !out){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    if(list->n == 0) return ERR_OK;
+
+    size_t total = 0;
+
+    for(size_t i = 0; i < list->n; i++){
+
+        const Diagnostic *d = &list->v[i];
+        total += diag_format(NULL, 0, d->line_no, d->column, list->text + d->message, d->source_len ? list->text + d->source : NULL, d->source_len);
+
+    }
+
+    char *buf = app_alloc(app_context_param, APP_MEM_DIAG, NULL, 0, total + 1);
+
+    if(!buf){
+
+        APP_PERROR(app_context_param, "DIAGNOSTIC OUTPUT MALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    size_t at = 0;
+
+    for(size_t i = 0; i < list->n; i++){
+
+        const Diagnostic *d = &list->v[i];
+        at += diag_format(buf + at, total + 1 - at, d->line_no, d->column, list->text + d->message, d->source_len ? list->text + d->source : NULL, d->source_len);
+
+    }
+
+    size_t written = fwrite(buf, 1, at, out);
+    app_free(app_context_param, APP_MEM_DIAG, buf, total + 1);
+
+    if(written != at){
+
+        APP_PERROR(app_context_param, "DIAGNOSTIC OUTPUT WRITE FAILED.");
+        return ERR_IO;
+
+    }
+
+    return ERR_OK;
+
+}
@@ -1,31 +1,286 @@
 #include "core/error_handling.h"
+#include "core/stats.h"
 #include <stdlib.h>
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+
+#define APP_LOG_TICK_NS (1000 * 1000)      // the writer wakes at least this often, producers signal it only past half a ring
+
+
+typedef struct{
+
+    atomic_size_t seq;                  // == position: free for that producer, == position + 1: published
+    char text[APP_LOG_RECORD_BYTES];    // NUL terminated, ends with '\n'
+
+}LogRecord;
+
+typedef struct{
+
+    LogRecord* ring;
+    size_t mask;                        // ring size - 1
+    AppLogPolicy policy;
+
+    _Alignas(64) atomic_size_t tail;    // next position a producer claims
+    _Alignas(64) size_t head;           // next position the writer drains, writer thread only
+    atomic_size_t written;              // every record before this position is in the file
+    atomic_size_t dropped;
+
+    atomic_int writer_idle;             // the writer sleeps on wake, producers signal it only then
+    atomic_int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t drained;
+    pthread_t writer;
+
+}AppLog;
+
+
+typedef struct{
+
+    atomic_size_t live;
+    atomic_size_t peak;
+    atomic_size_t allocs;
+
+}MemCounter;
 
 
 struct app_context_t{
 
-    FILE* error_log;
-    int last_error_num;
+    FILE* error_log;                    // NULL for a child
+    atomic_int last_error_num;
     char* error_log_path;
+    AppLog* log;                        // NULL: every record is written synchronously
+
+    app_context* parent;                // set for a child: records stay in buffer until merge_child_app_context()
+    char* buffer;
+    size_t buffer_n;
+    size_t buffer_cap;
+
+    app_alloc_fn alloc_fn;              // NULL: libc
+    void* alloc_ctx;
+    int mem_report;
+    MemCounter mem[APP_MEM_TAG_COUNT + 1];     // one per tag, then the total
 
 };
 
 
+static const char* const mem_tag_names[APP_MEM_TAG_COUNT] = {"arena", "ir", "symtab", "strpool", "tokens", "lines", "words", "diag", "other"};
 
 
-static FILE* error_sink(const app_context* app_context_param){                                                                  // this function decides where error logs will go.
-    
-    return (app_context_param)? app_context_param->error_log : stderr;
+static void log_wake_writer(AppLog* log){
+
+    if(atomic_load(&log->writer_idle)){
+
+        pthread_mutex_lock(&log->lock);
+        pthread_cond_signal(&log->wake);
+        pthread_mutex_unlock(&log->lock);
+
+    }
+
+}
+
+
+static void log_vpush(AppLog* log, const char* format, va_list args){                                                         // formats straight into a claimed ring record, no lock taken.
+
+    size_t pos = atomic_load_explicit(&log->tail, memory_order_relaxed);
+    LogRecord* r;
+
+    for(;;){
+
+        r = &log->ring[pos & log->mask];
+        size_t seq = atomic_load_explicit(&r->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if(diff == 0){
+
+            if(atomic_compare_exchange_weak_explicit(&log->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+
+        }
+        else if(diff < 0){                                                                                                     // full: the writer has not freed this record yet
+
+            if(log->policy == APP_LOG_DROP){
+
+                atomic_fetch_add_explicit(&log->dropped, 1, memory_order_relaxed);
+                return;
+
+            }
+
+            log_wake_writer(log);
+            sched_yield();
+            pos = atomic_load_explicit(&log->tail, memory_order_relaxed);
+
+        }
+        else pos = atomic_load_explicit(&log->tail, memory_order_relaxed);
+
+    }
+
+    int n = vsnprintf(r->text, sizeof(r->text), format, args);
+
+    if(n < 0) r->text[0] = '\0';
+    else if((size_t)n >= sizeof(r->text)) r->text[sizeof(r->text) - 2] = '\n';                                               // truncated, still one line
+
+    atomic_store(&r->seq, pos + 1);                                                                                           // publish, seq_cst: pairs with writer_idle
+
+    if(pos + 1 - atomic_load_explicit(&log->written, memory_order_relaxed) > (log->mask + 1) / 2) log_wake_writer(log);     // below half full the writer's own tick drains it
+
+}
+
+
+static void log_push(AppLog* log, const char* format, ...){
+
+    va_list args;
+    va_start(args, format);
+    log_vpush(log, format, args);
+    va_end(args);
 
 }
 
+
+static void log_push_text(AppLog* log, const char* text, size_t len){                                                         // one record per line, a line longer than a record takes several
+
+    while(len > 0){
+
+        const char* nl = memchr(text, '\n', len);
+        size_t line = nl ? (size_t)(nl - text) + 1 : len;
+        size_t piece = (line < APP_LOG_RECORD_BYTES - 1) ? line : APP_LOG_RECORD_BYTES - 1;
+
+        log_push(log, "%.*s", (int)piece, text);
+        text += piece;
+        len -= piece;
+
+    }
+
+}
+
+
+static void* log_writer(void* arg){                                                                                             // the only thread that touches the log FILE in async mode.
+
+    app_context* app_context_param = arg;
+    AppLog* log = app_context_param->log;
+
+    for(;;){
+
+        size_t start = log->head;
+
+        for(;;){
+
+            LogRecord* r = &log->ring[log->head & log->mask];
+            if(atomic_load_explicit(&r->seq, memory_order_acquire) != log->head + 1) break;
+
+            fputs(r->text, app_context_param->error_log);
+            atomic_store_explicit(&r->seq, log->head + log->mask + 1, memory_order_release);                                // free for the producer one lap ahead
+            log->head++;
+
+        }
+
+        if(log->head != start){
+
+            fflush(app_context_param->error_log);
+
+            pthread_mutex_lock(&log->lock);
+            atomic_store(&log->written, log->head);
+            pthread_cond_broadcast(&log->drained);
+            pthread_mutex_unlock(&log->lock);
+            continue;
+
+        }
+
+        // nothing published: stop once every claimed record is written, sleep otherwise
+
+        if(atomic_load(&log->stop) && atomic_load(&log->tail) == log->head) break;
+
+        pthread_mutex_lock(&log->lock);
+        atomic_store(&log->writer_idle, 1);
+
+        LogRecord* next = &log->ring[log->head & log->mask];
+
+        if(atomic_load(&next->seq) != log->head + 1 && !atomic_load(&log->stop)){
+
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += APP_LOG_TICK_NS;
+            if(until.tv_nsec >= 1000000000){ until.tv_sec++; until.tv_nsec -= 1000000000; }
+
+            pthread_cond_timedwait(&log->wake, &log->lock, &until);
+
+        }
+
+        atomic_store(&log->writer_idle, 0);
+        pthread_mutex_unlock(&log->lock);
+
+    }
+
+    return NULL;
+
+}
+
+
+static int buffer_reserve(app_context* child, size_t extra){
+
+    if(extra <= child->buffer_cap - child->buffer_n) return 1;
+
+    size_t new_cap = child->buffer_cap ? child->buffer_cap * 2 : 1024;
+    while(new_cap - child->buffer_n < extra) new_cap *= 2;
+
+    char* p = app_alloc(child, APP_MEM_OTHER, child->buffer, child->buffer_cap, new_cap);       // a failure is not logged: the record goes to stderr
+    if(!p) return 0;
+
+    child->buffer = p;
+    child->buffer_cap = new_cap;
+
+    return 1;
+
+}
+
+
+static void buffer_vappend(app_context* child, const char* format, va_list args){                                              // a record that can not be buffered goes to stderr, it is never lost silently
+
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+
+    if(n < 0) return;
+
+    if(!buffer_reserve(child, (size_t)n + 1)){
+
+        vfprintf(stderr, format, args);
+        return;
+
+    }
+
+    vsnprintf(child->buffer + child->buffer_n, (size_t)n + 1, format, args);
+    child->buffer_n += (size_t)n;
+
+}
+
+
+static void app_write(app_context* app_context_param, const char* format, ...){                                              // this function decides where error logs will go.
+
+    va_list args;
+    va_start(args, format);
+
+    if(!app_context_param) vfprintf(stderr, format, args);
+    else if(app_context_param->parent) buffer_vappend(app_context_param, format, args);
+    else if(app_context_param->log) log_vpush(app_context_param->log, format, args);
+    else vfprintf(app_context_param->error_log, format, args);                                                                // one call: stdio keeps the record in one piece
+
+    va_end(args);
+
+}
+
+
 void app_error(app_context* app_context_param, const char* message, const char* file, int line, const char* func){              // use this function for logging errors that do not set errno.
 
-    FILE* out = error_sink(app_context_param);
-    fprintf(out, "[%s:%d:%s] %s\n", file, line, func, message);
+    app_write(app_context_param, "[%s:%d:%s] %s\n", file, line, func, message);
     return;
 }
 
@@ -33,9 +288,23 @@ void app_error(app_context* app_context_param, const char* message, const char*
 void app_perror(app_context* app_context_param, const char* message, const char* file, int line, const char* func){             // use this function for logging errors that set errno.
 
     int e = errno;
-    FILE* out = error_sink(app_context_param);
-    fprintf(out, "[%s:%d:%s] %s: %s\n", file, line, func, message, strerror(e));
-    if(app_context_param) app_context_param->last_error_num = e;
+    app_write(app_context_param, "[%s:%d:%s] %s: %s\n", file, line, func, message, strerror(e));
+    if(app_context_param) atomic_store_explicit(&app_context_param->last_error_num, e, memory_order_relaxed);
+
+}
+
+
+void app_log_text(app_context* app_context_param, const char* text, size_t len){
+
+    if(app_context_param && !app_context_param->parent && app_context_param->log) log_push_text(app_context_param->log, text, len);
+    else app_write(app_context_param, "%.*s", (int)len, text);
+
+}
+
+
+int app_context_last_error(const app_context* app_context_param){
+
+    return app_context_param ? atomic_load_explicit(&app_context_param->last_error_num, memory_order_relaxed) : 0;
 
 }
 
@@ -76,12 +345,283 @@ app_context* create_app_context(const char* error_log_path_param){
     }
 
 
-    new_app_context->last_error_num = 0;
+    atomic_init(&new_app_context->last_error_num, 0);
+    new_app_context->log = NULL;
+    new_app_context->parent = NULL;
+    new_app_context->buffer = NULL;
+    new_app_context->buffer_n = new_app_context->buffer_cap = 0;
+    new_app_context->alloc_fn = NULL;
+    new_app_context->alloc_ctx = NULL;
+    new_app_context->mem_report = 0;
+    memset(new_app_context->mem, 0, sizeof(new_app_context->mem));
+
+    return new_app_context;
+}
+
+
+app_context* create_child_app_context(app_context* parent){                                                                    // per thread context, nothing is written until it is merged.
+
+    if(!parent) {
+
+        APP_ERROR(NULL, "INVALID ARGUMENT");
+        return NULL;
+    }
+
+    app_context* child = calloc(1, sizeof(app_context));
+
+    if(!child) {
+
+        APP_PERROR(parent, "CHILD APP CONTEXT STRUCT: ALLOCATION FAILED");
+        return NULL;
+    }
+
+    atomic_init(&child->last_error_num, 0);
+    child->parent = parent;
+    child->alloc_fn = parent->alloc_fn;
+    child->alloc_ctx = parent->alloc_ctx;
+
+    return child;
+}
+
+
+Err merge_child_app_context(app_context* parent, app_context* child){                                                         // the child's records go to parent in one piece, the child is emptied and stays usable.
+
+    if(!parent || !child || child->parent != parent) {
+
+        APP_ERROR(parent, "invalid argument.");
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    if(child->buffer_n){
+
+        if(parent->parent){
+
+            if(!buffer_reserve(parent, child->buffer_n)){
+
+                APP_PERROR(NULL, "CHILD APP CONTEXT MERGE: ALLOCATION FAILED");
+                return ERR_OOM;
+            }
+
+            memcpy(parent->buffer + parent->buffer_n, child->buffer, child->buffer_n);
+            parent->buffer_n += child->buffer_n;
+
+        }
+        else if(parent->log) log_push_text(parent->log, child->buffer, child->buffer_n);
+        else fwrite(child->buffer, 1, child->buffer_n, parent->error_log);
+
+        child->buffer_n = 0;
+
+    }
+
+    int e = atomic_exchange_explicit(&child->last_error_num, 0, memory_order_relaxed);
+    if(e) atomic_store_explicit(&parent->last_error_num, e, memory_order_relaxed);
+
+    return ERR_OK;
+}
+
+
+app_context* create_app_context_async(const char* error_log_path_param, const AppLogConfig* config){                            // same as create_app_context(), records are written by a background thread.
+
+    app_context* new_app_context = create_app_context(error_log_path_param);
+    if(!new_app_context) return NULL;
+
+    size_t n = (config && config->ring_records) ? config->ring_records : 1024;
+    size_t size = 2;
+    while(size < n) size *= 2;
+
+    AppLog* log = calloc(1, sizeof(AppLog));
+    LogRecord* ring = log ? malloc(sizeof(LogRecord) * size) : NULL;
+
+    if(!ring){
+
+        APP_PERROR(NULL, "ASYNC LOG RING: ALLOCATION FAILED");
+        free(log);
+        destroy_app_context(new_app_context);
+        return NULL;
+
+    }
+
+    for(size_t i = 0; i < size; i++) atomic_init(&ring[i].seq, i);
+
+    log->ring = ring;
+    log->mask = size - 1;
+    log->policy = config ? config->policy : APP_LOG_BLOCK;
+
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->wake, NULL);
+    pthread_cond_init(&log->drained, NULL);
+
+    new_app_context->log = log;
+
+    if(pthread_create(&log->writer, NULL, log_writer, new_app_context) != 0){
+
+        APP_ERROR(NULL, "ASYNC LOG WRITER THREAD CAN NOT BE CREATED");
+        new_app_context->log = NULL;
+        pthread_mutex_destroy(&log->lock);
+        pthread_cond_destroy(&log->wake);
+        pthread_cond_destroy(&log->drained);
+        free(ring);
+        free(log);
+        destroy_app_context(new_app_context);
+        return NULL;
+
+    }
 
     return new_app_context;
 }
 
 
+Err app_context_flush(app_context* app_context_param){                                                                        // waits for the writer, synchronous contexts just flush their FILE.
+
+    if(!app_context_param){
+
+        APP_ERROR(app_context_param, "invalid argument.");
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    AppLog* log = app_context_param->log;
+
+    if(!log){
+
+        if(app_context_param->error_log) fflush(app_context_param->error_log);          // a child has nothing to flush before its merge
+        return ERR_OK;
+
+    }
+
+    size_t target = atomic_load(&log->tail);
+
+    pthread_mutex_lock(&log->lock);
+
+    while(atomic_load(&log->written) < target){
+
+        pthread_cond_signal(&log->wake);
+        pthread_cond_wait(&log->drained, &log->lock);
+
+    }
+
+    pthread_mutex_unlock(&log->lock);
+
+    return ERR_OK;
+}
+
+
+size_t app_context_dropped(const app_context* app_context_param){
+
+    return (app_context_param && app_context_param->log) ? atomic_load(&app_context_param->log->dropped) : 0;
+
+}
+
+
+
+
+static void mem_account(app_context* app_context_param, AppMemTag tag, size_t old_size, size_t new_size){
+
+    MemCounter* counters[2] = {&app_context_param->mem[tag], &app_context_param->mem[APP_MEM_TAG_COUNT]};
+
+    for(int i = 0; i < 2; i++){
+
+        MemCounter* c = counters[i];
+
+        if(new_size) atomic_fetch_add_explicit(&c->allocs, 1, memory_order_relaxed);
+        if(new_size <= old_size){
+
+            atomic_fetch_sub_explicit(&c->live, old_size - new_size, memory_order_relaxed);
+            continue;
+
+        }
+
+        size_t live = atomic_fetch_add_explicit(&c->live, new_size - old_size, memory_order_relaxed) + (new_size - old_size);
+        size_t peak = atomic_load_explicit(&c->peak, memory_order_relaxed);
+
+        while(live > peak && !atomic_compare_exchange_weak_explicit(&c->peak, &peak, live, memory_order_relaxed, memory_order_relaxed));
+
+    }
+
+}
+
+
+void* app_alloc(app_context* app_context_param, AppMemTag tag, void* ptr, size_t old_size, size_t new_size){                   // the one heap entry point of mips_core and mips_front.
+
+    if(new_size) ASM_STATS_COUNT_ALLOC();
+    if(!ptr) old_size = 0;
+
+    void* p;
+
+    if(app_context_param && app_context_param->alloc_fn) p = app_context_param->alloc_fn(app_context_param->alloc_ctx, tag, ptr, old_size, new_size);
+    else if(new_size) p = realloc(ptr, new_size);
+    else{
+
+        free(ptr);
+        p = NULL;
+
+    }
+
+    if(new_size && !p) return NULL;         // a failed resize leaves ptr and the counters as they were
+
+    if(tag >= APP_MEM_TAG_COUNT) tag = APP_MEM_OTHER;
+    for(app_context* c = app_context_param; c; c = c->parent) mem_account(c, tag, old_size, new_size);
+
+    return p;
+
+}
+
+
+void app_context_set_allocator(app_context* app_context_param, app_alloc_fn alloc_fn, void* ctx){
+
+    if(!app_context_param) return;
+
+    app_context_param->alloc_fn = alloc_fn;
+    app_context_param->alloc_ctx = alloc_fn ? ctx : NULL;
+
+}
+
+
+void app_context_set_mem_report(app_context* app_context_param, int enabled){
+
+    if(app_context_param) app_context_param->mem_report = enabled;
+
+}
+
+
+Err app_context_mem_stats(const app_context* app_context_param, AppMemTag tag, AppMemStats* out_stats){
+
+    if(!app_context_param || tag > APP_MEM_TAG_COUNT || !out_stats) return ERR_INVALID_ARGUMENT;
+
+    const MemCounter* c = &app_context_param->mem[tag];
+    out_stats->live = atomic_load_explicit(&c->live, memory_order_relaxed);
+    out_stats->peak = atomic_load_explicit(&c->peak, memory_order_relaxed);
+    out_stats->allocs = atomic_load_explicit(&c->allocs, memory_order_relaxed);
+
+    return ERR_OK;
+
+}
+
+
+const char* app_mem_tag_name(AppMemTag tag){
+
+    return (tag < APP_MEM_TAG_COUNT) ? mem_tag_names[tag] : "total";
+
+}
+
+
+static void mem_report(app_context* app_context_param){                                                                        // one table, logged in one piece.
+
+    char text[(APP_MEM_TAG_COUNT + 2) * 80];
+    size_t n = (size_t)snprintf(text, sizeof(text), "memory by subsystem: %-8s %14s %14s %10s\n", "tag", "live bytes", "peak bytes", "allocs");
+
+    for(int tag = 0; tag <= APP_MEM_TAG_COUNT && n < sizeof(text); tag++){
+
+        AppMemStats stats = {0};
+        app_context_mem_stats(app_context_param, (AppMemTag)tag, &stats);
+
+        n += (size_t)snprintf(text + n, sizeof(text) - n, "memory by subsystem: %-8s %14zu %14zu %10zu\n",
+                              app_mem_tag_name((AppMemTag)tag), stats.live, stats.peak, stats.allocs);
+
+    }
+
+    app_log_text(app_context_param, text, n < sizeof(text) ? n : sizeof(text) - 1);
+
+}
 
 
 Err destroy_app_context(app_context* app_context_param){                                                                        // deallocate app_context_t instance and close associated file pointer. 
@@ -92,6 +632,34 @@ Err destroy_app_context(app_context* app_context_param){
         return ERR_INVALID_ARGUMENT;
     }    
 
+    if(app_context_param->parent){                                                                                             // a child owns no file, unmerged records are dropped
+
+        app_free(app_context_param, APP_MEM_OTHER, app_context_param->buffer, app_context_param->buffer_cap);
+        free(app_context_param);
+        return ERR_OK;
+
+    }
+
+    if(app_context_param->mem_report) mem_report(app_context_param);
+
+    AppLog* log = app_context_param->log;
+
+    if(log){                                                                                                                   // the writer drains every claimed record before it exits
+
+        pthread_mutex_lock(&log->lock);
+        atomic_store(&log->stop, 1);
+        pthread_cond_signal(&log->wake);
+        pthread_mutex_unlock(&log->lock);
+
+        pthread_join(log->writer, NULL);
+
+        pthread_mutex_destroy(&log->lock);
+        pthread_cond_destroy(&log->wake);
+        pthread_cond_destroy(&log->drained);
+        free(log->ring);
+        free(log);
+
+    }
     
     fclose(app_context_param->error_log);
     free(app_context_param->error_log_path);
@@ -1,6 +1,8 @@
 #include "core/ir.h"
 #include "core/error_handling.h"
+#include "core/isa_mips.h"
 #include <stdlib.h>
+#include <string.h>
 
 
 Err ir_init(IR *ir, app_context *app_context_param){
@@ -15,15 +17,32 @@ Err ir_init(IR *ir, app_context *app_context_param){
     ir->v = NULL;
     ir->n = 0;
     ir->cap = 0;
+    ir->words = NULL;
+    ir->words_n = ir->words_cap = 0;
+    ir->arena = NULL;
 
     return ERR_OK;
 
 }
 
-static Err ir_grow(IR *ir, app_context *app_context_param){
+
+Err ir_init_arena(IR *ir, Arena *arena, app_context *app_context_param){
+
+    Err e = ir_init(ir, app_context_param);
+    if(e != ERR_OK) return e;
+
+    ir->arena = arena;
+
+    return ERR_OK;
+
+}
+
+static Err ir_grow(IR *ir, size_t need, app_context *app_context_param){
 
     size_t new_cap = (ir->cap == 0)? 64 : (ir->cap * 2);
-    Statement *s_p = realloc(ir->v, sizeof(*s_p) * new_cap);
+    while(new_cap < ir->n + need) new_cap *= 2;
+    IrRec *s_p = ir->arena ? arena_realloc(ir->arena, ir->v, sizeof(*s_p) * ir->cap, sizeof(*s_p) * new_cap, app_context_param)
+                           : app_alloc(app_context_param, APP_MEM_IR, ir->v, sizeof(*s_p) * ir->cap, sizeof(*s_p) * new_cap);
     
     if(!s_p){
 
@@ -40,6 +59,149 @@ static Err ir_grow(IR *ir, app_context *app_context_param){
 }
 
 
+static Err ir_grow_words(IR *ir, size_t need, app_context *app_context_param){
+
+    size_t new_cap = (ir->words_cap == 0)? 256 : ir->words_cap;
+    while(new_cap < ir->words_n + need) new_cap *= 2;
+
+    int32_t *p = ir->arena ? arena_realloc(ir->arena, ir->words, sizeof(*p) * ir->words_cap, sizeof(*p) * new_cap, app_context_param)
+                           : app_alloc(app_context_param, APP_MEM_IR, ir->words, sizeof(*p) * ir->words_cap, sizeof(*p) * new_cap);
+
+    if(!p){
+
+        APP_PERROR(app_context_param, "IR REALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    ir->words = p;
+    ir->words_cap = new_cap;
+
+    return ERR_OK;
+
+}
+
+
+static Err ir_encode_words(IR *ir, IrRec *r, const int32_t *values, size_t n, app_context *app_context_param){
+
+    if(n > UINT32_MAX || ir->words_n + n + 1 > UINT32_MAX){
+
+        APP_ERROR(app_context_param, "TOO MANY .word VALUES");
+        return ERR_OOM;
+
+    }
+
+    if(ir->words_n + n + 1 > ir->words_cap){
+
+        Err e = ir_grow_words(ir, n + 1, app_context_param);
+        if(e != ERR_OK) return e;
+
+    }
+
+    r->val = (uint32_t)ir->words_n;
+    ir->words[ir->words_n++] = (int32_t)(uint32_t)n;
+    if(n) memcpy(&ir->words[ir->words_n], values, sizeof(*values) * n);
+    ir->words_n += n;
+
+    return ERR_OK;
+
+}
+
+
+static Err ir_encode_instr(IrRec *r, int op, const Operand *ops, int op_count, app_context *app_context_param){
+
+    const InstructionSpec *spec = isa_spec((IsaId)op);
+
+    if(!spec || op_count < 0 || !are_operands_valid(spec, ops, (size_t)op_count)){     // decoding relies on the spec
+
+        APP_ERROR(app_context_param, "INSTRUCTION DOES NOT MATCH ITS SPEC");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    int wide = 0;
+    r->op = (uint8_t)op;
+
+    for(int i = 0; i < op_count; i++){
+
+        const Operand *o = &ops[i];
+        int reg = (o->kind == OP_REGISTER) ? o->v.reg : (o->kind == OP_MEMORY) ? o->v.mem.base_reg : 0;
+
+        if(reg < 0 || (unsigned)reg > IR_REG_MASK){
+
+            APP_ERROR(app_context_param, "INVALID REGISTER NUMBER");
+            return ERR_INVALID_ARGUMENT;
+
+        }
+
+        r->regs |= (uint16_t)((unsigned)reg << (IR_REG_BITS * i));
+
+        if(o->kind == OP_REGISTER) continue;
+
+        if(wide++){
+
+            APP_ERROR(app_context_param, "MORE THAN ONE WIDE OPERAND");       // no instruction of the table has two
+            return ERR_INVALID_ARGUMENT;
+
+        }
+
+        r->val = (o->kind == OP_IMMEDIATE) ? (uint32_t)o->v.imm : (o->kind == OP_MEMORY) ? (uint32_t)o->v.mem.offset : o->v.label;
+
+    }
+
+    return ERR_OK;
+
+}
+
+
+Err ir_encode(const Statement *s, IrRec *out, app_context *app_context_param){
+
+    if(!s || !out){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    IrRec r = {0};
+    Err e = ERR_OK;
+
+    r.line_no = (uint32_t)s->line_no;
+    r.kind = (uint8_t)s->kind;
+
+    switch(s->kind){
+
+        case ST_INSTR:
+            e = ir_encode_instr(&r, s->as.instr.op, s->as.instr.ops, s->as.instr.op_count, app_context_param);
+            break;
+
+        case ST_LABEL:
+            r.label = s->as.label.name;
+            break;
+
+        case ST_LABEL_PLUS_INSTR:
+            r.label = s->as.label_plus_instr.name;
+            e = ir_encode_instr(&r, s->as.label_plus_instr.instr.op, s->as.label_plus_instr.instr.ops, s->as.label_plus_instr.instr.op_count, app_context_param);
+            break;
+
+        case ST_LABEL_PLUS_DIR_WORD:
+            r.label = s->as.label_plus_dir_word.name;
+            break;
+
+        default:
+            break;
+
+    }
+
+    if(e != ERR_OK) return e;
+
+    *out = r;
+
+    return ERR_OK;
+
+}
+
+
 Err ir_push(IR *ir, const Statement *s, app_context *app_context_param){
 
     if(!ir || !s){
@@ -51,68 +213,133 @@ Err ir_push(IR *ir, const Statement *s, app_context *app_context_param){
 
     if(ir->cap == ir->n){
 
-        Err e = ir_grow(ir, app_context_param);
+        Err e = ir_grow(ir, 1, app_context_param);
         if(e != ERR_OK) return e;
     }
 
-    ir->v[ir->n++] = *s;
+    IrRec r;
+    Err e = ir_encode(s, &r, app_context_param);
+
+    if(e == ERR_OK && s->kind == ST_DIR_WORD) e = ir_encode_words(ir, &r, s->as.dir_word.values, s->as.dir_word.n, app_context_param);
+    else if(e == ERR_OK && s->kind == ST_LABEL_PLUS_DIR_WORD) e = ir_encode_words(ir, &r, s->as.label_plus_dir_word.dir_word.values, s->as.label_plus_dir_word.dir_word.n, app_context_param);
+
+    if(e != ERR_OK) return e;
+
+    ir->v[ir->n++] = r;
 
     return ERR_OK;
 }
 
-void operand_free(Operand *op){
 
-    if(!op) return;
+Err ir_reserve(IR *ir, size_t records, size_t words, app_context *app_context_param){
 
-    if(op->kind == OP_LABEL && op->v.label){
+    if(!ir){
 
-        free(op->v.label);
-        op->v.label = NULL;
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
 
     }
 
-}
+    Err e;
 
+    if(ir->n + records > ir->cap && (e = ir_grow(ir, records, app_context_param)) != ERR_OK) return e;
+    if(ir->words_n + words > ir->words_cap && (e = ir_grow_words(ir, words, app_context_param)) != ERR_OK) return e;
 
-void stmt_free_heap_parts(Statement *s){
+    return ERR_OK;
 
-    if(!s) return;
+}
 
-    if(s->kind == ST_DIR_WORD){
 
-        free(s->as.dir_word.values);
-        s->as.dir_word.values = NULL;
-        s->as.dir_word.n = 0;
+static void ir_decode_instr(const IrRec *r, int *out_op, Operand *ops, int *out_op_count){
 
-    }
+    const InstructionSpec *spec = isa_spec((IsaId)r->op);
+
+    *out_op = r->op;
+    *out_op_count = spec->op_count;
 
-    else if(s->kind == ST_INSTR){
+    for(int i = 0; i < spec->op_count; i++){
 
-        for(size_t i = 0; i < (size_t)s->as.instr.op_count; i++){
+        Operand *o = &ops[i];
+        o->kind = isa_operand_kind(spec->ops[i]);
 
-            operand_free(&s->as.instr.ops[i]);
+        if(o->kind == OP_REGISTER) o->v.reg = ir_rec_reg(r, i);
+        else if(o->kind == OP_IMMEDIATE) o->v.imm = (int32_t)r->val;
+        else if(o->kind == OP_LABEL) o->v.label = r->val;
+        else{
+
+            o->v.mem.offset = (int32_t)r->val;
+            o->v.mem.base_reg = ir_rec_reg(r, i);
 
         }
 
     }
 
+}
 
-    else if(s->kind == ST_LABEL_PLUS_DIR_WORD){
 
-        free(s->as.label_plus_dir_word.dir_word.values);
-        s->as.label_plus_dir_word.dir_word.values = NULL;
-        s->as.label_plus_dir_word.dir_word.n = 0;
+Err ir_get(const IR *ir, size_t i, Statement *out){
+
+    if(!ir || !out || i >= ir->n) return ERR_INVALID_ARGUMENT;
+
+    const IrRec *r = &ir->v[i];
+    size_t n = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->line_no = (int)r->line_no;
+    out->kind = (StatementKind)r->kind;
+
+    switch(out->kind){
+
+        case ST_DIR_WORD:
+            out->as.dir_word.values = (int32_t *)ir_rec_words(ir, r, &n);
+            out->as.dir_word.n = n;
+            break;
+
+        case ST_INSTR:
+            ir_decode_instr(r, &out->as.instr.op, out->as.instr.ops, &out->as.instr.op_count);
+            break;
+
+        case ST_LABEL:
+            out->as.label.name = r->label;
+            break;
+
+        case ST_LABEL_PLUS_INSTR:
+            out->as.label_plus_instr.name = r->label;
+            ir_decode_instr(r, &out->as.label_plus_instr.instr.op, out->as.label_plus_instr.instr.ops, &out->as.label_plus_instr.instr.op_count);
+            break;
+
+        case ST_LABEL_PLUS_DIR_WORD:
+            out->as.label_plus_dir_word.name = r->label;
+            out->as.label_plus_dir_word.dir_word.values = (int32_t *)ir_rec_words(ir, r, &n);
+            out->as.label_plus_dir_word.dir_word.n = n;
+            break;
+
+        default:
+            break;
 
     }
 
+    return ERR_OK;
 
-    else if(s->kind == ST_LABEL_PLUS_INSTR){
+}
 
-        for(size_t i = 0; i < (size_t)s->as.label_plus_instr.instr.op_count; i++){
+void stmt_free_heap_parts(Statement *s, app_context *app_context_param){
 
-            operand_free(&s->as.label_plus_instr.instr.ops[i]);
+    if(!s) return;
 
-        }
+    if(s->kind == ST_DIR_WORD){
+
+        app_free(app_context_param, APP_MEM_WORDS, s->as.dir_word.values, sizeof(int32_t) * s->as.dir_word.n);
+        s->as.dir_word.values = NULL;
+        s->as.dir_word.n = 0;
+
+    }
+
+    else if(s->kind == ST_LABEL_PLUS_DIR_WORD){
+
+        app_free(app_context_param, APP_MEM_WORDS, s->as.label_plus_dir_word.dir_word.values, sizeof(int32_t) * s->as.label_plus_dir_word.dir_word.n);
+        s->as.label_plus_dir_word.dir_word.values = NULL;
+        s->as.label_plus_dir_word.dir_word.n = 0;
 
     }
 
@@ -121,19 +348,19 @@ void stmt_free_heap_parts(Statement *s){
 
 Err ir_free(IR *ir, app_context *app_context_param){
 
-    (void)app_context_param;
-
     if(!ir) return ERR_INVALID_ARGUMENT;
 
-    for(size_t i = 0; i < ir->n; i++){
+    if(!ir->arena){         // arena backed IR is released together with its arena
 
-        stmt_free_heap_parts(&ir->v[i]);
+        app_free(app_context_param, APP_MEM_IR, ir->v, sizeof(*ir->v) * ir->cap);
+        app_free(app_context_param, APP_MEM_IR, ir->words, sizeof(*ir->words) * ir->words_cap);
 
     }
 
-    free(ir->v);
     ir->v = NULL;
     ir->cap = ir->n = 0;
+    ir->words = NULL;
+    ir->words_n = ir->words_cap = 0;
 
     return ERR_OK;
 }
@@ -1,34 +1,64 @@
 #include "core/isa_mips.h"
+#include "core/isa_hash.h"
+#include "core/isa_mips_hash.h"     // generated by tools/isa_hash_gen.c
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
 
-static const InstructionSpec instruction_table[] = {
+static const InstructionSpec instruction_table[ISA_COUNT] = {
 
-    {"add", FMT_R, 0X00, 0x20, 3, {OPK_REG, OPK_REG, OPK_REG}, IMM_NONE},
-    {"sub", FMT_R, 0x00, 0x22, 3, {OPK_REG, OPK_REG, OPK_REG}, IMM_NONE},
-    {"addi", FMT_I, 0x08, 0x00, 3,{OPK_REG, OPK_REG, OPK_IMM}, IMM_SIGNED16},
-    {"lw", FMT_I, 0x23, 0x00, 2, {OPK_REG, OPK_MEM}, IMM_SIGNED16},
-    {"sw", FMT_I, 0x2B, 0x00, 2, {OPK_REG, OPK_MEM}, IMM_SIGNED16},
-    {"beq", FMT_I, 0x04, 0x00, 3, {OPK_REG, OPK_REG, OPK_LABEL}, IMM_BRANCH16},
-    {"j", FMT_J, 0x02, 0x00, 1, {OPK_LABEL}, IMM_J26}
+#define ISA_OPS(...) {__VA_ARGS__}
+#define ISA_INSTR(id, mnemonic, format, opcode, funct, op_count, ops, imm_kind) [ISA_##id] = {mnemonic, format, opcode, funct, op_count, ops, imm_kind},
+#include "core/isa_mips.def"
+#undef ISA_INSTR
+#undef ISA_OPS
 
 };
 
+_Static_assert(ISA_COUNT <= (1ull << (8 * sizeof(isa_hash_slot[0]))) - 1, "isa_hash_slot entry type too narrow for the instruction table");     // slots hold index + 1
+
+
+const InstructionSpec *isa_lookup_n(const char *mnemonic, size_t len){
+
+    if(!mnemonic) return NULL;
+
+    uint32_t h = isa_mnemonic_hash(mnemonic, len, ISA_HASH_SEED) & ((1u << ISA_HASH_BITS) - 1);
+    unsigned slot = isa_hash_slot[h];
+
+    if(slot == 0) return NULL;
+
+    const InstructionSpec *spec = &instruction_table[slot - 1];
+
+    if(strncmp(spec->mnemonic, mnemonic, len) != 0 || spec->mnemonic[len] != '\0') return NULL;      // the only string compare
+
+    return spec;
+
+}
+
 
 const InstructionSpec *isa_lookup(const char *mnemonic){
 
-    for(size_t i = 0; i < sizeof(instruction_table) / sizeof(instruction_table[0]); i++){
+    if(!mnemonic) return NULL;
+    return isa_lookup_n(mnemonic, strlen(mnemonic));
 
-        if(strcmp(mnemonic, instruction_table[i].mnemonic) == 0) return &instruction_table[i];
+}
 
-    }
-    
-    return NULL;
+
+const InstructionSpec *isa_spec(IsaId id){
+
+    if((unsigned)id >= ISA_COUNT) return NULL;
+    return &instruction_table[id];
+
+}
+
+
+IsaId isa_spec_id(const InstructionSpec *instr_spec){
+
+    return (IsaId)(instr_spec - instruction_table);
 
 }
 
-static OpKind convert_operand_class_to_operand_enum(const OperandClass operand_class){
+OpKind isa_operand_kind(OperandClass operand_class){
 
     switch (operand_class) {
         
@@ -41,7 +71,7 @@ static OpKind convert_operand_class_to_operand_enum(const OperandClass operand_c
 
 }
 
-int are_operands_valid(const InstructionSpec *instr_spec, Operand *ops, size_t op_count){
+int are_operands_valid(const InstructionSpec *instr_spec, const Operand *ops, size_t op_count){
 
     if(!instr_spec || !ops) return 0;
     if(instr_spec->op_count != op_count) return 0; 
@@ -49,7 +79,7 @@ int are_operands_valid(const InstructionSpec *instr_spec, Operand *ops, size_t o
 
     for(size_t i = 0; i < op_count; i++){
 
-        if(convert_operand_class_to_operand_enum(instr_spec->ops[i]) != ops[i].kind) return 0;  // one operand of operands is invalid.
+        if(isa_operand_kind(instr_spec->ops[i]) != ops[i].kind) return 0;  // one operand of operands is invalid.
 
     }
 
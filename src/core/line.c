@@ -4,11 +4,26 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 struct input_program_t{
 
     FILE* input;
-    char **lines;
+    LineList lines;
+
+};
+
+
+struct mapped_program_t{
+
+    const char *text;       // whole file, mapped read only (NULL for an empty file)
+    size_t size;
+    uint32_t *line_start;   // byte offset of every line start, 4 byte per line instead of a malloc'ed string per line
+    size_t line_start_cap;
     size_t number_of_line;
 
 };
@@ -32,7 +47,7 @@ static Err append_chunk(app_context* app_context_param, char **destination, size
         while(new_cap < *len + n + 1) new_cap *= 2;
 
 
-        char *p = realloc(*destination, new_cap);
+        char *p = app_alloc(app_context_param, APP_MEM_LINES, *destination, *cap, new_cap);
         
         if(!p){
 
@@ -55,9 +70,9 @@ static Err append_chunk(app_context* app_context_param, char **destination, size
 
 }
 
-Err read_line_fgets(app_context* app_context_param ,FILE *f, char** out_line){
+Err read_line_fgets(app_context* app_context_param ,FILE *f, char** out_line, size_t *out_size){
 
-    if(!f || !out_line) {
+    if(!f || !out_line || !out_size) {
 
         APP_ERROR(app_context_param, "INVALID ARGUMENT");
         return ERR_INVALID_ARGUMENT;
@@ -78,28 +93,38 @@ Err read_line_fgets(app_context* app_context_param ,FILE *f, char** out_line){
 
         if((e = append_chunk(app_context_param ,out_line, &len, &cap, chunk, n)) != ERR_OK){
 
-            free(*out_line);
+            app_free(app_context_param, APP_MEM_LINES, *out_line, cap);
             *out_line = NULL;
             return e;
 
         }
 
 
-        if(n > 0 && chunk[n - 1] == '\n') return ERR_OK;
+        if(n > 0 && chunk[n - 1] == '\n'){
+
+            *out_size = cap;
+            return ERR_OK;
+
+        }
 
 
     }
 
     if(ferror(f)){
 
-        free(*out_line);
+        app_free(app_context_param, APP_MEM_LINES, *out_line, cap);
         *out_line = NULL;
         APP_ERROR(app_context_param, "READ ERROR MAY BE OCCURED");
         return ERR_READ_ERROR;
 
     }
 
-    if(len > 0) return ERR_OK;
+    if(len > 0){
+
+        *out_size = cap;
+        return ERR_OK;
+
+    }
 
 
     APP_ERROR(app_context_param, "END OF FILE REACHED & NO CHARACTER INPUT FOUND");
@@ -107,20 +132,13 @@ Err read_line_fgets(app_context* app_context_param ,FILE *f, char** out_line){
 
 }
 
-static Err push_line(app_context* app_context_param, char ***lines, size_t *n, size_t *cap, char *line){
+static Err push_line(app_context* app_context_param, LineList *lines, char *line, size_t size){
 
-    if(!lines || !n || !cap || !line){
+    if(lines->cap == lines->n){
 
-        APP_ERROR(app_context_param, "INVALID ARGUMENT");
-        return ERR_INVALID_ARGUMENT;
-
-    }
-
-    if(*cap == *n){
+        size_t new_cap = (lines->cap == 0)? 64 : (lines->cap * 2);
+        LineBuf *p = app_alloc(app_context_param, APP_MEM_LINES, lines->v, lines->cap * sizeof(*p), new_cap * sizeof(*p));
 
-        size_t new_cap = (*cap == 0)? 64 : (*cap * 2);
-        char **p = realloc(*lines, new_cap * sizeof(*p));
-        
         if(!p){
 
             APP_PERROR(app_context_param, "REALLOC FAILED");
@@ -128,90 +146,72 @@ static Err push_line(app_context* app_context_param, char ***lines, size_t *n, s
 
         }
 
-        *lines = p;
-        *cap = new_cap;
+        lines->v = p;
+        lines->cap = new_cap;
 
     }
 
+    lines->v[lines->n++] = (LineBuf){line, size};
 
-    (*lines)[(*n)++] = line;
     return ERR_OK;
 
 }
 
-Err read_all_lines(app_context* app_context_param, FILE *f, char ***out_lines, size_t *out_n){
+Err line_list_free(LineList *lines, app_context* app_context_param){
 
-    if(!app_context_param || !f || !out_lines || !out_n){
+    if(!lines){
 
         APP_ERROR(app_context_param, "INVALID ARGUMENT");
         return ERR_INVALID_ARGUMENT;
+
     }
 
-    *out_lines = NULL;
-    *out_n = 0;
+    for(size_t i = 0; i < lines->n; i++) app_free(app_context_param, APP_MEM_LINES, lines->v[i].text, lines->v[i].size);
+    app_free(app_context_param, APP_MEM_LINES, lines->v, lines->cap * sizeof(*lines->v));
 
-    char **lines = NULL;
-    size_t n = 0; 
-    size_t cap = 0;
+    *lines = (LineList){0};
 
+    return ERR_OK;
+
+}
+
+Err read_all_lines(app_context* app_context_param, FILE *f, LineList *out_lines){
+
+    if(!app_context_param || !f || !out_lines){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    LineList lines = {0};
 
     for(;;){
 
         char *line = NULL;
-        Err e1 = read_line_fgets(app_context_param ,f, &line);
+        size_t size = 0;
+        Err e1 = read_line_fgets(app_context_param ,f, &line, &size);
 
-        if(e1 == ERR_NO_CHAR_INPUT) break;  
+        if(e1 == ERR_NO_CHAR_INPUT) break;
         if(e1 == ERR_READ_ERROR || e1 == ERR_OOM || e1 == ERR_INVALID_ARGUMENT){
 
-            for(size_t i = 0; i < n; i++) free(lines[i]);
-            free(lines);
+            line_list_free(&lines, app_context_param);
             return e1;
 
         }
 
-        Err e2;
-
-        e2 = push_line(app_context_param, &lines, &n, &cap, line);
+        Err e2 = push_line(app_context_param, &lines, line, size);
 
         if(e2 != ERR_OK){
 
-            free(line);
-            for(size_t i = 0; i < n; i++) free(lines[i]);
-            free(lines);
+            app_free(app_context_param, APP_MEM_LINES, line, size);
+            line_list_free(&lines, app_context_param);
             return e2;
 
         }
 
     }
 
-
     *out_lines = lines;
-    *out_n = n;
-    
-    return ERR_OK;
-
-}
-
-
-static Err free_lines(app_context* app_context_param, char ***lines, size_t *n){
-
-    if(!lines || !n) {
-
-        APP_ERROR(app_context_param, "INVALID ARGUMENT");
-        return ERR_INVALID_ARGUMENT;
-
-    }
-
-    for (size_t i = 0; i < *n; i++){
-
-        if((*lines)[i])
-            free((*lines)[i]);
-
-    }
-
-    free(*lines);
-    *lines = NULL;
-    *n = 0;
 
     return ERR_OK;
 
@@ -236,7 +236,7 @@ input_program* create_input_program(app_context* app_context_param, const char*
 
     }
 
-    input_program* input_prog = malloc(sizeof(input_program));
+    input_program* input_prog = app_alloc(app_context_param, APP_MEM_LINES, NULL, 0, sizeof(input_program));
 
     if(!input_prog){
 
@@ -247,8 +247,7 @@ input_program* create_input_program(app_context* app_context_param, const char*
     }
 
     input_prog->input = fp_input_file;
-    input_prog->lines = NULL;
-    input_prog->number_of_line = 0;
+    input_prog->lines = (LineList){0};
 
     return input_prog;
 }
@@ -266,9 +265,9 @@ Err destroy_input_program(app_context* app_context_param, input_program* input_p
 
     Err e1;
 
-    e1 = free_lines(app_context_param, &(input_program_param->lines), &(input_program_param->number_of_line));
+    e1 = line_list_free(&(input_program_param->lines), app_context_param);
 
-    free(input_program_param);
+    app_free(app_context_param, APP_MEM_LINES, input_program_param, sizeof(*input_program_param));
 
     return e1;
 
@@ -294,4 +293,197 @@ Err print_lines(app_context* app_context_param, char** lines, size_t n){
 
 
 
+static Err build_line_index(app_context* app_context_param, mapped_program* mapped_prog){                                      // single forward pass over the mapping, memchr does the newline search.
+
+    size_t cap = 0;
+    size_t n = 0;
+    uint32_t *starts = NULL;
+    size_t pos = 0;
+
+    while(pos < mapped_prog->size){
+
+        if(n == cap){
+
+            size_t new_cap = (cap == 0)? 1024 : cap * 2;
+            uint32_t *p = app_alloc(app_context_param, APP_MEM_LINES, starts, cap * sizeof(*p), new_cap * sizeof(*p));
+
+            if(!p){
+
+                APP_PERROR(app_context_param, "LINE INDEX REALLOC FAILED");
+                app_free(app_context_param, APP_MEM_LINES, starts, cap * sizeof(*starts));
+                return ERR_OOM;
+
+            }
+
+            starts = p;
+            cap = new_cap;
+
+        }
+
+        starts[n++] = (uint32_t)pos;
+
+        const char *nl = memchr(mapped_prog->text + pos, '\n', mapped_prog->size - pos);
+        pos = nl ? (size_t)(nl - mapped_prog->text) + 1 : mapped_prog->size;
+
+    }
+
+    mapped_prog->line_start = starts;
+    mapped_prog->line_start_cap = cap;
+    mapped_prog->number_of_line = n;
+
+    return ERR_OK;
+
+}
+
+
+mapped_program* create_mapped_program(app_context* app_context_param, const char* input_file_path){
+
+    if(!input_file_path){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return NULL;
+
+    }
+
+    int fd = open(input_file_path, O_RDONLY);
+
+    if(fd < 0){
+
+        APP_PERROR(app_context_param, "FILE CAN NOT BE OPENED.");
+        return NULL;
+
+    }
+
+    struct stat st;
+
+    if(fstat(fd, &st) != 0){
+
+        APP_PERROR(app_context_param, "FSTAT FAILED");
+        close(fd);
+        return NULL;
+
+    }
+
+    if((uint64_t)st.st_size > UINT32_MAX){
+
+        APP_ERROR(app_context_param, "FILE IS TOO LARGE FOR 32-BIT LINE INDEX");
+        close(fd);
+        return NULL;
+
+    }
+
+    mapped_program* mapped_prog = app_alloc(app_context_param, APP_MEM_LINES, NULL, 0, sizeof(mapped_program));
+
+    if(!mapped_prog){
+
+        APP_PERROR(app_context_param, "MALLOC FAILED");
+        close(fd);
+        return NULL;
+
+    }
+
+    mapped_prog->text = NULL;
+    mapped_prog->size = (size_t)st.st_size;
+    mapped_prog->line_start = NULL;
+    mapped_prog->line_start_cap = 0;
+    mapped_prog->number_of_line = 0;
+
+    if(mapped_prog->size > 0){      // mmap() rejects zero length, an empty file simply has no line.
+
+        void *p = mmap(NULL, mapped_prog->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(p == MAP_FAILED){
+
+            APP_PERROR(app_context_param, "MMAP FAILED");
+            app_free(app_context_param, APP_MEM_LINES, mapped_prog, sizeof(*mapped_prog));
+            close(fd);
+            return NULL;
+
+        }
+
+        madvise(p, mapped_prog->size, MADV_SEQUENTIAL);
+        mapped_prog->text = p;
+
+    }
+
+    close(fd);     // the mapping stays valid after close.
+
+    if(build_line_index(app_context_param, mapped_prog) != ERR_OK){
+
+        if(mapped_prog->text) munmap((void *)mapped_prog->text, mapped_prog->size);
+        app_free(app_context_param, APP_MEM_LINES, mapped_prog, sizeof(*mapped_prog));
+        return NULL;
+
+    }
+
+    return mapped_prog;
+
+}
+
+
+Err destroy_mapped_program(app_context* app_context_param, mapped_program* mapped_program_param){
+
+    if(!mapped_program_param){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    Err e = ERR_OK;
+
+    if(mapped_program_param->text && munmap((void *)mapped_program_param->text, mapped_program_param->size) != 0){
+
+        APP_PERROR(app_context_param, "MUNMAP FAILED");
+        e = ERR_DEALLOC;
 
+    }
+
+    app_free(app_context_param, APP_MEM_LINES, mapped_program_param->line_start, sizeof(*mapped_program_param->line_start) * mapped_program_param->line_start_cap);
+    app_free(app_context_param, APP_MEM_LINES, mapped_program_param, sizeof(*mapped_program_param));
+
+    return e;
+
+}
+
+
+size_t mapped_program_line_count(const mapped_program* mapped_program_param){
+
+    return mapped_program_param ? mapped_program_param->number_of_line : 0;
+
+}
+
+
+const char* mapped_program_text(const mapped_program* mapped_program_param, size_t *out_size){
+
+    if(!mapped_program_param || !mapped_program_param->text){
+
+        if(out_size) *out_size = 0;
+        return "";
+
+    }
+
+    if(out_size) *out_size = mapped_program_param->size;
+
+    return mapped_program_param->text;
+
+}
+
+
+LineView mapped_program_line(const mapped_program* mapped_program_param, size_t index){
+
+    LineView view = {"", 0};
+
+    if(!mapped_program_param || index >= mapped_program_param->number_of_line) return view;
+
+    size_t start = mapped_program_param->line_start[index];
+    size_t end = (index + 1 < mapped_program_param->number_of_line) ? mapped_program_param->line_start[index + 1] : mapped_program_param->size;
+
+    if(end > start && mapped_program_param->text[end - 1] == '\n') end--;
+
+    view.text = mapped_program_param->text + start;
+    view.len = end - start;
+
+    return view;
+
+}
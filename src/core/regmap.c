@@ -2,61 +2,98 @@
 #include <string.h>
 
 
-typedef struct{
-
-    const char *name;
-    int correspond_reg_num;
-
-}reg_spec;
-
-
-static const reg_spec reg_table[] = {
-
-    {"$zero",  0},
-    {"$at",    1},
-    {"$v0",    2},
-    {"$v1",    3},
-    {"$a0",    4},
-    {"$a1",    5},
-    {"$a2",    6},
-    {"$a3",    7},
-    {"$t0",    8},
-    {"$t1",    9},
-   {"$t2",    10},
-   {"$t3",    11},
-   {"$t4",    12},
-   {"$t5",    13},
-   {"$t6",    14},
-   {"$t7",    15},
-   {"$s0",    16},
-   {"$s1",    17},
-   {"$s2",    18},
-   {"$s3",    19},
-   {"$s4",    20},
-   {"$s5",    21},
-   {"$s6",    22},
-   {"$s7",    23},
-   {"$t8",    24},
-   {"$t9",    25},
-   {"$k0",    26},
-   {"$k1",    27},
-   {"$gp",    28},
-   {"$sp",    29},
-   {"$fp",    30},
-   {"$ra",    31}
+static const char *const reg_names[REG_FILE_SIZE] = {
+
+    "$zero", "$at", "$v0", "$v1", "$a0", "$a1", "$a2", "$a3",
+    "$t0",   "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7",
+    "$s0",   "$s1", "$s2", "$s3", "$s4", "$s5", "$s6", "$s7",
+    "$t8",   "$t9", "$k0", "$k1", "$gp", "$sp", "$fp", "$ra"
 
 };
 
 
+#define REG_KEY(a, b) (((unsigned)(unsigned char)(a) << 8) | (unsigned)(unsigned char)(b))
+
+
+static int decode_reg_number(const char *s, size_t n){      // "8", "31": one or two digits, 0..31
+
+    if(n == 0 || n > 2) return -1;
+
+    unsigned d0 = (unsigned)(unsigned char)s[0] - '0';
+    if(d0 > 9) return -1;
+    if(n == 1) return (int)d0;
+
+    unsigned d1 = (unsigned)(unsigned char)s[1] - '0';
+    if(d1 > 9) return -1;
+
+    unsigned v = d0 * 10 + d1;
+    return (v < REG_FILE_SIZE) ? (int)v : -1;
+
+}
+
+
+int regmap_decode(const char *s, size_t n){
+
+    if(!s || n < 2 || s[0] != '$') return -1;
+
+    if((unsigned)(unsigned char)s[1] - '0' <= 9) return decode_reg_number(s + 1, n - 1);     // $8
+    if(s[1] == 'r' && n >= 3 && (unsigned)(unsigned char)s[2] - '0' <= 9) return decode_reg_number(s + 2, n - 2);    // $r8
+
+    if(n == 5) return (memcmp(s + 1, "zero", 4) == 0) ? 0 : -1;
+    if(n != 3) return -1;
+
+    switch(REG_KEY(s[1], s[2])){
+
+        case REG_KEY('a', 't'): return 1;
+        case REG_KEY('v', '0'): return 2;
+        case REG_KEY('v', '1'): return 3;
+        case REG_KEY('a', '0'): return 4;
+        case REG_KEY('a', '1'): return 5;
+        case REG_KEY('a', '2'): return 6;
+        case REG_KEY('a', '3'): return 7;
+        case REG_KEY('t', '0'): return 8;
+        case REG_KEY('t', '1'): return 9;
+        case REG_KEY('t', '2'): return 10;
+        case REG_KEY('t', '3'): return 11;
+        case REG_KEY('t', '4'): return 12;
+        case REG_KEY('t', '5'): return 13;
+        case REG_KEY('t', '6'): return 14;
+        case REG_KEY('t', '7'): return 15;
+        case REG_KEY('s', '0'): return 16;
+        case REG_KEY('s', '1'): return 17;
+        case REG_KEY('s', '2'): return 18;
+        case REG_KEY('s', '3'): return 19;
+        case REG_KEY('s', '4'): return 20;
+        case REG_KEY('s', '5'): return 21;
+        case REG_KEY('s', '6'): return 22;
+        case REG_KEY('s', '7'): return 23;
+        case REG_KEY('t', '8'): return 24;
+        case REG_KEY('t', '9'): return 25;
+        case REG_KEY('k', '0'): return 26;
+        case REG_KEY('k', '1'): return 27;
+        case REG_KEY('g', 'p'): return 28;
+        case REG_KEY('s', 'p'): return 29;
+        case REG_KEY('f', 'p'): return 30;
+        case REG_KEY('s', '8'): return 30;      // alias of $fp
+        case REG_KEY('r', 'a'): return 31;
+        default: return -1;
+
+    }
+
+}
+
+
 int regmap_lookup(const char *s){
 
     if(!s) return -1;
 
-    for(size_t i = 0; i < REG_FILE_SIZE; i++){
+    return regmap_decode(s, strlen(s));   // -1: invalid reg
+}
 
-        if(strcmp(s, reg_table[i].name) == 0) return reg_table[i].correspond_reg_num;
 
-    }
+const char *regmap_name(int reg){
+
+    if(reg < 0 || reg >= REG_FILE_SIZE) return NULL;
+    return reg_names[reg];
 
-    return -1;   //invalid reg
-}
\ No newline at end of file
+}
@@ -0,0 +1,117 @@
+#include "core/spsc.h"
+#include <sched.h>
+
+
+#define SPSC_SPINS 64       // polls before a waiting side yields its CPU
+
+
+Err spsc_init(SpscQueue *q, size_t capacity, app_context *app_context_param){
+
+    if(!q || capacity == 0){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    size_t cap = 2;
+    while(cap < capacity) cap *= 2;
+
+    q->slots = app_alloc(app_context_param, APP_MEM_OTHER, NULL, 0, sizeof(*q->slots) * cap);
+
+    if(!q->slots){
+
+        APP_PERROR(app_context_param, "SPSC QUEUE ALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    q->mask = cap - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->tail_cache = 0;
+    q->head_cache = 0;
+
+    return ERR_OK;
+
+}
+
+
+Err spsc_free(SpscQueue *q, app_context *app_context_param){
+
+    if(!q) return ERR_INVALID_ARGUMENT;
+
+    app_free(app_context_param, APP_MEM_OTHER, q->slots, sizeof(*q->slots) * (q->mask + 1));
+    q->slots = NULL;
+
+    return ERR_OK;
+
+}
+
+
+int spsc_try_push(SpscQueue *q, void *item){
+
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    if(tail - q->head_cache > q->mask){
+
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);      // the slot we reuse was read before head moved past it
+        if(tail - q->head_cache > q->mask) return 0;
+
+    }
+
+    q->slots[tail & q->mask] = item;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);              // publish the slot
+
+    return 1;
+
+}
+
+
+void *spsc_try_pop(SpscQueue *q){
+
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    if(head == q->tail_cache){
+
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if(head == q->tail_cache) return NULL;
+
+    }
+
+    void *item = q->slots[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);              // hand the slot back
+
+    return item;
+
+}
+
+
+int spsc_push(SpscQueue *q, void *item, const atomic_int *stop){
+
+    for(unsigned spins = 0; !spsc_try_push(q, item); spins++){
+
+        if(stop && atomic_load_explicit(stop, memory_order_acquire)) return 0;
+        if(spins >= SPSC_SPINS) sched_yield();
+
+    }
+
+    return 1;
+
+}
+
+
+void *spsc_pop(SpscQueue *q, const atomic_int *stop){
+
+    void *item;
+
+    for(unsigned spins = 0; !(item = spsc_try_pop(q)); spins++){
+
+        if(stop && atomic_load_explicit(stop, memory_order_acquire)) return NULL;
+        if(spins >= SPSC_SPINS) sched_yield();
+
+    }
+
+    return item;
+
+}
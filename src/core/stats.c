@@ -0,0 +1,106 @@
+#include "core/stats.h"
+#include <stdatomic.h>
+#include <string.h>
+
+
+#if MIPS_ASM_STATS
+
+_Thread_local uint64_t asm_stats_alloc_count;
+
+static _Atomic uint64_t clock_cost = UINT64_MAX;
+
+
+uint64_t asm_stats_clock_cost(void){
+
+    uint64_t cost = atomic_load_explicit(&clock_cost, memory_order_relaxed);
+    if(cost != UINT64_MAX) return cost;
+
+    // the cheapest of a few back to back reads: what a timed stage pays for its own clock. racing threads store the same kind of value
+
+    cost = UINT64_MAX;
+
+    for(int i = 0; i < 32; i++){
+
+        uint64_t t0 = asm_stats_clock();
+        uint64_t t1 = asm_stats_clock();
+        if(t1 - t0 < cost) cost = t1 - t0;
+
+    }
+
+    atomic_store_explicit(&clock_cost, cost, memory_order_relaxed);
+    return cost;
+
+}
+
+#endif
+
+
+static const char *const stage_names[ASM_STAGE_COUNT] = {"read", "preprocess", "lex", "parse", "symtab", "ir"};
+
+
+void asm_stats_reset(AsmStats *stats){
+
+    if(stats) memset(stats, 0, sizeof(*stats));
+
+}
+
+
+void asm_stats_merge(AsmStats *into, const AsmStats *from){
+
+    if(!into || !from) return;
+
+    for(int i = 0; i < ASM_STAGE_COUNT; i++){
+
+        into->stage[i].calls += from->stage[i].calls;
+        into->stage[i].bytes += from->stage[i].bytes;
+        into->stage[i].allocs += from->stage[i].allocs;
+        into->stage[i].sampled_calls += from->stage[i].sampled_calls;
+        into->stage[i].sampled_ns += from->stage[i].sampled_ns;
+
+    }
+
+}
+
+
+void asm_stats_add(AsmStats *stats, AsmStage stage, uint64_t calls, uint64_t bytes, uint64_t ns){
+
+    if(!stats || stage >= ASM_STAGE_COUNT) return;
+
+    AsmStageStats *s = &stats->stage[stage];
+    s->calls += calls;
+    s->bytes += bytes;
+    s->sampled_calls += calls;
+    s->sampled_ns += ns;
+
+}
+
+
+const char *asm_stage_name(AsmStage stage){
+
+    return (stage < ASM_STAGE_COUNT) ? stage_names[stage] : "?";
+
+}
+
+
+Err asm_stats_print(const AsmStats *stats, FILE *out, app_context *app_context_param){
+
+    if(!stats || !out){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    for(int i = 0; i < ASM_STAGE_COUNT; i++){
+
+        const AsmStageStats *s = &stats->stage[i];
+        double ms = (double)asm_stage_ns(stats, (AsmStage)i) * 1e-6;
+
+        fprintf(out, "%-10s calls %10llu  bytes %12llu  allocs %8llu  time %10.3f ms\n", stage_names[i],
+                (unsigned long long)s->calls, (unsigned long long)s->bytes, (unsigned long long)s->allocs, ms);
+
+    }
+
+    return ERR_OK;
+
+}
@@ -0,0 +1,230 @@
+#include "core/strpool.h"
+#include "core/error_handling.h"
+#include "core/hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+Err strpool_init(StrPool *pool, app_context *app_context_param){
+
+    if(!pool){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    pool->v = NULL;
+    pool->n = pool->cap = 0;
+    pool->slots = NULL;
+    pool->slot_cap = 0;
+    pool->arena = NULL;
+
+    Err e = arena_init(&pool->bytes, 0, app_context_param);
+    pool->bytes.tag = APP_MEM_STRPOOL;
+
+    return e;
+
+}
+
+
+Err strpool_init_arena(StrPool *pool, Arena *arena, app_context *app_context_param){
+
+    if(!arena) return strpool_init(pool, app_context_param);
+
+    if(!pool){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->arena = arena;
+
+    return ERR_OK;
+
+}
+
+
+Err strpool_free(StrPool *pool, app_context *app_context_param){
+
+    if(!pool) return ERR_INVALID_ARGUMENT;
+
+    if(!pool->arena){
+
+        app_free(app_context_param, APP_MEM_STRPOOL, pool->v, sizeof(*pool->v) * pool->cap);
+        app_free(app_context_param, APP_MEM_STRPOOL, pool->slots, sizeof(*pool->slots) * pool->slot_cap);
+        arena_free(&pool->bytes, app_context_param);
+
+    }
+
+    pool->v = NULL;
+    pool->n = pool->cap = 0;
+    pool->slots = NULL;
+    pool->slot_cap = 0;
+
+    return ERR_OK;
+
+}
+
+
+static StrId strpool_find_hashed(const StrPool *pool, const char *s, size_t len, uint32_t hash){
+
+    if(pool->slot_cap == 0) return STRID_NONE;
+
+    size_t mask = pool->slot_cap - 1;
+    size_t pos = hash & mask;
+
+    for(size_t dist = 0; ; dist++, pos = (pos + 1) & mask){
+
+        const StrSlot *slot = &pool->slots[pos];
+
+        if(slot->id == STRID_NONE) return STRID_NONE;
+        if(((pos - (slot->hash & mask)) & mask) < dist) return STRID_NONE;      // Robin Hood: s would have been placed before this slot
+
+        const StrEntry *e = &pool->v[slot->id];
+        if(slot->hash == hash && e->len == len && memcmp(e->s, s, len) == 0) return slot->id;
+
+    }
+
+}
+
+
+StrId strpool_find(const StrPool *pool, const char *s, size_t len){
+
+    if(!pool || !s) return STRID_NONE;
+
+    return strpool_find_hashed(pool, s, len, hash_bytes(s, len));
+
+}
+
+
+static void strpool_index_insert(StrSlot *slots, size_t slot_cap, StrSlot entry){
+
+    size_t mask = slot_cap - 1;
+    size_t pos = entry.hash & mask;
+
+    for(size_t dist = 0; ; dist++, pos = (pos + 1) & mask){
+
+        if(slots[pos].id == STRID_NONE){
+
+            slots[pos] = entry;
+            return;
+
+        }
+
+        size_t resident_dist = (pos - (slots[pos].hash & mask)) & mask;
+
+        if(resident_dist < dist){       // take the slot from the richer entry and carry it on
+
+            StrSlot tmp = slots[pos];
+            slots[pos] = entry;
+            entry = tmp;
+            dist = resident_dist;
+
+        }
+
+    }
+
+}
+
+
+static Err strpool_rehash(StrPool *pool, app_context *app_context_param){
+
+    size_t new_cap = (pool->slot_cap == 0)? 128 : pool->slot_cap * 2;
+
+    StrSlot *slots = pool->arena ? arena_alloc(pool->arena, sizeof(*slots) * new_cap, app_context_param)
+                                 : app_alloc(app_context_param, APP_MEM_STRPOOL, NULL, 0, sizeof(*slots) * new_cap);
+
+    if(!slots){
+
+        APP_PERROR(app_context_param, "STRING POOL INDEX ALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    memset(slots, 0, sizeof(*slots) * new_cap);
+
+    for(size_t id = 1; id < pool->n; id++) strpool_index_insert(slots, new_cap, (StrSlot){pool->v[id].hash, (StrId)id});
+
+    if(!pool->arena) app_free(app_context_param, APP_MEM_STRPOOL, pool->slots, sizeof(*pool->slots) * pool->slot_cap);     // an arena keeps the old index until it is freed
+
+    pool->slots = slots;
+    pool->slot_cap = new_cap;
+
+    return ERR_OK;
+
+}
+
+
+static Err strpool_grow(StrPool *pool, app_context *app_context_param){
+
+    size_t new_cap = (pool->cap == 0)? 64 : pool->cap * 2;
+
+    StrEntry *p = pool->arena ? arena_realloc(pool->arena, pool->v, sizeof(*p) * pool->cap, sizeof(*p) * new_cap, app_context_param)
+                              : app_alloc(app_context_param, APP_MEM_STRPOOL, pool->v, sizeof(*p) * pool->cap, sizeof(*p) * new_cap);
+
+    if(!p){
+
+        APP_PERROR(app_context_param, "STRING POOL REALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    if(pool->cap == 0) memset(&p[0], 0, sizeof(p[0]));        // id 0 is STRID_NONE
+
+    pool->v = p;
+    pool->cap = new_cap;
+
+    if(pool->n == 0) pool->n = 1;
+
+    return ERR_OK;
+
+}
+
+
+Err strpool_intern(StrPool *pool, const char *s, size_t len, StrId *out_id, app_context *app_context_param){
+
+    if(!pool || !s || !out_id){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    if(len > UINT32_MAX || pool->n >= UINT32_MAX){
+
+        APP_ERROR(app_context_param, "STRING POOL FULL.");
+        return ERR_OOM;
+
+    }
+
+    uint32_t hash = hash_bytes(s, len);
+    StrId id = strpool_find_hashed(pool, s, len, hash);
+
+    if(id != STRID_NONE){
+
+        *out_id = id;
+        return ERR_OK;
+
+    }
+
+    Err e;
+
+    if(pool->n + 1 > pool->cap && (e = strpool_grow(pool, app_context_param)) != ERR_OK) return e;
+
+    if(pool->n * 4 > pool->slot_cap * 3 && (e = strpool_rehash(pool, app_context_param)) != ERR_OK) return e;     // keep the index at most 3/4 full
+
+    char *copy = arena_strndup(pool->arena ? pool->arena : &pool->bytes, s, len, app_context_param);
+    if(!copy) return ERR_OOM;
+
+    id = (StrId)pool->n++;
+    pool->v[id] = (StrEntry){copy, (uint32_t)len, hash};
+    strpool_index_insert(pool->slots, pool->slot_cap, (StrSlot){hash, id});
+
+    *out_id = id;
+
+    return ERR_OK;
+
+}
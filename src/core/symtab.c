@@ -14,36 +14,74 @@ Err symtab_init(Symtab *st, app_context *app_context_param){
 
     st->v = NULL;
     st->n = st->cap = 0;
+    st->arena = NULL;
+    st->by_id = NULL;
+    st->by_id_cap = 0;
 
-    return ERR_OK;
+    return strpool_init(&st->names, app_context_param);
+
+}
+
+
+Err symtab_init_arena(Symtab *st, Arena *arena, app_context *app_context_param){
+
+    if(!arena) return symtab_init(st, app_context_param);
+
+    if(!st){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    st->v = NULL;
+    st->n = st->cap = 0;
+    st->arena = arena;
+    st->by_id = NULL;
+    st->by_id_cap = 0;
+
+    return strpool_init_arena(&st->names, arena, app_context_param);
 
 }
 
 
 Err symtab_free(Symtab *st, app_context *app_context_param){
 
-    (void)app_context_param;
     if(!st) return ERR_INVALID_ARGUMENT;
-    free(st->v);
+
+    if(!st->arena){
+
+        app_free(app_context_param, APP_MEM_SYMTAB, st->v, sizeof(*st->v) * st->cap);
+        app_free(app_context_param, APP_MEM_SYMTAB, st->by_id, sizeof(*st->by_id) * st->by_id_cap);
+
+    }
+
+    strpool_free(&st->names, app_context_param);
+
     st->v = NULL;
     st->n = st->cap = 0;
+    st->by_id = NULL;
+    st->by_id_cap = 0;
     
     return ERR_OK;
 
 }
 
 
-int symtab_find(Symtab *st, const char *name){
+int symtab_find_id(const Symtab *st, StrId name){
 
-    if(!st || !name) return -1;
+    if(!st || name == STRID_NONE || name >= st->by_id_cap) return -1;
 
-    for(size_t i = 0; i < st->n; i++){
+    return (int)st->by_id[name] - 1;
 
-        if(strcmp(st->v[i].name, name) == 0) return (int)i;
+}
 
-    }
 
-    return -1;
+int symtab_find(Symtab *st, const char *name){
+
+    if(!st || !name) return -1;
+
+    return symtab_find_id(st, strpool_find(&st->names, name, strlen(name)));
 
 }
 
@@ -51,7 +89,8 @@ static Err symtab_grow(Symtab *st, app_context *app_context_param){
 
     size_t new_cap = (st->cap == 0)? 64 : st->cap * 2;
     
-    Symbol *p = realloc(st->v, sizeof(*p) * new_cap);
+    Symbol *p = st->arena ? arena_realloc(st->arena, st->v, sizeof(*p) * st->cap, sizeof(*p) * new_cap, app_context_param)
+                          : app_alloc(app_context_param, APP_MEM_SYMTAB, st->v, sizeof(*p) * st->cap, sizeof(*p) * new_cap);
 
     if(!p){
 
@@ -67,34 +106,90 @@ static Err symtab_grow(Symtab *st, app_context *app_context_param){
 
 }
 
-Err symtab_add(Symtab *st, const char *name, uint32_t addr, app_context *app_context_param){
+static Err symtab_grow_by_id(Symtab *st, StrId name, app_context *app_context_param){      // by_id follows the id range of the pool
 
-    if(!st || !name) {
+    size_t new_cap = (st->by_id_cap == 0)? 64 : st->by_id_cap;
+    while(new_cap <= name) new_cap *= 2;
+
+    uint32_t *p = st->arena ? arena_realloc(st->arena, st->by_id, sizeof(*p) * st->by_id_cap, sizeof(*p) * new_cap, app_context_param)
+                            : app_alloc(app_context_param, APP_MEM_SYMTAB, st->by_id, sizeof(*p) * st->by_id_cap, sizeof(*p) * new_cap);
+
+    if(!p){
+
+        APP_PERROR(app_context_param, "SYMBOL TABLE REALLOC FAILED.");
+        return ERR_OOM;
+
+    }
+
+    memset(p + st->by_id_cap, 0, sizeof(*p) * (new_cap - st->by_id_cap));
+
+    st->by_id = p;
+    st->by_id_cap = new_cap;
+
+    return ERR_OK;
+
+}
+
+Err symtab_add_id(Symtab *st, StrId name, uint32_t addr, app_context *app_context_param){
+
+    if(!st || name == STRID_NONE || name >= st->names.n) {
 
         APP_ERROR(app_context_param, "INVALID ARGUMENT");
         return ERR_INVALID_ARGUMENT;
 
     }
 
-    if(symtab_find(st, name) >= 0){
+    if(symtab_find_id(st, name) >= 0){
 
         APP_ERROR(app_context_param, "DUPLICATE LABEL IN SYMBOL TABLE.");
         return ERR_SYNTAX;
 
     }
 
-    if(st->n == st->cap){
+    Err e;
+
+    if(st->n == st->cap && (e = symtab_grow(st, app_context_param)) != ERR_OK) return e;
+    if(name >= st->by_id_cap && (e = symtab_grow_by_id(st, name, app_context_param)) != ERR_OK) return e;
 
-        Err e = symtab_grow(st, app_context_param);
-        if(e != ERR_OK) return e;
+    st->v[st->n] = (Symbol){name, addr};
+    st->by_id[name] = (uint32_t)(st->n + 1);
+    st->n++;
+
+    return ERR_OK;
+
+}
+
+Err symtab_add(Symtab *st, const char *name, uint32_t addr, app_context *app_context_param){
+
+    if(!st || !name) {
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
 
     }
 
-    strncpy(st->v[st->n].name, name, sizeof(st->v[st->n].name) - 1);
+    StrId id;
+    Err e = strpool_intern(&st->names, name, strlen(name), &id, app_context_param);
+    if(e != ERR_OK) return e;
 
-    st->v[st->n].name[sizeof(st->v[st->n].name) - 1] = '\0';
-    st->v[st->n].addr = addr;
-    st->n++;
+    return symtab_add_id(st, id, addr, app_context_param);
+
+}
+
+Err symtab_lookup_id(const Symtab *st, StrId name, uint32_t *out_addr, app_context *app_context_param){
+
+    if(!st || !out_addr){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    int index = symtab_find_id(st, name);
+
+    if(index < 0) return ERR_UNDEF_LABEL;
+
+    *out_addr = st->v[index].addr;
 
     return ERR_OK;
 
@@ -109,12 +204,17 @@ Err symtab_lookup(Symtab *st, const char *name, uint32_t *out_addr, app_context
 
     }
 
-    int index = symtab_find(st, name);
+    return symtab_lookup_id(st, strpool_find(&st->names, name, strlen(name)), out_addr, app_context_param);
 
-    if(index < 0) return ERR_UNDEF_LABEL;
+}
 
-    *out_addr = st->v[index].addr;
 
-    return ERR_OK;
+void symtab_truncate(Symtab *st, size_t n){
+
+    if(!st) return;
+
+    for(size_t i = n; i < st->n; i++) st->by_id[st->v[i].name] = 0;
+
+    if(n < st->n) st->n = n;
 
 }
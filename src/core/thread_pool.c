@@ -0,0 +1,192 @@
+#include "core/thread_pool.h"
+#include "core/error_handling.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+struct thread_pool_t{
+
+    pthread_t *threads;
+    unsigned n_threads;
+    unsigned cap_threads;           // allocated, n_threads drops when a thread fails to start
+
+    pthread_mutex_t run_lock;       // serializes thread_pool_run callers
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;         // generation changed or stop
+    pthread_cond_t done_cv;         // busy reached 0
+
+    thread_pool_fn fn;
+    void *arg;
+    size_t n_tasks;
+    atomic_size_t next_task;
+
+    uint64_t generation;            // one per run, workers wake up when it changes
+    unsigned busy;                  // workers still inside the current run
+    int stop;
+
+};
+
+
+static void run_tasks(thread_pool *pool){
+
+    for(;;){
+
+        size_t i = atomic_fetch_add_explicit(&pool->next_task, 1, memory_order_relaxed);
+        if(i >= pool->n_tasks) return;
+
+        pool->fn(pool->arg, i);
+
+    }
+
+}
+
+
+static void *worker_main(void *param){
+
+    thread_pool *pool = param;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for(;;){
+
+        while(!pool->stop && pool->generation == seen) pthread_cond_wait(&pool->work_cv, &pool->lock);
+        if(pool->stop) break;
+
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tasks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if(--pool->busy == 0) pthread_cond_broadcast(&pool->done_cv);
+
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+
+}
+
+
+thread_pool *create_thread_pool(app_context *app_context_param, unsigned n_threads){
+
+    if(n_threads == 0){
+
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = (online > 0) ? (unsigned)online : 1;
+
+    }
+
+    thread_pool *pool = app_alloc(app_context_param, APP_MEM_OTHER, NULL, 0, sizeof(*pool));
+
+    if(!pool){
+
+        APP_PERROR(app_context_param, "THREAD POOL: ALLOCATION FAILED");
+        return NULL;
+
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->n_threads = pool->cap_threads = n_threads - 1;        // the thread calling thread_pool_run() is the last worker
+
+    if(pool->n_threads && !(pool->threads = app_alloc(app_context_param, APP_MEM_OTHER, NULL, 0, sizeof(*pool->threads) * pool->cap_threads))){
+
+        APP_PERROR(app_context_param, "THREAD POOL: ALLOCATION FAILED");
+        app_free(app_context_param, APP_MEM_OTHER, pool, sizeof(*pool));
+        return NULL;
+
+    }
+
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cv, NULL);
+    pthread_cond_init(&pool->done_cv, NULL);
+
+    for(unsigned i = 0; i < pool->n_threads; i++){
+
+        if(pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0){
+
+            APP_ERROR(app_context_param, "THREAD POOL: PTHREAD_CREATE FAILED");
+            pool->n_threads = i;            // destroy joins the ones already running
+            destroy_thread_pool(app_context_param, pool);
+            return NULL;
+
+        }
+
+    }
+
+    return pool;
+
+}
+
+
+Err destroy_thread_pool(app_context *app_context_param, thread_pool *pool){
+
+    if(!pool){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(unsigned i = 0; i < pool->n_threads; i++) pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->done_cv);
+    pthread_cond_destroy(&pool->work_cv);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+
+    app_free(app_context_param, APP_MEM_OTHER, pool->threads, sizeof(*pool->threads) * pool->cap_threads);
+    app_free(app_context_param, APP_MEM_OTHER, pool, sizeof(*pool));
+
+    return ERR_OK;
+
+}
+
+
+unsigned thread_pool_size(const thread_pool *pool){
+
+    return pool ? pool->n_threads + 1 : 1;
+
+}
+
+
+Err thread_pool_run(thread_pool *pool, size_t n_tasks, thread_pool_fn fn, void *arg){
+
+    if(!pool || !fn) return ERR_INVALID_ARGUMENT;
+    if(n_tasks == 0) return ERR_OK;
+
+    pthread_mutex_lock(&pool->run_lock);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->n_tasks = n_tasks;
+    atomic_store_explicit(&pool->next_task, 0, memory_order_relaxed);
+    pool->busy = pool->n_threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->busy > 0) pthread_cond_wait(&pool->done_cv, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->run_lock);
+
+    return ERR_OK;
+
+}
@@ -1,5 +1,6 @@
 #include "front/parser.h"
 #include "core/error_handling.h"
+#include "core/diag.h"
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
@@ -7,57 +8,71 @@
 #include <errno.h>
 #include <stdint.h>
 #include "front/lexer.h"
+#include "front/scanner.h"
 #include "core/ir.h"
 #include "core/regmap.h"
 #include "core/isa_mips.h"
 
 
 
-static void report_syntax(app_context *app_context_param, int line_no, int column_no, const char *message, const char *source_line){
+static _Thread_local DiagList *g_parser_diag;
 
-    (void)app_context_param;
 
-    fprintf(stderr, "Syntax error at line %d, col %d: %s\n", line_no, column_no, message);
+DiagList *parser_set_diagnostics(DiagList *diag){
 
-    if(source_line){
+    DiagList *prev = g_parser_diag;
+    g_parser_diag = diag;
 
-        fprintf(stderr, " %s\n", source_line);
-        fprintf(stderr, " ");
+    return prev;
 
-        for(int i = 0; i < column_no; i++) fputc(' ', stderr);
-        fprintf(stderr, "^\n");
+}
 
-    }
 
-}
+static void report_syntax(app_context *app_context_param, int line_no, int column_no, const char *message, const TokenVec *tv){
+
+    const char *src = (tv && tv->src) ? tv->src : NULL;
+    size_t src_len = src ? tv->src_len : 0;
 
+    if(g_parser_diag){
+
+        diag_add(g_parser_diag, (uint32_t)line_no, (uint32_t)column_no, ERR_SYNTAX, message, src, src_len, app_context_param);
+        return;
+
+    }
 
-static int parse_reg_name(const char *lex){
+    // no list: the diagnostic is formatted first and goes to the context (stderr without one) in a single write
 
-    if(!lex || lex[0] != '$') return -1;
+    char buf[512];
+    size_t n = diag_format(buf, sizeof(buf), (uint32_t)line_no, (uint32_t)column_no, message, src, src_len);
 
-    if(isdigit((unsigned char)lex[1])){
+    if(n < sizeof(buf)){
 
-        char *end = NULL;
-        long v = strtol(lex + 1, &end, 10);
-        if(end && *end == '\0' && v >= 0 && v <= 31) return (int)v;
-        return -1;
+        app_log_text(app_context_param, buf, n);
+        return;
 
     }
 
-    return regmap_lookup(lex);
+    char *long_buf = app_alloc(app_context_param, APP_MEM_DIAG, NULL, 0, n + 1);
+
+    if(long_buf){
+
+        diag_format(long_buf, n + 1, (uint32_t)line_no, (uint32_t)column_no, message, src, src_len);
+        app_log_text(app_context_param, long_buf, n);
+        app_free(app_context_param, APP_MEM_DIAG, long_buf, n + 1);
+
+    }
+    else app_log_text(app_context_param, buf, sizeof(buf) - 1);
 
 }
 
-static Err parse_int32(const char *lex, int32_t *out){
+
+static Err parse_int32(const char *lex, size_t n, int32_t *out){
 
     if(!lex || !out) return ERR_INVALID_ARGUMENT;
 
-    errno = 0;
-    char *end = NULL;
-    long v = strtol(lex, &end, 0);
+    long v = 0;
 
-    if(!end || *end != '\0' || errno != 0) return ERR_SYNTAX;
+    if(!scan_int_literal(lex, n, &v)) return ERR_SYNTAX;
     if(v < INT32_MIN || v > INT32_MAX) return ERR_SYNTAX;     // overflow
 
     *out = (int32_t)v;
@@ -66,16 +81,15 @@ static Err parse_int32(const char *lex, int32_t *out){
 }
 
 
-static char *dup_cstr(app_context *app_context_param, const char *s){
+// .word values come from the arena when the caller gave one, nothing to free then.
 
-    char *p = strdup(s);
-    if(!p) APP_PERROR(app_context_param, "STRDUP FAILED.");
-    return p;
+static void release_values(app_context *app_context_param, Arena *arena, int32_t *values, size_t cap){
 
-}
+    if(!arena) app_free(app_context_param, APP_MEM_WORDS, values, sizeof(*values) * cap);
 
+}
 
-static Err parse_operand(app_context *app_context_param, const TokenVec *tv, size_t *pos, Operand *out_operand, const char *source_line){
+static Err parse_operand(app_context *app_context_param, StrPool *pool, const TokenVec *tv, size_t *pos, Operand *out_operand){
 
     if(!tv || !pos || !out_operand) return ERR_INVALID_ARGUMENT;
 
@@ -91,20 +105,20 @@ static Err parse_operand(app_context *app_context_param, const TokenVec *tv, siz
         if(*pos + 3 < tv->n && tv->v[*pos + 1].kind == TOK_LPAREN && tv->v[*pos + 2].kind == TOK_REG && tv->v[*pos + 3].kind == TOK_RPAREN){
 
             int32_t off = 0;
-            Err e = parse_int32(t->lexeme, &off);
+            Err e = parse_int32(tok_text(tv, t), t->len, &off);
             
             if(e != ERR_OK){
 
-                report_syntax(app_context_param, t->line_no, t->column_no, "INVALID OFFSET IMMEDIATE", source_line);
+                report_syntax(app_context_param, t->line_no, tok_column(t), "INVALID OFFSET IMMEDIATE", tv);
                 return ERR_SYNTAX;
 
             }
 
-            int base = parse_reg_name(tv->v[*pos + 2].lexeme);
+            int base = regmap_decode(tok_text(tv, &tv->v[*pos + 2]), tv->v[*pos + 2].len);
 
             if(base < 0) {
 
-                report_syntax(app_context_param, tv->v[*pos + 2].line_no, tv->v[*pos + 2].column_no, "INVALID BASE REGISTER", source_line);
+                report_syntax(app_context_param, tv->v[*pos + 2].line_no, tok_column(&tv->v[*pos + 2]), "INVALID BASE REGISTER", tv);
                 return ERR_SYNTAX;
 
             }
@@ -121,11 +135,11 @@ static Err parse_operand(app_context *app_context_param, const TokenVec *tv, siz
         //otherwise this is an immediate
 
         int32_t imm = 0;
-        Err e = parse_int32(t->lexeme, &imm);
+        Err e = parse_int32(tok_text(tv, t), t->len, &imm);
 
         if(e != ERR_OK){
 
-            report_syntax(app_context_param, t->line_no, t->column_no, "INVALID IMMEDIATE", source_line);
+            report_syntax(app_context_param, t->line_no, tok_column(t), "INVALID IMMEDIATE", tv);
             return ERR_SYNTAX;
 
         }
@@ -141,11 +155,11 @@ static Err parse_operand(app_context *app_context_param, const TokenVec *tv, siz
 
     if(t->kind == TOK_REG){
 
-        int r = parse_reg_name(t->lexeme);
+        int r = regmap_decode(tok_text(tv, t), t->len);
 
         if(r < 0){
 
-            report_syntax(app_context_param, t->line_no, t->column_no, "INVALID REGISTER NAME", source_line);
+            report_syntax(app_context_param, t->line_no, tok_column(t), "INVALID REGISTER NAME", tv);
             return ERR_SYNTAX;
 
         }
@@ -163,9 +177,10 @@ static Err parse_operand(app_context *app_context_param, const TokenVec *tv, siz
 
         // label reference
 
-        char *name = dup_cstr(app_context_param, t->lexeme);
-        
-        if(!name) return ERR_OOM;
+        StrId name;
+        Err e = strpool_intern(pool, tok_text(tv, t), t->len, &name, app_context_param);
+
+        if(e != ERR_OK) return e;
 
         out_operand->kind = OP_LABEL;
         out_operand->v.label = name;
@@ -174,26 +189,22 @@ static Err parse_operand(app_context *app_context_param, const TokenVec *tv, siz
         return ERR_OK;
     }
 
-    report_syntax(app_context_param, t->line_no, t->column_no, "UNEXPECTED TOKEN IN OPERAND", source_line);
+    report_syntax(app_context_param, t->line_no, tok_column(t), "UNEXPECTED TOKEN IN OPERAND", tv);
     
     return ERR_SYNTAX;
 
 
 }
 
-static int tok_is_dot(const Token *t, const char *s){
+static int tok_is_dot(const TokenVec *tv, const Token *t, const char *s){
 
-    return t && t->kind == TOK_DOT && strcmp(t->lexeme, s) == 0;
+    return t && t->kind == TOK_DOT && tok_eq(tv, t, s);
 
 }
 
-Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *source_line, int line_no, int *out_has_label, Statement *out_statement){
-
-    if(!tv || !out_statement || !out_has_label) return ERR_INVALID_ARGUMENT;
-
-    fprintf(stderr, "DEBUG: parse_line called, tv->n=%zu, line=%d\n", tv->n, line_no);
-    fflush(stderr);
+Err parse_line(app_context *app_context_param, Arena *arena, StrPool *pool, const TokenVec *tv, int line_no, int *out_has_label, Statement *out_statement){
 
+    if(!pool || !tv || !out_statement || !out_has_label) return ERR_INVALID_ARGUMENT;
 
     *out_has_label = 0;
 
@@ -203,39 +214,39 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
     size_t pos = 0;
 
     int has_label_prefix = 0;
-    char label_name[64] = {0};
+    StrId label_name = STRID_NONE;
 
     if(tv->n >= 2 && tv->v[0].kind == TOK_IDENT && tv->v[1].kind == TOK_COLON){
 
         has_label_prefix = 1;
-        strncpy(label_name, tv->v[0].lexeme, sizeof(label_name) - 1);
-        label_name[sizeof(label_name) - 1] = '\0';
         pos = 2;
 
         if(pos < tv->n && tv->v[pos].kind == TOK_COLON){
 
-            report_syntax(app_context_param, line_no, (int)tv->v[pos].column_no, "double colon is invalid.", source_line);
+            report_syntax(app_context_param, line_no, tok_column(&tv->v[pos]), "double colon is invalid.", tv);
             return ERR_SYNTAX;
 
         }
 
 
+        if(pos < tv->n && tv->v[pos].kind != TOK_IDENT && tv->v[pos].kind != TOK_DOT){
+
+            report_syntax(app_context_param, line_no, tok_column(&tv->v[pos]), "expected instruction or .word after label.", tv);
+            return ERR_SYNTAX;
+        }
+
+        Err e = strpool_intern(pool, tok_text(tv, &tv->v[0]), tv->v[0].len, &label_name, app_context_param);
+        if(e != ERR_OK) return e;
+
         if(pos >= tv->n){
 
             *out_has_label = 1;
             out_statement->kind = ST_LABEL;
-            strncpy(out_statement->as.label.name, label_name, sizeof(out_statement->as.label.name) - 1);
-            out_statement->as.label.name[sizeof(out_statement->as.label.name) - 1] = '\0';
+            out_statement->as.label.name = label_name;
             return ERR_OK;
 
         }
 
-        if(tv->v[pos].kind != TOK_IDENT && tv->v[pos].kind != TOK_DOT){
-
-            report_syntax(app_context_param, line_no, (int)tv->v[pos].column_no, "expected instruction or .word after label.", source_line);
-            return ERR_SYNTAX;
-        }
-
 
     }
 
@@ -243,11 +254,11 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
     if(pos < tv->n && tv->v[pos].kind == TOK_DOT){
 
-        if(tok_is_dot(&tv->v[pos], ".text")){
+        if(tok_is_dot(tv, &tv->v[pos], ".text")){
 
             if(has_label_prefix){
 
-                report_syntax(app_context_param, line_no, (int)tv->v[pos].column_no, "label prefix allowed only for instruction or .word", source_line);
+                report_syntax(app_context_param, line_no, tok_column(&tv->v[pos]), "label prefix allowed only for instruction or .word", tv);
                 return ERR_SYNTAX;
 
             }
@@ -257,11 +268,11 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
         }
 
-        if(tok_is_dot(&tv->v[pos], ".data")){
+        if(tok_is_dot(tv, &tv->v[pos], ".data")){
 
             if(has_label_prefix){
 
-                report_syntax(app_context_param, line_no, (int)tv->v[pos].column_no, "label prefix allowed only for instruction or .word", source_line);
+                report_syntax(app_context_param, line_no, tok_column(&tv->v[pos]), "label prefix allowed only for instruction or .word", tv);
                 return ERR_SYNTAX;
 
             }
@@ -271,13 +282,13 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
         }
 
-        if(tok_is_dot(&tv->v[pos], ".word")){
+        if(tok_is_dot(tv, &tv->v[pos], ".word")){
 
             pos++;
 
             if(pos >= tv->n || tv->v[pos].kind != TOK_INT){
 
-                report_syntax(app_context_param, line_no, (pos < tv->n ? tv->v[pos].column_no : 1), ".word expects at least one integer", source_line);
+                report_syntax(app_context_param, line_no, (pos < tv->n ? tok_column(&tv->v[pos]) : 1), ".word expects at least one integer", tv);
                 return ERR_SYNTAX;
 
             }
@@ -285,7 +296,8 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
             size_t cap = 8;
             size_t n = 0;
 
-            int32_t *values = malloc(sizeof(*values) * cap);
+            int32_t *values = arena ? arena_alloc(arena, sizeof(*values) * cap, app_context_param)
+                                    : app_alloc(app_context_param, APP_MEM_WORDS, NULL, 0, sizeof(*values) * cap);
 
             if(!values){
 
@@ -298,18 +310,18 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
                 if(tv->v[pos].kind != TOK_INT){
 
-                    report_syntax(app_context_param, tv->v[pos].line_no, tv->v[pos].column_no, ".word expects an integer", source_line);
-                    free(values);
+                    report_syntax(app_context_param, tv->v[pos].line_no, tok_column(&tv->v[pos]), ".word expects an integer", tv);
+                    release_values(app_context_param, arena, values, cap);
                     return ERR_SYNTAX;
 
                 }
 
 
                 int32_t value = 0;
-                if(parse_int32(tv->v[pos].lexeme, &value) != ERR_OK){
+                if(parse_int32(tok_text(tv, &tv->v[pos]), tv->v[pos].len, &value) != ERR_OK){
 
-                    report_syntax(app_context_param, tv->v[pos].line_no, tv->v[pos].column_no, "invalid .word integer", source_line);
-                    free(values);
+                    report_syntax(app_context_param, tv->v[pos].line_no, tok_column(&tv->v[pos]), "invalid .word integer", tv);
+                    release_values(app_context_param, arena, values, cap);
                     return ERR_SYNTAX;
 
                 }
@@ -317,12 +329,13 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
                 if(n == cap){
 
                     cap*=2;
-                    int32_t *p = realloc(values, sizeof(*p) * cap);
+                    int32_t *p = arena ? arena_realloc(arena, values, sizeof(*p) * n, sizeof(*p) * cap, app_context_param)
+                                       : app_alloc(app_context_param, APP_MEM_WORDS, values, sizeof(*p) * n, sizeof(*p) * cap);
 
                     if(!p){
 
                         APP_PERROR(app_context_param, "REALLOC FAILED");
-                        free(values);
+                        release_values(app_context_param, arena, values, n);
                         return ERR_OOM;
 
                     }
@@ -338,8 +351,8 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
                     if(tv->v[pos].kind != TOK_COMMA){
 
-                        report_syntax(app_context_param, tv->v[pos].line_no, tv->v[pos].column_no, "expected ',' between .word values", source_line);
-                        free(values);
+                        report_syntax(app_context_param, tv->v[pos].line_no, tok_column(&tv->v[pos]), "expected ',' between .word values", tv);
+                        release_values(app_context_param, arena, values, cap);
                         return ERR_SYNTAX;
 
                     }
@@ -348,8 +361,8 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
                     if(pos >= tv->n){
 
-                        report_syntax(app_context_param, line_no, tv->v[pos - 1].column_no, "trailing comma in .word", source_line);
-                        free(values);
+                        report_syntax(app_context_param, line_no, tok_column(&tv->v[pos - 1]), "trailing comma in .word", tv);
+                        release_values(app_context_param, arena, values, cap);
                         return ERR_SYNTAX;
 
                     }
@@ -358,13 +371,28 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
                 
 
+            }
+
+            if(!arena && n < cap){          // heap values are freed by their count, stmt_free_heap_parts() knows no cap
+
+                int32_t *p = app_alloc(app_context_param, APP_MEM_WORDS, values, sizeof(*p) * cap, sizeof(*p) * n);
+
+                if(!p){
+
+                    APP_PERROR(app_context_param, "REALLOC FAILED");
+                    release_values(app_context_param, arena, values, cap);
+                    return ERR_OOM;
+
+                }
+
+                values = p;
+
             }
 
             if(has_label_prefix){
 
                 out_statement->kind = ST_LABEL_PLUS_DIR_WORD;
-                strncpy(out_statement->as.label_plus_dir_word.name, label_name, sizeof(out_statement->as.label_plus_dir_word.name) - 1);
-                out_statement->as.label_plus_dir_word.name[sizeof(out_statement->as.label_plus_dir_word.name) - 1] = '\0';
+                out_statement->as.label_plus_dir_word.name = label_name;
                 out_statement->as.label_plus_dir_word.dir_word.values = values;
                 out_statement->as.label_plus_dir_word.dir_word.n = n;
 
@@ -380,7 +408,7 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
         }
 
-        report_syntax(app_context_param, tv->v[pos].line_no, tv->v[pos].column_no, "unknown directive", source_line);
+        report_syntax(app_context_param, tv->v[pos].line_no, tok_column(&tv->v[pos]), "unknown directive", tv);
         return ERR_SYNTAX;
 
     }
@@ -392,13 +420,11 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
     if(pos < tv->n && tv->v[pos].kind == TOK_IDENT){
 
       
-        char mnemonic[16] = {0};
         Operand ops[3] = {0};
         int operand_count = 0;
 
-        strncpy(mnemonic, tv->v[pos].lexeme, sizeof(mnemonic) - 1);
-        mnemonic[sizeof(mnemonic) - 1] = '\0';
-        int mnemonic_col = (int)tv->v[pos].column_no;
+        const Token *mnemonic_tok = &tv->v[pos];
+        int mnemonic_col = tok_column(mnemonic_tok);
         pos++;
 
         while(pos < tv->n){
@@ -412,44 +438,24 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
             if(operand_count >= 3){
 
-                report_syntax(app_context_param, (int)tv->v[pos].line_no, (int)tv->v[pos].column_no, "too many operands (max 3).", source_line);
-                for(size_t i = 0; i < operand_count; i++){
-
-                    operand_free(&ops[i]);
-
-                }
+                report_syntax(app_context_param, (int)tv->v[pos].line_no, tok_column(&tv->v[pos]), "too many operands (max 3).", tv);
                 return ERR_SYNTAX;
 
             }
 
 
             Operand operand = {0};
-            Err e = parse_operand(app_context_param, tv, &pos, &operand, source_line);
-            if(e != ERR_OK){
-
-                for(size_t i = 0; i < operand_count; i++){
-
-                    operand_free(&ops[i]);
-
-                }
-
-                return e;
-            }
+            Err e = parse_operand(app_context_param, pool, tv, &pos, &operand);
+            if(e != ERR_OK) return e;
 
             ops[operand_count++] = operand;
         }
 
-        const InstructionSpec *instruction_spec = isa_lookup(mnemonic);
+        const InstructionSpec *instruction_spec = isa_lookup_n(tok_text(tv, mnemonic_tok), mnemonic_tok->len);
 
         if(!instruction_spec || instruction_spec->op_count != operand_count || !are_operands_valid(instruction_spec, ops, operand_count)){
 
-            report_syntax(app_context_param, line_no, mnemonic_col, "May be invalid mnemonic, wrong operand count or operand types mismatch.", source_line);
-            for(size_t i = 0; i < operand_count; i++){
-
-                operand_free(&ops[i]);
-
-            }
-
+            report_syntax(app_context_param, line_no, mnemonic_col, "May be invalid mnemonic, wrong operand count or operand types mismatch.", tv);
             return ERR_SYNTAX;
         }
 
@@ -458,11 +464,9 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
             out_statement->kind = ST_LABEL_PLUS_INSTR;
 
-            strncpy(out_statement->as.label_plus_instr.name, label_name, sizeof(out_statement->as.label_plus_instr.name) - 1);
-            out_statement->as.label_plus_instr.name[sizeof(out_statement->as.label_plus_instr.name) - 1] = '\0';
+            out_statement->as.label_plus_instr.name = label_name;
 
-            strncpy(out_statement->as.label_plus_instr.instr.mnemonic, mnemonic, sizeof(out_statement->as.label_plus_instr.instr.mnemonic) - 1);
-            out_statement->as.label_plus_instr.instr.mnemonic[sizeof(out_statement->as.label_plus_instr.instr.mnemonic) - 1] = '\0';
+            out_statement->as.label_plus_instr.instr.op = isa_spec_id(instruction_spec);
 
             out_statement->as.label_plus_instr.instr.op_count = operand_count;
 
@@ -482,8 +486,7 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
             out_statement->kind = ST_INSTR;
 
-            strncpy(out_statement->as.instr.mnemonic, mnemonic, sizeof(out_statement->as.instr.mnemonic) - 1);
-            out_statement->as.instr.mnemonic[sizeof(out_statement->as.instr.mnemonic) - 1] = '\0';
+            out_statement->as.instr.op = isa_spec_id(instruction_spec);
 
             out_statement->as.instr.op_count = operand_count;
 
@@ -500,9 +503,9 @@ Err parse_line(app_context *app_context_param, const TokenVec *tv, const char *s
 
     }
 
-    int col = (pos < tv->n) ? (int)tv->v[pos].column_no : (tv->n ? (int)tv->v[tv->n - 1].column_no : 1);
+    int col = (pos < tv->n) ? tok_column(&tv->v[pos]) : (tv->n ? tok_column(&tv->v[tv->n - 1]) : 1);
 
-    report_syntax(app_context_param, line_no, col, "unrecognized statement", source_line);
+    report_syntax(app_context_param, line_no, col, "unrecognized statement", tv);
     return ERR_SYNTAX;
 
 }
\ No newline at end of file
@@ -0,0 +1,429 @@
+#include "front/scanner.h"
+#include "front/lexer.h"
+#include "core/error_handling.h"
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+
+#define S CC_SPACE
+#define D CC_DELIM
+#define E CC_END
+
+const unsigned char scanner_char_class[256] = {
+
+    ['\0'] = E,
+    ['\t'] = S, ['\n'] = S, ['\v'] = S, ['\f'] = S, ['\r'] = S, [' '] = S,
+    [':'] = D, [','] = D, ['('] = D, [')'] = D,
+    ['#'] = E
+
+};
+
+#undef S
+#undef D
+#undef E
+
+
+static int digit_value(char c){
+
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return 99;
+
+}
+
+
+int scan_int_literal(const char *p, size_t n, long *out_value){
+
+    size_t i = 0;
+    int negative = 0;
+
+    if(i < n && (p[i] == '+' || p[i] == '-')){
+
+        negative = (p[i] == '-');
+        i++;
+
+    }
+
+    if(i >= n) return 0;
+
+    unsigned base = 10;
+
+    if(p[i] == '0'){
+
+        base = 8;
+
+        if(i + 2 < n && (p[i + 1] == 'x' || p[i + 1] == 'X') && digit_value(p[i + 2]) < 16){
+
+            base = 16;
+            i += 2;
+
+        }
+
+    }
+
+    unsigned long limit = negative ? (unsigned long)LONG_MAX + 1UL : (unsigned long)LONG_MAX;
+    unsigned long value = 0;
+
+    for(; i < n; i++){
+
+        unsigned d = (unsigned)digit_value(p[i]);
+
+        if(d >= base) return 0;
+        if(value > (limit - d) / base) return 0;         // strtol would report ERANGE
+
+        value = value * base + d;
+
+    }
+
+    if(out_value) *out_value = negative ? (long)(0UL - value) : (long)value;
+
+    return 1;
+
+}
+
+
+static TokKind classify_span(const char *w, size_t n){
+
+    if(w[0] == '.') return TOK_DOT;
+
+    if(w[0] == '$') return TOK_REG;
+
+    if(scan_int_literal(w, n, NULL)) return TOK_INT;
+
+    return TOK_IDENT;
+
+}
+
+
+static Err push_span(TokenVec *out, TokKind kind, size_t start, size_t n, int line_no, app_context *app_context_param){
+
+    Token t;
+    t.kind = kind;
+    t.line_no = (uint32_t)line_no;
+    t.off = (uint32_t)start;
+    t.len = (uint32_t)n;
+
+    return tokenvec_push(out, &t, app_context_param);
+
+}
+
+
+// block classification **********************************
+//
+// SIMD implementations classify exactly SCAN_BLOCK bytes and return one bit per byte
+// for each class, bit i <-> p[i]. the scalar fallback walks the class table byte by byte instead.
+
+#define SCAN_BLOCK 32
+#define SCAN_SIMD_MIN_LEN (2 * SCAN_BLOCK)      // shorter lines: setting up the block masks costs more than the byte loop
+
+typedef struct{
+
+    uint32_t space;
+    uint32_t delim;
+    uint32_t end;
+
+}BlockMasks;
+
+typedef void (*classify_block_fn)(const unsigned char *p, BlockMasks *out);
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#define SCANNER_X86 1
+#include <immintrin.h>
+
+
+__attribute__((target("sse2")))
+static void classify_half_sse2(const unsigned char *p, uint32_t *space, uint32_t *delim, uint32_t *end){
+
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+
+    // \t \n \v \f \r are 9..13: (x - 9) <= 4 unsigned
+    __m128i t = _mm_sub_epi8(x, _mm_set1_epi8(9));
+    __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t);
+    __m128i sp = _mm_or_si128(ctl, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+
+    __m128i dl = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(':')), _mm_cmpeq_epi8(x, _mm_set1_epi8(','))),
+                              _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('(')), _mm_cmpeq_epi8(x, _mm_set1_epi8(')'))));
+
+    __m128i en = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('#')), _mm_cmpeq_epi8(x, _mm_setzero_si128()));
+
+    *space = (uint32_t)_mm_movemask_epi8(sp);
+    *delim = (uint32_t)_mm_movemask_epi8(dl);
+    *end = (uint32_t)_mm_movemask_epi8(en);
+
+}
+
+
+__attribute__((target("sse2")))
+static void classify_block_sse2(const unsigned char *p, BlockMasks *out){
+
+    uint32_t s0, d0, e0, s1, d1, e1;
+
+    classify_half_sse2(p, &s0, &d0, &e0);
+    classify_half_sse2(p + 16, &s1, &d1, &e1);
+
+    out->space = s0 | (s1 << 16);
+    out->delim = d0 | (d1 << 16);
+    out->end = e0 | (e1 << 16);
+
+}
+
+
+__attribute__((target("avx2")))
+static void classify_block_avx2(const unsigned char *p, BlockMasks *out){
+
+    __m256i x = _mm256_loadu_si256((const __m256i *)p);
+
+    __m256i t = _mm256_sub_epi8(x, _mm256_set1_epi8(9));
+    __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(4)), t);
+    __m256i sp = _mm256_or_si256(ctl, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+
+    __m256i dl = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(','))),
+                                 _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('(')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(')'))));
+
+    __m256i en = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('#')), _mm256_cmpeq_epi8(x, _mm256_setzero_si256()));
+
+    out->space = (uint32_t)_mm256_movemask_epi8(sp);
+    out->delim = (uint32_t)_mm256_movemask_epi8(dl);
+    out->end = (uint32_t)_mm256_movemask_epi8(en);
+
+}
+
+#endif
+
+
+static int impl_supported(ScanImpl impl){
+
+    switch(impl){
+
+        case SCAN_IMPL_SCALAR: return 1;
+
+#ifdef SCANNER_X86
+        case SCAN_IMPL_SSE2: return __builtin_cpu_supports("sse2");
+        case SCAN_IMPL_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+
+        default: return 0;
+
+    }
+
+}
+
+
+static _Atomic int g_scan_impl = SCAN_IMPL_AUTO;      // resolved lazily, every thread resolves to the same value
+
+
+ScanImpl scanner_select_impl(ScanImpl requested){
+
+    ScanImpl chosen = SCAN_IMPL_SCALAR;
+
+    if(requested != SCAN_IMPL_AUTO && impl_supported(requested)) chosen = requested;
+    else if(impl_supported(SCAN_IMPL_AVX2)) chosen = SCAN_IMPL_AVX2;
+    else if(impl_supported(SCAN_IMPL_SSE2)) chosen = SCAN_IMPL_SSE2;
+
+    atomic_store_explicit(&g_scan_impl, chosen, memory_order_relaxed);
+
+    return chosen;
+
+}
+
+
+const char *scanner_impl_name(ScanImpl impl){
+
+    switch(impl){
+
+        case SCAN_IMPL_SCALAR: return "scalar";
+        case SCAN_IMPL_SSE2: return "sse2";
+        case SCAN_IMPL_AVX2: return "avx2";
+        default: return "auto";
+
+    }
+
+}
+
+
+static classify_block_fn resolve_classifier(void){         // NULL selects the scalar byte loop
+
+    int impl = atomic_load_explicit(&g_scan_impl, memory_order_relaxed);
+    if(impl == SCAN_IMPL_AUTO) impl = scanner_select_impl(SCAN_IMPL_AUTO);
+
+    switch(impl){
+
+#ifdef SCANNER_X86
+        case SCAN_IMPL_SSE2: return classify_block_sse2;
+        case SCAN_IMPL_AVX2: return classify_block_avx2;
+#endif
+
+        default: return NULL;
+
+    }
+
+}
+
+
+static TokKind delim_kind(char c){
+
+    return (c == ':') ? TOK_COLON : (c == ',') ? TOK_COMMA : (c == '(') ? TOK_LPAREN : TOK_RPAREN;
+
+}
+
+
+static Err scan_line_scalar(const char *line, size_t len, int line_no, TokenVec *out, app_context *app_context_param){
+
+    const unsigned char *cls = scanner_char_class;
+    size_t i = 0;
+    Err e;
+
+    while(i < len){
+
+        unsigned char k = cls[(unsigned char)line[i]];
+
+        if(k & CC_SPACE){
+
+            i++;
+            continue;
+
+        }
+
+        if(k & CC_END) break;       // rest of the line is a comment
+
+        if(k & CC_DELIM){
+
+            if((e = push_span(out, delim_kind(line[i]), i, 1, line_no, app_context_param)) != ERR_OK) return e;
+            i++;
+            continue;
+
+        }
+
+        // word token part, runs until whitespace, delimiter or comment
+
+        size_t start = i;
+        while(i < len && !cls[(unsigned char)line[i]]) i++;
+
+        if((e = push_span(out, classify_span(line + start, i - start), start, i - start, line_no, app_context_param)) != ERR_OK) return e;
+
+    }
+
+    return ERR_OK;
+
+}
+
+// ********************************************************
+
+
+Err scan_line(const char *line, size_t len, int line_no, TokenVec *out, app_context *app_context_param){
+
+    if(!line || !out){
+
+        APP_ERROR(app_context_param, "INVALID ARGUMENT.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    if(len > UINT32_MAX){
+
+        APP_ERROR(app_context_param, "LINE TOO LONG FOR 32-BIT TOKEN OFFSETS.");
+        return ERR_INVALID_ARGUMENT;
+
+    }
+
+    out->n = 0;
+    out->src = line;
+    out->src_len = len;
+
+    classify_block_fn classify = resolve_classifier();
+    if(!classify || len < SCAN_SIMD_MIN_LEN) return scan_line_scalar(line, len, line_no, out, app_context_param);
+
+    // word bytes are the ones in no class; a word starts where word bit is set and the previous one is not,
+    // it ends on the first non word bit after it. ctz walks these events in source order.
+
+    uint32_t carry = 0;             // 1 when the byte before this block belongs to a word
+    size_t word_start = 0;
+    Err e;
+
+    for(size_t base = 0; base < len; base += SCAN_BLOCK){
+
+        const unsigned char *p = (const unsigned char *)line + base;
+        unsigned char tail[SCAN_BLOCK];
+
+        if(len - base < SCAN_BLOCK){
+
+            // short tail: zero padding reads as '\0', which is CC_END, so no byte past len is ever touched
+
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p, len - base);
+            p = tail;
+
+        }
+
+        BlockMasks m;
+        classify(p, &m);
+
+        int stop = 0;
+
+        if(m.end){
+
+            // '#' or '\0': everything from there on is neither word nor delimiter
+
+            uint32_t keep = (uint32_t)((1ULL << __builtin_ctz(m.end)) - 1);
+            m.space &= keep;
+            m.delim &= keep;
+            m.end = ~keep;
+            stop = 1;
+
+        }
+
+        uint32_t word = ~(m.space | m.delim | m.end);
+        uint32_t prev = (word << 1) | carry;
+        uint32_t starts = word & ~prev;
+        uint32_t ends = ~word & prev;
+        uint32_t events = starts | ends | m.delim;
+
+        while(events){
+
+            unsigned bit = (unsigned)__builtin_ctz(events);
+            uint32_t b = 1u << bit;
+            size_t pos = base + bit;
+
+            if(ends & b){
+
+                if((e = push_span(out, classify_span(line + word_start, pos - word_start), word_start, pos - word_start, line_no, app_context_param)) != ERR_OK) return e;
+
+            }
+
+            if(starts & b) word_start = pos;
+
+            if(m.delim & b){
+
+                if((e = push_span(out, delim_kind(line[pos]), pos, 1, line_no, app_context_param)) != ERR_OK) return e;
+
+            }
+
+            events &= events - 1;
+
+        }
+
+        carry = word >> 31;
+
+        if(stop){
+
+            carry = 0;
+            break;
+
+        }
+
+    }
+
+    if(carry){          // the line ended inside a word on a block boundary
+
+        if((e = push_span(out, classify_span(line + word_start, len - word_start), word_start, len - word_start, line_no, app_context_param)) != ERR_OK) return e;
+
+    }
+
+    return ERR_OK;
+
+}
@@ -10,6 +10,21 @@ int main(){
     test_lex_all_tables(NULL);
     test_parser_tables(NULL);
     test_pass1_tables(NULL);
+    test_line_tables(NULL);
+    test_arena_all(NULL);
+    test_isa_tables(NULL);
+    test_ir_all(NULL);
+    test_regmap_tables(NULL);
+    test_strpool_all(NULL);
+    test_symtab_all(NULL);
+    test_thread_pool_all(NULL);
+    test_spsc_all(NULL);
+    test_session_all(NULL);
+    test_pass2_all(NULL);
+    test_onepass_all(NULL);
+    test_cache_all(NULL);
+    test_batch_all(NULL);
+    test_app_context_all(NULL);
     
     return 0;
 }
\ No newline at end of file
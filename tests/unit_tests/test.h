@@ -4,6 +4,8 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "core/error_handling.h"
 
 
@@ -26,6 +28,49 @@ static inline void test_fail(const char *file, int line, const char *expression,
 
 }
 
+// TEMPORARY FILE HELPERS
+// path NULL: an anonymous tmpfile(). a path ending in XXXXXX is a mkstemp() template and gets the name of the
+// file created, any other path is created or truncated.
+
+static inline FILE *test_create_file(char *path){
+
+    FILE *f = NULL;
+    size_t len = path ? strlen(path) : 0;
+
+    if(!path) f = tmpfile();
+    else if(len >= 6 && strcmp(path + len - 6, "XXXXXX") == 0){
+
+        int fd = mkstemp(path);
+        if(fd >= 0 && !(f = fdopen(fd, "w+"))) close(fd);
+
+    }
+    else f = fopen(path, "w+");
+
+    if(!f) test_fail(__FILE__, __LINE__, "test_create_file", "temporary file can not be created");
+
+    return f;
+
+}
+
+static inline void test_write_file(char *path, const char *text){
+
+    FILE *f = test_create_file(path);
+    if(fputs(text, f) == EOF && *text) test_fail(__FILE__, __LINE__, "fputs", "temporary file can not be written");
+    fclose(f);
+
+}
+
+static inline FILE *test_write_lines(char *path, char *const *lines, size_t n){       // every line '\n' terminated, returned rewound
+
+    FILE *f = test_create_file(path);
+
+    for(size_t i = 0; i < n; i++) if(fprintf(f, "%s\n", lines[i]) < 0) test_fail(__FILE__, __LINE__, "fprintf", "temporary file can not be written");
+    rewind(f);
+
+    return f;
+
+}
+
 // ASSERT MACROS HELPER
 
 #define ASSERT_EQ_INT(a, b) do{\
@@ -55,7 +100,23 @@ static inline void test_fail(const char *file, int line, const char *expression,
         test_fail(__FILE__, __LINE__, "strcmp(" #a ", " #b ")", _buf);\
     }\
 }while(0)
-        
+
+
+#define ASSERT_SPANEQ(p, n, s) do{\
+    const char *_p = (p);\
+    size_t _n = (size_t)(n);\
+    const char *_s = (s);\
+    if(strlen(_s) != _n || memcmp(_p, _s, _n) != 0){\
+        char _buf[256];\
+        snprintf(_buf, sizeof(_buf),\
+                 "Expected span equal:\n"\
+                 " %s = \"%.*s\"\n"\
+                 " %s = \"%s\"",\
+                 #p, (int)_n, _p, #s, _s);\
+        test_fail(__FILE__, __LINE__, "span(" #p ") == " #s, _buf);\
+    }\
+}while(0)
+
 void test_lex_all_tables(app_context *app_context_param);
 
 void test_preprocess_all_tables();
@@ -64,4 +125,34 @@ void test_parser_tables(app_context *app_context_param);
 
 void test_pass1_tables(app_context *app_context_param);
 
+void test_line_tables(app_context *app_context_param);
+
+void test_arena_all(app_context *app_context_param);
+
+void test_isa_tables(app_context *app_context_param);
+
+void test_ir_all(app_context *app_context_param);
+
+void test_regmap_tables(app_context *app_context_param);
+
+void test_symtab_all(app_context *app_context_param);
+
+void test_strpool_all(app_context *app_context_param);
+
+void test_thread_pool_all(app_context *app_context_param);
+
+void test_spsc_all(app_context *app_context_param);
+
+void test_session_all(app_context *app_context_param);
+
+void test_pass2_all(app_context *app_context_param);
+
+void test_onepass_all(app_context *app_context_param);
+
+void test_cache_all(app_context *app_context_param);
+
+void test_batch_all(app_context *app_context_param);
+
+void test_app_context_all(app_context *app_context_param);
+
 #endif
\ No newline at end of file
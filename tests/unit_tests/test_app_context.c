@@ -0,0 +1,425 @@
+#include "test.h"
+#include "asm/pass1.h"
+#include "core/error_handling.h"
+#include "core/thread_pool.h"
+#include "core/line.h"
+#include "front/parser.h"
+#include "front/scanner.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define LOG_TEST_THREADS 4
+#define LOG_TEST_RECORDS 5000       // per thread
+
+
+typedef struct{
+
+    app_context *app;
+
+}LogTestJob;
+
+
+static void log_task(void *arg, size_t index){
+
+    LogTestJob *job = arg;
+    char message[64];
+
+    for(size_t i = 0; i < LOG_TEST_RECORDS; i++){
+
+        snprintf(message, sizeof(message), "T%zu R%zu", index, i);
+        APP_ERROR(job->app, message);
+
+    }
+
+}
+
+
+#define CHILD_TEST_PROGRAMS 16
+
+
+typedef struct{
+
+    app_context *parent;
+    app_context *children[CHILD_TEST_PROGRAMS];
+
+}ChildTestJob;
+
+
+static void assemble_broken(app_context *app_context_param, size_t k){      // a different error in every program, reported through app_context_param
+
+    char src[4][48];
+    char *lines[4] = {src[0], src[1], src[2], src[3]};
+
+    snprintf(src[0], sizeof(src[0]), ".text");
+    snprintf(src[1], sizeof(src[1]), "l%zu: add $t0, $t1, $t2", k);
+    snprintf(src[2], sizeof(src[2]), (k % 3 == 0) ? "l%zu: sub $t0, $t1, $t2" : (k % 3 == 1) ? "add $t%zu, $t1" : ".word %zu", k);
+    snprintf(src[3], sizeof(src[3]), "j l%zu", k);
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    IR ir;
+    Symtab st;
+    AsmState state;
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &cfg, lines, 4, &ir, &st, &state), ERR_SYNTAX);
+
+    if(k == CHILD_TEST_PROGRAMS - 1){
+
+        errno = ENOENT;
+        APP_PERROR(app_context_param, "LAST PROGRAM");
+
+    }
+
+}
+
+
+static void child_task(void *arg, size_t index){
+
+    ChildTestJob *job = arg;
+
+    job->children[index] = create_child_app_context(job->parent);
+    ASSERT_EQ_INT(job->children[index] != NULL, 1);
+    assemble_broken(job->children[index], index);
+
+}
+
+
+static char *read_all(const char *path, size_t *out_len){
+
+    FILE *f = fopen(path, "rb");
+    ASSERT_EQ_INT(f != NULL, 1);
+
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    rewind(f);
+
+    char *text = malloc((size_t)len + 1);
+    ASSERT_EQ_INT(text != NULL, 1);
+    ASSERT_EQ_INT(fread(text, 1, (size_t)len, f), len);
+    text[len] = '\0';
+    fclose(f);
+
+    *out_len = (size_t)len;
+    return text;
+
+}
+
+
+static void check_log(const char *path, size_t expected_records, int complete){      // one well formed line per record, in per thread order
+
+    size_t len;
+    char *text = read_all(path, &len);
+    size_t next[LOG_TEST_THREADS] = {0};
+    size_t lines = 0;
+
+    for(char *save = NULL, *line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save)){
+
+        const char *m = strstr(line, "] T");
+        ASSERT_EQ_INT(m != NULL, 1);
+
+        size_t t, r;
+        ASSERT_EQ_INT(sscanf(m, "] T%zu R%zu", &t, &r), 2);
+        ASSERT_EQ_INT(t < LOG_TEST_THREADS, 1);
+
+        if(complete) ASSERT_EQ_INT(r, next[t]);
+        else ASSERT_EQ_INT(r >= next[t], 1);        // drops leave gaps, never reorder
+
+        next[t] = r + 1;
+        lines++;
+
+    }
+
+    ASSERT_EQ_INT(lines, expected_records);
+    free(text);
+
+}
+
+
+#define MEM_HEADER 16
+
+
+typedef struct{
+
+    atomic_size_t outstanding;
+    atomic_int mismatches;
+
+}CheckingAllocator;
+
+
+static void *checking_alloc(void *ctx, AppMemTag tag, void *ptr, size_t old_size, size_t new_size){      // keeps the size in front of the block: every free and resize must name it
+
+    CheckingAllocator *a = ctx;
+    unsigned char *base = ptr ? (unsigned char *)ptr - MEM_HEADER : NULL;
+
+    if(tag >= APP_MEM_TAG_COUNT || (base && *(size_t *)base != old_size)) atomic_fetch_add(&a->mismatches, 1);
+
+    if(!new_size){
+
+        free(base);
+        atomic_fetch_sub(&a->outstanding, old_size);
+        return NULL;
+
+    }
+
+    base = realloc(base, MEM_HEADER + new_size);
+    if(!base) return NULL;
+
+    *(size_t *)base = new_size;
+    atomic_fetch_add(&a->outstanding, new_size);
+    atomic_fetch_sub(&a->outstanding, old_size);
+
+    return base + MEM_HEADER;
+
+}
+
+
+static size_t mem_live(const app_context *app_context_param, AppMemTag tag){
+
+    AppMemStats stats;
+    ASSERT_EQ_INT(app_context_mem_stats(app_context_param, tag, &stats), ERR_OK);
+    return stats.live;
+
+}
+
+
+static void test_app_context_memory(const char *path, thread_pool *pool){      // every tag returns to zero live bytes, sizes match, the report lands in the log
+
+    unlink(path);
+
+    CheckingAllocator checker;
+    atomic_init(&checker.outstanding, 0);
+    atomic_init(&checker.mismatches, 0);
+
+    app_context *app = create_app_context(path);
+    ASSERT_EQ_INT(app != NULL, 1);
+    app_context_set_allocator(app, checking_alloc, &checker);
+    app_context_set_mem_report(app, 1);
+
+    // pass 1 from the heap, serial and on the pool
+
+    size_t nlines = 6000;
+    char **lines = malloc(sizeof(*lines) * nlines);
+    ASSERT_EQ_INT(lines != NULL, 1);
+
+    for(size_t i = 0; i < nlines; i++){
+
+        char buf[64];
+
+        if(i == 0) snprintf(buf, sizeof(buf), ".data");
+        else if(i < 100) snprintf(buf, sizeof(buf), "w%zu: .word %zu, 2, 3", i, i);
+        else if(i == 100) snprintf(buf, sizeof(buf), ".text");
+        else snprintf(buf, sizeof(buf), "l%zu: beq $t0, $t1, l%zu", i, (i > 101) ? i - 1 : i);
+
+        lines[i] = strdup(buf);
+        ASSERT_EQ_INT(lines[i] != NULL, 1);
+
+    }
+
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig parallel_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pool = pool};
+    const AsmConfig *configs[] = {&serial_cfg, &parallel_cfg};
+
+    for(size_t k = 0; k < ARR_LEN(configs); k++){
+
+        IR ir;
+        Symtab st;
+        AsmState state;
+
+        ASSERT_EQ_INT(assemble_pass1(app, configs[k], lines, nlines, &ir, &st, &state), ERR_OK);
+        ASSERT_EQ_INT(mem_live(app, APP_MEM_IR) >= sizeof(IrRec) * nlines, 1);
+        ASSERT_EQ_INT(mem_live(app, APP_MEM_SYMTAB) >= sizeof(Symbol) * (nlines - 2), 1);
+        ASSERT_EQ_INT(mem_live(app, APP_MEM_STRPOOL) > 0, 1);
+        ASSERT_EQ_INT(mem_live(app, APP_MEM_TOKENS), 0);         // the token vector dies with pass 1
+
+        ir_free(&ir, app);
+        symtab_free(&st, app);
+        ASSERT_EQ_INT(mem_live(app, APP_MEM_TAG_COUNT), 0);
+
+    }
+
+    for(size_t i = 0; i < nlines; i++) free(lines[i]);
+    free(lines);
+
+    AppMemStats ir_stats, total;
+    ASSERT_EQ_INT(app_context_mem_stats(app, APP_MEM_IR, &ir_stats), ERR_OK);
+    ASSERT_EQ_INT(app_context_mem_stats(app, APP_MEM_TAG_COUNT, &total), ERR_OK);
+    ASSERT_EQ_INT(ir_stats.peak >= sizeof(IrRec) * nlines && ir_stats.allocs > 0, 1);
+    ASSERT_EQ_INT(total.peak >= ir_stats.peak, 1);
+
+    // heap .word values are handed out at their exact size
+
+    app_context *child = create_child_app_context(app);
+    TokenVec tv;
+    StrPool names;
+    Statement s;
+    int has_label = 0;
+    const char *word_line = "v: .word 1, 2, 3, 4, 5, 6, 7, 8, 9";
+
+    ASSERT_EQ_INT(tokenvec_init(&tv, child), ERR_OK);
+    ASSERT_EQ_INT(strpool_init(&names, child), ERR_OK);
+    ASSERT_EQ_INT(scan_line(word_line, strlen(word_line), 1, &tv, child), ERR_OK);
+    ASSERT_EQ_INT(parse_line(child, NULL, &names, &tv, 1, &has_label, &s), ERR_OK);
+    ASSERT_EQ_INT(mem_live(child, APP_MEM_WORDS), sizeof(int32_t) * 9);
+    ASSERT_EQ_INT(mem_live(app, APP_MEM_WORDS), sizeof(int32_t) * 9);       // a child counts into its parent
+
+    stmt_free_heap_parts(&s, child);
+    strpool_free(&names, child);
+    tokenvec_free(&tv, child);
+    ASSERT_EQ_INT(mem_live(child, APP_MEM_TAG_COUNT), 0);
+    ASSERT_EQ_INT(destroy_app_context(child), ERR_OK);
+
+    // read_all_lines
+
+    FILE *f = tmpfile();
+    ASSERT_EQ_INT(f != NULL, 1);
+    for(int i = 0; i < 300; i++) fprintf(f, "line %d\n", i);
+    rewind(f);
+
+    LineList read;
+    ASSERT_EQ_INT(read_all_lines(app, f, &read), ERR_OK);
+    ASSERT_EQ_INT(read.n, 300);
+    ASSERT_STREQ(read.v[299].text, "line 299\n");
+    ASSERT_EQ_INT(mem_live(app, APP_MEM_LINES) > 0, 1);
+    ASSERT_EQ_INT(line_list_free(&read, app), ERR_OK);
+    fclose(f);
+
+    ASSERT_EQ_INT(mem_live(app, APP_MEM_TAG_COUNT), 0);
+    ASSERT_EQ_INT(atomic_load(&checker.outstanding), 0);
+    ASSERT_EQ_INT(atomic_load(&checker.mismatches), 0);
+    ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+
+    size_t len;
+    char *text = read_all(path, &len);
+    ASSERT_EQ_INT(strstr(text, "memory by subsystem: symtab") != NULL, 1);
+    ASSERT_EQ_INT(strstr(text, "memory by subsystem: total") != NULL, 1);
+    free(text);
+
+}
+
+
+void test_app_context_all(app_context *app_context_param){
+
+    char path[] = "/tmp/mips_log_test_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_EQ_INT(fd >= 0, 1);
+    close(fd);
+
+    thread_pool *pool = create_thread_pool(app_context_param, LOG_TEST_THREADS);
+    ASSERT_EQ_INT(pool != NULL, 1);
+
+    // block policy, a ring much smaller than the load: every record arrives
+
+    const AppLogConfig block = {.ring_records = 64, .policy = APP_LOG_BLOCK};
+    app_context *app = create_app_context_async(path, &block);
+    ASSERT_EQ_INT(app != NULL, 1);
+
+    LogTestJob job = {app};
+    ASSERT_EQ_INT(thread_pool_run(pool, LOG_TEST_THREADS, log_task, &job), ERR_OK);
+    ASSERT_EQ_INT(app_context_dropped(app), 0);
+    ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+    check_log(path, LOG_TEST_THREADS * LOG_TEST_RECORDS, 1);
+
+    // flush: what was logged before the call is in the file
+
+    ASSERT_EQ_INT(truncate(path, 0), 0);
+    app = create_app_context_async(path, NULL);
+    ASSERT_EQ_INT(app != NULL, 1);
+
+    APP_ERROR(app, "T0 R0");
+    APP_ERROR(app, "T0 R1");
+    ASSERT_EQ_INT(app_context_flush(app), ERR_OK);
+    check_log(path, 2, 1);
+
+    // an over long record is cut but stays one line
+
+    char long_message[APP_LOG_RECORD_BYTES * 2];
+    memset(long_message, 'x', sizeof(long_message) - 1);
+    long_message[sizeof(long_message) - 1] = '\0';
+    memcpy(long_message, "T0 R2 ", 6);
+
+    APP_ERROR(app, long_message);
+    ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+
+    size_t len;
+    char *text = read_all(path, &len);
+    ASSERT_EQ_INT(text[len - 1], '\n');
+    ASSERT_EQ_INT(strlen(strrchr(text, '[')), APP_LOG_RECORD_BYTES - 1);
+    free(text);
+
+    // drop policy: the caller never waits, written + dropped accounts for every record
+
+    ASSERT_EQ_INT(truncate(path, 0), 0);
+    const AppLogConfig drop = {.ring_records = 4, .policy = APP_LOG_DROP};
+    app = create_app_context_async(path, &drop);
+    ASSERT_EQ_INT(app != NULL, 1);
+
+    job.app = app;
+    ASSERT_EQ_INT(thread_pool_run(pool, LOG_TEST_THREADS, log_task, &job), ERR_OK);
+    size_t dropped = app_context_dropped(app);
+    ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+    check_log(path, LOG_TEST_THREADS * LOG_TEST_RECORDS - dropped, 0);
+
+    // children: programs assembled concurrently, merged in program order, give the log of the serial run
+
+    ASSERT_EQ_INT(truncate(path, 0), 0);
+    app = create_app_context(path);
+    ASSERT_EQ_INT(app != NULL, 1);
+
+    for(size_t k = 0; k < CHILD_TEST_PROGRAMS; k++) assemble_broken(app, k);
+    ASSERT_EQ_INT(app_context_last_error(app), ENOENT);
+    ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+
+    size_t serial_len;
+    char *serial = read_all(path, &serial_len);
+    ASSERT_EQ_INT(strstr(serial, "col") != NULL, 1);           // parser diagnostics went to the context too
+
+    static const AppLogConfig async_cfg = {.ring_records = 64, .policy = APP_LOG_BLOCK};
+
+    for(int async = 0; async < 2; async++){
+
+        ASSERT_EQ_INT(truncate(path, 0), 0);
+        ChildTestJob child_job = {async ? create_app_context_async(path, &async_cfg) : create_app_context(path), {0}};
+        ASSERT_EQ_INT(child_job.parent != NULL, 1);
+
+        ASSERT_EQ_INT(thread_pool_run(pool, CHILD_TEST_PROGRAMS, child_task, &child_job), ERR_OK);
+        ASSERT_EQ_INT(app_context_last_error(child_job.parent), 0);          // nothing reaches the parent before the merge
+
+        for(size_t k = 0; k < CHILD_TEST_PROGRAMS; k++){
+
+            ASSERT_EQ_INT(merge_child_app_context(child_job.parent, child_job.children[k]), ERR_OK);
+            ASSERT_EQ_INT(destroy_app_context(child_job.children[k]), ERR_OK);
+
+        }
+
+        ASSERT_EQ_INT(app_context_last_error(child_job.parent), ENOENT);
+        ASSERT_EQ_INT(destroy_app_context(child_job.parent), ERR_OK);
+
+        char *merged = read_all(path, &len);
+        ASSERT_EQ_INT(len, serial_len);
+        ASSERT_EQ_INT(memcmp(merged, serial, len), 0);
+        free(merged);
+
+    }
+
+    free(serial);
+
+    // a child only merges into its own parent
+
+    app = create_app_context(path);
+    app_context *other = create_app_context(path);
+    app_context *child = create_child_app_context(app);
+    ASSERT_EQ_INT(child != NULL, 1);
+    ASSERT_EQ_INT(merge_child_app_context(other, child), ERR_INVALID_ARGUMENT);
+    ASSERT_EQ_INT(destroy_app_context(child), ERR_OK);
+    ASSERT_EQ_INT(destroy_app_context(other), ERR_OK);
+    ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+
+    test_app_context_memory(path, pool);
+
+    destroy_thread_pool(app_context_param, pool);
+    unlink(path);
+
+}
@@ -0,0 +1,87 @@
+#include "test.h"
+#include "core/arena.h"
+#include "core/error_handling.h"
+#include <stdint.h>
+#include <string.h>
+
+
+static void test_arena_alloc_alignment(app_context *app_context_param){
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 256, app_context_param), ERR_OK);
+
+    for(size_t i = 1; i < 200; i++){
+
+        unsigned char *p = arena_alloc(&arena, i, app_context_param);
+        ASSERT_EQ_INT(p != NULL, 1);
+        ASSERT_EQ_INT((uintptr_t)p % 16, 0);
+        memset(p, 0xAB, i);         // must be writable, ASAN catches overlap with a neighbour
+
+    }
+
+    // bigger than a block: gets its own block
+
+    char *big = arena_alloc(&arena, 10000, app_context_param);
+    ASSERT_EQ_INT(big != NULL, 1);
+    memset(big, 0, 10000);
+
+    ASSERT_EQ_INT(arena_free(&arena, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(arena.head == NULL, 1);
+    ASSERT_EQ_INT(arena.bytes_allocated, 0);
+
+}
+
+
+static void test_arena_realloc_in_place(app_context *app_context_param){
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 4096, app_context_param), ERR_OK);
+
+    int32_t *v = arena_alloc(&arena, 4 * sizeof(*v), app_context_param);
+    for(int i = 0; i < 4; i++) v[i] = i;
+
+    int32_t *w = arena_realloc(&arena, v, 4 * sizeof(*v), 64 * sizeof(*v), app_context_param);
+    ASSERT_EQ_INT(w == v, 1);           // last allocation grows where it is
+
+    char *s = arena_strndup(&arena, "loop_label_xyz", 4, app_context_param);
+    ASSERT_STREQ(s, "loop");
+
+    int32_t *x = arena_realloc(&arena, w, 64 * sizeof(*w), 128 * sizeof(*w), app_context_param);
+    ASSERT_EQ_INT(x != w, 1);           // not the last one any more: copied
+    for(int i = 0; i < 4; i++) ASSERT_EQ_INT(x[i], i);
+
+    arena_free(&arena, app_context_param);
+
+}
+
+
+static void test_arena_rewind(app_context *app_context_param){
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 128, app_context_param), ERR_OK);
+
+    char *keep = arena_strndup(&arena, "kept", 4, app_context_param);
+    ArenaMark mark = arena_mark(&arena);
+
+    for(int i = 0; i < 100; i++) arena_alloc(&arena, 100, app_context_param);      // spills into many blocks
+
+    arena_rewind(&arena, mark);
+
+    ASSERT_STREQ(keep, "kept");
+    ASSERT_EQ_INT(arena.bytes_allocated, 5);
+
+    char *again = arena_alloc(&arena, 1, app_context_param);
+    ASSERT_EQ_INT(again == keep + 16, 1);       // bump pointer is back where the mark was
+
+    arena_free(&arena, app_context_param);
+
+}
+
+
+void test_arena_all(app_context *app_context_param){
+
+    test_arena_alloc_alignment(app_context_param);
+    test_arena_realloc_in_place(app_context_param);
+    test_arena_rewind(app_context_param);
+
+}
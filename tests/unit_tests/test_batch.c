@@ -0,0 +1,262 @@
+#include "test.h"
+#include "asm/batch.h"
+#include "core/thread_pool.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define BATCH_TEST_FILES 40
+
+
+static char *read_text(const char *path){
+
+    FILE *f = fopen(path, "rb");
+    ASSERT_EQ_INT(f != NULL, 1);
+
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    rewind(f);
+
+    char *text = malloc((size_t)len + 1);
+    ASSERT_EQ_INT(text != NULL, 1);
+    ASSERT_EQ_INT(fread(text, 1, (size_t)len, f), len);
+    text[len] = '\0';
+    fclose(f);
+
+    return text;
+
+}
+
+
+static void write_program(char *path, size_t k){      // k words of text and data; every 7th file has a syntax error, every 11th an undefined label
+
+    char text[4096];
+    size_t n = (size_t)snprintf(text, sizeof(text), ".text\nmain%zu:\n", k);
+
+    for(size_t i = 0; i < k; i++) n += (size_t)snprintf(text + n, sizeof(text) - n, "    addi $t0, $t0, %zu\n", i);
+
+    if(k % 7 == 3) n += (size_t)snprintf(text + n, sizeof(text) - n, "    add $t0, $t1\n");
+    if(k % 11 == 5) n += (size_t)snprintf(text + n, sizeof(text) - n, "    j nowhere\n");
+
+    n += (size_t)snprintf(text + n, sizeof(text) - n, "    j main%zu\n.data\ntbl:\n", k);
+    for(size_t i = 0; i < k; i++) n += (size_t)snprintf(text + n, sizeof(text) - n, "    .word %zu\n", i);
+
+    test_write_file(path, text);
+
+}
+
+
+static Err run_batch(const char *log_path, const char *manifest, thread_pool *pool, const char *cache_dir, AsmBatchResult *results, char **out_log){
+
+    unlink(log_path);
+    app_context *app = create_app_context(log_path);
+    ASSERT_EQ_INT(app != NULL, 1);
+
+    AsmBatchList list;
+    ASSERT_EQ_INT(asm_batch_list_init(&list, app), ERR_OK);
+    ASSERT_EQ_INT(asm_batch_list_read_manifest(&list, manifest, app), ERR_OK);
+    ASSERT_EQ_INT(list.n, BATCH_TEST_FILES + 1);
+
+    const AsmBatchConfig cfg = {.config = {.text_base = 0x00400000, .data_base = 0x10010000}, .pool = pool, .cache_dir = cache_dir};
+    Err e = asm_batch_assemble(app, &cfg, &list, results);
+
+    ASSERT_EQ_INT(asm_batch_list_free(&list, app), ERR_OK);
+    ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+
+    *out_log = read_text(log_path);
+    return e;
+
+}
+
+
+static void remove_dir(const char *dir){
+
+    DIR *d = opendir(dir);
+    ASSERT_EQ_INT(d != NULL, 1);
+
+    for(struct dirent *ent = readdir(d); ent; ent = readdir(d)){
+
+        if(strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
+        unlink(path);
+
+    }
+
+    closedir(d);
+    rmdir(dir);
+
+}
+
+
+static size_t count_entries(const char *dir){
+
+    DIR *d = opendir(dir);
+    ASSERT_EQ_INT(d != NULL, 1);
+
+    size_t n = 0;
+    for(struct dirent *ent = readdir(d); ent; ent = readdir(d)) if(strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0) n++;
+
+    closedir(d);
+
+    return n;
+
+}
+
+
+static void test_batch_same_source(app_context *app_context_param, thread_pool *pool, const char *dir){      // workers storing one key at once: each through its own temporary file
+
+    char cache_dir[128], path[160], copy[160];
+    snprintf(cache_dir, sizeof(cache_dir), "%s/same_cache", dir);
+    snprintf(path, sizeof(path), "%s/same.s", dir);
+    snprintf(copy, sizeof(copy), "%s/same_copy.s", dir);
+
+    write_program(path, 40);
+    write_program(copy, 40);
+
+    AsmBatchList list;
+    ASSERT_EQ_INT(asm_batch_list_init(&list, app_context_param), ERR_OK);
+
+    for(size_t i = 0; i < 16; i++){
+
+        const char *p = (i % 2) ? copy : path;
+        ASSERT_EQ_INT(asm_batch_list_add(&list, p, strlen(p), app_context_param), ERR_OK);
+
+    }
+
+    const AsmBatchConfig cfg = {.config = {.text_base = 0x00400000, .data_base = 0x10010000}, .pool = pool, .cache_dir = cache_dir};
+    AsmBatchResult results[16];
+
+    for(int round = 0; round < 8; round++){
+
+        ASSERT_EQ_INT(mkdir(cache_dir, 0755), 0);
+
+        for(int warm = 0; warm < 2; warm++){
+
+            ASSERT_EQ_INT(asm_batch_assemble(app_context_param, &cfg, &list, results), ERR_OK);
+
+            for(size_t i = 0; i < list.n; i++){
+
+                ASSERT_EQ_INT(results[i].text_words, 41);
+                ASSERT_EQ_INT(results[i].data_words, 40);
+                ASSERT_EQ_INT(results[i].symbols, 2);
+                if(warm) ASSERT_EQ_INT(results[i].cache_hit, 1);
+
+            }
+
+            ASSERT_EQ_INT(count_entries(cache_dir), 1);         // the one entry, no temporary file left behind
+
+        }
+
+        remove_dir(cache_dir);
+
+    }
+
+    ASSERT_EQ_INT(asm_batch_list_free(&list, app_context_param), ERR_OK);
+    unlink(path);
+    unlink(copy);
+
+}
+
+
+void test_batch_all(app_context *app_context_param){
+
+    char dir[] = "/tmp/mips_batch_test_XXXXXX";
+    ASSERT_EQ_INT(mkdtemp(dir) != NULL, 1);
+
+    char cache_dir[128], manifest[128], log_path[128], path[160];
+    snprintf(cache_dir, sizeof(cache_dir), "%s/cache", dir);
+    snprintf(manifest, sizeof(manifest), "%s/manifest", dir);
+    snprintf(log_path, sizeof(log_path), "%s/log", dir);
+    ASSERT_EQ_INT(mkdir(cache_dir, 0755), 0);
+
+    // manifest: every file, a missing one at the end, comments and blanks in between
+
+    FILE *m = fopen(manifest, "w");
+    ASSERT_EQ_INT(m != NULL, 1);
+    fprintf(m, "# batch test\n\n");
+
+    for(size_t k = 0; k < BATCH_TEST_FILES; k++){
+
+        snprintf(path, sizeof(path), "%s/p%zu.s", dir, k);
+        write_program(path, k);
+        fprintf(m, (k % 5 == 0) ? "   %s  \n" : "%s\n", path);
+
+    }
+
+    fprintf(m, "%s/missing.s\n", dir);
+    fclose(m);
+
+    // serial reference
+
+    AsmBatchResult serial[BATCH_TEST_FILES + 1], parallel[BATCH_TEST_FILES + 1], cached[BATCH_TEST_FILES + 1];
+    char *serial_log, *parallel_log, *cached_log;
+
+    ASSERT_EQ_INT(run_batch(log_path, manifest, NULL, NULL, serial, &serial_log), ERR_SYNTAX);     // first failing file: p3
+
+    for(size_t k = 0; k < BATCH_TEST_FILES; k++){
+
+        Err expected = (k % 7 == 3) ? ERR_SYNTAX : (k % 11 == 5) ? ERR_UNDEF_LABEL : ERR_OK;
+        ASSERT_EQ_INT(serial[k].result, expected);
+
+        if(expected == ERR_OK){
+
+            ASSERT_EQ_INT(serial[k].text_words, k + 1);
+            ASSERT_EQ_INT(serial[k].data_words, k);
+            ASSERT_EQ_INT(serial[k].symbols, 2);
+
+        }
+
+    }
+
+    ASSERT_EQ_INT(serial[BATCH_TEST_FILES].result, ERR_IO);
+
+    // on the pool: same results, same log, byte for byte
+
+    thread_pool *pool = create_thread_pool(app_context_param, 4);
+    ASSERT_EQ_INT(pool != NULL, 1);
+
+    ASSERT_EQ_INT(run_batch(log_path, manifest, pool, NULL, parallel, &parallel_log), ERR_SYNTAX);
+    ASSERT_EQ_INT(strcmp(serial_log, parallel_log), 0);
+
+    for(size_t k = 0; k <= BATCH_TEST_FILES; k++){
+
+        ASSERT_EQ_INT(parallel[k].result, serial[k].result);
+        ASSERT_EQ_INT(parallel[k].text_words, serial[k].text_words);
+        ASSERT_EQ_INT(parallel[k].data_words, serial[k].data_words);
+        ASSERT_EQ_INT(parallel[k].symbols, serial[k].symbols);
+
+    }
+
+    // through the cache: a cold run fills it, the warm one hits for every valid file
+
+    for(int warm = 0; warm < 2; warm++){
+
+        ASSERT_EQ_INT(run_batch(log_path, manifest, pool, cache_dir, cached, &cached_log), ERR_SYNTAX);
+
+        for(size_t k = 0; k <= BATCH_TEST_FILES; k++){
+
+            ASSERT_EQ_INT(cached[k].result, serial[k].result);
+            ASSERT_EQ_INT(cached[k].text_words, serial[k].text_words);
+            ASSERT_EQ_INT(cached[k].cache_hit, warm && serial[k].result == ERR_OK);
+
+        }
+
+        free(cached_log);
+
+    }
+
+    test_batch_same_source(app_context_param, pool, dir);
+    destroy_thread_pool(app_context_param, pool);
+
+    free(serial_log);
+    free(parallel_log);
+    remove_dir(cache_dir);
+    remove_dir(dir);
+
+}
@@ -0,0 +1,221 @@
+#include "test.h"
+#include "asm/cache.h"
+#include "asm/pass1.h"
+#include "asm/pass2.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static void entry_file(const char *dir, char *out, size_t cap){        // the one .masm file in dir
+
+    DIR *d = opendir(dir);
+    ASSERT_EQ_INT(d != NULL, 1);
+
+    struct dirent *ent;
+    int found = 0;
+
+    while((ent = readdir(d))){
+
+        size_t len = strlen(ent->d_name);
+
+        if(len > 5 && strcmp(ent->d_name + len - 5, ".masm") == 0){
+
+            snprintf(out, cap, "%s/%s", dir, ent->d_name);
+            found++;
+
+        }
+
+    }
+
+    closedir(d);
+    ASSERT_EQ_INT(found, 1);
+
+}
+
+
+static void assert_matches_reference(app_context *app_context_param, const AsmConfig *cfg, const char *src, const AsmCachedView *v){
+
+    size_t n = 0;
+    char *copy = strdup(src);
+    char *lines[64];
+
+    for(char *save = NULL, *tok = strtok_r(copy, "\n", &save); tok; tok = strtok_r(NULL, "\n", &save)) lines[n++] = tok;
+
+    IR ir;
+    Symtab st;
+    AsmState state;
+    AsmImage img;
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, cfg, lines, n, &ir, &st, &state), ERR_OK);
+    ASSERT_EQ_INT(assemble_pass2(app_context_param, cfg, &ir, &st, &state, &img), ERR_OK);
+
+    ASSERT_EQ_INT(v->state.section, state.section);
+    ASSERT_EQ_INT(v->state.text_pc, state.text_pc);
+    ASSERT_EQ_INT(v->state.data_pc, state.data_pc);
+    ASSERT_EQ_INT(v->text_base, cfg->text_base);
+    ASSERT_EQ_INT(v->data_base, cfg->data_base);
+    ASSERT_EQ_INT(v->text_n, img.text_n);
+    ASSERT_EQ_INT(v->data_n, img.data_n);
+    ASSERT_EQ_INT(memcmp(v->text, img.text, sizeof(*img.text) * img.text_n), 0);
+    ASSERT_EQ_INT(memcmp(v->data, img.data, sizeof(*img.data) * img.data_n), 0);
+    ASSERT_EQ_INT(v->n_symbols, st.n);
+
+    for(size_t i = 0; i < st.n; i++){
+
+        ASSERT_STREQ(v->names + v->symbols[i].name, symtab_name(&st, i));
+        ASSERT_EQ_INT(v->symbols[i].addr, st.v[i].addr);
+
+    }
+
+    asm_image_free(&img, app_context_param);
+    ir_free(&ir, app_context_param);
+    symtab_free(&st, app_context_param);
+    free(copy);
+
+}
+
+
+static const char *const program =
+    ".text\n"
+    "main: addi $t0, $zero, 3\n"
+    "loop: addi $t0, $t0, -1\n"
+    "    beq $t0, $zero, loop\n"
+    "    j done\n"
+    "done: add $v0, $t0, $t0\n"
+    ".data\n"
+    "tbl: .word 1, 2, 3\n"
+    "    .word -4\n";
+
+static const uint32_t program_text_lines[] = {2, 3, 4, 5, 6};
+static const uint32_t program_data_lines[] = {8, 8, 8, 9};
+
+
+void test_cache_all(app_context *app_context_param){
+
+    char dir[] = "/tmp/mips_cache_test_XXXXXX";
+    ASSERT_EQ_INT(mkdtemp(dir) != NULL, 1);
+
+    char src_path[128], entry[512];
+    snprintf(src_path, sizeof(src_path), "%s/prog.s", dir);
+    test_write_file(src_path, program);
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    asm_cached_program *p;
+    int hit;
+
+    // miss, then hit: both give the pass 1 + pass 2 result
+
+    ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, dir, &cfg, src_path, &p, &hit), ERR_OK);
+    ASSERT_EQ_INT(hit, 0);
+    assert_matches_reference(app_context_param, &cfg, program, asm_cached_view(p));
+    ASSERT_EQ_INT(destroy_asm_cached_program(app_context_param, p), ERR_OK);
+
+    ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, dir, &cfg, src_path, &p, &hit), ERR_OK);
+    ASSERT_EQ_INT(hit, 1);
+
+    const AsmCachedView *v = asm_cached_view(p);
+    assert_matches_reference(app_context_param, &cfg, program, v);
+    ASSERT_EQ_INT(v->text_n, sizeof(program_text_lines) / sizeof(*program_text_lines));
+    ASSERT_EQ_INT(v->data_n, sizeof(program_data_lines) / sizeof(*program_data_lines));
+    ASSERT_EQ_INT(memcmp(v->text_lines, program_text_lines, sizeof(program_text_lines)), 0);
+    ASSERT_EQ_INT(memcmp(v->data_lines, program_data_lines, sizeof(program_data_lines)), 0);
+    ASSERT_EQ_INT(destroy_asm_cached_program(app_context_param, p), ERR_OK);
+
+    // lookup by key, and the key covers the bases
+
+    AsmCacheKey key;
+    asm_cache_key(program, strlen(program), &cfg, &key);
+    ASSERT_EQ_INT(asm_cache_lookup(app_context_param, dir, &key, &p), ERR_OK);
+    ASSERT_EQ_INT(p != NULL, 1);
+    destroy_asm_cached_program(app_context_param, p);
+
+    key.text_base += 4;
+    ASSERT_EQ_INT(asm_cache_lookup(app_context_param, dir, &key, &p), ERR_OK);
+    ASSERT_EQ_INT(p == NULL, 1);
+
+    const AsmConfig moved = {.text_base = 0x00500000, .data_base = 0x10010000};
+    ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, dir, &moved, src_path, &p, &hit), ERR_OK);
+    ASSERT_EQ_INT(hit, 0);
+    assert_matches_reference(app_context_param, &moved, program, asm_cached_view(p));
+    destroy_asm_cached_program(app_context_param, p);
+
+    // an edited source is a different entry
+
+    const char *edited = ".text\nmain: addi $t0, $zero, 4\n";
+    test_write_file(src_path, edited);
+    ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, dir, &cfg, src_path, &p, &hit), ERR_OK);
+    ASSERT_EQ_INT(hit, 0);
+    assert_matches_reference(app_context_param, &cfg, edited, asm_cached_view(p));
+    destroy_asm_cached_program(app_context_param, p);
+
+    // damaged entries are misses and get replaced: truncated, foreign build id, bad section offset
+
+    char sub[160];
+    snprintf(sub, sizeof(sub), "%s/damaged", dir);
+    ASSERT_EQ_INT(mkdir(sub, 0755), 0);
+    test_write_file(src_path, program);
+    ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, sub, &cfg, src_path, &p, &hit), ERR_OK);
+    destroy_asm_cached_program(app_context_param, p);
+    entry_file(sub, entry, sizeof(entry));
+
+    static const struct{ const char *name; long offset; int truncate; }damage[] = {
+
+        {"truncated", 0, 1},
+        {"build_id", 16, 0},
+        {"text_offset", 104, 0}
+
+    };
+
+    for(size_t i = 0; i < sizeof(damage) / sizeof(damage[0]); i++){
+
+        FILE *f = fopen(entry, "r+b");
+        ASSERT_EQ_INT(f != NULL, 1);
+
+        if(damage[i].truncate) ASSERT_EQ_INT(ftruncate(fileno(f), 100), 0);
+        else{
+
+            fseek(f, damage[i].offset, SEEK_SET);
+            fputc('#', f);
+
+        }
+
+        fclose(f);
+
+        ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, sub, &cfg, src_path, &p, &hit), ERR_OK);
+        if(hit) fprintf(stderr, "cache damage case %s\n", damage[i].name);
+        ASSERT_EQ_INT(hit, 0);
+        assert_matches_reference(app_context_param, &cfg, program, asm_cached_view(p));
+        destroy_asm_cached_program(app_context_param, p);
+
+        ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, sub, &cfg, src_path, &p, &hit), ERR_OK);
+        ASSERT_EQ_INT(hit, 1);
+        destroy_asm_cached_program(app_context_param, p);
+
+    }
+
+    // an unwritable cache still assembles, a store into it fails
+
+    char missing[160];
+    snprintf(missing, sizeof(missing), "%s/missing", dir);
+    ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, missing, &cfg, src_path, &p, &hit), ERR_OK);
+    ASSERT_EQ_INT(hit, 0);
+    assert_matches_reference(app_context_param, &cfg, program, asm_cached_view(p));
+    destroy_asm_cached_program(app_context_param, p);
+
+    // a source error is returned and nothing is stored
+
+    test_write_file(src_path, ".text\nj nowhere\n");
+    ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, dir, &cfg, src_path, &p, &hit), ERR_UNDEF_LABEL);
+    ASSERT_EQ_INT(p == NULL, 1);
+    ASSERT_EQ_INT(asm_cache_assemble_file(app_context_param, dir, &cfg, src_path, &p, &hit), ERR_UNDEF_LABEL);
+    ASSERT_EQ_INT(hit, 0);
+
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    ASSERT_EQ_INT(system(cmd), 0);
+
+}
@@ -0,0 +1,165 @@
+#include "test.h"
+#include "core/ir.h"
+#include "core/isa_mips.h"
+#include "core/strpool.h"
+#include "core/error_handling.h"
+#include <string.h>
+
+
+static int operands_equal(const Operand *a, const Operand *b, int n){
+
+    for(int i = 0; i < n; i++){
+
+        if(a[i].kind != b[i].kind) return 0;
+        if(a[i].kind == OP_REGISTER && a[i].v.reg != b[i].v.reg) return 0;
+        if(a[i].kind == OP_IMMEDIATE && a[i].v.imm != b[i].v.imm) return 0;
+        if(a[i].kind == OP_LABEL && a[i].v.label != b[i].v.label) return 0;
+        if(a[i].kind == OP_MEMORY && (a[i].v.mem.offset != b[i].v.mem.offset || a[i].v.mem.base_reg != b[i].v.mem.base_reg)) return 0;
+
+    }
+
+    return 1;
+
+}
+
+
+static void fill_statements(Statement *s, int32_t *words, StrId main_id, StrId loop_id){      // one statement of every kind, covering every operand class
+
+    memset(s, 0, sizeof(*s) * 8);
+
+    s[0] = (Statement){.line_no = 1, .kind = ST_DIR_TEXT};
+
+    s[1].line_no = 2;
+    s[1].kind = ST_LABEL_PLUS_INSTR;
+    s[1].as.label_plus_instr.name = main_id;
+    s[1].as.label_plus_instr.instr.op = ISA_ADDI;
+    s[1].as.label_plus_instr.instr.op_count = 3;
+    s[1].as.label_plus_instr.instr.ops[0] = (Operand){.kind = OP_REGISTER, .v.reg = 31};
+    s[1].as.label_plus_instr.instr.ops[1] = (Operand){.kind = OP_REGISTER, .v.reg = 17};
+    s[1].as.label_plus_instr.instr.ops[2] = (Operand){.kind = OP_IMMEDIATE, .v.imm = INT32_MIN};
+
+    s[2].line_no = 3;
+    s[2].kind = ST_INSTR;
+    s[2].as.instr.op = ISA_SW;
+    s[2].as.instr.op_count = 2;
+    s[2].as.instr.ops[0] = (Operand){.kind = OP_REGISTER, .v.reg = 8};
+    s[2].as.instr.ops[1] = (Operand){.kind = OP_MEMORY, .v.mem = {-4, 29}};
+
+    s[3].line_no = 4;
+    s[3].kind = ST_INSTR;
+    s[3].as.instr.op = ISA_BEQ;
+    s[3].as.instr.op_count = 3;
+    s[3].as.instr.ops[0] = (Operand){.kind = OP_REGISTER, .v.reg = 9};
+    s[3].as.instr.ops[1] = (Operand){.kind = OP_REGISTER, .v.reg = 0};
+    s[3].as.instr.ops[2] = (Operand){.kind = OP_LABEL, .v.label = loop_id};
+
+    s[4] = (Statement){.line_no = 5, .kind = ST_LABEL, .as.label.name = loop_id};
+    s[5] = (Statement){.line_no = 6, .kind = ST_DIR_DATA};
+
+    s[6].line_no = 7;
+    s[6].kind = ST_DIR_WORD;
+    s[6].as.dir_word.values = words;
+    s[6].as.dir_word.n = 3;
+
+    s[7].line_no = 8;
+    s[7].kind = ST_LABEL_PLUS_DIR_WORD;
+    s[7].as.label_plus_dir_word.name = main_id + 1;
+    s[7].as.label_plus_dir_word.dir_word.values = words + 3;
+    s[7].as.label_plus_dir_word.dir_word.n = 1;
+
+}
+
+
+static void assert_statement_equal(const Statement *a, const Statement *b){
+
+    ASSERT_EQ_INT(a->line_no, b->line_no);
+    ASSERT_EQ_INT(a->kind, b->kind);
+
+    switch(a->kind){
+
+        case ST_INSTR:
+            ASSERT_EQ_INT(a->as.instr.op, b->as.instr.op);
+            ASSERT_EQ_INT(a->as.instr.op_count, b->as.instr.op_count);
+            ASSERT_EQ_INT(operands_equal(a->as.instr.ops, b->as.instr.ops, a->as.instr.op_count), 1);
+            break;
+
+        case ST_LABEL_PLUS_INSTR:
+            ASSERT_EQ_INT(a->as.label_plus_instr.name, b->as.label_plus_instr.name);
+            ASSERT_EQ_INT(a->as.label_plus_instr.instr.op, b->as.label_plus_instr.instr.op);
+            ASSERT_EQ_INT(a->as.label_plus_instr.instr.op_count, b->as.label_plus_instr.instr.op_count);
+            ASSERT_EQ_INT(operands_equal(a->as.label_plus_instr.instr.ops, b->as.label_plus_instr.instr.ops, a->as.label_plus_instr.instr.op_count), 1);
+            break;
+
+        case ST_LABEL:
+            ASSERT_EQ_INT(a->as.label.name, b->as.label.name);
+            break;
+
+        case ST_DIR_WORD:
+            ASSERT_EQ_INT(a->as.dir_word.n, b->as.dir_word.n);
+            ASSERT_EQ_INT(memcmp(a->as.dir_word.values, b->as.dir_word.values, sizeof(int32_t) * a->as.dir_word.n), 0);
+            break;
+
+        case ST_LABEL_PLUS_DIR_WORD:
+            ASSERT_EQ_INT(a->as.label_plus_dir_word.name, b->as.label_plus_dir_word.name);
+            ASSERT_EQ_INT(a->as.label_plus_dir_word.dir_word.n, b->as.label_plus_dir_word.dir_word.n);
+            ASSERT_EQ_INT(memcmp(a->as.label_plus_dir_word.dir_word.values, b->as.label_plus_dir_word.dir_word.values, sizeof(int32_t) * a->as.label_plus_dir_word.dir_word.n), 0);
+            break;
+
+        default:
+            break;
+
+    }
+
+}
+
+
+static void run_ir_round_trip(IR *ir, app_context *app_context_param){
+
+    int32_t words[4] = {10, -1, 0x7FFFFFFF, 42};
+    int32_t expected_words[4] = {10, -1, 0x7FFFFFFF, 42};
+    Statement in[8], out;
+
+    fill_statements(in, words, 1, 2);
+
+    for(size_t i = 0; i < ARR_LEN(in); i++) ASSERT_EQ_INT(ir_push(ir, &in[i], app_context_param), ERR_OK);
+
+    memset(words, 0, sizeof(words));        // ir_push copied the payload, the caller's array is free to change
+    fill_statements(in, expected_words, 1, 2);
+
+    ASSERT_EQ_INT(ir->n, ARR_LEN(in));
+    ASSERT_EQ_INT(ir->words_n, (3 + 1) + (1 + 1));
+
+    for(size_t i = 0; i < ARR_LEN(in); i++){
+
+        ASSERT_EQ_INT(ir_get(ir, i, &out), ERR_OK);
+        assert_statement_equal(&in[i], &out);
+
+    }
+
+    ASSERT_EQ_INT(ir_get(ir, ARR_LEN(in), &out), ERR_INVALID_ARGUMENT);
+
+    // an instruction whose operands do not match its spec can not be encoded
+
+    Statement bad = in[2];
+    bad.as.instr.ops[1] = (Operand){.kind = OP_REGISTER, .v.reg = 1};
+    ASSERT_EQ_INT(ir_push(ir, &bad, app_context_param), ERR_INVALID_ARGUMENT);
+    ASSERT_EQ_INT(ir->n, ARR_LEN(in));
+
+}
+
+
+void test_ir_all(app_context *app_context_param){
+
+    IR ir;
+
+    ASSERT_EQ_INT(ir_init(&ir, app_context_param), ERR_OK);
+    run_ir_round_trip(&ir, app_context_param);
+    ASSERT_EQ_INT(ir_free(&ir, app_context_param), ERR_OK);
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 0, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(ir_init_arena(&ir, &arena, app_context_param), ERR_OK);
+    run_ir_round_trip(&ir, app_context_param);
+    ASSERT_EQ_INT(arena_free(&arena, app_context_param), ERR_OK);
+
+}
@@ -0,0 +1,75 @@
+#include "test.h"
+#include "core/isa_mips.h"
+#include <string.h>
+
+
+typedef struct{
+
+    const char *name;
+    const char *mnemonic;
+    size_t len;                 // span length handed to isa_lookup_n
+    int expected_id;            // -1: not an instruction
+
+}isa_lookup_case;
+
+
+static const isa_lookup_case isa_lookup_table[] = {
+
+    {"add", "add", 3, ISA_ADD},
+    {"sub", "sub", 3, ISA_SUB},
+    {"addi", "addi", 4, ISA_ADDI},
+    {"lw", "lw", 2, ISA_LW},
+    {"sw", "sw", 2, ISA_SW},
+    {"beq", "beq", 3, ISA_BEQ},
+    {"j", "j", 1, ISA_J},
+    {"prefix of a span", "addi $t0", 4, ISA_ADDI},
+    {"shorter span of longer mnemonic", "addi", 3, ISA_ADD},
+    {"empty", "", 0, -1},
+    {"unknown", "mul", 3, -1},
+    {"upper case", "ADD", 3, -1},
+    {"mnemonic with suffix", "addx", 4, -1},
+    {"mnemonic prefix", "ad", 2, -1},
+    {"long garbage", "this_is_not_an_instruction", 26, -1}
+
+};
+
+
+static void test_isa_lookup_every_entry(void){      // every table row is reachable by its own mnemonic, by both entry points.
+
+    for(int id = 0; id < ISA_COUNT; id++){
+
+        const InstructionSpec *spec = isa_spec((IsaId)id);
+        ASSERT_EQ_INT(spec != NULL, 1);
+        ASSERT_EQ_INT(isa_lookup(spec->mnemonic) == spec, 1);
+        ASSERT_EQ_INT(isa_lookup_n(spec->mnemonic, strlen(spec->mnemonic)) == spec, 1);
+        ASSERT_EQ_INT(isa_spec_id(spec), id);
+
+    }
+
+    ASSERT_EQ_INT(isa_spec(ISA_COUNT) == NULL, 1);
+
+}
+
+
+void test_isa_tables(app_context *app_context_param){
+
+    (void)app_context_param;
+
+    for(size_t i = 0; i < ARR_LEN(isa_lookup_table); i++){
+
+        const isa_lookup_case *c = &isa_lookup_table[i];
+        const InstructionSpec *spec = isa_lookup_n(c->mnemonic, c->len);
+
+        if((spec ? (int)isa_spec_id(spec) : -1) != c->expected_id) fprintf(stderr, "\n[CASE]  name = %s\n", c->name);
+
+        ASSERT_EQ_INT(spec ? (int)isa_spec_id(spec) : -1, c->expected_id);
+
+    }
+
+    ASSERT_EQ_INT(isa_lookup("beq") == isa_spec(ISA_BEQ), 1);
+    ASSERT_EQ_INT(isa_lookup("beqz") == NULL, 1);
+    ASSERT_EQ_INT(isa_lookup(NULL) == NULL, 1);
+
+    test_isa_lookup_every_entry();
+
+}
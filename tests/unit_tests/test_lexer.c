@@ -1,5 +1,6 @@
 #include "test.h"
 #include "front/lexer.h"
+#include "front/scanner.h"
 #include "core/error_handling.h"
 #include <stdio.h>
 #include <string.h>
@@ -61,7 +62,7 @@ static void run_lex_case(const char *suite_name, const LexCase *test_case, app_c
     for(size_t i = 0; i < test_case->expected_n; i++){
 
         ASSERT_EQ_INT((int)tv.v[i].kind, test_case->expected[i].kind);
-        ASSERT_STREQ(tv.v[i].lexeme, test_case->expected[i].lex);
+        ASSERT_SPANEQ(tok_text(&tv, &tv.v[i]), tv.v[i].len, test_case->expected[i].lex);
     }
 
     tokenvec_free(&tv, app_context_param);
@@ -230,18 +231,115 @@ static const LexCase g_real_line_cases[] = {
 
 
 
+// lex_line goes through scan_line, so comments and surrounding blanks never reach the token stream.
+static const LexCase g_fused_scan_cases[] = {
+    { "comment_only", "# nothing here", 0, {{0}} },
+    { "blank_then_comment", " \t  # nothing here", 0, {{0}} },
+    { "trailing_comment", "  add $t0 # why", 2, { {TOK_IDENT,"add"}, {TOK_REG,"$t0"} } },
+    { "comment_glued_to_word", "j main#x", 2, { {TOK_IDENT,"j"}, {TOK_IDENT,"main"} } },
+    { "crlf_line", "j main\r\n", 2, { {TOK_IDENT,"j"}, {TOK_IDENT,"main"} } },
+
+    // integer classification follows strtol(.., 0) exactly
+    { "int_plus", "+5", 1, { {TOK_INT,"+5"} } },
+    { "int_hex_upper", "0XfF", 1, { {TOK_INT,"0XfF"} } },
+    { "not_int_hex_prefix_only", "0x", 1, { {TOK_IDENT,"0x"} } },
+    { "not_int_bad_octal", "08", 1, { {TOK_IDENT,"08"} } },
+    { "not_int_sign_only", "-", 1, { {TOK_IDENT,"-"} } },
+    { "not_int_overflow", "99999999999999999999", 1, { {TOK_IDENT,"99999999999999999999"} } },
+};
+
+
+
 static const LexSuite g_lex_suites[] = {
 
     {"delimiters", g_delimiter_cases, ARR_LEN(g_delimiter_cases)},
     {"identifier+directive", g_ident_and_directive_cases, ARR_LEN(g_ident_and_directive_cases)},
     {"registers", g_register_cases, ARR_LEN(g_register_cases)},
     {"integers", g_int_cases, ARR_LEN(g_int_cases)},
-    {"real-lines", g_real_line_cases, ARR_LEN(g_real_line_cases)}
+    {"real-lines", g_real_line_cases, ARR_LEN(g_real_line_cases)},
+    {"fused-scan", g_fused_scan_cases, ARR_LEN(g_fused_scan_cases)}
 
 };
 
 
 
+static void test_scan_line_view(app_context *app_context_param){        // scan_line must stop at len, the bytes after the view are not part of the line.
+
+    const char text[] = "beq $t0, $t1, loop\nadd $t0, $t1, $t2";
+    TokenVec tv = {0};
+
+    Err e = scan_line(text, 18, 7, &tv, app_context_param);
+
+    ASSERT_EQ_INT(e, ERR_OK);
+    ASSERT_EQ_INT(tv.n, 6);
+    ASSERT_SPANEQ(tok_text(&tv, &tv.v[5]), tv.v[5].len, "loop");
+    ASSERT_EQ_INT(tv.v[5].line_no, 7);
+    ASSERT_EQ_INT(tok_column(&tv.v[5]), 15);
+    ASSERT_EQ_INT(tv.src == text, 1);
+
+    // the vector is reused: old tokens are dropped
+
+    e = scan_line(text + 19, sizeof(text) - 20, 8, &tv, app_context_param);
+
+    ASSERT_EQ_INT(e, ERR_OK);
+    ASSERT_EQ_INT(tv.n, 6);
+    ASSERT_SPANEQ(tok_text(&tv, &tv.v[0]), tv.v[0].len, "add");
+
+    tokenvec_free(&tv, app_context_param);
+
+}
+
+
+static void test_scan_impls_agree(app_context *app_context_param){       // every block classifier must produce the scalar token stream.
+
+    static const char *lines[] = {
+
+        "main: add $t0, $t1, $t2                  # long enough for the block path .....",
+        "table_with_a_rather_long_name_crossing_the_block_edge: .word 1, 2, 3, 0x10, -7, 077, 99",
+        "    lw $t3, 16($sp)\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t",
+        "abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz01",        // 64 bytes, ends inside a word on a block edge
+        "                                                              #   ,,,,",
+        ".word 1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30#x"
+
+    };
+
+    static const ScanImpl impls[] = { SCAN_IMPL_SSE2, SCAN_IMPL_AVX2 };
+
+    for(size_t l = 0; l < ARR_LEN(lines); l++){
+
+        TokenVec expected = {0};
+        ASSERT_EQ_INT(scanner_select_impl(SCAN_IMPL_SCALAR), SCAN_IMPL_SCALAR);
+        ASSERT_EQ_INT(scan_line(lines[l], strlen(lines[l]), 1, &expected, app_context_param), ERR_OK);
+
+        for(size_t k = 0; k < ARR_LEN(impls); k++){
+
+            if(scanner_select_impl(impls[k]) != impls[k]) continue;      // CPU does not have it
+
+            TokenVec got = {0};
+            ASSERT_EQ_INT(scan_line(lines[l], strlen(lines[l]), 1, &got, app_context_param), ERR_OK);
+            ASSERT_EQ_INT(got.n, expected.n);
+
+            for(size_t i = 0; i < got.n; i++){
+
+                ASSERT_EQ_INT(got.v[i].kind, expected.v[i].kind);
+                ASSERT_EQ_INT(got.v[i].off, expected.v[i].off);
+                ASSERT_EQ_INT(got.v[i].len, expected.v[i].len);
+
+            }
+
+            tokenvec_free(&got, app_context_param);
+
+        }
+
+        tokenvec_free(&expected, app_context_param);
+
+    }
+
+    scanner_select_impl(SCAN_IMPL_AUTO);
+
+}
+
+
 void test_lex_all_tables(app_context *app_context_param){
 
     (void)app_context_param;
@@ -252,4 +350,7 @@ void test_lex_all_tables(app_context *app_context_param){
 
     }
 
+    test_scan_line_view(app_context_param);
+    test_scan_impls_agree(app_context_param);
+
 }
@@ -0,0 +1,74 @@
+#include "test.h"
+#include "core/line.h"
+#include "core/error_handling.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+
+typedef struct{
+
+    const char *name;
+    const char *content;
+    size_t expected_n;
+    const char *expected[6];
+
+}MappedCase;
+
+
+static void run_mapped_case(const MappedCase *test_case, app_context *app_context_param){
+
+    char path[] = "/tmp/mips_line_testXXXXXX";
+    test_write_file(path, test_case->content);
+
+    mapped_program *mp = create_mapped_program(app_context_param, path);
+
+    if(!mp) fprintf(stderr, "\n[MAPPED CASE] %s\n", test_case->name);
+    ASSERT_EQ_INT(mp != NULL, 1);
+
+    if(mapped_program_line_count(mp) != test_case->expected_n) fprintf(stderr, "\n[MAPPED CASE] %s\n", test_case->name);
+    ASSERT_EQ_INT(mapped_program_line_count(mp), test_case->expected_n);
+
+    for(size_t i = 0; i < test_case->expected_n; i++){
+
+        LineView view = mapped_program_line(mp, i);
+        ASSERT_EQ_INT(view.len, strlen(test_case->expected[i]));
+        ASSERT_EQ_INT(memcmp(view.text, test_case->expected[i], view.len), 0);
+
+    }
+
+    // out of range index gives an empty view instead of reading past the index
+    ASSERT_EQ_INT(mapped_program_line(mp, test_case->expected_n).len, 0);
+
+    ASSERT_EQ_INT(destroy_mapped_program(app_context_param, mp), ERR_OK);
+    unlink(path);
+
+}
+
+
+static const MappedCase g_mapped_cases[] = {
+
+    { "empty_file", "", 0, {0} },
+    { "single_line_newline", ".text\n", 1, { ".text" } },
+    { "single_line_no_newline", ".text", 1, { ".text" } },
+    { "blank_lines", "\n\n\n", 3, { "", "", "" } },
+    { "program",
+      ".data\na: .word 1, 2\n.text\nmain: add $t0, $t1, $t2\n",
+      4,
+      { ".data", "a: .word 1, 2", ".text", "main: add $t0, $t1, $t2" } },
+    { "last_line_unterminated", "a:\n  j a  # loop", 2, { "a:", "  j a  # loop" } },
+
+};
+
+
+void test_line_tables(app_context *app_context_param){
+
+    for(size_t i = 0; i < ARR_LEN(g_mapped_cases); i++){
+
+        run_mapped_case(&g_mapped_cases[i], app_context_param);
+
+    }
+
+    ASSERT_EQ_INT(create_mapped_program(app_context_param, "/nonexistent/dir/file.asm") == NULL, 1);
+
+}
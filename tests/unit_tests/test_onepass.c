@@ -0,0 +1,170 @@
+#include "test.h"
+#include "asm/onepass.h"
+#include "asm/pass1.h"
+#include "asm/pass2.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define ONEPASS_TEST_LINES 5000
+
+
+static char **make_program(size_t n){      // forward and backward branches and jumps, chains of several references to one label
+
+    char **lines = malloc(sizeof(*lines) * n);
+    ASSERT_EQ_INT(lines != NULL, 1);
+
+    for(size_t i = 0; i < n; i++){
+
+        char buf[80];
+        size_t block = i % 1000;
+
+        if(block == 0) snprintf(buf, sizeof(buf), ".text");
+        else if(block == 950) snprintf(buf, sizeof(buf), ".data");
+        else if(block > 950) snprintf(buf, sizeof(buf), (i % 2) ? "w%zu: .word %zu, -3" : "    .word %zu", i, i);
+        else if(i % 10 == 0) snprintf(buf, sizeof(buf), "l%zu: add $t0, $t1, $t2", i);
+        else if(i % 10 == 2 && block + 8 < 950) snprintf(buf, sizeof(buf), "    beq $t0, $zero, l%zu", i + 8);          // forward
+        else if(i % 10 == 4 && block + 16 < 950) snprintf(buf, sizeof(buf), "    j l%zu", i + 16);                      // forward, two labels ahead
+        else if(i % 10 == 6 && block > 6) snprintf(buf, sizeof(buf), "    beq $t1, $t2, l%zu", i - 6);                  // backward
+        else if(i % 10 == 8) snprintf(buf, sizeof(buf), "    lw $t3, %zu($sp)", i % 64);
+        else snprintf(buf, sizeof(buf), "    addi $t1, $t1, %zu", i % 1000);
+
+        lines[i] = strdup(buf);
+
+    }
+
+    return lines;
+
+}
+
+
+static void assert_same_output(const AsmImage *a, const Symtab *a_st, const AsmState *a_state, const AsmImage *b, const Symtab *b_st, const AsmState *b_state){
+
+    ASSERT_EQ_INT(a_state->section, b_state->section);
+    ASSERT_EQ_INT(a_state->text_pc, b_state->text_pc);
+    ASSERT_EQ_INT(a_state->data_pc, b_state->data_pc);
+    ASSERT_EQ_INT(a->text_n, b->text_n);
+    ASSERT_EQ_INT(a->data_n, b->data_n);
+    ASSERT_EQ_INT(memcmp(a->text, b->text, sizeof(*a->text) * a->text_n), 0);
+    ASSERT_EQ_INT(memcmp(a->data, b->data, sizeof(*a->data) * a->data_n), 0);
+    ASSERT_EQ_INT(a_st->n, b_st->n);
+
+    for(size_t i = 0; i < a_st->n; i++){
+
+        ASSERT_STREQ(symtab_name(a_st, i), symtab_name(b_st, i));
+        ASSERT_EQ_INT(a_st->v[i].addr, b_st->v[i].addr);
+
+    }
+
+}
+
+
+typedef struct{
+
+    const char *name;
+    const char *src;
+    Err expected;
+
+}OnePassErrorCase;
+
+
+static const OnePassErrorCase error_table[] = {
+
+    {"never_defined", ".text\nbeq $t0, $t1, later\nj nowhere\nlater: add $t0, $t0, $t0\n", ERR_UNDEF_LABEL},
+    {"undefined_backward_use", ".text\nl: add $t0, $t0, $t0\nbeq $t0, $t1, missing\n", ERR_UNDEF_LABEL},
+    {"duplicate_label", ".text\nx: add $t0, $t0, $t0\nx: add $t0, $t0, $t0\n", ERR_SYNTAX},
+    {"jump_to_data_region", ".text\nj d\n.data\nd: .word 1\n", ERR_SYNTAX},
+    {"immediate_too_wide", ".text\naddi $t0, $t0, 70000\n", ERR_SYNTAX},
+    {"syntax_error", ".text\nadd $t0\n", ERR_SYNTAX}
+
+};
+
+
+void test_onepass_all(app_context *app_context_param){
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    char **lines = make_program(ONEPASS_TEST_LINES);
+
+    // reference: the two pass pipeline
+
+    IR ir;
+    Symtab ref_st;
+    AsmState ref_state;
+    AsmImage ref;
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &cfg, lines, ONEPASS_TEST_LINES, &ir, &ref_st, &ref_state), ERR_OK);
+    ASSERT_EQ_INT(assemble_pass2(app_context_param, &cfg, &ir, &ref_st, &ref_state, &ref), ERR_OK);
+
+    // FILE *, heap
+
+    FILE *f = test_write_lines(NULL, lines, ONEPASS_TEST_LINES);
+    AsmImage img;
+    Symtab st;
+    AsmState state;
+
+    ASSERT_EQ_INT(assemble_onepass_stream(app_context_param, &cfg, f, &img, &st, &state), ERR_OK);
+    assert_same_output(&img, &st, &state, &ref, &ref_st, &ref_state);
+    asm_image_free(&img, app_context_param);
+    symtab_free(&st, app_context_param);
+
+    // descriptor, arena
+
+    rewind(f);
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 0, app_context_param), ERR_OK);
+    const AsmConfig arena_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .arena = &arena};
+
+    ASSERT_EQ_INT(assemble_onepass_fd(app_context_param, &arena_cfg, fileno(f), &img, &st, &state), ERR_OK);
+    assert_same_output(&img, &st, &state, &ref, &ref_st, &ref_state);
+    arena_free(&arena, app_context_param);
+
+    // pipelined: encoding runs with address assignment, behind the reader and scanner threads
+
+    rewind(f);
+    const AsmConfig pipe_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pipelined = 1};
+
+    ASSERT_EQ_INT(assemble_onepass_stream(app_context_param, &pipe_cfg, f, &img, &st, &state), ERR_OK);
+    assert_same_output(&img, &st, &state, &ref, &ref_st, &ref_state);
+    asm_image_free(&img, app_context_param);
+    symtab_free(&st, app_context_param);
+    fclose(f);
+
+    // empty input
+
+    f = tmpfile();
+    ASSERT_EQ_INT(assemble_onepass_stream(app_context_param, &cfg, f, &img, &st, &state), ERR_OK);
+    ASSERT_EQ_INT(img.text_n, 0);
+    ASSERT_EQ_INT(img.data_n, 0);
+    ASSERT_EQ_INT(st.n, 0);
+    asm_image_free(&img, app_context_param);
+    symtab_free(&st, app_context_param);
+    fclose(f);
+
+    for(size_t k = 0; k < ARR_LEN(error_table); k++){
+
+        f = tmpfile();
+        fputs(error_table[k].src, f);
+        rewind(f);
+
+        Err e = assemble_onepass_stream(app_context_param, &cfg, f, &img, &st, &state);
+
+        if(e != error_table[k].expected) fprintf(stderr, "onepass case %s\n", error_table[k].name);
+        ASSERT_EQ_INT(e, error_table[k].expected);
+
+        rewind(f);
+        ASSERT_EQ_INT(assemble_onepass_stream(app_context_param, &pipe_cfg, f, &img, &st, &state), e);
+
+        fclose(f);
+
+    }
+
+    asm_image_free(&ref, app_context_param);
+    ir_free(&ir, app_context_param);
+    symtab_free(&ref_st, app_context_param);
+
+    for(size_t i = 0; i < ONEPASS_TEST_LINES; i++) free(lines[i]);
+    free(lines);
+
+}
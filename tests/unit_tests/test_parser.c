@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "core/isa_mips.h"
 #include "front/parser.h"
 #include "front/preprocess.h"
 
@@ -50,16 +51,18 @@ typedef struct{
 
     }st;
 
+    const char *label_operand;      // expected name of the OP_LABEL operand, if any
+
 }ParseCase;
 
 
-static void assert_stmt_matches(const ParseCase *test_case, Statement *statement){
+static void assert_stmt_matches(const ParseCase *test_case, Statement *statement, const StrPool *pool){
 
     ASSERT_EQ_INT((int)statement->kind, (int)test_case->expected_kind);
     
     if(test_case->expected_kind == ST_LABEL){
 
-        ASSERT_STREQ(statement->as.label.name, test_case->label_name);
+        ASSERT_STREQ(strpool_str(pool, statement->as.label.name), test_case->label_name);
 
     }
 
@@ -67,7 +70,7 @@ static void assert_stmt_matches(const ParseCase *test_case, Statement *statement
 
     if(test_case->expected_kind == ST_INSTR){
 
-        ASSERT_STREQ(statement->as.instr.mnemonic, test_case->st.st_instruction.mnemonic);
+        ASSERT_STREQ(isa_spec(statement->as.instr.op)->mnemonic, test_case->st.st_instruction.mnemonic);
         ASSERT_EQ_INT((int)statement->as.instr.op_count, (int)test_case->st.st_instruction.operand_count);
 
 
@@ -89,7 +92,7 @@ static void assert_stmt_matches(const ParseCase *test_case, Statement *statement
 
             if(test_case->st.st_instruction.ops[i].kind ==  OP_LABEL){
 
-                ASSERT_STREQ(statement->as.instr.ops[i].v.label, test_case->st.st_instruction.ops[i].v.label);
+                ASSERT_STREQ(strpool_str(pool, statement->as.instr.ops[i].v.label), test_case->label_operand);
 
             }
 
@@ -107,8 +110,8 @@ static void assert_stmt_matches(const ParseCase *test_case, Statement *statement
 
     if(test_case->expected_kind == ST_LABEL_PLUS_INSTR){
 
-        ASSERT_STREQ(statement->as.label_plus_instr.name, test_case->label_name);
-        ASSERT_STREQ(statement->as.label_plus_instr.instr.mnemonic, test_case->st.st_label_plus_instruction.mnemonic);
+        ASSERT_STREQ(strpool_str(pool, statement->as.label_plus_instr.name), test_case->label_name);
+        ASSERT_STREQ(isa_spec(statement->as.label_plus_instr.instr.op)->mnemonic, test_case->st.st_label_plus_instruction.mnemonic);
         ASSERT_EQ_INT(statement->as.label_plus_instr.instr.op_count, test_case->st.st_label_plus_instruction.operand_count);
 
         for(size_t i = 0; i < (size_t)statement->as.label_plus_instr.instr.op_count; i++){
@@ -130,7 +133,7 @@ static void assert_stmt_matches(const ParseCase *test_case, Statement *statement
 
             if(test_case->st.st_label_plus_instruction.ops[i].kind == OP_LABEL){
 
-                ASSERT_STREQ(statement->as.label_plus_instr.instr.ops[i].v.label, test_case->st.st_label_plus_instruction.ops[i].v.label);
+                ASSERT_STREQ(strpool_str(pool, statement->as.label_plus_instr.instr.ops[i].v.label), test_case->label_operand);
 
             }
 
@@ -162,7 +165,7 @@ static void assert_stmt_matches(const ParseCase *test_case, Statement *statement
 
     if(test_case->expected_kind == ST_LABEL_PLUS_DIR_WORD){
 
-        ASSERT_STREQ(statement->as.label_plus_dir_word.name, test_case->label_name);
+        ASSERT_STREQ(strpool_str(pool, statement->as.label_plus_dir_word.name), test_case->label_name);
         ASSERT_EQ_INT(statement->as.label_plus_dir_word.dir_word.n, test_case->st.st_label_plus_dir_word.n);
 
 
@@ -201,8 +204,11 @@ static void run_parse_case(const ParseCase *test_case, app_context *app_context_
     Statement s;
     memset(&s, 0, sizeof(s));
 
+    StrPool pool;
+    ASSERT_EQ_INT(strpool_init(&pool, app_context_param), ERR_OK);
+
     int has_label = 0;
-    Err pe = parse_line(app_context_param, &tv, temp_buf, 1, &has_label, &s);
+    Err pe = parse_line(app_context_param, NULL, &pool, &tv, 1, &has_label, &s);
 
     if(pe != test_case->expected_error){
 
@@ -215,11 +221,12 @@ static void run_parse_case(const ParseCase *test_case, app_context *app_context_
 
     if(pe == ERR_OK){
 
-        assert_stmt_matches(test_case, &s);
-        stmt_free_heap_parts(&s);
+        assert_stmt_matches(test_case, &s, &pool);
+        stmt_free_heap_parts(&s, app_context_param);
 
     }
 
+    strpool_free(&pool, app_context_param);
     tokenvec_free(&tv, app_context_param);
 
 }
@@ -243,28 +250,32 @@ static const ParseCase g_parser_ok_cases[] = {
         ERR_OK,
         ST_DIR_TEXT,
         NULL,
-        {0}},
+        {0},
+        NULL},
 
     {"directive_data",
         ".data",
         ERR_OK,
         ST_DIR_DATA,
         NULL,
-        {0}},
+        {0},
+        NULL},
 
     {"directive_word_3",
         ".word 10, 20, -1",
         ERR_OK,
         ST_DIR_WORD,
         NULL,
-        {.st_dir_word = {{10, 20, -1}, 3}}},
+        {.st_dir_word = {{10, 20, -1}, 3}},
+        NULL},
 
         {"label_only",
         "main:",
         ERR_OK,
         ST_LABEL,
         "main",
-        {0}},
+        {0},
+        NULL},
 
         {"instruction_add",
         "add $t0, $t1, $t2",
@@ -273,7 +284,8 @@ static const ParseCase g_parser_ok_cases[] = {
         NULL,
         {.st_instruction = {"add",
         {{.kind = OP_REGISTER, .v.reg = 8}, {.kind = OP_REGISTER, .v.reg = 9}, {.kind = OP_REGISTER, .v.reg = 10}},
-        3}}},
+        3}},
+        NULL},
 
     {"instruction_lw",
         "lw $t0, 4($sp)",
@@ -281,7 +293,8 @@ static const ParseCase g_parser_ok_cases[] = {
         ST_INSTR,
         NULL,
         {.st_instruction = {"lw", {{.kind = OP_REGISTER, .v.reg = 8}, {.kind = OP_MEMORY, .v.mem = {4, 29}}},
-        2}}},
+        2}},
+        NULL},
 
         {"label_then_instruction_lw",
         "main: lw $t0, 4($sp)",
@@ -289,14 +302,33 @@ static const ParseCase g_parser_ok_cases[] = {
         ST_LABEL_PLUS_INSTR,
         "main",
         {.st_label_plus_instruction = {"lw", {{.kind = OP_REGISTER, .v.reg = 8}, {.kind = OP_MEMORY, .v.mem = {4, 29}}},
-        2}}},
+        2}},
+        NULL},
+
+        {"instruction_j",
+        "j loop_end",
+        ERR_OK,
+        ST_INSTR,
+        NULL,
+        {.st_instruction = {"j", {{.kind = OP_LABEL}}, 1}},
+        "loop_end"},
+
+        {"label_then_instruction_beq",
+        "loop: beq $t0, $zero, loop_end",
+        ERR_OK,
+        ST_LABEL_PLUS_INSTR,
+        "loop",
+        {.st_label_plus_instruction = {"beq", {{.kind = OP_REGISTER, .v.reg = 8}, {.kind = OP_REGISTER, .v.reg = 0}, {.kind = OP_LABEL}},
+        3}},
+        "loop_end"},
 
         {"label_then_directive_word",
         "arr1: .word 10, 0x10, -23",
         ERR_OK,
         ST_LABEL_PLUS_DIR_WORD,
         "arr1",
-        {.st_label_plus_dir_word = {{10, 0x10, -23}, 3}}}
+        {.st_label_plus_dir_word = {{10, 0x10, -23}, 3}},
+        NULL}
 
 };
 
@@ -309,27 +341,74 @@ static const ParseCase g_parser_bad_cases[] = {
         ERR_SYNTAX,
         0,
         NULL,
-        {0}},
+        {0},
+        NULL},
 
     {"label_double_colon",
         "main::",
         ERR_SYNTAX,
         0,
         NULL,
-        {0}},
+        {0},
+        NULL},
 
     {"instruction_missing_operand",
         "add $t0, $t1,",
         ERR_SYNTAX,
         0,
         NULL,
-        {0}}
+        {0},
+        NULL}
 
 };
 
+static void test_parse_long_label_operand(app_context *app_context_param){       // interned names have no length limit, neither operands nor definitions are cut at 63 bytes.
+
+    char line[256] = "j ";
+    char label[201];
+
+    memset(label, 'L', sizeof(label) - 1);
+    label[sizeof(label) - 1] = '\0';
+    strcat(line, label);
+
+    TokenVec tv = {0};
+    ASSERT_EQ_INT(lex_line(line, 1, &tv, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(tv.v[1].len, 200);
+
+    StrPool pool;
+    ASSERT_EQ_INT(strpool_init(&pool, app_context_param), ERR_OK);
+
+    Statement s;
+    int has_label = 0;
+
+    ASSERT_EQ_INT(parse_line(app_context_param, NULL, &pool, &tv, 1, &has_label, &s), ERR_OK);
+    ASSERT_EQ_INT(s.kind, ST_INSTR);
+    ASSERT_EQ_INT(strpool_len(&pool, s.as.instr.ops[0].v.label), 200);
+    ASSERT_EQ_INT(strcmp(strpool_str(&pool, s.as.instr.ops[0].v.label), label), 0);
+
+    StrId operand = s.as.instr.ops[0].v.label;
+
+    // the same name as a definition: one id, no second copy
+
+    char def[512];
+    snprintf(def, sizeof(def), "%s: j %s", label, label);
+    tokenvec_free(&tv, app_context_param);
+    ASSERT_EQ_INT(lex_line(def, 2, &tv, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(parse_line(app_context_param, NULL, &pool, &tv, 2, &has_label, &s), ERR_OK);
+    ASSERT_EQ_INT(s.kind, ST_LABEL_PLUS_INSTR);
+    ASSERT_EQ_INT(s.as.label_plus_instr.name, operand);
+    ASSERT_EQ_INT(s.as.label_plus_instr.instr.ops[0].v.label, operand);
+    ASSERT_EQ_INT(strpool_count(&pool), 1);
+
+    strpool_free(&pool, app_context_param);
+    tokenvec_free(&tv, app_context_param);
+
+}
+
 void test_parser_tables(app_context *app_context_param){
 
     run_parse_table(g_parser_ok_cases, ARR_LEN(g_parser_ok_cases), app_context_param);
     run_parse_table(g_parser_bad_cases, ARR_LEN(g_parser_bad_cases), app_context_param);
+    test_parse_long_label_operand(app_context_param);
 
 }
@@ -1,9 +1,16 @@
 #include "test.h"
 #include "asm/pass1.h"
+#include "asm/pass1_pipeline.h"
 #include "core/ir.h"
+#include "core/thread_pool.h"
 #include "core/error_handling.h"
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 
 #define INPUT_PROGRAM_SIZE 10
@@ -23,7 +30,7 @@ typedef struct{
 
 static void run_pass1_case(app_context *app_context_param, pass1_case* test_case){
 
-    const AsmConfig cfg = {0x00400000, 0x10010000};
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
     AsmState state;
     IR ir;
     Symtab symtab;
@@ -55,6 +62,822 @@ static void run_pass1_case(app_context *app_context_param, pass1_case* test_case
 }
 
 
+static void run_pass1_arena_case(app_context *app_context_param, pass1_case* test_case){        // same program with every pass 1 allocation carved from one arena.
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 0, app_context_param), ERR_OK);
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .arena = &arena};
+    AsmState state;
+    IR ir;
+    Symtab symtab;
+
+    Err e = assemble_pass1(app_context_param, &cfg, test_case->lines, INPUT_PROGRAM_SIZE, &ir, &symtab, &state);
+
+    ASSERT_EQ_INT(e, ERR_OK);
+    ASSERT_EQ_INT(state.data_pc, test_case->expected_final_state.data_pc);
+    ASSERT_EQ_INT(state.text_pc, test_case->expected_final_state.text_pc);
+    ASSERT_EQ_INT(ir.arena == &arena, 1);
+
+    for(size_t i = 0; i < sizeof(test_case->label_addresses) / sizeof(test_case->label_addresses[0]); i++){
+
+        ASSERT_EQ_INT(symtab.v[i].addr, test_case->label_addresses[i]);
+
+    }
+
+    ASSERT_EQ_INT(arena_free(&arena, app_context_param), ERR_OK);      // releases IR, Symtab and every label/.word part at once
+
+}
+
+
+static void test_pass1_arena_error_rewinds(app_context *app_context_param){     // a failing run leaves the arena exactly where it found it.
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 0, app_context_param), ERR_OK);
+
+    char *before = arena_strndup(&arena, "caller data", 11, app_context_param);
+    size_t used = arena.bytes_allocated;
+
+    char *lines[] = { ".text", "main: j main", "j somewhere", "main: add $t0, $t1, $t2" };     // duplicate label
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .arena = &arena};
+    AsmState state;
+    IR ir;
+    Symtab symtab;
+
+    Err e = assemble_pass1(app_context_param, &cfg, lines, ARR_LEN(lines), &ir, &symtab, &state);
+
+    ASSERT_EQ_INT(e, ERR_SYNTAX);
+    ASSERT_EQ_INT(arena.bytes_allocated, used);
+    ASSERT_STREQ(before, "caller data");
+
+    arena_free(&arena, app_context_param);
+
+}
+
+
+static void check_pass1_result(const pass1_case *test_case, const char *entry_point, Err e, const AsmState *state, const Symtab *symtab){
+
+    if(e != ERR_OK){
+
+        fprintf(stderr, "\n[CASE]  name = %s entry = %s\n", test_case->name, entry_point);
+
+    }
+
+    ASSERT_EQ_INT(e, ERR_OK);
+    ASSERT_EQ_INT(state->data_pc, test_case->expected_final_state.data_pc);
+    ASSERT_EQ_INT(state->text_pc, test_case->expected_final_state.text_pc);
+
+    for(size_t i = 0; i < sizeof(test_case->label_addresses) / sizeof(test_case->label_addresses[0]); i++){
+
+        ASSERT_EQ_INT(symtab->v[i].addr, test_case->label_addresses[i]);
+
+    }
+
+}
+
+
+static void run_pass1_file_case(app_context *app_context_param, pass1_case* test_case){        // same program, loaded from a file through the mmap and streaming entry points.
+
+    char path[] = "/tmp/mips_pass1_testXXXXXX";
+    fclose(test_write_lines(path, test_case->lines, INPUT_PROGRAM_SIZE));
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    AsmState state;
+    IR ir;
+    Symtab symtab;
+    Err e;
+
+    // mmap line views
+
+    mapped_program *program = create_mapped_program(app_context_param, path);
+    ASSERT_EQ_INT(program != NULL, 1);
+    ASSERT_EQ_INT(mapped_program_line_count(program), INPUT_PROGRAM_SIZE);
+
+    e = assemble_pass1_mapped(app_context_param, &cfg, program, &ir, &symtab, &state);
+    check_pass1_result(test_case, "mapped", e, &state, &symtab);
+    ir_free(&ir, app_context_param);
+    symtab_free(&symtab, app_context_param);
+    destroy_mapped_program(app_context_param, program);
+
+    // FILE* stream
+
+    FILE *f = fopen(path, "r");
+    ASSERT_EQ_INT(f != NULL, 1);
+
+    e = assemble_pass1_stream(app_context_param, &cfg, f, &ir, &symtab, &state);
+    check_pass1_result(test_case, "stream", e, &state, &symtab);
+    ir_free(&ir, app_context_param);
+    symtab_free(&symtab, app_context_param);
+
+    // FILE* stream without IR, addresses only
+
+    rewind(f);
+    e = assemble_pass1_stream(app_context_param, &cfg, f, NULL, &symtab, &state);
+    check_pass1_result(test_case, "stream_no_ir", e, &state, &symtab);
+    symtab_free(&symtab, app_context_param);
+    fclose(f);
+
+    // raw fd
+
+    int fd = open(path, O_RDONLY);
+    ASSERT_EQ_INT(fd >= 0, 1);
+
+    e = assemble_pass1_fd(app_context_param, &cfg, fd, &ir, &symtab, &state);
+    check_pass1_result(test_case, "fd", e, &state, &symtab);
+    ir_free(&ir, app_context_param);
+    symtab_free(&symtab, app_context_param);
+    close(fd);
+
+    unlink(path);
+
+}
+
+
+#define PARALLEL_TEST_LINES 30000
+
+
+static char **make_parallel_program(size_t nlines){      // sections switch every 700 lines, so chunk boundaries land in both of them
+
+    char **lines = calloc(nlines, sizeof(*lines));
+    ASSERT_EQ_INT(lines != NULL, 1);
+
+    for(size_t i = 0; i < nlines; i++){
+
+        char buf[96];
+        int in_text = (i / 700) % 2 == 0;
+
+        if(i % 700 == 0) snprintf(buf, sizeof(buf), in_text ? ".text" : ".data");
+        else if(in_text){
+
+            switch(i % 6){
+
+                case 0: snprintf(buf, sizeof(buf), "t%zu: add $t0, $t1, $t2", i); break;
+                case 1: snprintf(buf, sizeof(buf), "    beq $t0, $zero, t%zu   # back edge", i - 1); break;
+                case 2: snprintf(buf, sizeof(buf), "    j fwd_%zu", i / 60); break;
+                case 3: snprintf(buf, sizeof(buf), "%s", (i % 12 == 3) ? "" : "# comment only"); break;
+                case 4: snprintf(buf, sizeof(buf), "fwd_%zu:", i / 6); break;
+                default: snprintf(buf, sizeof(buf), "    lw $t3, %zu($sp)", i % 128); break;
+
+            }
+
+        }
+        else{
+
+            switch(i % 3){
+
+                case 0: snprintf(buf, sizeof(buf), "d%zu: .word 1, -2, 0x%zx", i, i); break;
+                case 1: snprintf(buf, sizeof(buf), "    .word %zu", i); break;
+                default: snprintf(buf, sizeof(buf), "dl%zu:", i); break;
+
+            }
+
+        }
+
+        lines[i] = strdup(buf);
+        ASSERT_EQ_INT(lines[i] != NULL, 1);
+
+    }
+
+    return lines;
+
+}
+
+
+static void free_parallel_program(char **lines, size_t nlines){
+
+    for(size_t i = 0; i < nlines; i++) free(lines[i]);
+    free(lines);
+
+}
+
+
+static void assert_pass1_identical(const IR *a_ir, const Symtab *a_st, const AsmState *a_state, const IR *b_ir, const Symtab *b_st, const AsmState *b_state){
+
+    ASSERT_EQ_INT(a_state->section, b_state->section);
+    ASSERT_EQ_INT(a_state->text_pc, b_state->text_pc);
+    ASSERT_EQ_INT(a_state->data_pc, b_state->data_pc);
+
+    ASSERT_EQ_INT(a_ir->n, b_ir->n);
+    ASSERT_EQ_INT(memcmp(a_ir->v, b_ir->v, sizeof(*a_ir->v) * a_ir->n), 0);
+    ASSERT_EQ_INT(a_ir->words_n, b_ir->words_n);
+    ASSERT_EQ_INT(memcmp(a_ir->words, b_ir->words, sizeof(*a_ir->words) * a_ir->words_n), 0);
+
+    ASSERT_EQ_INT(a_st->n, b_st->n);
+    ASSERT_EQ_INT(memcmp(a_st->v, b_st->v, sizeof(*a_st->v) * a_st->n), 0);
+    ASSERT_EQ_INT(a_st->names.n, b_st->names.n);
+
+    for(StrId id = 1; id < a_st->names.n; id++) ASSERT_STREQ(strpool_str(&a_st->names, id), strpool_str(&b_st->names, id));
+
+}
+
+
+#define LONG_LINE_WORDS 50000
+#define LONG_LINE_LABEL 100000
+#define LONG_LINE_LINES 7
+
+
+static char **make_long_line_program(void){       // lines far over the stream window: a comment, a label name, a .word list
+
+    char **lines = malloc(sizeof(*lines) * LONG_LINE_LINES);
+    ASSERT_EQ_INT(lines != NULL, 1);
+
+    char *comment = malloc(200002);
+    char *words = malloc(LONG_LINE_LABEL + 16 + (size_t)LONG_LINE_WORDS * 8);
+    ASSERT_EQ_INT(comment != NULL && words != NULL, 1);
+
+    comment[0] = '#';
+    memset(comment + 1, 'x', 200000);
+    comment[200001] = '\0';
+
+    memset(words, 'l', LONG_LINE_LABEL);
+    size_t len = LONG_LINE_LABEL + (size_t)sprintf(words + LONG_LINE_LABEL, ": .word 0");
+    for(size_t i = 1; i < LONG_LINE_WORDS; i++) len += (size_t)sprintf(words + len, ", %zu", i);
+
+    lines[0] = strdup(".text");
+    lines[1] = comment;
+    lines[2] = strdup("main: add $t0, $t1, $t2");
+    lines[3] = strdup("j main");
+    lines[4] = strdup(".data");
+    lines[5] = words;
+    lines[6] = strdup("tail: .word 7");
+
+    return lines;
+
+}
+
+
+static void test_pass1_long_lines(app_context *app_context_param){       // lines of any length assemble whole, through every entry point, serial and pipelined.
+
+    char **lines = make_long_line_program();
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig pipe_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pipelined = 1};
+    IR base_ir, ir;
+    Symtab base_st, st;
+    AsmState base_state, state;
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &cfg, lines, LONG_LINE_LINES, &base_ir, &base_st, &base_state), ERR_OK);
+    ASSERT_EQ_INT(base_state.text_pc, 8);
+    ASSERT_EQ_INT(base_state.data_pc, 4 * (LONG_LINE_WORDS + 1));
+    ASSERT_EQ_INT(base_ir.n, 6);
+    ASSERT_EQ_INT(base_ir.v[1].line_no, 3);
+    ASSERT_EQ_INT(base_ir.v[5].line_no, 7);
+
+    size_t n_words;
+    const int32_t *words = ir_rec_words(&base_ir, &base_ir.v[4], &n_words);
+    ASSERT_EQ_INT(n_words, LONG_LINE_WORDS);
+    ASSERT_EQ_INT(words[LONG_LINE_WORDS - 1], LONG_LINE_WORDS - 1);
+
+    ASSERT_EQ_INT(base_st.n, 3);
+    ASSERT_EQ_INT(strlen(strpool_str(&base_st.names, base_st.v[1].name)), LONG_LINE_LABEL);
+    ASSERT_EQ_INT(base_st.v[1].addr, 0x10010000);
+    ASSERT_EQ_INT(base_st.v[2].addr, 0x10010000 + 4 * LONG_LINE_WORDS);
+
+    // mmap line views
+
+    char path[] = "/tmp/mips_pass1_longXXXXXX";
+    FILE *f = test_write_lines(path, lines, LONG_LINE_LINES);
+    fclose(f);
+
+    mapped_program *program = create_mapped_program(app_context_param, path);
+    ASSERT_EQ_INT(program != NULL, 1);
+    ASSERT_EQ_INT(assemble_pass1_mapped(app_context_param, &cfg, program, &ir, &st, &state), ERR_OK);
+    assert_pass1_identical(&base_ir, &base_st, &base_state, &ir, &st, &state);
+    ir_free(&ir, app_context_param);
+    symtab_free(&st, app_context_param);
+    destroy_mapped_program(app_context_param, program);
+
+    // streams: the window grows, serial and pipelined
+
+    const AsmConfig *stream_cfgs[] = {&cfg, &pipe_cfg};
+
+    for(size_t k = 0; k < ARR_LEN(stream_cfgs); k++){
+
+        f = fopen(path, "r");
+        ASSERT_EQ_INT(f != NULL, 1);
+        ASSERT_EQ_INT(assemble_pass1_stream(app_context_param, stream_cfgs[k], f, &ir, &st, &state), ERR_OK);
+        assert_pass1_identical(&base_ir, &base_st, &base_state, &ir, &st, &state);
+        ir_free(&ir, app_context_param);
+        symtab_free(&st, app_context_param);
+        fclose(f);
+
+        int fd = open(path, O_RDONLY);
+        ASSERT_EQ_INT(fd >= 0, 1);
+        ASSERT_EQ_INT(assemble_pass1_fd(app_context_param, stream_cfgs[k], fd, &ir, &st, &state), ERR_OK);
+        assert_pass1_identical(&base_ir, &base_st, &base_state, &ir, &st, &state);
+        ir_free(&ir, app_context_param);
+        symtab_free(&st, app_context_param);
+        close(fd);
+
+    }
+
+    unlink(path);
+    ir_free(&base_ir, app_context_param);
+    symtab_free(&base_st, app_context_param);
+    free_parallel_program(lines, LONG_LINE_LINES);
+
+}
+
+
+static void *failing_alloc(void *ctx, AppMemTag tag, void *ptr, size_t old_size, size_t new_size){        // the first *ctx allocations succeed, every later one fails
+
+    atomic_size_t *left = ctx;
+    (void)tag;
+    (void)old_size;
+
+    if(!new_size){
+
+        free(ptr);
+        return NULL;
+
+    }
+
+    size_t n = atomic_load(left);
+
+    do{
+
+        if(n == 0) return NULL;
+
+    }while(!atomic_compare_exchange_weak(left, &n, n - 1));
+
+    return realloc(ptr, new_size);
+
+}
+
+
+static void test_pass1_oom(void){       // out of memory at any point: ERR_OOM, and the caller's uninitialized outputs are never freed.
+
+    char *lines[] = { ".text", "main: add $t0, $t1, $t2", "j main", ".data", "tbl: .word 1, 2, 3" };
+    FILE *f = test_write_lines(NULL, lines, ARR_LEN(lines));
+
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig pipe_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pipelined = 1};
+
+    for(int mode = 0; mode < 3; mode++){        // lines, stream, pipelined stream
+
+        Err e = ERR_OOM;
+
+        for(size_t budget = 0; e == ERR_OOM; budget++){
+
+            app_context *app = create_app_context("/dev/null");
+            ASSERT_EQ_INT(app != NULL, 1);
+
+            atomic_size_t left;
+            atomic_init(&left, budget);
+            app_context_set_allocator(app, failing_alloc, &left);
+
+            AsmState state;
+            IR ir;
+            Symtab symtab;
+            memset(&ir, 0xA5, sizeof(ir));
+            memset(&symtab, 0xA5, sizeof(symtab));
+            ir.arena = NULL;            // heap owned garbage: freeing it would crash
+            symtab.arena = NULL;
+
+            rewind(f);
+            if(mode == 0) e = assemble_pass1(app, &serial_cfg, lines, ARR_LEN(lines), &ir, &symtab, &state);
+            else e = assemble_pass1_stream(app, mode == 1 ? &serial_cfg : &pipe_cfg, f, &ir, &symtab, &state);
+
+            if(e == ERR_OK){
+
+                ASSERT_EQ_INT(state.data_pc, 12);
+                ir_free(&ir, app);
+                symtab_free(&symtab, app);
+
+            }
+            else ASSERT_EQ_INT(e, ERR_OOM);
+
+            AppMemStats mem;
+            ASSERT_EQ_INT(app_context_mem_stats(app, APP_MEM_TAG_COUNT, &mem), ERR_OK);
+            ASSERT_EQ_INT(mem.live, 0);         // the stream window included
+
+            ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+
+        }
+
+    }
+
+    fclose(f);
+
+}
+
+
+static void test_pass1_parallel_identical(app_context *app_context_param, thread_pool *pool){      // same IR, Symtab, pool ids and state as the serial pass.
+
+    char **lines = make_parallel_program(PARALLEL_TEST_LINES);
+
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig parallel_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pool = pool};
+    IR serial_ir, parallel_ir;
+    Symtab serial_st, parallel_st;
+    AsmState serial_state, parallel_state;
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &serial_cfg, lines, PARALLEL_TEST_LINES, &serial_ir, &serial_st, &serial_state), ERR_OK);
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &parallel_cfg, lines, PARALLEL_TEST_LINES, &parallel_ir, &parallel_st, &parallel_state), ERR_OK);
+    assert_pass1_identical(&serial_ir, &serial_st, &serial_state, &parallel_ir, &parallel_st, &parallel_state);
+
+    ir_free(&parallel_ir, app_context_param);
+    symtab_free(&parallel_st, app_context_param);
+
+    // arena backed
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 0, app_context_param), ERR_OK);
+    const AsmConfig arena_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .arena = &arena, .pool = pool};
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &arena_cfg, lines, PARALLEL_TEST_LINES, &parallel_ir, &parallel_st, &parallel_state), ERR_OK);
+    assert_pass1_identical(&serial_ir, &serial_st, &serial_state, &parallel_ir, &parallel_st, &parallel_state);
+    arena_free(&arena, app_context_param);
+
+    ir_free(&serial_ir, app_context_param);
+    symtab_free(&serial_st, app_context_param);
+    free_parallel_program(lines, PARALLEL_TEST_LINES);
+
+}
+
+
+static void test_pass1_parallel_errors(app_context *app_context_param, thread_pool *pool){     // broken input fails the same way in both modes.
+
+    static const struct{ size_t line; const char *text; }breakages[] = {
+
+        {25001, "t0: sub $t0, $t1, $t2"},        // duplicate of a label defined in the first chunk
+        {29999, "add $t0, $t1"},                 // syntax error in the last chunk
+        {701, "add $t0, $t1, $t2"},              // instruction in .data
+        {3, ".word 5"}                           // .word in .text
+
+    };
+
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig parallel_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pool = pool};
+
+    for(size_t k = 0; k < ARR_LEN(breakages); k++){
+
+        char **lines = make_parallel_program(PARALLEL_TEST_LINES);
+        free(lines[breakages[k].line]);
+        lines[breakages[k].line] = strdup(breakages[k].text);
+
+        IR ir;
+        Symtab st;
+        AsmState state;
+
+        Err serial_e = assemble_pass1(app_context_param, &serial_cfg, lines, PARALLEL_TEST_LINES, &ir, &st, &state);
+        Err parallel_e = assemble_pass1(app_context_param, &parallel_cfg, lines, PARALLEL_TEST_LINES, &ir, &st, &state);
+
+        ASSERT_EQ_INT(serial_e, ERR_SYNTAX);
+        ASSERT_EQ_INT(parallel_e, serial_e);
+
+        free_parallel_program(lines, PARALLEL_TEST_LINES);
+
+    }
+
+}
+
+
+static void test_pass1_recovery(app_context *app_context_param, thread_pool *pool){     // one run reports every broken line, in line order, in both modes.
+
+    static const struct{ size_t line; const char *text; uint32_t column; }breakages[] = {
+
+        {3, ".word 5", 0},
+        {701, "add $t0, $t1, $t2", 0},
+        {25001, "t0: sub $t0, $t1, $t2", 0},
+        {29999, "add $t0, $t1", 1}
+
+    };
+
+    char **lines = make_parallel_program(PARALLEL_TEST_LINES);
+
+    for(size_t k = 0; k < ARR_LEN(breakages); k++){
+
+        free(lines[breakages[k].line]);
+        lines[breakages[k].line] = strdup(breakages[k].text);
+
+    }
+
+    DiagList serial_diag, parallel_diag;
+    ASSERT_EQ_INT(diag_init(&serial_diag, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(diag_init(&parallel_diag, app_context_param), ERR_OK);
+
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .diagnostics = &serial_diag};
+    const AsmConfig parallel_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pool = pool, .diagnostics = &parallel_diag};
+    IR ir;
+    Symtab st;
+    AsmState state;
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &serial_cfg, lines, PARALLEL_TEST_LINES, &ir, &st, &state), ERR_SYNTAX);
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &parallel_cfg, lines, PARALLEL_TEST_LINES, &ir, &st, &state), ERR_SYNTAX);
+    ASSERT_EQ_INT(serial_diag.n, ARR_LEN(breakages));
+    ASSERT_EQ_INT(parallel_diag.n, serial_diag.n);
+
+    for(size_t k = 0; k < ARR_LEN(breakages); k++){
+
+        const Diagnostic *d = &serial_diag.v[k];
+
+        ASSERT_EQ_INT(d->line_no, breakages[k].line + 1);
+        ASSERT_EQ_INT(d->column, breakages[k].column);
+        ASSERT_EQ_INT(d->code, ERR_SYNTAX);
+        ASSERT_SPANEQ(serial_diag.text + d->source, d->source_len, breakages[k].text);
+        ASSERT_EQ_INT(parallel_diag.v[k].line_no, d->line_no);
+        ASSERT_STREQ(diag_message(&parallel_diag, k), diag_message(&serial_diag, k));
+
+    }
+
+    // emitted once, in one piece
+
+    FILE *f = tmpfile();
+    ASSERT_EQ_INT(f != NULL, 1);
+    ASSERT_EQ_INT(diag_emit(&serial_diag, f, app_context_param), ERR_OK);
+
+    char out[1024] = {0};
+    rewind(f);
+    fread(out, 1, sizeof(out) - 1, f);
+    fclose(f);
+
+    ASSERT_EQ_INT(strncmp(out, "Syntax error at line 4: .word directives are out of .data section\n .word 5\n", 75), 0);
+    ASSERT_EQ_INT(strstr(out, "Syntax error at line 30000, col 1: ") != NULL, 1);
+
+    char one[128];
+    ASSERT_EQ_INT(diag_format(one, sizeof(one), 2, 5, "bad operand", "add $t0", 7), 59);
+    ASSERT_EQ_INT(strcmp(one, "Syntax error at line 2, col 5: bad operand\n add $t0\n     ^\n"), 0);
+
+    // error free input: nothing reported, same output as without recovery
+
+    free_parallel_program(lines, PARALLEL_TEST_LINES);
+    lines = make_parallel_program(PARALLEL_TEST_LINES);
+    diag_clear(&serial_diag);
+
+    const AsmConfig plain_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    IR plain_ir;
+    Symtab plain_st;
+    AsmState plain_state;
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &plain_cfg, lines, PARALLEL_TEST_LINES, &plain_ir, &plain_st, &plain_state), ERR_OK);
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &serial_cfg, lines, PARALLEL_TEST_LINES, &ir, &st, &state), ERR_OK);
+    ASSERT_EQ_INT(serial_diag.n, 0);
+    assert_pass1_identical(&plain_ir, &plain_st, &plain_state, &ir, &st, &state);
+
+    ir_free(&ir, app_context_param);
+    symtab_free(&st, app_context_param);
+    ir_free(&plain_ir, app_context_param);
+    symtab_free(&plain_st, app_context_param);
+    diag_free(&serial_diag, app_context_param);
+    diag_free(&parallel_diag, app_context_param);
+    free_parallel_program(lines, PARALLEL_TEST_LINES);
+
+}
+
+
+static void test_pass1_stats(app_context *app_context_param, thread_pool *pool){       // exact call and byte counts in every mode, NULL stats changes nothing.
+
+    const size_t nlines = 4000;
+    char **lines = make_parallel_program(nlines);
+
+    uint64_t bytes = 0, statements = 0;
+
+    for(size_t i = 0; i < nlines; i++){
+
+        bytes += strlen(lines[i]);
+        if(lines[i][0] != '\0' && lines[i][0] != '#') statements++;
+
+    }
+
+    AsmStats serial, parallel, stream, pipelined;
+    asm_stats_reset(&serial);
+    asm_stats_reset(&parallel);
+    asm_stats_reset(&stream);
+    asm_stats_reset(&pipelined);
+
+    const AsmConfig plain_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .stats = &serial};
+    const AsmConfig parallel_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pool = pool, .stats = &parallel};
+    const AsmConfig stream_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .stats = &stream};
+    const AsmConfig pipe_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .stats = &pipelined, .pipelined = 1};
+    IR plain_ir, ir;
+    Symtab plain_st, st;
+    AsmState plain_state, state;
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &plain_cfg, lines, nlines, &plain_ir, &plain_st, &plain_state), ERR_OK);
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &serial_cfg, lines, nlines, &ir, &st, &state), ERR_OK);
+    assert_pass1_identical(&plain_ir, &plain_st, &plain_state, &ir, &st, &state);
+    ir_free(&ir, app_context_param);
+    symtab_free(&st, app_context_param);
+
+    ASSERT_EQ_INT(assemble_pass1(app_context_param, &parallel_cfg, lines, nlines, &ir, &st, &state), ERR_OK);
+    assert_pass1_identical(&plain_ir, &plain_st, &plain_state, &ir, &st, &state);
+    ir_free(&ir, app_context_param);
+    symtab_free(&st, app_context_param);
+
+    FILE *f = test_write_lines(NULL, lines, nlines);
+
+    ASSERT_EQ_INT(assemble_pass1_stream(app_context_param, &stream_cfg, f, &ir, &st, &state), ERR_OK);
+    assert_pass1_identical(&plain_ir, &plain_st, &plain_state, &ir, &st, &state);
+    ir_free(&ir, app_context_param);
+    symtab_free(&st, app_context_param);
+
+    rewind(f);
+    ASSERT_EQ_INT(assemble_pass1_stream(app_context_param, &pipe_cfg, f, &ir, &st, &state), ERR_OK);
+    assert_pass1_identical(&plain_ir, &plain_st, &plain_state, &ir, &st, &state);
+    ir_free(&ir, app_context_param);
+    symtab_free(&st, app_context_param);
+    fclose(f);
+
+#if MIPS_ASM_STATS
+
+    const AsmStats *all[] = {&serial, &parallel, &stream, &pipelined};
+
+    for(size_t i = 0; i < ARR_LEN(all); i++){
+
+        const AsmStats *s = all[i];
+
+        ASSERT_EQ_INT(s->stage[ASM_STAGE_LEX].calls, nlines);
+        ASSERT_EQ_INT(s->stage[ASM_STAGE_LEX].bytes, bytes);
+        ASSERT_EQ_INT(s->stage[ASM_STAGE_PARSE].calls, statements);
+        ASSERT_EQ_INT(s->stage[ASM_STAGE_SYMTAB].calls, plain_st.n);
+        ASSERT_EQ_INT(s->stage[ASM_STAGE_IR].calls, plain_ir.n);
+        ASSERT_EQ_INT(s->stage[ASM_STAGE_IR].allocs > 0, 1);            // heap backed IR grows while it is pushed to
+        ASSERT_EQ_INT(s->stage[ASM_STAGE_LEX].sampled_calls > 0 && s->stage[ASM_STAGE_LEX].sampled_calls < nlines / 8, 1);
+
+    }
+
+    ASSERT_EQ_INT(serial.stage[ASM_STAGE_READ].calls, 0);
+    ASSERT_EQ_INT(stream.stage[ASM_STAGE_READ].calls > 0, 1);
+    ASSERT_EQ_INT(stream.stage[ASM_STAGE_READ].bytes, bytes + nlines);
+    ASSERT_EQ_INT(pipelined.stage[ASM_STAGE_READ].bytes, bytes + nlines);
+
+#else
+
+    AsmStats zero;
+    asm_stats_reset(&zero);
+    ASSERT_EQ_INT(memcmp(&serial, &zero, sizeof(zero)), 0);
+
+#endif
+
+    ir_free(&plain_ir, app_context_param);
+    symtab_free(&plain_st, app_context_param);
+    free_parallel_program(lines, nlines);
+
+}
+
+
+static void test_pass1_pipelined(app_context *app_context_param){       // the three thread pipeline gives what the serial stream gives, errors included.
+
+    char **lines = make_parallel_program(PARALLEL_TEST_LINES);          // about 10 windows: every batch goes round more than once
+    FILE *f = test_write_lines(NULL, lines, PARALLEL_TEST_LINES);
+
+    const AsmConfig serial_cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    const AsmConfig pipe_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pipelined = 1};
+    IR serial_ir, ir;
+    Symtab serial_st, st;
+    AsmState serial_state, state;
+
+    ASSERT_EQ_INT(assemble_pass1_stream(app_context_param, &serial_cfg, f, &serial_ir, &serial_st, &serial_state), ERR_OK);
+    rewind(f);
+    ASSERT_EQ_INT(assemble_pass1_stream(app_context_param, &pipe_cfg, f, &ir, &st, &state), ERR_OK);
+    assert_pass1_identical(&serial_ir, &serial_st, &serial_state, &ir, &st, &state);
+    ir_free(&ir, app_context_param);
+    symtab_free(&st, app_context_param);
+
+    // raw fd, arena backed
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 0, app_context_param), ERR_OK);
+    const AsmConfig arena_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .arena = &arena, .pipelined = 1};
+
+    rewind(f);
+    ASSERT_EQ_INT(assemble_pass1_fd(app_context_param, &arena_cfg, fileno(f), &ir, &st, &state), ERR_OK);
+    assert_pass1_identical(&serial_ir, &serial_st, &serial_state, &ir, &st, &state);
+    arena_free(&arena, app_context_param);
+    fclose(f);
+
+    // broken input: same error, same diagnostics in recovery mode
+
+    static const struct{ size_t line; const char *text; }breakages[] = {
+
+        {3, ".word 5"},                             // .word in .text, found by address assignment
+        {701, "add $t0, $t1, $t2"},                 // instruction in .data
+        {25001, "t0: sub $t0, $t1, $t2"},           // duplicate label
+        {29999, "add $t0, $t1"}                     // syntax error, found by the scanner thread
+
+    };
+
+    for(size_t k = 0; k < ARR_LEN(breakages); k++){
+
+        free(lines[breakages[k].line]);
+        lines[breakages[k].line] = strdup(breakages[k].text);
+
+        f = test_write_lines(NULL, lines, PARALLEL_TEST_LINES);
+        ASSERT_EQ_INT(assemble_pass1_stream(app_context_param, &pipe_cfg, f, &ir, &st, &state), ERR_SYNTAX);
+        fclose(f);
+
+    }
+
+    DiagList serial_diag, pipe_diag;
+    ASSERT_EQ_INT(diag_init(&serial_diag, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(diag_init(&pipe_diag, app_context_param), ERR_OK);
+
+    const AsmConfig serial_rec_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .diagnostics = &serial_diag};
+    const AsmConfig pipe_rec_cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .diagnostics = &pipe_diag, .pipelined = 1};
+
+    f = test_write_lines(NULL, lines, PARALLEL_TEST_LINES);
+    ASSERT_EQ_INT(assemble_pass1_stream(app_context_param, &serial_rec_cfg, f, &ir, &st, &state), ERR_SYNTAX);
+    rewind(f);
+    ASSERT_EQ_INT(assemble_pass1_stream(app_context_param, &pipe_rec_cfg, f, &ir, &st, &state), ERR_SYNTAX);
+    fclose(f);
+
+    ASSERT_EQ_INT(serial_diag.n, ARR_LEN(breakages));
+    ASSERT_EQ_INT(pipe_diag.n, serial_diag.n);
+    ASSERT_EQ_INT(pipe_diag.text_n, serial_diag.text_n);
+    ASSERT_EQ_INT(memcmp(pipe_diag.v, serial_diag.v, sizeof(*serial_diag.v) * serial_diag.n), 0);
+    ASSERT_EQ_INT(memcmp(pipe_diag.text, serial_diag.text, serial_diag.text_n), 0);
+
+    diag_free(&serial_diag, app_context_param);
+    diag_free(&pipe_diag, app_context_param);
+    ir_free(&serial_ir, app_context_param);
+    symtab_free(&serial_st, app_context_param);
+    free_parallel_program(lines, PARALLEL_TEST_LINES);
+
+}
+
+
+static void *batch_grow_failing_alloc(void *ctx, AppMemTag tag, void *ptr, size_t old_size, size_t new_size){     // a fresh batch can not grow past twice its window
+
+    (void)ctx;
+    (void)tag;
+
+    if(!new_size){
+
+        free(ptr);
+        return NULL;
+
+    }
+
+    if(ptr && old_size == PASS1_STREAM_WINDOW && new_size > 2 * PASS1_STREAM_WINDOW) return NULL;
+
+    return realloc(ptr, new_size);
+
+}
+
+
+static void test_pass1_pipeline_grow_oom(void){       // the reader fails to grow the batch a long line is carried into: every batch still comes back.
+
+    // the first line grows its batch to 4 windows, the second starts inside it and carries more than a window over
+
+    FILE *f = tmpfile();
+    ASSERT_EQ_INT(f != NULL, 1);
+
+    fputc('#', f);
+    for(size_t i = 0; i < 2 * PASS1_STREAM_WINDOW; i++) fputc('a', f);
+    fputs("\n#", f);
+    for(size_t i = 0; i < 4 * PASS1_STREAM_WINDOW; i++) fputc('b', f);
+    fputs("\nmain: j main\n", f);
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000, .pipelined = 1};
+
+    for(int run = 0; run < 2; run++){
+
+        app_context *app = create_app_context("/dev/null");
+        ASSERT_EQ_INT(app != NULL, 1);
+        app_context_set_allocator(app, batch_grow_failing_alloc, NULL);
+
+        rewind(f);
+
+        if(run == 0){
+
+            // stage by stage: the first line, then the failure, and nothing after it
+
+            pass1_pipeline *pl = create_pass1_pipeline(app, &cfg, pass1_read_file, f);
+            ASSERT_EQ_INT(pl != NULL, 1);
+
+            Pass1Batch *b = pass1_pipeline_next(pl);
+            ASSERT_EQ_INT(b != NULL, 1);
+            ASSERT_EQ_INT(b->last, 1);
+            ASSERT_EQ_INT(b->e, ERR_OOM);
+            ASSERT_EQ_INT(b->len, 2 * PASS1_STREAM_WINDOW + 2);
+            pass1_pipeline_release(pl, b);
+
+            ASSERT_EQ_INT(destroy_pass1_pipeline(app, pl), ERR_OK);        // all PASS1_PIPELINE_BATCHES batches accounted for
+
+        }
+        else{
+
+            IR ir;
+            Symtab st;
+            AsmState state;
+            ASSERT_EQ_INT(assemble_pass1_stream(app, &cfg, f, &ir, &st, &state), ERR_OOM);
+
+        }
+
+        AppMemStats mem;
+        ASSERT_EQ_INT(app_context_mem_stats(app, APP_MEM_TAG_COUNT, &mem), ERR_OK);
+        ASSERT_EQ_INT(mem.live, 0);
+        ASSERT_EQ_INT(destroy_app_context(app), ERR_OK);
+
+    }
+
+    fclose(f);
+
+}
+
+
 static pass1_case pass1_table[] = {
 
     {"test_input_program1",
@@ -93,7 +916,25 @@ void test_pass1_tables(app_context *app_context_param){
     for(size_t i = 0; i < ARR_LEN(pass1_table); i++){
 
         run_pass1_case(app_context_param, &pass1_table[i]);
+        run_pass1_file_case(app_context_param, &pass1_table[i]);
+        run_pass1_arena_case(app_context_param, &pass1_table[i]);
 
     }
 
+    test_pass1_long_lines(app_context_param);
+    test_pass1_arena_error_rewinds(app_context_param);
+    test_pass1_oom();
+
+    thread_pool *pool = create_thread_pool(app_context_param, 4);
+    ASSERT_EQ_INT(pool != NULL, 1);
+
+    test_pass1_parallel_identical(app_context_param, pool);
+    test_pass1_parallel_errors(app_context_param, pool);
+    test_pass1_recovery(app_context_param, pool);
+    test_pass1_stats(app_context_param, pool);
+    test_pass1_pipelined(app_context_param);
+    test_pass1_pipeline_grow_oom();
+
+    destroy_thread_pool(app_context_param, pool);
+
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "test.h"
+#include "asm/pass1.h"
+#include "asm/pass2.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define PASS2_MAX_LINES 8
+#define PASS2_MAX_WORDS 8
+
+
+typedef struct{
+
+    const char *name;
+    const char *lines[PASS2_MAX_LINES];
+    Err expected;
+    uint32_t text[PASS2_MAX_WORDS];
+    size_t text_n;
+    uint32_t data[PASS2_MAX_WORDS];
+    size_t data_n;
+
+}Pass2Case;
+
+
+static const Pass2Case pass2_table[] = {
+
+    {"r_format", {".text", "add $t0, $t1, $t2", "sub $s0, $s1, $s2"}, ERR_OK, {0x012A4020, 0x02328022}, 2, {0}, 0},
+    {"i_format", {".text", "addi $t0, $t1, -1", "lw $t0, 4($sp)", "sw $ra, -8($sp)", "addi $zero, $zero, 32767"}, ERR_OK,
+        {0x2128FFFF, 0x8FA80004, 0xAFBFFFF8, 0x20007FFF}, 4, {0}, 0},
+    {"branch_back_and_forward", {".text", "loop: add $t0, $t1, $t2", "beq $t0, $zero, loop", "beq $t0, $t1, done", "add $t0, $t0, $t0", "done: j loop"}, ERR_OK,
+        {0x012A4020, 0x1100FFFE, 0x11090001, 0x01084020, 0x08100000}, 5, {0}, 0},
+    {"data_words", {".data", "a: .word 1, -1, 0x7fffffff", ".word 5", ".text", "lw $t0, 0($gp)"}, ERR_OK,
+        {0x8F880000}, 1, {1, 0xFFFFFFFF, 0x7FFFFFFF, 5}, 4},
+    {"undefined_label", {".text", "j nowhere"}, ERR_UNDEF_LABEL, {0}, 0, {0}, 0},
+    {"immediate_too_wide", {".text", "addi $t0, $t0, 32768"}, ERR_SYNTAX, {0}, 0, {0}, 0},
+    {"offset_too_wide", {".text", "lw $t0, -32769($sp)"}, ERR_SYNTAX, {0}, 0, {0}, 0},
+    {"jump_out_of_region", {".data", "d: .word 0", ".text", "j d"}, ERR_SYNTAX, {0}, 0, {0}, 0}
+
+};
+
+
+static Err run_case(const char *const *src, size_t n, const AsmConfig *cfg, AsmImage *out){
+
+    IR ir;
+    Symtab st;
+    AsmState state;
+
+    Err e = assemble_pass1(NULL, cfg, (char **)src, n, &ir, &st, &state);
+    ASSERT_EQ_INT(e, ERR_OK);
+
+    e = assemble_pass2(NULL, cfg, &ir, &st, &state, out);
+
+    if(!cfg->arena){
+
+        ir_free(&ir, NULL);
+        symtab_free(&st, NULL);
+
+    }
+
+    return e;
+
+}
+
+
+static void test_pass2_branch_range(void){          // 16-bit word offsets: 32767 instructions forward is the farthest
+
+    size_t n = 32772;
+    char **src = calloc(n, sizeof(*src));
+    ASSERT_EQ_INT(src != NULL, 1);
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+
+    for(int far = 0; far <= 1; far++){
+
+        size_t body = 32767 + (size_t)far;
+
+        src[0] = ".text";
+        src[1] = "beq $t0, $t1, target";
+        for(size_t i = 0; i < body; i++) src[2 + i] = "add $t0, $t0, $t0";
+        src[2 + body] = "target: add $t1, $t1, $t1";
+
+        AsmImage img;
+        Err e = run_case((const char *const *)src, 3 + body, &cfg, &img);
+
+        if(far) ASSERT_EQ_INT(e, ERR_SYNTAX);
+        else{
+
+            ASSERT_EQ_INT(e, ERR_OK);
+            ASSERT_EQ_INT(img.text[0], 0x11097FFF);
+            asm_image_free(&img, NULL);
+
+        }
+
+    }
+
+    free(src);
+
+}
+
+
+void test_pass2_all(app_context *app_context_param){
+
+    (void)app_context_param;
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+
+    for(size_t k = 0; k < ARR_LEN(pass2_table); k++){
+
+        const Pass2Case *c = &pass2_table[k];
+        size_t n = 0;
+        while(n < PASS2_MAX_LINES && c->lines[n]) n++;
+
+        for(int use_arena = 0; use_arena <= 1; use_arena++){
+
+            Arena arena;
+            AsmConfig case_cfg = cfg;
+
+            if(use_arena){
+
+                ASSERT_EQ_INT(arena_init(&arena, 0, NULL), ERR_OK);
+                case_cfg.arena = &arena;
+
+            }
+
+            AsmImage img;
+            Err e = run_case(c->lines, n, &case_cfg, &img);
+
+            if(e != c->expected) fprintf(stderr, "pass2 case %s\n", c->name);
+            ASSERT_EQ_INT(e, c->expected);
+
+            if(e == ERR_OK){
+
+                ASSERT_EQ_INT(img.text_n, c->text_n);
+                ASSERT_EQ_INT(img.data_n, c->data_n);
+                ASSERT_EQ_INT(img.text_base, cfg.text_base);
+                ASSERT_EQ_INT(img.data_base, cfg.data_base);
+                ASSERT_EQ_INT(memcmp(img.text, c->text, sizeof(*img.text) * c->text_n), 0);
+                ASSERT_EQ_INT(memcmp(img.data, c->data, sizeof(*img.data) * c->data_n), 0);
+
+                asm_image_free(&img, NULL);
+
+            }
+
+            if(use_arena) arena_free(&arena, NULL);
+
+        }
+
+    }
+
+    test_pass2_branch_range();
+
+}
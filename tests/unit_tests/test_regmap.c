@@ -0,0 +1,84 @@
+#include "test.h"
+#include "core/regmap.h"
+#include <string.h>
+
+
+typedef struct{
+
+    const char *name;
+    const char *token;
+    size_t len;                 // span length handed to regmap_decode
+    int expected_reg;           // -1: not a register
+
+}regmap_case;
+
+
+static const regmap_case regmap_table[] = {
+
+    {"zero", "$zero", 5, 0},
+    {"at", "$at", 3, 1},
+    {"t0", "$t0", 3, 8},
+    {"t9", "$t9", 3, 25},
+    {"s8 alias of fp", "$s8", 3, 30},
+    {"fp", "$fp", 3, 30},
+    {"ra", "$ra", 3, 31},
+    {"number 0", "$0", 2, 0},
+    {"number 8", "$8", 2, 8},
+    {"number 31", "$31", 3, 31},
+    {"number leading zero", "$08", 3, 8},
+    {"r0", "$r0", 3, 0},
+    {"r31", "$r31", 4, 31},
+    {"span inside an operand", "$sp)", 3, 29},
+    {"number 32", "$32", 3, -1},
+    {"r32", "$r32", 4, -1},
+    {"three digits", "$008", 4, -1},
+    {"no dollar", "t0", 2, -1},
+    {"dollar only", "$", 1, -1},
+    {"t10", "$t10", 4, -1},
+    {"s9", "$s9", 3, -1},
+    {"k2", "$k2", 3, -1},
+    {"upper case", "$T0", 3, -1},
+    {"zer", "$zer", 4, -1},
+    {"zeros", "$zeros", 6, -1},
+    {"r with letter", "$rx", 3, -1},
+    {"number with letter", "$1a", 3, -1}
+
+};
+
+
+static void test_regmap_names_round_trip(void){         // every canonical name decodes to its own number, by both entry points.
+
+    for(int r = 0; r < REG_FILE_SIZE; r++){
+
+        const char *name = regmap_name(r);
+        ASSERT_EQ_INT(name != NULL, 1);
+        ASSERT_EQ_INT(regmap_decode(name, strlen(name)), r);
+        ASSERT_EQ_INT(regmap_lookup(name), r);
+
+    }
+
+    ASSERT_EQ_INT(regmap_name(-1) == NULL, 1);
+    ASSERT_EQ_INT(regmap_name(REG_FILE_SIZE) == NULL, 1);
+    ASSERT_EQ_INT(regmap_lookup(NULL), -1);
+
+}
+
+
+void test_regmap_tables(app_context *app_context_param){
+
+    (void)app_context_param;
+
+    for(size_t i = 0; i < ARR_LEN(regmap_table); i++){
+
+        const regmap_case *c = &regmap_table[i];
+        int r = regmap_decode(c->token, c->len);
+
+        if(r != c->expected_reg) fprintf(stderr, "\n[CASE]  name = %s\n", c->name);
+
+        ASSERT_EQ_INT(r, c->expected_reg);
+
+    }
+
+    test_regmap_names_round_trip();
+
+}
@@ -0,0 +1,245 @@
+#include "test.h"
+#include "asm/session.h"
+#include "core/isa_mips.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SESSION_TEST_LINES 3000
+
+
+typedef struct{
+
+    char **v;
+    size_t n;
+
+}TestProgram;
+
+
+static void program_splice(TestProgram *p, size_t first, size_t n_removed, char **ins, size_t n_ins){     // the same edit the session gets, on plain lines
+
+    for(size_t i = first; i < first + n_removed; i++) free(p->v[i]);
+
+    char **v = malloc(sizeof(*v) * (p->n - n_removed + n_ins + 1));
+    ASSERT_EQ_INT(v != NULL, 1);
+
+    memcpy(v, p->v, sizeof(*v) * first);
+    for(size_t i = 0; i < n_ins; i++) v[first + i] = strdup(ins[i]);
+    memcpy(v + first + n_ins, p->v + first + n_removed, sizeof(*v) * (p->n - first - n_removed));
+
+    free(p->v);
+    p->v = v;
+    p->n = p->n - n_removed + n_ins;
+
+}
+
+
+static void program_make(TestProgram *p){       // .text with labels and branches, a .data block every 1000 lines
+
+    p->v = malloc(sizeof(*p->v) * SESSION_TEST_LINES);
+    p->n = SESSION_TEST_LINES;
+    ASSERT_EQ_INT(p->v != NULL, 1);
+
+    for(size_t i = 0; i < SESSION_TEST_LINES; i++){
+
+        char buf[80];
+        size_t block = i % 1000;
+
+        if(block == 0) snprintf(buf, sizeof(buf), ".text");
+        else if(block == 900) snprintf(buf, sizeof(buf), ".data");
+        else if(block > 900) snprintf(buf, sizeof(buf), (i % 2) ? "w%zu: .word %zu, -3" : "    .word %zu", i, i);
+        else if(i % 7 == 0) snprintf(buf, sizeof(buf), "l%zu: add $t0, $t1, $t2", i);
+        else if(i % 7 == 3) snprintf(buf, sizeof(buf), "    beq $t0, $zero, l%zu", i - 3);
+        else if(i % 7 == 5) snprintf(buf, sizeof(buf), "    # comment %zu", i);
+        else snprintf(buf, sizeof(buf), "    addi $t1, $t1, %zu", i);
+
+        p->v[i] = strdup(buf);
+
+    }
+
+}
+
+
+static void program_free(TestProgram *p){
+
+    for(size_t i = 0; i < p->n; i++) free(p->v[i]);
+    free(p->v);
+
+}
+
+
+static int spec_has_label_operand(const IrRec *r){
+
+    if(r->kind != ST_INSTR && r->kind != ST_LABEL_PLUS_INSTR) return 0;
+
+    const InstructionSpec *spec = isa_spec((IsaId)r->op);
+
+    for(int i = 0; i < spec->op_count; i++){
+
+        if(spec->ops[i] == OPK_LABEL) return 1;
+
+    }
+
+    return 0;
+
+}
+
+
+static void assert_session_matches(const asm_session *s, const TestProgram *p){      // same program as a fresh pass 1, names compared as strings
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    IR ir;
+    Symtab st;
+    AsmState state;
+
+    ASSERT_EQ_INT(assemble_pass1(NULL, &cfg, p->v, p->n, &ir, &st, &state), ERR_OK);
+
+    const IR *sir = asm_session_ir(s);
+    const Symtab *sst = asm_session_symtab(s);
+    AsmState sstate = asm_session_state(s);
+
+    ASSERT_EQ_INT(asm_session_line_count(s), p->n);
+    ASSERT_EQ_INT(sstate.section, state.section);
+    ASSERT_EQ_INT(sstate.text_pc, state.text_pc);
+    ASSERT_EQ_INT(sstate.data_pc, state.data_pc);
+    ASSERT_EQ_INT(sir->n, ir.n);
+    ASSERT_EQ_INT(sir->words_n, ir.words_n);
+
+    for(size_t i = 0; i < ir.n; i++){
+
+        const IrRec *a = &sir->v[i], *b = &ir.v[i];
+
+        ASSERT_EQ_INT(a->line_no, b->line_no);
+        ASSERT_EQ_INT(a->kind, b->kind);
+        ASSERT_EQ_INT(a->op, b->op);
+        ASSERT_EQ_INT(a->regs, b->regs);
+        ASSERT_EQ_INT(a->label == STRID_NONE, b->label == STRID_NONE);
+        if(b->label != STRID_NONE) ASSERT_STREQ(strpool_str(&sst->names, a->label), strpool_str(&st.names, b->label));
+
+        if(b->kind == ST_DIR_WORD || b->kind == ST_LABEL_PLUS_DIR_WORD){
+
+            size_t na, nb;
+            const int32_t *wa = ir_rec_words(sir, a, &na), *wb = ir_rec_words(&ir, b, &nb);
+
+            ASSERT_EQ_INT(na, nb);
+            ASSERT_EQ_INT(memcmp(wa, wb, sizeof(*wa) * na), 0);
+
+        }
+        else if(spec_has_label_operand(b)) ASSERT_STREQ(strpool_str(&sst->names, a->val), strpool_str(&st.names, b->val));
+        else ASSERT_EQ_INT(a->val, b->val);
+
+    }
+
+    ASSERT_EQ_INT(sst->n, st.n);
+
+    for(size_t i = 0; i < st.n; i++){
+
+        ASSERT_STREQ(symtab_name(sst, i), symtab_name(&st, i));
+        ASSERT_EQ_INT(sst->v[i].addr, st.v[i].addr);
+
+    }
+
+    ir_free(&ir, NULL);
+    symtab_free(&st, NULL);
+
+}
+
+
+typedef struct{
+
+    const char *name;
+    size_t first;
+    size_t n_removed;
+    const char *ins[4];
+    size_t n_ins;
+    Err expected;           // != ERR_OK: rejected, the session keeps the program it had
+
+}SessionEditCase;
+
+
+static const SessionEditCase edit_table[] = {
+
+    {"replace_one_instruction", 1500, 1, {"    sub $t0, $t0, $t1"}, 1, ERR_OK},
+    {"insert_labeled_block", 10, 0, {"fresh_a: add $t2, $t2, $t2", "    j fresh_b", "fresh_b:", "    lw $t3, 4($sp)"}, 4, ERR_OK},
+    {"delete_across_data_block", 850, 300, {NULL}, 0, ERR_OK},
+    {"edit_first_line", 0, 1, {".text"}, 1, ERR_OK},
+    {"append_data", SIZE_MAX, 0, {".data", "tail: .word 7, 8, 9"}, 2, ERR_OK},
+    {"move_label_backwards", 7, 1, {"    add $t0, $t1, $t2"}, 1, ERR_OK},
+    {"reuse_label_of_removed_line", 1, 0, {"l7: addi $t1, $t1, 1"}, 1, ERR_OK},
+    {"duplicate_label", 2000, 0, {"l14: add $t0, $t1, $t2"}, 1, ERR_SYNTAX},
+    {"syntax_error", 42, 1, {"add $t0, $t1"}, 1, ERR_SYNTAX},
+    {"instruction_in_data", 1650, 0, {"add $t0, $t1, $t2"}, 1, ERR_SYNTAX},
+    {"word_in_text", 5, 0, {".word 1"}, 1, ERR_SYNTAX},
+    {"range_out_of_bounds", 5000, 1, {NULL}, 0, ERR_INVALID_ARGUMENT}
+
+};
+
+
+void test_session_all(app_context *app_context_param){
+
+    const AsmConfig cfg = {.text_base = 0x00400000, .data_base = 0x10010000};
+    TestProgram p;
+    program_make(&p);
+
+    asm_session *s = create_asm_session(app_context_param, &cfg);
+    ASSERT_EQ_INT(s != NULL, 1);
+    ASSERT_EQ_INT(asm_session_load(app_context_param, s, p.v, p.n), ERR_OK);
+    assert_session_matches(s, &p);
+
+    for(size_t k = 0; k < ARR_LEN(edit_table); k++){
+
+        const SessionEditCase *c = &edit_table[k];
+        size_t first = (c->first == SIZE_MAX) ? p.n : c->first;
+
+        Err e = asm_session_edit(app_context_param, s, first, c->n_removed, (char **)c->ins, c->n_ins);
+
+        if(e != c->expected) fprintf(stderr, "session edit case %s\n", c->name);
+        ASSERT_EQ_INT(e, c->expected);
+
+        if(e == ERR_OK) program_splice(&p, first, c->n_removed, (char **)c->ins, c->n_ins);
+        assert_session_matches(s, &p);
+
+    }
+
+    // whole program updates: only the changed range is handed to the edit
+
+    free(p.v[1200]);
+    p.v[1200] = strdup("    addi $t1, $t1, -1");
+    free(p.v[1201]);
+    p.v[1201] = strdup("moved_here: sub $t1, $t1, $t1");
+
+    ASSERT_EQ_INT(asm_session_update(app_context_param, s, p.v, p.n), ERR_OK);
+    assert_session_matches(s, &p);
+    ASSERT_EQ_INT(asm_session_update(app_context_param, s, p.v, p.n), ERR_OK);
+    assert_session_matches(s, &p);
+
+    char *broken[] = {".text", "x: add $t0, $t1, $t2", "x:"};
+    ASSERT_EQ_INT(asm_session_update(app_context_param, s, broken, ARR_LEN(broken)), ERR_SYNTAX);
+    assert_session_matches(s, &p);
+
+    // a failed load keeps the old program too, a good one replaces it
+
+    ASSERT_EQ_INT(asm_session_load(app_context_param, s, broken, ARR_LEN(broken)), ERR_SYNTAX);
+    assert_session_matches(s, &p);
+
+    program_free(&p);
+    program_make(&p);
+    ASSERT_EQ_INT(asm_session_load(app_context_param, s, p.v, p.n), ERR_OK);
+    assert_session_matches(s, &p);
+
+    // down to nothing and back
+
+    ASSERT_EQ_INT(asm_session_edit(app_context_param, s, 0, p.n, NULL, 0), ERR_OK);
+    program_splice(&p, 0, p.n, NULL, 0);
+    assert_session_matches(s, &p);
+
+    char *again[] = {".data", "only: .word 1"};
+    ASSERT_EQ_INT(asm_session_update(app_context_param, s, again, ARR_LEN(again)), ERR_OK);
+    program_splice(&p, 0, 0, again, ARR_LEN(again));
+    assert_session_matches(s, &p);
+
+    program_free(&p);
+    ASSERT_EQ_INT(destroy_asm_session(app_context_param, s), ERR_OK);
+
+}
@@ -0,0 +1,77 @@
+#include "test.h"
+#include "core/spsc.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+
+#define SPSC_TEST_ITEMS 200000
+
+
+typedef struct{
+
+    SpscQueue *q;
+    atomic_int stop;
+
+}SpscTestJob;
+
+
+static void *produce(void *arg){
+
+    SpscTestJob *job = arg;
+
+    for(uintptr_t i = 1; i <= SPSC_TEST_ITEMS; i++) if(!spsc_push(job->q, (void *)i, &job->stop)) break;
+
+    return NULL;
+
+}
+
+
+void test_spsc_all(app_context *app_context_param){
+
+    SpscQueue q;
+
+    // one thread: capacity rounding, full, empty, FIFO across the wrap
+
+    ASSERT_EQ_INT(spsc_init(&q, 5, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(q.mask, 7);
+    ASSERT_EQ_INT(spsc_try_pop(&q) == NULL, 1);
+
+    for(uintptr_t round = 0; round < 3; round++){
+
+        for(uintptr_t i = 1; i <= 8; i++) ASSERT_EQ_INT(spsc_try_push(&q, (void *)(round * 8 + i)), 1);
+        ASSERT_EQ_INT(spsc_try_push(&q, (void *)1), 0);
+
+        for(uintptr_t i = 1; i <= 8; i++) ASSERT_EQ_INT((uintptr_t)spsc_try_pop(&q), round * 8 + i);
+        ASSERT_EQ_INT(spsc_try_pop(&q) == NULL, 1);
+
+    }
+
+    ASSERT_EQ_INT(spsc_free(&q, app_context_param), ERR_OK);
+
+    // two threads through a small ring: every item once, in order
+
+    ASSERT_EQ_INT(spsc_init(&q, 64, app_context_param), ERR_OK);
+
+    SpscTestJob job = {&q, 0};
+    pthread_t producer;
+    ASSERT_EQ_INT(pthread_create(&producer, NULL, produce, &job), 0);
+
+    uintptr_t expected = 1;
+    for(; expected <= SPSC_TEST_ITEMS; expected++) if((uintptr_t)spsc_pop(&q, &job.stop) != expected) break;
+
+    pthread_join(producer, NULL);
+    ASSERT_EQ_INT(expected, SPSC_TEST_ITEMS + 1);
+    ASSERT_EQ_INT(spsc_try_pop(&q) == NULL, 1);
+
+    // stop releases a waiting side
+
+    atomic_store(&job.stop, 1);
+    ASSERT_EQ_INT(spsc_pop(&q, &job.stop) == NULL, 1);
+
+    for(uintptr_t i = 1; i <= 64; i++) ASSERT_EQ_INT(spsc_try_push(&q, (void *)i), 1);
+    ASSERT_EQ_INT(spsc_push(&q, (void *)1, &job.stop), 0);
+
+    ASSERT_EQ_INT(spsc_free(&q, app_context_param), ERR_OK);
+
+}
@@ -0,0 +1,68 @@
+#include "test.h"
+#include "core/strpool.h"
+#include "core/arena.h"
+#include "core/error_handling.h"
+#include <stdio.h>
+#include <string.h>
+
+
+#define STRPOOL_TEST_NAMES 10000
+
+
+static void check_strpool(StrPool *pool, app_context *app_context_param){
+
+    char name[32];
+    StrId first = STRID_NONE, id = STRID_NONE;
+
+    ASSERT_EQ_INT(strpool_intern(pool, "main", 4, &first, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(first != STRID_NONE, 1);
+
+    const char *first_str = strpool_str(pool, first);
+
+    for(int i = 0; i < STRPOOL_TEST_NAMES; i++){
+
+        snprintf(name, sizeof(name), "name_%d", i);
+        ASSERT_EQ_INT(strpool_intern(pool, name, strlen(name), &id, app_context_param), ERR_OK);
+        ASSERT_EQ_INT(id, first + 1 + i);           // dense ids in first seen order
+
+    }
+
+    ASSERT_EQ_INT(strpool_count(pool), STRPOOL_TEST_NAMES + 1);
+    ASSERT_EQ_INT(strpool_str(pool, first) == first_str, 1);        // strings never move while the pool grows
+    ASSERT_STREQ(strpool_str(pool, first), "main");
+
+    // interning again returns the same id and stores nothing
+
+    ASSERT_EQ_INT(strpool_intern(pool, "main: add", 4, &id, app_context_param), ERR_OK);        // span, not NUL terminated
+    ASSERT_EQ_INT(id, first);
+    ASSERT_EQ_INT(strpool_find(pool, "name_9999", 9), first + STRPOOL_TEST_NAMES);
+    ASSERT_EQ_INT(strpool_count(pool), STRPOOL_TEST_NAMES + 1);
+
+    ASSERT_EQ_INT(strpool_find(pool, "name_", 5), STRID_NONE);
+    ASSERT_EQ_INT(strpool_find(pool, "mai", 3), STRID_NONE);
+    ASSERT_EQ_INT(strpool_str(pool, STRID_NONE) == NULL, 1);
+    ASSERT_EQ_INT(strpool_str(pool, (StrId)(STRPOOL_TEST_NAMES + 2)) == NULL, 1);
+
+    ASSERT_EQ_INT(strpool_intern(pool, "", 0, &id, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(strpool_len(pool, id), 0);
+    ASSERT_STREQ(strpool_str(pool, id), "");
+
+}
+
+
+void test_strpool_all(app_context *app_context_param){
+
+    StrPool pool;
+
+    ASSERT_EQ_INT(strpool_init(&pool, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(strpool_find(&pool, "main", 4), STRID_NONE);
+    check_strpool(&pool, app_context_param);
+    ASSERT_EQ_INT(strpool_free(&pool, app_context_param), ERR_OK);
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 0, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(strpool_init_arena(&pool, &arena, app_context_param), ERR_OK);
+    check_strpool(&pool, app_context_param);
+    ASSERT_EQ_INT(arena_free(&arena, app_context_param), ERR_OK);
+
+}
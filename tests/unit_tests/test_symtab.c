@@ -0,0 +1,88 @@
+#include "test.h"
+#include "core/symtab.h"
+#include "core/arena.h"
+#include "core/error_handling.h"
+#include <stdio.h>
+#include <string.h>
+
+
+#define SYMTAB_TEST_LABELS 20000        // enough to rehash the index several times
+
+
+static void fill_symtab(Symtab *st, app_context *app_context_param){
+
+    char name[32];
+
+    for(uint32_t i = 0; i < SYMTAB_TEST_LABELS; i++){
+
+        snprintf(name, sizeof(name), "label_%u", i);
+        ASSERT_EQ_INT(symtab_add(st, name, 0x00400000 + 4 * i, app_context_param), ERR_OK);
+
+    }
+
+}
+
+
+static void check_symtab(Symtab *st, app_context *app_context_param){
+
+    char name[32];
+    uint32_t addr = 0;
+
+    ASSERT_EQ_INT(st->n, SYMTAB_TEST_LABELS);
+
+    for(uint32_t i = 0; i < SYMTAB_TEST_LABELS; i++){
+
+        snprintf(name, sizeof(name), "label_%u", i);
+        ASSERT_EQ_INT(symtab_find(st, name), (int)i);               // insertion order is kept
+        ASSERT_EQ_INT(symtab_lookup(st, name, &addr, app_context_param), ERR_OK);
+        ASSERT_EQ_INT(addr, 0x00400000 + 4 * i);
+
+    }
+
+    ASSERT_EQ_INT(symtab_lookup(st, "label_", &addr, app_context_param), ERR_UNDEF_LABEL);
+    ASSERT_EQ_INT(symtab_lookup(st, "label_20000", &addr, app_context_param), ERR_UNDEF_LABEL);
+    ASSERT_EQ_INT(symtab_find(st, ""), -1);
+
+    ASSERT_EQ_INT(symtab_add(st, "label_123", 0, app_context_param), ERR_SYNTAX);       // duplicate, table unchanged
+    ASSERT_EQ_INT(st->n, SYMTAB_TEST_LABELS);
+    ASSERT_EQ_INT(strpool_count(&st->names), SYMTAB_TEST_LABELS);
+
+}
+
+
+static void test_symtab_empty(app_context *app_context_param){
+
+    Symtab st;
+    uint32_t addr = 0;
+
+    ASSERT_EQ_INT(symtab_init(&st, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(symtab_find(&st, "main"), -1);
+    ASSERT_EQ_INT(symtab_lookup(&st, "main", &addr, app_context_param), ERR_UNDEF_LABEL);
+    ASSERT_EQ_INT(symtab_free(&st, app_context_param), ERR_OK);
+
+}
+
+
+void test_symtab_all(app_context *app_context_param){
+
+    test_symtab_empty(app_context_param);
+
+    // heap owned
+
+    Symtab st;
+    ASSERT_EQ_INT(symtab_init(&st, app_context_param), ERR_OK);
+    fill_symtab(&st, app_context_param);
+    check_symtab(&st, app_context_param);
+    ASSERT_EQ_INT(symtab_free(&st, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(st.by_id == NULL, 1);
+
+    // arena owned
+
+    Arena arena;
+    ASSERT_EQ_INT(arena_init(&arena, 0, app_context_param), ERR_OK);
+    ASSERT_EQ_INT(symtab_init_arena(&st, &arena, app_context_param), ERR_OK);
+    fill_symtab(&st, app_context_param);
+    check_symtab(&st, app_context_param);
+    ASSERT_EQ_INT(arena_free(&arena, app_context_param), ERR_OK);
+
+}
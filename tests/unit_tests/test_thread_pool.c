@@ -0,0 +1,59 @@
+#include "test.h"
+#include "core/thread_pool.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+
+#define POOL_TEST_TASKS 10000
+
+
+typedef struct{
+
+    atomic_int *hits;
+    atomic_size_t total;
+
+}PoolTestJob;
+
+
+static void count_task(void *arg, size_t index){
+
+    PoolTestJob *job = arg;
+
+    atomic_fetch_add(&job->hits[index], 1);
+    atomic_fetch_add(&job->total, index);
+
+}
+
+
+void test_thread_pool_all(app_context *app_context_param){
+
+    static const unsigned sizes[] = {1, 2, 8};
+
+    for(size_t k = 0; k < ARR_LEN(sizes); k++){
+
+        thread_pool *pool = create_thread_pool(app_context_param, sizes[k]);
+        ASSERT_EQ_INT(pool != NULL, 1);
+        ASSERT_EQ_INT(thread_pool_size(pool), sizes[k]);
+
+        atomic_int *hits = calloc(POOL_TEST_TASKS, sizeof(*hits));
+        ASSERT_EQ_INT(hits != NULL, 1);
+
+        for(int run = 1; run <= 3; run++){          // the same workers serve every run
+
+            PoolTestJob job = {hits, 0};
+
+            ASSERT_EQ_INT(thread_pool_run(pool, POOL_TEST_TASKS, count_task, &job), ERR_OK);
+            ASSERT_EQ_INT(atomic_load(&job.total) == (size_t)POOL_TEST_TASKS * (POOL_TEST_TASKS - 1) / 2, 1);
+
+            for(size_t i = 0; i < POOL_TEST_TASKS; i++) ASSERT_EQ_INT(atomic_load(&hits[i]), run);      // every index exactly once per run
+
+        }
+
+        ASSERT_EQ_INT(thread_pool_run(pool, 0, count_task, NULL), ERR_OK);
+
+        free(hits);
+        ASSERT_EQ_INT(destroy_thread_pool(app_context_param, pool), ERR_OK);
+
+    }
+
+}
@@ -0,0 +1,95 @@
+// isa_hash_gen: build time generator of the perfect hash behind isa_lookup().
+//
+// reads the mnemonics from include/core/isa_mips.def, searches the smallest power of two table
+// and a seed for isa_mnemonic_hash() that puts every mnemonic in its own slot, and writes
+//
+//     ISA_HASH_SEED, ISA_HASH_BITS and isa_hash_slot[] (instruction index + 1, 0 = empty)
+//
+// usage: isa_hash_gen <output header>
+
+#include "core/isa_hash.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *g_mnemonics[] = {
+
+#define ISA_OPS(...)
+#define ISA_INSTR(id, mnemonic, format, opcode, funct, op_count, ops, imm_kind) mnemonic,
+#include "core/isa_mips.def"
+#undef ISA_INSTR
+#undef ISA_OPS
+
+};
+
+#define N_MNEMONICS (sizeof(g_mnemonics) / sizeof(g_mnemonics[0]))
+#define MAX_BITS 16
+#define SEED_TRIES 1000000u
+
+
+static int try_seed(uint32_t seed, unsigned bits, uint16_t *slots){
+
+    size_t size = (size_t)1 << bits;
+    memset(slots, 0, size * sizeof(*slots));
+
+    for(size_t i = 0; i < N_MNEMONICS; i++){
+
+        uint32_t h = isa_mnemonic_hash(g_mnemonics[i], strlen(g_mnemonics[i]), seed) & (uint32_t)(size - 1);
+        if(slots[h]) return 0;
+        slots[h] = (uint16_t)(i + 1);
+
+    }
+
+    return 1;
+
+}
+
+
+int main(int argc, char **argv){
+
+    if(argc != 2){
+
+        fprintf(stderr, "usage: %s <output header>\n", argv[0]);
+        return 1;
+
+    }
+
+    static uint16_t slots[1u << MAX_BITS];
+    unsigned bits = 1;
+
+    while(((size_t)1 << bits) < 2 * N_MNEMONICS) bits++;       // load factor <= 0.5 keeps the seed search short
+
+    for(; bits <= MAX_BITS; bits++){
+
+        for(uint32_t seed = 0; seed < SEED_TRIES; seed++){
+
+            if(!try_seed(seed, bits, slots)) continue;
+
+            FILE *out = fopen(argv[1], "w");
+
+            if(!out){
+
+                perror(argv[1]);
+                return 1;
+
+            }
+
+            fprintf(out, "// generated by tools/isa_hash_gen.c from include/core/isa_mips.def, do not edit\n\n");
+            fprintf(out, "#ifndef ISA_MIPS_HASH_H\n#define ISA_MIPS_HASH_H\n\n#include <stdint.h>\n\n");
+            fprintf(out, "#define ISA_HASH_SEED 0x%08Xu\n#define ISA_HASH_BITS %u\n\n", seed, bits);
+            fprintf(out, "static const %s isa_hash_slot[%zu] = {", N_MNEMONICS < 255 ? "uint8_t" : "uint16_t", (size_t)1 << bits);
+
+            for(size_t i = 0; i < ((size_t)1 << bits); i++) fprintf(out, "%s%u", (i % 16) ? ", " : "\n    ", slots[i]);
+
+            fprintf(out, "\n};\n\n#endif\n");
+
+            return fclose(out) == 0 ? 0 : 1;
+
+        }
+
+    }
+
+    fprintf(stderr, "isa_hash_gen: no collision free seed found\n");
+    return 1;
+
+}